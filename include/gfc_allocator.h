@@ -0,0 +1,193 @@
+#ifndef __GFC_ALLOCATOR_H__
+#define __GFC_ALLOCATOR_H__
+
+#include <SDL.h>
+
+/**
+ * @brief an allocator that containers can be built on instead of the heap
+ * containers made with an allocator remember it, and use it for growing and freeing
+ * @note allocators are not thread safe
+ */
+typedef struct
+{
+    void *(*allocate)(void *context,size_t size);                                   /**<must return zeroed memory*/
+    void *(*reallocate)(void *context,void *ptr,size_t oldSize,size_t newSize);     /**<optional, alloc + copy + release is used if NULL*/
+    void  (*release)(void *context,void *ptr);                                      /**<optional, nothing is released if NULL*/
+    void *context;
+    Uint32 allocations;     /**<how many allocations have been made since the last stats reset*/
+    Uint32 releases;        /**<how many releases have been made since the last stats reset*/
+    size_t bytes;           /**<how many bytes have been requested since the last stats reset*/
+}gfcAllocator;
+
+typedef struct gfcArenaBlock_S gfcArenaBlock;
+
+/**
+ * @brief a bump allocator.  Allocations are never freed individually, the whole arena is reset at once
+ * Use one for data that lives for a frame or a level, and reset it when the frame or level ends.
+ */
+typedef struct
+{
+    gfcArenaBlock  *first;
+    gfcArenaBlock  *current;    /**<the block being allocated from*/
+    size_t          blockSize;  /**<default size of new blocks*/
+    size_t          used;       /**<bytes handed out since the last reset*/
+    gfcAllocator    allocator;  /**<for passing the arena to containers*/
+}gfcArena;
+
+/**
+ * @brief a position in an arena to rewind to
+ */
+typedef struct
+{
+    gfcArenaBlock  *block;
+    size_t          offset;
+    size_t          used;
+}gfcArenaMark;
+
+typedef struct gfcPoolChunk_S gfcPoolChunk;
+
+/**
+ * @brief a pool of fixed size elements.  Released elements go on a free list for reuse
+ */
+typedef struct
+{
+    gfcPoolChunk   *chunks;
+    void           *freeList;
+    size_t          elementSize;
+    Uint32          chunkCount;     /**<elements per chunk*/
+    Uint32          inUse;
+    gfcAllocator    allocator;      /**<for passing the pool to containers*/
+}gfcPool;
+
+/**
+ * @brief allocate zeroed memory from an allocator
+ * @param allocator the allocator to use, if NULL the heap is used (same as gfc_allocate_array)
+ * @param typeSize the size of each element
+ * @param count the number of elements
+ * @return NULL on error, zeroed memory otherwise
+ */
+void *gfc_allocator_alloc(gfcAllocator *allocator,size_t typeSize,size_t count);
+
+/**
+ * @brief grow an allocation.  The new part is NOT zeroed
+ * @param allocator the allocator that made ptr, if NULL the heap is used
+ * @param ptr the memory to grow
+ * @param oldSize its current size in bytes
+ * @param newSize the size it should be
+ * @return NULL on error (ptr is left as it was), the new memory otherwise
+ */
+void *gfc_allocator_realloc(gfcAllocator *allocator,void *ptr,size_t oldSize,size_t newSize);
+
+/**
+ * @brief give memory back to the allocator that made it
+ * @param allocator the allocator that made ptr, if NULL the heap is used
+ * @param ptr the memory to release
+ */
+void gfc_allocator_free(gfcAllocator *allocator,void *ptr);
+
+/**
+ * @brief zero the allocation counters, call once per frame to track churn per frame
+ * @param allocator the allocator to reset
+ */
+void gfc_allocator_reset_stats(gfcAllocator *allocator);
+
+#ifdef GFC_ALLOCATION_STATS
+/**
+ * @brief get the counters for heap allocations made through a NULL allocator
+ * @note only available when built with GFC_ALLOCATION_STATS defined, the counters are not thread safe
+ * @return the heap counters, reset them with gfc_allocator_reset_stats()
+ */
+gfcAllocator *gfc_allocator_heap_stats();
+#endif
+
+/**
+ * @brief make a new arena
+ * @param blockSize how many bytes to reserve at a time, 0 for a default of 64k
+ * @return NULL on error, the new arena otherwise
+ */
+gfcArena *gfc_arena_new(size_t blockSize);
+
+/**
+ * @brief free an arena and everything allocated from it
+ * @param arena the arena to free
+ */
+void gfc_arena_free(gfcArena *arena);
+
+/**
+ * @brief allocate zeroed memory from the arena, aligned to 16 bytes
+ * @param arena the arena to allocate from
+ * @param size how many bytes
+ * @return NULL on error, the memory otherwise.  Valid until the arena is reset or rewound past it
+ */
+void *gfc_arena_alloc(gfcArena *arena,size_t size);
+
+/**
+ * @brief release everything allocated from the arena at once, keeping its blocks for reuse
+ * @param arena the arena to reset
+ */
+void gfc_arena_reset(gfcArena *arena);
+
+/**
+ * @brief remember the current position of the arena
+ * @param arena the arena to mark
+ * @return a mark for gfc_arena_rewind()
+ */
+gfcArenaMark gfc_arena_mark(gfcArena *arena);
+
+/**
+ * @brief release everything allocated since mark was taken
+ * @param arena the arena to rewind
+ * @param mark a mark taken from this arena since it was last reset
+ */
+void gfc_arena_rewind(gfcArena *arena,gfcArenaMark mark);
+
+/**
+ * @brief get the allocator interface of an arena for passing to container constructors
+ * @param arena the arena
+ * @return NULL on error, the allocator otherwise
+ */
+gfcAllocator *gfc_arena_allocator(gfcArena *arena);
+
+/**
+ * @brief make a new pool of fixed size elements
+ * @param elementSize the size of each element
+ * @param chunkCount how many elements to reserve at a time, 0 for a default of 64
+ * @return NULL on error, the new pool otherwise
+ */
+gfcPool *gfc_pool_new(size_t elementSize,Uint32 chunkCount);
+
+/**
+ * @brief free a pool and all of its elements
+ * @param pool the pool to free
+ */
+void gfc_pool_free(gfcPool *pool);
+
+/**
+ * @brief get a zeroed element from the pool
+ * @param pool the pool to allocate from
+ * @return NULL on error, the element otherwise
+ */
+void *gfc_pool_alloc(gfcPool *pool);
+
+/**
+ * @brief return an element to the pool
+ * @param pool the pool the element came from
+ * @param element the element to return
+ */
+void gfc_pool_release(gfcPool *pool,void *element);
+
+/**
+ * @brief return every element to the pool at once, keeping its memory for reuse
+ * @param pool the pool to reset
+ */
+void gfc_pool_reset(gfcPool *pool);
+
+/**
+ * @brief get the allocator interface of a pool for passing to constructors
+ * @note only allocations that fit in the element size can be made from it
+ * @param pool the pool
+ * @return NULL on error, the allocator otherwise
+ */
+gfcAllocator *gfc_pool_allocator(gfcPool *pool);
+
+#endif
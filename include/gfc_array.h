@@ -0,0 +1,159 @@
+#ifndef __GFC_ARRAY_H__
+#define __GFC_ARRAY_H__
+
+#include <SDL.h>
+
+#include "gfc_list.h"
+
+/**
+ * @brief the GFC Array is an automatically expanding array that stores its elements by value in contiguous memory
+ * Where a gfcList holds pointers to data that lives elsewhere, a gfcArray holds the data itself,
+ * so walking it touches memory in order instead of chasing a pointer per element.
+ * @note pointers to elements are invalidated when the array grows, hold on to indices instead
+ * Example:
+ *  gfcArray *points = gfc_array_new_type(Vector2D);
+ *  gfc_array_append_value(points,Vector2D,vector2d(1,2));
+ *  gfc_array_append_value(points,Vector2D,{3,4});
+ *  gfc_array_foreach_type(points,Vector2D,p)
+ *  {
+ *      p->x += 1;
+ *  }
+ */
+typedef struct
+{
+    void *elements;     /**<count elements of elementSize bytes each*/
+    Uint32 elementSize;
+    Uint32 size;        /**<how many elements there is room for*/
+    Uint32 count;
+}gfcArray;
+
+/**
+ * @brief allocate a new array for elements of type T
+ */
+#define gfc_array_new_type(T) gfc_array_new(sizeof(T))
+
+/**
+ * @brief get the elements of the array as a pointer to T
+ */
+#define gfc_array_data(array,T) ((T *)(array)->elements)
+
+/**
+ * @brief access the nth element of an array of T.  No bounds checking, use gfc_array_get_nth() for that
+ */
+#define gfc_array_nth(array,T,n) (gfc_array_data(array,T)[n])
+
+/**
+ * @brief append a copy of a value to an array of T, the value may be an expression of type T or the fields of T in braces
+ * @note the value initializes a T[1], so it is copied whole, or the braced fields fill in the one T
+ * @return NULL on error, a pointer to the new element otherwise
+ */
+#define gfc_array_append_value(array,T,...) ((T *)gfc_array_append(array,(T[1]){__VA_ARGS__}))
+
+/**
+ * @brief loop over every element of an array of T, it is a T * to the current element
+ */
+#define gfc_array_foreach_type(array,T,it)\
+    for (T *it = (array) ? gfc_array_data(array,T) : NULL; (array) && (it < gfc_array_data(array,T) + (array)->count); it++)
+
+/**
+ * @brief allocate a new empty array
+ * @param elementSize the size in bytes of each element
+ * @return NULL on error or a new empty array
+ */
+gfcArray *gfc_array_new(Uint32 elementSize);
+
+/**
+ * @brief allocate a new empty array with room for count elements
+ * @param elementSize the size in bytes of each element
+ * @param count how many elements to make room for
+ * @return NULL on error or a new empty array
+ */
+gfcArray *gfc_array_new_size(Uint32 elementSize,Uint32 count);
+
+/**
+ * @brief free an array and all of the elements it holds
+ * @param array the array to free
+ */
+void gfc_array_delete(gfcArray *array);
+
+/**
+ * @brief make sure the array has room for at least count elements without growing again
+ * @param array the array to grow
+ * @param count how many elements there should be room for
+ * @return -1 on error (out of memory), 0 otherwise
+ */
+int gfc_array_reserve(gfcArray *array,Uint32 count);
+
+/**
+ * @brief copy an element onto the end of the array
+ * @param array the array to add to
+ * @param element pointer to the data to copy in, if NULL the new element is zeroed
+ * @return NULL on error, a pointer to the new element otherwise
+ */
+void *gfc_array_append(gfcArray *array,const void *element);
+
+/**
+ * @brief get a pointer to the nth element
+ * @param array the array to pull from
+ * @param n which element
+ * @return NULL on error or out of range, a pointer to the element otherwise
+ */
+void *gfc_array_get_nth(gfcArray *array,Uint32 n);
+
+/**
+ * @brief copy data over the nth element
+ * @param array the array to change
+ * @param n which element
+ * @param element the data to copy in
+ */
+void gfc_array_set_nth(gfcArray *array,Uint32 n,const void *element);
+
+/**
+ * @brief delete the nth element, keeping the order of the array
+ * @return -1 on error, 0 otherwise
+ */
+int gfc_array_delete_nth(gfcArray *array,Uint32 n);
+
+/**
+ * @brief delete the nth element by moving the last element into its place
+ * @note this is constant time but does NOT preserve the order of the array
+ * @return -1 on error, 0 otherwise
+ */
+int gfc_array_swap_remove_nth(gfcArray *array,Uint32 n);
+
+/**
+ * @brief empty the array, keeping its memory for reuse
+ * @param array the array to clear
+ */
+void gfc_array_clear(gfcArray *array);
+
+/**
+ * @brief get the number of elements in the array
+ * @param array the array to check
+ * @return the count, 0 if array is NULL
+ */
+Uint32 gfc_array_get_count(gfcArray *array);
+
+/**
+ * @brief sort the array in place
+ * @param array the array to sort
+ * @param compare qsort style comparison, it is given pointers to two elements
+ */
+void gfc_array_sort(gfcArray *array,int (*compare)(const void *a,const void *b));
+
+/**
+ * @brief call function for each element in the array
+ * @param array the array to iterate over
+ * @param function called with a pointer to each element in order
+ */
+void gfc_array_foreach(gfcArray *array,gfc_work_func function);
+
+/**
+ * @brief call function for each element in the array with some context
+ * @param array the array to iterate over
+ * @param function called with a pointer to each element in order and contextData
+ * @param contextData passed to every call of function
+ */
+void gfc_array_foreach_context(gfcArray *array,gfc_work_func_context function,void *contextData);
+
+#endif
@@ -10,23 +10,31 @@
 #include "gfc_text.h"
 #include "gfc_list.h"
 #include "gfc_hashmap.h"
-
-typedef struct
-{
-    int channel;        /**<which channel to play it on*/
-    int current;        /**<which sound is currently being played*/
-    gfcList *sequence;     /**<list of Sound pointers to be played in sequence*/
-}SoundSequence;
+#include "gfc_callbacks.h"
 
 typedef struct
 {
     Uint32 ref_count;
-    TextLine filepath;  /**<the sound file that was loaded*/
+    gfcString filepath; /**<the sound file that was loaded, see gfc_string_cstr()*/
     Mix_Chunk *sound;
     float volume;
     int defaultChannel;
 }Sound;
 
+/**
+ * @brief a queued sequence of sounds.  These are preallocated by the audio system and handed between
+ * the game and audio threads, so they are never allocated or freed while audio is playing
+ */
+typedef struct SoundSequence_S
+{
+    int channel;        /**<which channel to play it on*/
+    Uint32 current;     /**<which sound is next to be played*/
+    Uint32 count;       /**<how many sounds are in the sequence*/
+    Uint32 size;        /**<how many sounds there is room for*/
+    Sound **sounds;     /**<the Sound pointers to be played in sequence*/
+    struct SoundSequence_S *next;  /**<the next sequence queued on the same channel*/
+}SoundSequence;
+
 /**
  * @brief initializes the audio system based on the passed in parameters
  * @param maxSounds the maximum number of sounds that can be loaded into memory at once
@@ -48,6 +56,7 @@ void gfc_audio_init(
  * @brief load a music file (ogg or mp3 or other supported music file) from disk or pak
  * @param filename the name of the file (or path to it in the pak file)
  * @return NULL on error or a pointer to the music file.  Clean it up with Mix_FreeMusic(Mix_Music *music)
+ * @note the music is streamed from the file as it plays, see gfc_pak_file_open_rw()
  */
 Mix_Music *gfc_sound_load_music(const char *filename);
 
@@ -60,6 +69,16 @@ Mix_Music *gfc_sound_load_music(const char *filename);
  */
 Sound *gfc_sound_load(const char *filename,float volume,int defaultChannel);
 
+/**
+ * @brief same as gfc_sound_load(), but decodes the sound as it is read from disk or the pak.
+ * Use it for large sounds, so the whole compressed file is never held in memory or in the pak extraction cache
+ * @param filename the file to load
+ * @param volume how loud the sound should be on a scale from 0 to 1.0
+ * @param defaultChannel which channel to play this sound on if not specified
+ * @return NULL on error or a pointer to the sound file
+ */
+Sound *gfc_sound_load_streamed(const char *filename,float volume,int defaultChannel);
+
 /**
  * @brief play a sound file that has been loaded
  * @param loops number of times to loop,  0 means play once, no loops
@@ -75,6 +94,14 @@ void gfc_sound_play(Sound *sound,int loops,float volume,int channel,int group);
  */
 void gfc_sound_free(Sound *sound);
 
+/**
+ * @brief free every loaded sound that is no longer referenced
+ * @note sounds whose ref count drops to zero stay loaded so they can be handed back out by gfc_sound_load()
+ * until their slot is needed.  Call this to release them all at once, such as between levels
+ * @return how many sounds were freed
+ */
+Uint32 gfc_sound_purge_unused();
+
 /**
  * @brief frees all sounds from memory.  This will invalidate any help Sound pointers
  */
@@ -94,6 +121,24 @@ HashMap *gfc_sound_pack_parse_file(const char *filename);
  */
 HashMap *gfc_sound_pack_parse(SJson *sounds);
 
+/**
+ * @brief decode every sound in a pack that is not loaded yet, in parallel on the pak loader's worker threads
+ * @param pack the sound pack to load
+ * @return how many sounds were loaded
+ * @note blocks until they are all done.  Only its own loads are delivered, other async pak loads are left for
+ * gfc_pak_poll_completions(), so it is safe to call from an async load callback.
+ * gfc_sound_pack_parse() calls this, so only packs built some other way need it
+ */
+Uint32 gfc_sound_pack_preload(HashMap *pack);
+
+/**
+ * @brief cache the sounds decoded by gfc_sound_pack_preload() on disk, as raw samples in the format gfc_audio_init() opened.
+ * Later preloads of the same files read the samples back instead of decoding them again
+ * @param directory where to keep the cache, it must already exist.  NULL to turn the cache off (the default)
+ * @note cached samples are matched to their source by a checksum of the file, so changed files are decoded again
+ */
+void gfc_sound_set_pcm_cache(const char *directory);
+
 /**
  * @brief player a sound from a sound pack by its name
  * @param pack the sound pack to play from
@@ -105,6 +150,17 @@ HashMap *gfc_sound_pack_parse(SJson *sounds);
  */
 void gfc_sound_pack_play(HashMap *pack, const char *name,int loops,float volume,int channel,int group);
 
+/**
+ * @brief play a sound from a sound pack by its interned name
+ * @param pack the sound pack to play from
+ * @param nameId the id returned from gfc_str_intern() for the sound name
+ * @param loops number of times to loop,  0 means play once, no loops
+ * @param volume how loud to play it
+ * @param channel which channel to play on, -1 means use default
+ * @param group which group to play on, -1 means use default
+ */
+void gfc_sound_pack_play_by_id(HashMap *pack, gfcStringId nameId,int loops,float volume,int channel,int group);
+
 /**
  * @brief free a previously loaded sound pack
  * @param pack the sound pack to free
@@ -117,8 +173,18 @@ void gfc_sound_pack_free(HashMap *pack);
  * @param channel the channel to play the sounds on
  * @note copies the sound list, so feel free to free the list provided.
  * @note it will not free or change the refcount for the sounds in the list, so keep them alive while needed
+ * @note sequences start from the audio thread within one mix buffer. Only queue them from one thread
  */
 void gfc_sound_queue_sequence(gfcList *sounds,int channel);
 
+/**
+ * @brief get told when a channel stops playing.  Channels finish on the audio thread, so the callback is posted to
+ * a queue and runs when that queue is drained
+ * @param queue the queue to post to
+ * @param callback called with the channel number as its data, ie: (int)(size_t)data.  NULL to stop
+ * @note set this while nothing is playing, such as right after gfc_audio_init(), and keep the queue until audio closes
+ */
+void gfc_sound_set_finished_callback(gfcCallbackQueue *queue,void (*callback)(void *data));
+
 
 #endif
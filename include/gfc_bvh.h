@@ -0,0 +1,120 @@
+#ifndef __GFC_BVH_H__
+#define __GFC_BVH_H__
+
+#include <SDL.h>
+
+#include "gfc_primitives.h"
+
+/**
+ * @purpose gfc_bvh is a bounding volume hierarchy over a triangle soup, for picking, line of sight and
+ * collision against meshes with too many triangles to test one by one.
+ * It is built once with a binned surface area heuristic, and can not be changed after.
+ * Leaf triangles are tested four at a time with SSE2 or NEON when they are available (see gfc_simd.h)
+ * @note edge tests are two sided and count a hit at t in (0,1], as gfc_triangle_edge_test() does.
+ * They use Moller-Trumbore rather than the plane and projection test in gfc_primitives, which misses some
+ * hits, so the results will not always match gfc_triangle_edge_test().
+ */
+typedef struct gfcTriangleBVH_S gfcTriangleBVH;
+
+/**
+ * @brief what a bvh query hit
+ */
+typedef struct
+{
+    Uint32      triangle;   /**<index of the triangle in the array the bvh was built from*/
+    float       t;          /**<for edges how far along the edge it hit, 0 at a to 1 at b. For spheres the distance from the center*/
+    Vector3D    poc;        /**<point of contact*/
+    Vector3D    normal;     /**<for edges the face normal, by winding as gfc_triangle_get_normal(). For spheres from the poc toward the center*/
+}gfcBVHHit;
+
+/**
+ * @brief called for each triangle found by gfc_triangle_bvh_sphere_query()
+ * @param triangle index of the triangle in the array the bvh was built from
+ * @param context the context passed to the query
+ * @return 0 to stop the query, anything else to keep going
+ */
+typedef Uint8 (*gfcTriangleBVHQueryFunc)(Uint32 triangle,void *context);
+
+/**
+ * @brief build a bvh from an array of triangles
+ * @param triangles the triangles, they are copied
+ * @param count how many triangles there are
+ * @return NULL on error, the bvh otherwise.  Free with gfc_triangle_bvh_free()
+ */
+gfcTriangleBVH *gfc_triangle_bvh_new(Triangle3D *triangles,Uint32 count);
+
+/**
+ * @brief build a bvh from an array of triangles, splitting the build across threads
+ * @note the tree built is the same as gfc_triangle_bvh_new() would build
+ * @param triangles the triangles, they are copied
+ * @param count how many triangles there are
+ * @param threads how many threads to build with, 0 to pick from the cpu count.  Runs on the gfc_jobs pool when it is started
+ * @return NULL on error, the bvh otherwise.  Free with gfc_triangle_bvh_free()
+ */
+gfcTriangleBVH *gfc_triangle_bvh_new_threaded(Triangle3D *triangles,Uint32 count,Uint32 threads);
+
+/**
+ * @brief free a bvh
+ * @param bvh the bvh to free
+ */
+void gfc_triangle_bvh_free(gfcTriangleBVH *bvh);
+
+/**
+ * @brief get how many triangles a bvh was built with
+ * @param bvh the bvh to check
+ * @return the count
+ */
+Uint32 gfc_triangle_bvh_get_count(gfcTriangleBVH *bvh);
+
+/**
+ * @brief get a triangle from the bvh
+ * @param bvh the bvh
+ * @param n index of the triangle in the array the bvh was built from
+ * @return NULL if out of range, the triangle otherwise
+ */
+const Triangle3D *gfc_triangle_bvh_get_triangle(gfcTriangleBVH *bvh,Uint32 n);
+
+/**
+ * @brief get the box around every triangle in the bvh
+ * @param bvh the bvh to check
+ * @return the bounds, a zero box if the bvh is empty
+ */
+Box gfc_triangle_bvh_get_bounds(gfcTriangleBVH *bvh);
+
+/**
+ * @brief find the triangle an edge hits nearest its start
+ * @param bvh the bvh to search
+ * @param e the edge to test with (from a to b)
+ * @param hit [optional] if provided this will be populated with the hit
+ * @return 0 if nothing was hit, 1 otherwise
+ */
+Uint8 gfc_triangle_bvh_edge_test(gfcTriangleBVH *bvh,Edge3D e,gfcBVHHit *hit);
+
+/**
+ * @brief check if an edge hits any triangle, which is faster than finding the nearest.  Good for line of sight
+ * @param bvh the bvh to search
+ * @param e the edge to test with (from a to b)
+ * @return 0 if nothing was hit, 1 otherwise
+ */
+Uint8 gfc_triangle_bvh_edge_test_any(gfcTriangleBVH *bvh,Edge3D e);
+
+/**
+ * @brief find the triangle nearest the center of a sphere that is touching the sphere
+ * @param bvh the bvh to search
+ * @param s the sphere to test
+ * @param hit [optional] if provided this will be populated with the hit
+ * @return 0 if no triangle touches the sphere, 1 otherwise
+ */
+Uint8 gfc_triangle_bvh_sphere_test(gfcTriangleBVH *bvh,Sphere s,gfcBVHHit *hit);
+
+/**
+ * @brief find every triangle that touches a sphere
+ * @param bvh the bvh to search
+ * @param s the sphere to test
+ * @param func (optional) called for each triangle found
+ * @param context passed to func
+ * @return how many triangles were found
+ */
+Uint32 gfc_triangle_bvh_sphere_query(gfcTriangleBVH *bvh,Sphere s,gfcTriangleBVHQueryFunc func,void *context);
+
+#endif
@@ -1,14 +1,92 @@
 #ifndef __GFC_CALLBACKS_H__
 #define __GFC_CALLBACKS_H__
 
+#include <SDL.h>
+
+#include "gfc_allocator.h"
+
 typedef struct
 {
     void *data;
     void (*callback)(void *data);
+    gfcAllocator *allocator;    /**<where the callback lives, NULL for the heap*/
 }Callback;
 
+/**
+ * @brief a queue of callbacks to run later, at a point in the frame of your choosing
+ * Callbacks can be posted from any thread, but only one thread may drain the queue.  This is how work done on the audio
+ * thread or in jobs gets its results back to the main thread safely: post there, drain on the main thread.
+ * Callbacks run in the order they were posted.
+ */
+typedef struct
+{
+    void           *posted;     /**<callbacks posted since the last drain, newest first.  Any thread pushes onto this*/
+    void           *head;       /**<callbacks waiting to run in order, only the draining thread touches these*/
+    void           *tail;
+    SDL_atomic_t    count;      /**<how many callbacks are waiting*/
+    gfcPool        *pool;       /**<where the queue nodes come from*/
+    SDL_SpinLock    poolLock;
+}gfcCallbackQueue;
+
 Callback *gfc_callback_new(void (*callback)(void *data),void *data);
+
+/**
+ * @brief make a new callback from an allocator, a gfcPool of sizeof(Callback) suits these well
+ * @param callback the function to call
+ * @param data passed to the function
+ * @param allocator where to allocate the callback from, NULL for the heap
+ * @return NULL on error, the callback otherwise.  gfc_callback_free() returns it to the allocator
+ */
+Callback *gfc_callback_new_allocator(void (*callback)(void *data),void *data,gfcAllocator *allocator);
 void gfc_callback_free(Callback *callback);
 void gfc_callback_call(Callback *callback);
 
+/**
+ * @brief make a new callback queue
+ * @param count how many callbacks to make room for at a time.  More room is made as needed, 0 for a default of 64
+ * @return NULL on error, the queue otherwise.  Free with gfc_callback_queue_free()
+ */
+gfcCallbackQueue *gfc_callback_queue_new(Uint32 count);
+
+/**
+ * @brief free a callback queue.  Callbacks still in it are not called
+ * @param queue the queue to free
+ */
+void gfc_callback_queue_free(gfcCallbackQueue *queue);
+
+/**
+ * @brief post a callback to a queue to be run the next time it is drained.  Safe from any thread
+ * @param queue the queue to post to
+ * @param callback the function to call
+ * @param data passed to the function
+ * @return -1 on error (out of memory), 0 otherwise
+ * @note room is made when the queue is out of it, so size the queue to avoid allocating on the audio thread
+ */
+int gfc_callback_queue_post(gfcCallbackQueue *queue,void (*callback)(void *data),void *data);
+
+/**
+ * @brief post a copy of a callback to a queue.  The callback itself can be freed right after
+ * @param queue the queue to post to
+ * @param callback the callback to copy
+ * @return -1 on error, 0 otherwise
+ */
+int gfc_callback_queue_post_callback(gfcCallbackQueue *queue,Callback *callback);
+
+/**
+ * @brief run the callbacks in a queue, in the order they were posted
+ * callbacks posted while draining wait for the next drain, so a callback that posts itself again does not loop forever
+ * @param queue the queue to drain.  Only drain a queue from one thread
+ * @param budget how many milliseconds to spend, 0 for no limit.  At least one callback is run each drain,
+ * and the ones left over run first next time
+ * @return how many callbacks were run
+ */
+Uint32 gfc_callback_queue_drain(gfcCallbackQueue *queue,float budget);
+
+/**
+ * @brief get how many callbacks are waiting in a queue
+ * @param queue the queue to check
+ * @return the count
+ */
+Uint32 gfc_callback_queue_get_count(gfcCallbackQueue *queue);
+
 #endif
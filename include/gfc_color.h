@@ -4,6 +4,16 @@
 #include <SDL.h>
 #include "gfc_vector.h"
 
+/**
+ * the color constructors are defined in this header so they can be inlined, gfc_color.c defines
+ * GFC_COLOR_IMPLEMENTATION to export the out of line versions.  See gfc_vector.h
+ */
+#ifdef GFC_COLOR_IMPLEMENTATION
+#define GFC_COLOR_INLINE
+#else
+#define GFC_COLOR_INLINE static inline
+#endif
+
 typedef enum
 {
     CT_RGBAf,   /**<RGBA in floating point 0-1*/
@@ -54,7 +64,16 @@ typedef struct
  * @param a alpha value 0 - 1
  * @returns a newly set color
  */
-Color gfc_color(float r,float g,float b,float a);
+GFC_COLOR_INLINE Color gfc_color(float r,float g,float b,float a)
+{
+    Color color;
+    color.r = MIN(MAX(r,-1),1);
+    color.g = MIN(MAX(g,-1),1);
+    color.b = MIN(MAX(b,-1),1);
+    color.a = MIN(MAX(a,-1),1);
+    color.ct = CT_RGBAf;
+    return color;
+}
 
 /**
  * @brief check if two colors are the same color
@@ -72,7 +91,16 @@ int gfc_color_cmp(Color a, Color b);
  * @param a alpha value 0 - 255
  * @returns a newly set color
  */
-Color gfc_color8(Uint8 r,Uint8 g,Uint8 b,Uint8 a);
+GFC_COLOR_INLINE Color gfc_color8(Uint8 r,Uint8 g,Uint8 b,Uint8 a)
+{
+    Color color;
+    color.r = (float)r;
+    color.g = (float)g;
+    color.b = (float)b;
+    color.a = (float)a;
+    color.ct = CT_RGBA8;
+    return color;
+}
 /**
  * @brief create and return a color from floating point RGBA values
  * @param h hue value 0 - 360
@@ -87,7 +115,13 @@ Color gfc_color_hsl(float h,float s,float l,float a);
  * @param hex the hex value of the color
  * @returns a newly set color
  */
-Color gfc_color_hex(Uint32 hex);
+GFC_COLOR_INLINE Color gfc_color_hex(Uint32 hex)
+{
+    Color color;
+    color.r = (float)hex;
+    color.ct = CT_HEX;
+    return color;
+}
 
 /**
  * @brief convert a color to floating point representation
@@ -123,7 +157,17 @@ Uint32 gfc_color_to_hex(Color color);
  * @param color the color to convert
  * @return a new color in the format CT_RGBAf
  */
-Color gfc_color_from_sdl(SDL_Color color);
+GFC_COLOR_INLINE Color gfc_color_from_sdl(SDL_Color color)
+{
+    Color nc;
+    float factor = 1.0/255.0;
+    nc.ct = CT_RGBAf;
+    nc.r = color.r *factor;
+    nc.g = color.g *factor;
+    nc.b = color.b *factor;
+    nc.a = color.a *factor;
+    return nc;
+}
 
 /**
  * @brief convert a gfc color to SDL color format
@@ -137,14 +181,32 @@ SDL_Color gfc_color_to_sdl(Color color);
  * @param vector the vector to convert
  * @return a new color in the format CT_RGBA8
  */
-Color gfc_color_from_vector4(Vector4D vector);
+GFC_COLOR_INLINE Color gfc_color_from_vector4(Vector4D vector)
+{
+    Color color;
+    color.ct = CT_RGBA8;
+    color.r = vector.x;
+    color.g = vector.y;
+    color.b = vector.z;
+    color.a = vector.w;
+    return color;
+}
 
 /**
  * @brief create a color from a vector where x = r, y = g, z = b, w = a
  * @param vector the vector to convert
  * @return a new color in the format CT_RGBAf
  */
-Color gfc_color_from_vector4f(Vector4D vector);
+GFC_COLOR_INLINE Color gfc_color_from_vector4f(Vector4D vector)
+{
+    Color color;
+    color.ct = CT_RGBAf;
+    color.r = vector.x;
+    color.g = vector.y;
+    color.b = vector.z;
+    color.a = vector.w;
+    return color;
+}
 
 /**
  * @brief convert a color to a vector where x = r, y = g, z = b, w = a
@@ -210,5 +272,48 @@ void gfc_color_multiply(Color *dst,Color a,Color b);
  */
 Color gfc_color_clamp(Color color);
 
+/**
+ * The array functions below pack colors into Uint32 pixels four at a time with SSE2 or NEON when they are
+ * available (see gfc_simd.h).  Channels are clamped to 0-1, scaled to 0-255 and truncated, as gfc_color_to_sdl() does.
+ * RGBA8 is packed as gfc_color_to_hex() does it: red in the high byte and alpha in the low, SDL_PIXELFORMAT_RGBA8888
+ */
+
+/**
+ * @brief pack an array of colors into RGBA8
+ * @param dst where to write count pixels
+ * @param colors the colors to pack, they can be of any format and may be mixed
+ * @param count how many colors there are
+ */
+void gfc_colors_to_int8(Uint32 *dst,const Color *colors,Uint32 count);
+
+/**
+ * @brief convert an array of hue,saturation,lightness,alpha colors to RGBA8
+ * @param dst where to write count pixels
+ * @param colors the colors to convert.  Their format is not checked, each is read as h,s,l,a
+ * @param count how many colors there are
+ */
+void gfc_colors_hsl_to_rgb(Uint32 *dst,const Color *colors,Uint32 count);
+
+/**
+ * @brief blend two arrays of colors and pack the results into RGBA8
+ * @param dst where to write count pixels
+ * @param a the colors at t = 0, of any format
+ * @param b the colors at t = 1, of any format
+ * @param t how far to blend from a to b.  0.5 gives the same as gfc_color_blend() for RGB colors
+ * @param count how many colors there are in each array
+ * @note colors are blended in RGB, even when both are CT_HSL
+ */
+void gfc_colors_blend(Uint32 *dst,const Color *a,const Color *b,float t,Uint32 count);
+
+/**
+ * @brief pack an array of colors straight into a surface pixel format
+ * @param pixels where to write count pixels of format->BytesPerPixel each, ie: a row of surface->pixels
+ * @param colors the colors to pack, of any format
+ * @param count how many colors there are
+ * @param format the pixel format to pack to, ie: surface->format
+ * @note 32 bit formats with 8 bits per channel are packed directly, others go through SDL_MapRGBA()
+ */
+void gfc_colors_to_pixels(void *pixels,const Color *colors,Uint32 count,const SDL_PixelFormat *format);
+
 
  #endif
@@ -0,0 +1,155 @@
+#ifndef __GFC_CONFIG_BLOB_H__
+#define __GFC_CONFIG_BLOB_H__
+
+#include <SDL.h>
+#include "simple_json.h"
+#include "gfc_text.h"
+
+/**
+ * @purpose a compiled config def file is a flat blob that can be mapped and searched without parsing any json.
+ * It holds, for every resource list in a config def file, a hash table of its defs by "name", the name of every def
+ * and the json text of every def.  The json of a def is only parsed the first time the def itself is asked for.
+ * Build one with gfc_config_blob_compile() or tools/gfc_config_build, see gfc_config_def_load() for how they are found.
+ * @note blobs are written in the byte order of the machine that built them, and are rejected on any other
+ */
+
+#define GFC_CONFIG_BLOB_EXT ".gcd"      /**<the extension of compiled config def files*/
+#define GFC_CONFIG_BLOB_VERSION 1
+#define GFC_CONFIG_BLOB_NONE 0xFFFFFFFF /**<a def with no "name" string*/
+
+typedef struct
+{
+    char   magic[4];        /**<"GCDB"*/
+    Uint32 version;         /**<GFC_CONFIG_BLOB_VERSION*/
+    Uint32 sourceCrc;       /**<crc32 of the json file it was compiled from*/
+    Uint32 size;            /**<of the whole blob, in bytes*/
+    Uint32 resourceCount;
+    Uint32 resources;       /**<offset of resourceCount GFC_ConfigBlobResource*/
+    Uint32 resourceSlots;   /**<size of the resource hash table, a power of two*/
+    Uint32 resourceTable;   /**<offset of the resource hash table, each slot is 0 for empty or 1 + a resource index*/
+    Uint32 defCount;
+    Uint32 defs;            /**<offset of defCount GFC_ConfigBlobDef, grouped by resource*/
+    Uint32 slotCount;
+    Uint32 slots;           /**<offset of every resource's name hash table, packed together*/
+    Uint32 strings;         /**<offset of the nul terminated strings*/
+    Uint32 stringsSize;
+    Uint32 text;            /**<offset of the json text of the defs*/
+    Uint32 textSize;
+}GFC_ConfigBlobHeader;
+
+typedef struct
+{
+    Uint32 name;            /**<offset in strings*/
+    Uint32 nameLength;
+    Uint32 hash;            /**<gfc_string_hash_seeded() of the name with GFC_STRING_HASH_SEED*/
+    Uint32 firstDef;
+    Uint32 defCount;
+    Uint32 nameSlots;       /**<index of its first slot in slots, each slot is 0 for empty or 1 + a def index in the resource*/
+    Uint32 nameSlotCount;   /**<a power of two, 0 if no def has a name*/
+}GFC_ConfigBlobResource;
+
+typedef struct
+{
+    Uint32 text;            /**<offset in text*/
+    Uint32 textLength;
+    Uint32 name;            /**<offset of its "name" in strings, GFC_CONFIG_BLOB_NONE if it has none*/
+    Uint32 nameLength;
+    Uint32 hash;
+}GFC_ConfigBlobDef;
+
+typedef struct
+{
+    const void                    *map;         /**<from gfc_pak_file_map()*/
+    void                          *copy;        /**<an aligned copy, if the mapping was not aligned*/
+    const GFC_ConfigBlobHeader    *header;
+    const GFC_ConfigBlobResource  *resources;
+    const Uint32                  *resourceTable;
+    const GFC_ConfigBlobDef       *defs;
+    const Uint32                  *slots;
+    const char                    *strings;
+    const char                    *text;
+    SJson                        **parsed;      /**<for each def, its json once it has been asked for*/
+    SJson                        **lists;       /**<for each resource, a json array of its defs once it has been asked for*/
+}GFC_ConfigBlob;
+
+/**
+ * @brief get the name of the compiled form of a config def file, its .json extension is replaced if it has one
+ * @param filename the json file
+ * @param compiled [output] the name gfc_config_def_load() looks for
+ * @return -1 if the name would not fit, 0 otherwise
+ */
+int gfc_config_blob_get_name(const char *filename,TextLine compiled);
+
+/**
+ * @brief compile a config def json file into a blob
+ * @param filename the json file to compile, loaded through the pak manager
+ * @param outFile where to write the blob
+ * @return -1 on error or if a resource list holds anything but objects, 0 otherwise
+ */
+int gfc_config_blob_compile(const char *filename,const char *outFile);
+
+/**
+ * @brief map a compiled config def file and check that it is sound
+ * @param filename the blob to load, through the pak manager
+ * @return NULL if it could not be loaded or is not a valid blob, the blob otherwise
+ */
+GFC_ConfigBlob *gfc_config_blob_load(const char *filename);
+
+/**
+ * @brief unmap a blob and free every def that was parsed from it
+ * @param blob the blob to free
+ */
+void gfc_config_blob_free(GFC_ConfigBlob *blob);
+
+/**
+ * @brief find a resource list in a blob
+ * @param blob the blob to search
+ * @param resource the name of the list
+ * @return -1 if it is not there, its index otherwise
+ */
+int gfc_config_blob_find_resource(GFC_ConfigBlob *blob,const char *resource);
+
+/**
+ * @brief get how many defs a resource list has
+ * @param blob the blob
+ * @param resource a resource index from gfc_config_blob_find_resource()
+ * @return 0 on error, the count otherwise
+ */
+Uint32 gfc_config_blob_get_def_count(GFC_ConfigBlob *blob,int resource);
+
+/**
+ * @brief find a def in a resource list by its "name", through the list's hash table
+ * @param blob the blob
+ * @param resource a resource index from gfc_config_blob_find_resource()
+ * @param name the name to find
+ * @return -1 if it is not there, the index of the first def with that name in the list otherwise
+ */
+int gfc_config_blob_find_def(GFC_ConfigBlob *blob,int resource,const char *name);
+
+/**
+ * @brief get the "name" of a def without parsing it
+ * @param blob the blob
+ * @param resource a resource index from gfc_config_blob_find_resource()
+ * @param n the index of the def in the list
+ * @return NULL if it has none or on error, the name otherwise.  It lives as long as the blob
+ */
+const char *gfc_config_blob_get_def_name(GFC_ConfigBlob *blob,int resource,Uint32 n);
+
+/**
+ * @brief get the json of a def, parsing it the first time it is asked for
+ * @param blob the blob
+ * @param resource a resource index from gfc_config_blob_find_resource()
+ * @param n the index of the def in the list
+ * @return NULL on error, the json otherwise.  It is owned by the blob, do not free it
+ */
+SJson *gfc_config_blob_get_def(GFC_ConfigBlob *blob,int resource,Uint32 n);
+
+/**
+ * @brief get a whole resource list as a json array, made from copies of its defs the first time it is asked for
+ * @param blob the blob
+ * @param resource a resource index from gfc_config_blob_find_resource()
+ * @return NULL on error, the json array otherwise.  It is owned by the blob, do not free it
+ */
+SJson *gfc_config_blob_get_list(GFC_ConfigBlob *blob,int resource);
+
+#endif
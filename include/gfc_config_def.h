@@ -19,6 +19,8 @@
  * }
  * You can load multiple files that all follow this format and the system will keep track of them and search them all.
  * As long as the list names never repeat, this will work
+ * A file can also be compiled ahead of time into a .gcd blob (see gfc_config_blob.h) which is searched without parsing any json,
+ * each def is only parsed the first time it is asked for.
  */
 
 /**
@@ -28,7 +30,9 @@ void gfc_config_def_init();
 
 /**
  * @brief load config definition lists for a game resource
- * @param filename the json file containing the info
+ * If filename ends in .gcd it is loaded as a compiled blob.  Otherwise if its compiled form (from gfc_config_blob_get_name())
+ * exists and was built from the json as it is now, that is loaded instead.  A stale blob is reported and the json is used.
+ * @param filename the json file containing the info, or its compiled form
  */
 void gfc_config_def_load(const char *filename);
 
@@ -81,4 +85,36 @@ SJson *gfc_config_def_get_value(const char *resource, const char *name, const ch
  */
 Uint32 gfc_config_def_get_resource_count(const char *resource);
 
+/**
+ * @brief load a config def file again, replacing what was loaded from it
+ * The file is parsed before anything is replaced, so if it fails to load what was there before is kept.
+ * Only the resource lists that could come from this file are indexed again, others are left alone.
+ * @param filename a file previously loaded with gfc_config_def_load()
+ * @return -1 on error, 0 otherwise
+ * @note json returned from the old file is freed, subscribers should get their defs again when told
+ */
+int gfc_config_def_reload(const char *filename);
+
+/**
+ * @brief reload config def files automatically when they change, see gfc_watch.h
+ * @param enable if set, loaded files (and any loaded later) are watched, otherwise they are not
+ * @note changes are picked up by gfc_watch_update()
+ */
+void gfc_config_def_watch(Uint8 enable);
+
+/**
+ * @brief be told when a resource list is reloaded
+ * @param resource the name of the resource list
+ * @param onReload called after a reload of the file it comes from, or one that now has it or no longer does
+ * @param data passed to onReload
+ * @return 0 on error, an id for gfc_config_def_unsubscribe() otherwise
+ */
+Uint32 gfc_config_def_subscribe(const char *resource,void (*onReload)(void *data),void *data);
+
+/**
+ * @brief stop being told about a resource list.  It is safe to call from an onReload callback
+ * @param subscriptionId the id returned from gfc_config_def_subscribe()
+ */
+void gfc_config_def_unsubscribe(Uint32 subscriptionId);
+
 #endif
@@ -0,0 +1,97 @@
+#ifndef __GFC_DEQUE_H__
+#define __GFC_DEQUE_H__
+
+#include <SDL.h>
+
+/**
+ * @brief the GFC Deque is an automatically expanding double ended queue
+ * the deque stores data pointers in a ring buffer, so adding or removing at either end is constant time
+ */
+typedef struct
+{
+    void **elements;
+    Uint32 size;        /**<always a power of two*/
+    Uint32 head;        /**<index of the first element*/
+    Uint32 count;
+}gfcDeque;
+
+/**
+ * @brief allocate a new empty deque
+ * @return NULL on memory error or a new empty deque
+ */
+gfcDeque *gfc_deque_new();
+
+/**
+ * @brief allocate a new empty deque with room for at least count elements
+ * @param count how many elements you wish to support before it needs to grow
+ * @return NULL on memory error or a new empty deque
+ */
+gfcDeque *gfc_deque_new_size(Uint32 count);
+
+/**
+ * @brief free a deque
+ * @note does not free any of the data the deque points to
+ * @param deque the deque to free
+ */
+void gfc_deque_delete(gfcDeque *deque);
+
+/**
+ * @brief add an element to the front of the deque
+ * @param deque the deque to add to
+ * @param data the data to add
+ * @return -1 on error (out of memory), 0 otherwise
+ */
+int gfc_deque_push_front(gfcDeque *deque,void *data);
+
+/**
+ * @brief add an element to the back of the deque
+ * @param deque the deque to add to
+ * @param data the data to add
+ * @return -1 on error (out of memory), 0 otherwise
+ */
+int gfc_deque_push_back(gfcDeque *deque,void *data);
+
+/**
+ * @brief remove and return the element at the front of the deque
+ * @param deque the deque to remove from
+ * @return NULL if empty or error, the data otherwise
+ */
+void *gfc_deque_pop_front(gfcDeque *deque);
+
+/**
+ * @brief remove and return the element at the back of the deque
+ * @param deque the deque to remove from
+ * @return NULL if empty or error, the data otherwise
+ */
+void *gfc_deque_pop_back(gfcDeque *deque);
+
+/**
+ * @brief get the nth element from the front of the deque without removing it
+ * @param deque the deque to search
+ * @param n which element, 0 is the front
+ * @return NULL on error or out of range, the data otherwise
+ */
+void *gfc_deque_get_nth(gfcDeque *deque,Uint32 n);
+
+/**
+ * @brief remove the first element pointing to data, keeping the order of the rest
+ * @param deque the deque to remove from
+ * @param data the data to match
+ * @return -1 if not found or error, 0 otherwise
+ */
+int gfc_deque_delete_data(gfcDeque *deque,void *data);
+
+/**
+ * @brief get the number of elements in the deque
+ * @param deque the deque to check
+ * @return the count, 0 if deque is NULL
+ */
+Uint32 gfc_deque_get_count(gfcDeque *deque);
+
+/**
+ * @brief empty the deque without freeing any of the data it points to
+ * @param deque the deque to clear
+ */
+void gfc_deque_clear(gfcDeque *deque);
+
+#endif
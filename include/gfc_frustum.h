@@ -0,0 +1,94 @@
+#ifndef __GFC_FRUSTUM_H__
+#define __GFC_FRUSTUM_H__
+
+#include <SDL.h>
+
+#include "gfc_matrix.h"
+#include "gfc_primitives.h"
+
+/**
+ * @purpose gfc_frustum pulls the six clip planes out of a view projection matrix and tests bounding volumes against them.
+ * The batch functions cull four volumes at a time with SSE2 or NEON when they are available (see gfc_simd.h)
+ * @note tests are conservative: a volume is only culled if it is completely behind one of the planes,
+ * so some volumes near the corners of the frustum are kept even though they are not in view
+ */
+
+typedef enum
+{
+    FP_LEFT,
+    FP_RIGHT,
+    FP_BOTTOM,
+    FP_TOP,
+    FP_NEAR,
+    FP_FAR,
+    FP_MAX
+}FrustumPlanes;
+
+typedef struct
+{
+    Plane3D planes[FP_MAX];  /**<normalized, with the normals pointing into the frustum*/
+}gfcFrustum;
+
+/**
+ * @brief how many Uint32 words a visibility mask for count volumes needs
+ */
+#define gfc_frustum_mask_words(count) (((count) + 31) / 32)
+
+/**
+ * @brief check if the nth volume was visible in a mask
+ */
+#define gfc_frustum_visible(mask,n) (((mask)[(n) >> 5] >> ((n) & 31)) & 1)
+
+/**
+ * @brief get the frustum planes from a view projection matrix
+ * @param viewproj the matrix that takes world points to clip space as v * viewproj,
+ * ie: gfc_matrix_multiply(viewproj,view,proj).  Clip space depth is -w to w, as gfc_matrix_perspective() makes
+ * @return the frustum
+ */
+gfcFrustum gfc_frustum_from_matrix(Matrix4 viewproj);
+
+/**
+ * @brief check if a point is inside the frustum
+ * @param f the frustum
+ * @param p the point to check
+ * @return 1 if it is inside, 0 if not
+ */
+Uint8 gfc_frustum_test_point(gfcFrustum *f,Vector3D p);
+
+/**
+ * @brief check if a sphere may be in view
+ * @param f the frustum
+ * @param s the sphere to check
+ * @return 0 if it is completely outside, 1 otherwise
+ */
+Uint8 gfc_frustum_test_sphere(gfcFrustum *f,Sphere s);
+
+/**
+ * @brief check if a box may be in view
+ * @param f the frustum
+ * @param b the box to check
+ * @return 0 if it is completely outside, 1 otherwise
+ */
+Uint8 gfc_frustum_test_box(gfcFrustum *f,Box b);
+
+/**
+ * @brief test an array of spheres against the frustum
+ * @param f the frustum
+ * @param spheres the spheres to test
+ * @param count how many spheres there are
+ * @param visible (optional) gfc_frustum_mask_words(count) words that will be set to the visibility mask
+ * @return how many spheres may be in view
+ */
+Uint32 gfc_frustum_cull_spheres(gfcFrustum *f,Sphere *spheres,Uint32 count,Uint32 *visible);
+
+/**
+ * @brief test an array of boxes against the frustum
+ * @param f the frustum
+ * @param boxes the boxes to test
+ * @param count how many boxes there are
+ * @param visible (optional) gfc_frustum_mask_words(count) words that will be set to the visibility mask
+ * @return how many boxes may be in view
+ */
+Uint32 gfc_frustum_cull_boxes(gfcFrustum *f,Box *boxes,Uint32 count,Uint32 *visible);
+
+#endif
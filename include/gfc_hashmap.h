@@ -25,19 +25,34 @@
 #include "gfc_text.h"
 #include "gfc_types.h"
 #include "gfc_list.h"
+#include "gfc_string.h"
+
+/**
+ * @brief handle to an interned string.  Two ids are equal if and only if their strings are equal
+ */
+typedef Uint32 gfcStringId;
+#define GFC_STRING_ID_NONE 0
 
 typedef struct
 {
-    TextLine key;
-    Uint32 hashValue;
+    gfcString key;      /**<short keys are stored in the slot, long ones are allocated from the map's allocator*/
+    Uint32 hashValue;   /**<full hash of the key, zero marks an empty slot*/
+    gfcStringId keyId;  /**<interned id of the key, if known.  Set on first lookup by id*/
     void *data;
 }HashElement;
 
+/**
+ * @brief the GFC HashMap is an open addressing (robin hood) hash table
+ * elements are stored inline in a flat array whose size is always a power of two
+ */
 typedef struct
 {
-    gfcList* map;      /**<the hash values*/
-    Uint32 size;    /**<how many values are available in the hash*/
+    HashElement *elements;  /**<the slots of the table*/
+    Uint32 size;    /**<how many slots are available in the hash*/
+    Uint32 count;   /**<how many slots are in use*/
     Uint32 seed;    /**<the seed to calculate the hashed*/
+    gfcAllocator *allocator;    /**<where the map and its slots live, NULL for the heap*/
+    Uint32 longKeys;            /**<keys too long to be stored in their slot, freed with the map*/
 }HashMap;
 
 /**
@@ -47,6 +62,23 @@ typedef struct
  */
 HashMap *gfc_hashmap_new();
 
+/**
+ * @brief allocate and initialize an empty hashmap with room for at least count items
+ * @param count how many items you expect to store.  The table will grow as needed past this
+ * @returns NULL on error or an empty hashmap otherwise
+ * @note must be freed with gfc_hashmap_free();
+ */
+HashMap *gfc_hashmap_new_size(Uint32 count);
+
+/**
+ * @brief allocate and initialize an empty hashmap from an allocator
+ * @note the map grows and is freed through the same allocator.  An arena can release it with a reset instead
+ * @param count how many items you expect to store.  The table will grow as needed past this
+ * @param allocator where to allocate the map from, NULL for the heap
+ * @returns NULL on error or an empty hashmap otherwise
+ */
+HashMap *gfc_hashmap_new_size_allocator(Uint32 count,gfcAllocator *allocator);
+
 /**
  * @brief free a previously allocated hashmap
  * @param map the hashmap to free
@@ -58,6 +90,7 @@ void gfc_hashmap_free(HashMap *map);
  * @param map the map to add a value to
  * @param key the key to retreive the data with
  * @param data the data to keep track of
+ * @note if the key is already in the map, its data is replaced
  */
 void gfc_hashmap_insert(HashMap *map,const char *key,void *data);
 
@@ -75,6 +108,30 @@ void *gfc_hashmap_get(HashMap *map,const char *key);
  */
 void gfc_hashmap_delete_by_key(HashMap *map,const char *key);
 
+/**
+ * @brief add data to the hashmap using a gfcString key.  Its cached hash and length save rescanning the key
+ * @param map the map to add a value to
+ * @param key the key to retreive the data with, it is copied
+ * @param data the data to keep track of
+ * @note if the key is already in the map, its data is replaced
+ */
+void gfc_hashmap_insert_string(HashMap *map,const gfcString *key,void *data);
+
+/**
+ * @brief search the hashmap for a gfcString key
+ * @param map the map to search
+ * @param key the key to search by
+ * @return NULL if not found, the data otherwise
+ */
+void *gfc_hashmap_get_string(HashMap *map,const gfcString *key);
+
+/**
+ * @brief delete a value out of the hashmap by gfcString key
+ * @param map the map to delete a value from
+ * @param key the key to the value to be deleted
+ */
+void gfc_hashmap_delete_by_string(HashMap *map,const gfcString *key);
+
 /**
  * @brief get a list of all of the values in the hashmap
  * @param map the map to extract the data from
@@ -91,6 +148,67 @@ gfcList *gfc_hashmap_get_all_values(HashMap *map);
  */
 void gfc_hashmap_foreach(HashMap *map, gfc_work_func func);
 
+/**
+ * @brief run a function on all values in a hashmap
+ * @param map the hashmap to work on
+ * @param func the function to be run on each item, it will be given each item from the hashmap and the context
+ * @param context this will be passed to each call of func
+ */
+void gfc_hashmap_foreach_context(HashMap *map, gfc_work_func_context func,void *context);
+
+/**
+ * @brief get the number of items stored in the hashmap
+ * @param map the map to check
+ * @return 0 if NULL or empty, the count otherwise
+ */
+Uint32 gfc_hashmap_get_count(HashMap *map);
+
+/**
+ * @brief intern a string, so it can be referred to by an integer handle
+ * @param str the string to intern.  It is copied.
+ * @return GFC_STRING_ID_NONE on error, the id for the string otherwise.  Interning the same string again returns the same id
+ * @note interned strings live until program exit
+ */
+gfcStringId gfc_str_intern(const char *str);
+
+/**
+ * @brief find the id of a string that has already been interned, without interning it
+ * @param str the string to search for
+ * @return GFC_STRING_ID_NONE if not interned, its id otherwise
+ */
+gfcStringId gfc_str_find(const char *str);
+
+/**
+ * @brief get the string for an interned id
+ * @param id the id to look up
+ * @return NULL if the id is not valid, the interned string otherwise.  DO NOT FREE IT
+ */
+const char *gfc_str_from_id(gfcStringId id);
+
+/**
+ * @brief add data to the hashmap using an interned key
+ * @param map the map to add a value to
+ * @param id the interned key to retreive the data with
+ * @param data the data to keep track of
+ * @note the data can be retrieved by id or by the key string
+ */
+void gfc_hashmap_insert_by_id(HashMap *map,gfcStringId id,void *data);
+
+/**
+ * @brief search the hashmap for an interned key.  After the first hit this avoids hashing and string compares
+ * @param map the map to search
+ * @param id the interned key to search by
+ * @return NULL if not found, the data otherwise
+ */
+void *gfc_hashmap_get_by_id(HashMap *map,gfcStringId id);
+
+/**
+ * @brief delete a value out of the hashmap by interned key
+ * @param map the map to delete a value from
+ * @param id the interned key to the value to be deleted
+ */
+void gfc_hashmap_delete_by_id(HashMap *map,gfcStringId id);
+
 /**
  * @brief simple log the hash keys of the provided hashmap
  * @param map the map to print.  If NULL, this is a no op
@@ -4,6 +4,9 @@
 #include <SDL.h>
 #include "gfc_text.h"
 #include "gfc_list.h"
+#include "gfc_string.h"
+#include "gfc_hashmap.h"
+#include "gfc_callbacks.h"
 
 typedef enum
 {
@@ -22,6 +25,43 @@ typedef enum
     IET_Release = 3
 }InputEventType;
 
+typedef enum
+{
+    IEK_None    = 0,    /**<marks the last frame of a recording*/
+    IEK_Key     = 1,    /**<code is the scancode, value is 1 for down, 0 for up*/
+    IEK_Button  = 2,    /**<code is the button index of controller, value is 1 for down, 0 for up*/
+    IEK_Axis    = 3,    /**<code is the axis index of controller, value is its position*/
+    IEK_Wheel   = 4,    /**<code is the horizontal scroll, value the vertical*/
+    IEK_Quit    = 5     /**<the window was closed*/
+}InputEventKind;
+
+/**
+ * @brief one input event, as kept in the event buffer and written to recordings
+ */
+typedef struct
+{
+    Uint64 time;        /**<nanoseconds since gfc_input_init(), see gfc_input_get_time()*/
+    Uint32 ticks;       /**<SDL_GetTicks() time of the event*/
+    Uint32 frame;       /**<the update the event was applied in, recordings count from the first recorded update*/
+    Uint16 kind;        /**<InputEventKind*/
+    Uint16 controller;  /**<index of the controller for buttons and axes*/
+    Sint32 code;
+    Sint32 value;
+}GFC_InputEvent;
+
+/**
+ * @brief what the event buffer tracks for each key or button
+ */
+typedef struct
+{
+    Uint64 time;        /**<when the reported state last changed*/
+    Uint32 ticks;
+    Uint32 frame;       /**<the event frame the reported state last changed in*/
+    Uint8  live;        /**<the state after every event so far, it is a frame ahead of the reported state after a quick tap*/
+    Uint64 liveTime;
+    Uint32 liveTicks;
+}GFC_InputEventState;
+
 typedef struct
 {
     Uint32 num_buttons;
@@ -31,6 +71,8 @@ typedef struct
     Sint16 *axis_maxes;
     Sint16 *axis;
     Sint16 *old_axis;
+    gfcList **button_commands;          /**<for each button, the commands bound to it*/
+    GFC_InputEventState *button_events; /**<for each button, its event state when the event buffer is in use*/
     SDL_Joystick *controller;
 }GFC_InputController;
 
@@ -39,18 +81,22 @@ typedef struct
  */
 typedef struct
 {
-    TextLine command;
+    gfcString command;                  /**<the name of the command, see gfc_string_cstr()*/
+    gfcStringId commandId;              /**<interned id of command, see gfc_str_intern()*/
     gfcList *keyCodes;                     /**<list of keys that must be pressed together to count as a single input*/
     Uint8 controller;                   /**<Index of the controller to use to update this input*/
     gfcList *buttons;                      /**<list of buttons that must be pressed together to count as a single input*/
     gfcList *axes;                         /**<list of axes that must be pressed together to count as a single input*/
     int downCount;
     Uint32 pressTime;                   /**<clock ticks when button was pressed*/
+    Uint64 pressTimestamp;              /**<nanoseconds when it was pressed, see gfc_input_get_time()*/
     InputEventType state;               /**<updated each frame*/
+    Uint32 updateFrame;                 /**<last input frame this command was queued for evaluation*/
     void (*onPress)(void *data);        /**<callback for press event*/
     void (*onHold)(void *data);         /**<callback for hold event*/
     void (*onRelease)(void *data);      /**<callback for release event*/
     void *data;                         /**<pointer to be passed to callbacks*/
+    Uint32 sourceFile;                  /**<1 + the order of the command file it was loaded from, 0 if it was not*/
 }Input;
 
 /**
@@ -62,6 +108,7 @@ void gfc_input_init(char *configFile);
 /**
  * @brief called as often as you want your input data update.  Every Frame, or faster if you like
  * @note must be called or input will be stale
+ * @note only commands bound to keys or buttons that changed, or that are not idle, are evaluated
  */
 void gfc_input_update();
 
@@ -71,6 +118,22 @@ void gfc_input_update();
  */
 void gfc_input_commands_load(char *configFile);
 
+/**
+ * @brief load a command file again, after it changed on disk or in a pak
+ * commands that are still in the file are rebound in place, so Input pointers and callbacks set on them stay good.
+ * New commands are added, and commands no longer in the file are left with no keys or buttons.
+ * @note controller button and axis mappings are not reloaded
+ * @param configFile the file, as it was given to gfc_input_commands_load()
+ * @return -1 if it was never loaded or could not be parsed (the old bindings are kept), 0 otherwise
+ */
+int gfc_input_commands_reload(const char *configFile);
+
+/**
+ * @brief reload command files automatically when they change, see gfc_watch_update()
+ * @param enable 1 to watch every command file loaded so far and from now on, 0 to stop
+ */
+void gfc_input_watch(Uint8 enable);
+
 /**
  * @brief clears all user input configuration
  */
@@ -88,6 +151,42 @@ Uint8 gfc_input_command_down(const char *command);
 
 InputEventType gfc_input_command_get_state(const char *command);
 
+/**
+ * @brief get the input for a command by name
+ * @param name the name of the command
+ * @return NULL if not found or the input otherwise
+ * @note the handle stays valid until gfc_input_commands_purge() so it can be cached and polled directly
+ */
+Input *gfc_input_get_by_name(const char *name);
+
+/**
+ * @brief get the input for a command by its interned id
+ * @param commandId the id returned from gfc_str_intern() for the command name
+ * @return NULL if not found or the input otherwise
+ */
+Input *gfc_input_get_by_id(gfcStringId commandId);
+
+/**
+ * @brief check command state by interned id, avoiding string compares in per frame code
+ * @param commandId the id returned from gfc_str_intern() for the command name
+ * @returns true if the command is in the given state, false otherwise
+ */
+Uint8 gfc_input_command_pressed_by_id(gfcStringId commandId);
+Uint8 gfc_input_command_held_by_id(gfcStringId commandId);
+Uint8 gfc_input_command_released_by_id(gfcStringId commandId);
+Uint8 gfc_input_command_down_by_id(gfcStringId commandId);
+
+InputEventType gfc_input_command_get_state_by_id(gfcStringId commandId);
+
+/**
+ * @brief get all of the commands that include the given key
+ * @param keysym the scancode to check
+ * @return NULL if no commands use the key, a list of Input * otherwise
+ * @note commands bound to SHIFT, ALT, CTRL or SUPER are listed under both the left and right keys
+ * @note the list is owned by the input system, do not free it
+ */
+gfcList *gfc_input_get_by_scancode(SDL_Scancode keysym);
+
 /**
  * @brief report if the key provided has been pressed this frame
  * @param key the name of the key to check
@@ -99,6 +198,32 @@ Uint8 gfc_input_key_released(const char *key);
 Uint8 gfc_input_key_held(const char *key);
 Uint8 gfc_input_key_down(const char *key);
 
+/**
+ * @brief get the scancode for a key name, as used in input configs
+ * @param key the name of the key, ie: "a", "F1", "LSHIFT", "ESCAPE"
+ * @return -1 if the name is not a key (SHIFT, ALT, CTRL and SUPER name both sides so they have no scancode),
+ * the scancode otherwise
+ * @note look keys up once and keep the scancode for the gfc_input_scancode checks, they skip the name lookup
+ */
+SDL_Scancode gfc_input_key_to_scancode(const char *key);
+
+/**
+ * @brief check if a meta key name was given
+ * @param key the name to check
+ * @return EMK_None if it is not SHIFT, ALT, CTRL or SUPER, the InputModKey otherwise
+ */
+InputModKey gfc_input_key_mod_check(const char *key);
+
+/**
+ * @brief report the state of a key by scancode, without looking up a name
+ * @param kc the scancode to check
+ * @returns true if the key was pressed (or released, or held, or is down) this frame, false otherwise
+ */
+Uint8 gfc_input_scancode_pressed(SDL_Scancode kc);
+Uint8 gfc_input_scancode_released(SDL_Scancode kc);
+Uint8 gfc_input_scancode_held(SDL_Scancode kc);
+Uint8 gfc_input_scancode_down(SDL_Scancode kc);
+
 /**
  * @brief check if the mouse wheel is moving in the indicated direction
  * @return 0 if it is not, 1 if it is
@@ -152,5 +277,83 @@ void gfc_input_set_callbacks(
     void *data
 );
 
+/**
+ * @brief deliver input callbacks through a queue instead of calling them during gfc_input_update()
+ * @param queue the queue to post onPress, onHold and onRelease to, NULL to call them right away again
+ * @note the queue is not owned by input, drain it where the frame should handle input
+ */
+void gfc_input_set_callback_queue(gfcCallbackQueue *queue);
+
+/**
+ * @brief get the time input events are stamped with
+ * @return nanoseconds since gfc_input_init()
+ */
+Uint64 gfc_input_get_time();
+
+/**
+ * @brief keep every key, button, axis and wheel event in a ring buffer and update input from the events
+ * By default input looks at the state of the keyboard and controllers once per update, so a key that goes down
+ * and back up between two updates is never seen.  From the events no press or release is lost: a tap shorter than
+ * a frame is pressed for one update and released the next, and pressTime comes from the time of the event.
+ * @param count how many events to keep, rounded up to a power of two.  0 turns the buffer off
+ * @return -1 on error, 0 otherwise
+ * @note recording and replay update from events too, with or without the buffer
+ */
+int gfc_input_event_buffer_enable(Uint32 count);
+
+/**
+ * @brief get how many events are held in the event buffer
+ * @return the count, at most the size of the buffer
+ */
+Uint32 gfc_input_event_get_count();
+
+/**
+ * @brief get an event from the event buffer
+ * @param n which event, 0 is the oldest kept
+ * @return NULL if out of range, the event otherwise.  It is written over once the buffer wraps around to it
+ */
+const GFC_InputEvent *gfc_input_event_get_nth(Uint32 n);
+
+/**
+ * @brief start writing every input event to a file, to be replayed with gfc_input_replay_load()
+ * @param filename the file to write
+ * @return -1 on error, 0 otherwise
+ * @note the events are written as they are in memory, recordings are for the machine they were made on
+ */
+int gfc_input_record_start(const char *filename);
+
+/**
+ * @brief finish and close the current recording, if any
+ */
+void gfc_input_record_stop();
+
+/**
+ * @brief replay a recording in place of the keyboard and controllers
+ * Events are applied on the same update, counted from the start, they were recorded on, so the commands
+ * go through the same states each update as they did when recorded, however fast the updates are run.
+ * Nothing needs a window, so input driven tests can run headless at full speed.
+ * @param filename the recording to load
+ * @return -1 on error or if it uses a controller button or axis that is not connected now, 0 otherwise
+ */
+int gfc_input_replay_load(const char *filename);
+
+/**
+ * @brief replay events from memory in place of the keyboard and controllers, see gfc_input_replay_load()
+ * @param events the events, in frame order.  They are copied
+ * @param count how many events there are
+ * @return -1 on error, 0 otherwise
+ */
+int gfc_input_replay_events(const GFC_InputEvent *events,Uint32 count);
+
+/**
+ * @brief check if a replay is still running
+ * @return 1 until the update with the last of the replayed events, 0 after
+ */
+Uint8 gfc_input_replay_active();
+
+/**
+ * @brief stop replaying and go back to the keyboard and controllers
+ */
+void gfc_input_replay_stop();
 
 #endif
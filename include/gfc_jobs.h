@@ -0,0 +1,130 @@
+#ifndef __GFC_JOBS_H__
+#define __GFC_JOBS_H__
+
+#include <SDL.h>
+
+#include "gfc_list.h"
+
+/**
+ * @purpose gfc_jobs is a fixed pool of worker threads for splitting cpu heavy work across cores.
+ * Each thread in the pool has its own queue of jobs.  A thread runs the newest job on its own queue first,
+ * and when that is empty it steals the oldest job from another thread's queue.
+ * Jobs are counted on a gfcJobCounter.  A thread waiting on a counter runs jobs while it waits instead of sleeping,
+ * and jobs can be held back until another counter is done, which builds up dependencies.
+ * Jobs can be posted from any thread.  Threads outside of the pool share one queue the workers take from.
+ * @note jobs should not block on locks or io for long, that holds a worker the other jobs could be using.
+ * gfc_pak's async loads keep their own threads for this reason
+ */
+
+/**
+ * @brief counts jobs that are not done yet.  Zero it before first use, ie: gfcJobCounter counter = {0};
+ * @note a counter must stay valid until every job counted on it is done
+ */
+typedef struct
+{
+    SDL_atomic_t    pending;    /**<jobs counted on this that are not done yet*/
+    SDL_SpinLock    lock;
+    void           *waiting;    /**<jobs held back until pending is zero*/
+}gfcJobCounter;
+
+/**
+ * @brief the part of a range gfc_parallel_for() hands to each call
+ */
+typedef struct
+{
+    Uint32 begin;   /**<first index to work on*/
+    Uint32 end;     /**<one past the last index*/
+}gfcJobRange;
+
+/**
+ * @brief start the worker threads
+ * @param threads how many workers to start, 0 for one per cpu less the calling thread.  At least one is started
+ * @note the thread that calls this is part of the pool, it runs jobs when it waits on a counter.
+ * Closed at exit
+ */
+void gfc_jobs_init(Uint32 threads);
+
+/**
+ * @brief get how many threads can run jobs, the workers and the thread that started them
+ * @return 0 if the pool is not running, the thread count otherwise
+ */
+Uint32 gfc_jobs_get_thread_count();
+
+/**
+ * @brief post a job
+ * @param fn the function to run, as fn(data,context)
+ * @param data the first parameter for fn
+ * @param context the second parameter for fn
+ * @param counter (optional) counted until the job is done
+ * @note if the pool is not running the job runs before this returns
+ */
+void gfc_jobs_run(gfc_work_func_context *fn,void *data,void *context,gfcJobCounter *counter);
+
+/**
+ * @brief post a job that does not start until another counter is done
+ * @param after (optional) the counter to wait for.  If it is already zero the job is posted right away
+ * @param fn the function to run, as fn(data,context)
+ * @param data the first parameter for fn
+ * @param context the second parameter for fn
+ * @param counter (optional) counted until the job is done.  Counted from now, not from when it starts
+ */
+void gfc_jobs_run_after(gfcJobCounter *after,gfc_work_func_context *fn,void *data,void *context,gfcJobCounter *counter);
+
+/**
+ * @brief run jobs until everything counted on a counter is done
+ * @param counter the counter to wait on
+ */
+void gfc_jobs_wait(gfcJobCounter *counter);
+
+/**
+ * @brief count work on a counter that is not a job, so jobs can wait for it with gfc_jobs_run_after()
+ * @param counter the counter to add to
+ * @param count how much to add, each needs a gfc_job_counter_done()
+ */
+void gfc_job_counter_add(gfcJobCounter *counter,Uint32 count);
+
+/**
+ * @brief mark one piece of counted work as done.  Jobs waiting on the counter are posted when it reaches zero
+ * @param counter the counter to take from
+ */
+void gfc_job_counter_done(gfcJobCounter *counter);
+
+/**
+ * @brief check if everything counted on a counter is done without waiting
+ * @param counter the counter to check
+ * @return 1 if done, 0 if not
+ */
+Uint8 gfc_job_counter_is_done(gfcJobCounter *counter);
+
+/**
+ * @brief run a function on several threads at once and wait for all of them to return
+ * for work that hands itself out with an atomic counter, as the bvh and noise builds do
+ * @param fn the function, each thread calls fn(data) once
+ * @param data passed to fn
+ * @param threads how many calls to make, 0 for one per thread in the pool (or per cpu)
+ * @note one of the calls is made on the calling thread.  If the pool is not running this starts threads for the
+ * other calls and waits for them, so it can be used before gfc_jobs_init()
+ */
+void gfc_jobs_run_parallel(gfc_work_func *fn,void *data,Uint32 threads);
+
+/**
+ * @brief split a range of indices into chunks, run fn for each chunk across the pool and wait for them all
+ * @param begin the first index
+ * @param end one past the last index
+ * @param grain how many indices each chunk should have, 0 to pick from the range and thread count
+ * @param fn called as fn(gfcJobRange *range,context) for each chunk
+ * @param context passed to fn
+ * @note if the pool is not running the whole range is run as one chunk on the calling thread
+ */
+void gfc_parallel_for(Uint32 begin,Uint32 end,Uint32 grain,gfc_work_func_context *fn,void *context);
+
+/**
+ * @brief gfc_list_foreach_context() split across the pool.  Waits until every element is done
+ * @param list the list to iterate over
+ * @param function called with each element's data and the context, in no particular order
+ * @param contextData passed to each call.  Calls run at the same time, so it must be safe to share
+ * @note the list must not change until this returns
+ */
+void gfc_parallel_foreach_context(gfcList *list,void (*function)(void *data,void *context),void *contextData);
+
+#endif
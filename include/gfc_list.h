@@ -3,6 +3,8 @@
 
 #include <SDL.h>
 
+#include "gfc_allocator.h"
+
 typedef void gfc_work_func(void*);/**<prototype for a work function*/
 typedef void gfc_work_func_context(void*,void*);/**<prototype for a work function*/
 
@@ -20,6 +22,7 @@ typedef struct
     ListElementData *elements;
     Uint32 size;
     Uint32 count;
+    gfcAllocator *allocator;    /**<where the list and its elements live, NULL for the heap*/
 }gfcList;
 
 /**
@@ -35,6 +38,15 @@ gfcList *gfc_list_new();
  */
 gfcList *gfc_list_new_size(Uint32 count);
 
+/**
+ * @brief allocate a new empty list of size 'count' from an allocator
+ * @note the list grows and is deleted through the same allocator.  An arena can release it with a reset instead
+ * @param count how many elements you wish to support in this list.
+ * @param allocator where to allocate the list from, NULL for the heap
+ * @return NULL on memory error or a new empty list
+ */
+gfcList *gfc_list_new_size_allocator(Uint32 count,gfcAllocator *allocator);
+
 /**
  * @brief make a copy of a list.  
  * @note: THIS DOES NOT COPY ANY DATA POINTED TO BY THE OLD LIST
@@ -44,6 +56,15 @@ gfcList *gfc_list_new_size(Uint32 count);
  */
 gfcList *gfc_list_copy(gfcList *old);
 
+/**
+ * @brief make sure the list has room for at least count elements without growing again
+ * @param list the list to grow
+ * @param count how many elements the list should be able to hold
+ * @return -1 on error (out of memory), 0 otherwise
+ * @note the list is grown in place, the list pointer does not change
+ */
+int gfc_list_reserve(gfcList *list,Uint32 count);
+
 /**
  * @brief deletes a list that has been previously allocated
  * @param list the list to delete;
@@ -109,6 +130,25 @@ gfcList *gfc_list_insert(gfcList *list,void *data,Uint32 n);
  */
 int gfc_list_delete_nth(gfcList *list,Uint32 n);
 
+/**
+ * @brief delete the element at the nth position by moving the last element into its place
+ * @note this is constant time but does NOT preserve the order of the list
+ * @note this does not clean up the information that the list is referring to
+ * @param list the list to delete out of
+ * @param n the element to delete
+ * @return -1 on error, 0 otherwise
+ */
+int gfc_list_swap_remove_nth(gfcList *list,Uint32 n);
+
+/**
+ * @brief delete the first element pointing to data by moving the last element into its place
+ * @note does NOT preserve the order of the list, and does not delete the data itself
+ * @param list the list to delete the element from
+ * @param data used to match against which element to delete
+ * @return -1 on error or not found, 0 otherwise
+ */
+int gfc_list_swap_remove_data(gfcList *list,void *data);
+
 /**
  * @brief delete the item at the end of the list
  * @note this does not clean up the information that the list is referring to
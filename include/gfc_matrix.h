@@ -2,8 +2,13 @@
 #define __GFC_MATRIX_H__
 
 #include "gfc_vector.h"
+#include "gfc_simd.h"
 
-typedef float Matrix4[4][4];
+/**
+ * @brief row major 4x4 matrix, points are row vectors and the translation is in row 3
+ * @note aligned to 16 bytes so the SIMD paths can load whole rows
+ */
+typedef GFC_ALIGN16_PRE float Matrix4[4][4] GFC_ALIGN16_POST;
 typedef float Matrix3[3][3];
 typedef float Matrix2[2][2];
 
@@ -120,6 +125,62 @@ void gfc_matrix_perspective(
  */
 Vector3D gfc_unproject(Vector3D in,Matrix4 view, Matrix4 proj,Vector2D viewport);
 
+/**
+ * @brief everything gfc_unproject needs, worked out once so it can be reused for every unproject in a frame
+ * @note set it up with gfc_unprojector_set() whenever the view, projection or viewport changes
+ */
+typedef struct
+{
+    Matrix4     invViewProj;    /**<inverse of view * proj, for unprojecting points*/
+    Vector3D    dx,dy,origin;   /**<the direction gfc_unproject gives, before it is normalized, is dx * x + dy * y + origin*/
+    Vector2D    viewport;
+    Uint8       valid;          /**<set if gfc_unprojector_set() succeeded*/
+}gfcUnprojector;
+
+/**
+ * @brief set up an unprojector for a view, inverting the matrices once
+ * @param u the unprojector to set
+ * @param view the view matrix of the scene
+ * @param proj the projection matrix of the scene
+ * @param viewport screen extent (x,y)
+ * @return 0 if the viewport is empty or the matrices can not be inverted, 1 otherwise
+ */
+Uint8 gfc_unprojector_set(gfcUnprojector *u,Matrix4 view,Matrix4 proj,Vector2D viewport);
+
+/**
+ * @brief map screen coordinates into a 3d direction, as gfc_unproject() does
+ * @param u the unprojector, set up for the view
+ * @param in the screen coordinates to map, z is ignored
+ * @return the normalized direction from the camera, or a zero vector if u is not valid
+ */
+Vector3D gfc_unprojector_direction(gfcUnprojector *u,Vector3D in);
+
+/**
+ * @brief map a screen position and depth back into the world point it was projected from
+ * @param u the unprojector, set up for the view
+ * @param in the screen coordinates, with z the depth from 0 at the near plane to 1 at the far plane
+ * @return the world point, or a zero vector if u is not valid
+ */
+Vector3D gfc_unprojector_point(gfcUnprojector *u,Vector3D in);
+
+/**
+ * @brief map many screen coordinates into 3d directions, as gfc_unprojector_direction()
+ * @param u the unprojector, set up for the view
+ * @param in the screen coordinates to map
+ * @param out where to write the directions, may be the same as in
+ * @param n how many there are
+ */
+void gfc_unproject_batch(gfcUnprojector *u,Vector3D *in,Vector3D *out,Uint32 n);
+
+/**
+ * @brief map many screen positions and depths back to world points, as gfc_unprojector_point()
+ * @param u the unprojector, set up for the view
+ * @param in the screen coordinates and depths
+ * @param out where to write the points, may be the same as in
+ * @param n how many there are
+ */
+void gfc_unproject_points_batch(gfcUnprojector *u,Vector3D *in,Vector3D *out,Uint32 n);
+
 /**
  * @brief multiply the two input matrices together and save the result into out
  * @note operation is out = a * b, so most of the time a is changed by b
@@ -158,6 +219,21 @@ void gfc_matrix_M_multiply_v(
   Vector4D   vec
 );
 
+/**
+ * @brief transform a batch of points by a matrix, as v * M with w of 1
+ * @note the result is not divided by w, this is meant for affine transforms (model and skinning matrices)
+ * @param mat the matrix to transform by
+ * @param in the points to transform
+ * @param out where to write the transformed points, this may be the same as in
+ * @param n how many points
+ */
+void gfc_matrix_transform_points(
+    Matrix4 mat,
+    Vector3D *in,
+    Vector3D *out,
+    Uint32 n
+);
+
 
 /**
  * @brief create a transformation matrix from the three basic operation vectors
@@ -1,8 +1,39 @@
 #ifndef __GFC_NOISE_H__
 #define __GFC_NOISE_H__
 
+#include <SDL.h>
+
 #include "gfc_vector.h"
 
+/**
+ * @purpose gfc_noise makes smooth gradient noise for heightmaps, textures and world generation.
+ * gfc_perlin() is the original unseeded noise.  The gfc_noise functions are seeded, can tile, stack octaves
+ * and come in 3D.  They look up their gradients in a table instead of calling sin and cos.
+ * The fill functions make a whole grid at once, four samples at a time with SSE2 or NEON when they are
+ * available (see gfc_simd.h), and can split the rows across threads.
+ */
+
+#define GFC_NOISE_MAX_OCTAVES 16
+
+typedef enum
+{
+    GFC_NF_FBM = 0,     /**<octaves added together, about -1 to 1*/
+    GFC_NF_RIDGED       /**<each octave is (1 - |noise|)^2, 0 to 1 with sharp ridges along the zero crossings*/
+}gfcNoiseFractal;
+
+typedef struct
+{
+    Uint32  seed;
+    Uint32  octaves;        /**<how many layers of noise to stack, 1 for plain noise.  At most GFC_NOISE_MAX_OCTAVES*/
+    float   lacunarity;     /**<how much the frequency goes up each octave, usually 2*/
+    float   gain;           /**<how much the amplitude goes down each octave, usually 0.5*/
+    gfcNoiseFractal fractal;
+    Uint32  periodX;        /**<how many lattice cells before the noise repeats, 0 for it not to tile*/
+    Uint32  periodY;
+    Uint32  periodZ;
+    Uint32  threads;        /**<how many threads the fill functions may use, 0 for all of them.  Runs on the gfc_jobs pool when it is started*/
+}gfcNoiseParams;
+
 /**
  * @brief generate a perline noise value at the vector position
  * @param in the input vector
@@ -10,4 +41,79 @@
  */
 float gfc_perlin(Vector2D in);
 
+/**
+ * @brief fill a grid with gfc_perlin()
+ * @param out where to write, w * h floats in rows
+ * @param w how many samples across
+ * @param h how many samples down
+ * @param origin the position of the first sample
+ * @param scale how far apart the samples are
+ * @note out[y * w + x] is the same as gfc_perlin(vector2d(origin.x + x * scale,origin.y + y * scale))
+ */
+void gfc_perlin_fill(float *out,Uint32 w,Uint32 h,Vector2D origin,float scale);
+
+/**
+ * @brief get noise parameters with the usual settings: lacunarity 2, gain 0.5, fbm, not tiled and threaded
+ * @param seed the seed for the noise
+ * @param octaves how many octaves to stack
+ * @return the parameters
+ */
+gfcNoiseParams gfc_noise_params(Uint32 seed,Uint32 octaves);
+
+/**
+ * @brief seeded 2D gradient noise
+ * @param seed the seed, different seeds give unrelated noise
+ * @param in where to sample, the lattice is one unit apart
+ * @return about -1 to 1
+ */
+float gfc_noise2(Uint32 seed,Vector2D in);
+
+/**
+ * @brief seeded 3D gradient noise
+ * @param seed the seed, different seeds give unrelated noise
+ * @param in where to sample, the lattice is one unit apart
+ * @return about -1 to 1
+ */
+float gfc_noise3(Uint32 seed,Vector3D in);
+
+/**
+ * @brief 2D noise with octaves and tiling
+ * @param params how to make the noise
+ * @param in where to sample
+ * @return about -1 to 1 for fbm, 0 to 1 for ridged
+ * @note tiling repeats every period lattice cells.  Later octaves only line up when lacunarity is a whole number
+ */
+float gfc_noise_fractal2(const gfcNoiseParams *params,Vector2D in);
+
+/**
+ * @brief 3D noise with octaves and tiling
+ * @param params how to make the noise
+ * @param in where to sample
+ * @return about -1 to 1 for fbm, 0 to 1 for ridged
+ */
+float gfc_noise_fractal3(const gfcNoiseParams *params,Vector3D in);
+
+/**
+ * @brief fill a grid with gfc_noise_fractal2()
+ * @param out where to write, w * h floats in rows
+ * @param w how many samples across
+ * @param h how many samples down
+ * @param origin the position of the first sample
+ * @param scale how far apart the samples are, in lattice cells.  A tiled grid wraps when w * scale is the period
+ * @param params how to make the noise
+ */
+void gfc_noise_fill(float *out,Uint32 w,Uint32 h,Vector2D origin,float scale,const gfcNoiseParams *params);
+
+/**
+ * @brief fill a volume with gfc_noise_fractal3()
+ * @param out where to write, w * h * d floats, out[(z * h + y) * w + x]
+ * @param w how many samples across
+ * @param h how many samples down
+ * @param d how many samples deep
+ * @param origin the position of the first sample
+ * @param scale how far apart the samples are, in lattice cells
+ * @param params how to make the noise
+ */
+void gfc_noise_fill3(float *out,Uint32 w,Uint32 h,Uint32 d,Vector3D origin,float scale,const gfcNoiseParams *params);
+
 #endif
@@ -3,13 +3,60 @@
 
 #include "simple_json.h"
 #include "gfc_types.h"
+#include "gfc_text.h"
 
 /**
  * @purpose The Pak manager is meant to obscure game content / assets through zip compression.
  * Pak files (just rename the .zip extenstion to .pak or anything for that matter) are added to the manager.
  * Files can be loaded through the manager where it will first check to see if a file is on disk, and then iterate through all of the registered pak files looking for the file in question before giving up.
+ * All of the registered pak files are indexed together as they are added.  A loose file on disk overrides every pak, otherwise the first pak added that contains the file wins.
  */
 
+typedef enum
+{
+    PLP_Urgent = 0,     /**<needed right now, served before anything else*/
+    PLP_Normal,
+    PLP_Prefetch,       /**<only loaded when nothing more urgent is waiting*/
+    PLP_MAX
+}GFC_PakLoadPriority;
+
+/**
+ * @brief the result of an asynchronous load, passed as the data to the load's callback
+ */
+typedef struct
+{
+    Uint32 id;          /**<the id returned when the load was requested*/
+    TextLine filename;  /**<the file that was requested*/
+    void *data;         /**<the file data or NULL if it could not be loaded*/
+    size_t size;        /**<size of data in bytes*/
+    void *context;      /**<the context provided with the request*/
+}GFC_PakLoadResult;
+
+/**
+ * @brief statistics for the extraction cache, see gfc_pak_cache_get_stats()
+ */
+typedef struct
+{
+    Uint64 hits;            /**<extractions served from the cache*/
+    Uint64 misses;          /**<extractions that had to inflate while the cache was enabled*/
+    Uint64 evictions;       /**<entries dropped to stay within budget*/
+    Uint64 bytesInflated;   /**<bytes extracted from archives on the main path, cached or not*/
+    size_t bytesResident;   /**<bytes currently held by the cache, including entries in use*/
+    Uint32 entries;         /**<files currently held by the cache*/
+}GFC_PakCacheStats;
+
+/**
+ * @brief where a file comes from and when that last changed, see gfc_pak_file_get_stamp()
+ */
+typedef struct
+{
+    Uint8  found;       /**<the file exists, loose on disk or in a pak*/
+    Uint8  loose;       /**<it is a loose file on disk*/
+    Sint64 modified;    /**<when the loose file, or the pak it is in, last changed on disk*/
+    Uint64 size;        /**<size of the file in bytes*/
+    Uint32 crc;         /**<crc32 of an archive entry, from the pak's directory.  0 for loose files*/
+}GFC_PakFileStamp;
+
 /**
  * @brief initialize the internal pak manager, queueing up its cleanup on program exit
  */
@@ -19,9 +66,44 @@ void gfc_pak_manager_init();
  * @brief register a pak file to the system
  * @param filename the pak file to load
  * @note a no-op if filename is null.  Fails if the file cannot be loaded or out of memory.  See slog for details
+ * @note the pak is kept open and mapped, so a pak renamed over it is not read until gfc_pak_manager_refresh()
  */
 void gfc_pak_manager_add(const char *filename);
 
+/**
+ * @brief forget every cached lookup and rebuild the archive index
+ * @note lookups, including misses, are cached.  Call this after adding or removing loose files on disk during development
+ */
+void gfc_pak_manager_invalidate();
+
+/**
+ * @brief reopen any pak files that changed on disk since they were added, and index them again
+ * @return how many paks were reopened
+ * @note everything mapped or streamed from the old pak stays valid.  Replace paks by writing a new file and renaming
+ * it over the old one, a pak that is overwritten in place can not be read safely while it is mapped
+ * @note paks are not reopened while asynchronous loads are waiting, they are picked up by a later call
+ */
+int gfc_pak_manager_refresh();
+
+/**
+ * @brief check where a file comes from and when that last changed, without loading it
+ * @param filename the file to check
+ * @param stamp [output] filled in, found is 0 if the file does not exist anywhere
+ * @return -1 on error, 0 otherwise
+ * @note a loose file is looked for on disk every call, so a watched file that is added or removed is picked up
+ * without a gfc_pak_manager_invalidate()
+ */
+int gfc_pak_file_get_stamp(const char *filename,GFC_PakFileStamp *stamp);
+
+/**
+ * @brief get a hash of the contents of a file, to tell if a file that was touched actually changed
+ * @param filename the file to hash
+ * @param crc [output] the crc32 of the file
+ * @return -1 if the file could not be found or read, 0 otherwise
+ * @note archive entries are not extracted, their crc is in the pak's directory.  Loose files are read
+ */
+int gfc_pak_file_get_crc(const char *filename,Uint32 *crc);
+
 /**
  * @brief extract a file from disk or an archive.
  * @param filename the name of the file to extract
@@ -31,6 +113,122 @@ void gfc_pak_manager_add(const char *filename);
  */
 void *gfc_pak_file_extract(const char *filename,size_t *fileSize);
 
+/**
+ * @brief get a read only view of a file from disk or an archive without copying it where possible
+ * @param filename the name of the file to map
+ * @param fileSize [output] if provided, fileSize will be populated with the size of the file
+ * @return NULL on error or not found.  A pointer to the read only file data otherwise.
+ * @note loose files and entries stored uncompressed in a pak are memory mapped, compressed entries are extracted
+ * @note the data returned must be released with gfc_pak_file_unmap(), NOT free()
+ */
+const void *gfc_pak_file_map(const char *filename,size_t *fileSize);
+
+/**
+ * @brief release a view returned by gfc_pak_file_map()
+ * @param data the pointer returned by gfc_pak_file_map()
+ */
+void gfc_pak_file_unmap(const void *data);
+
+/**
+ * @brief open a file from disk or an archive for streaming, without extracting the whole thing
+ * @param filename the name of the file to open
+ * @return NULL on error or not found.  A read only SDL_RWops otherwise, close it with SDL_RWclose()
+ * @note loose files are read from disk and stored pak entries from the mapped pak.  Compressed entries are inflated
+ * as they are read, keeping only a small window of the file in memory.  Seeking back further than that window
+ * inflates from the start again, so store files that are seeked around in (such as ogg) uncompressed if possible
+ * @note the pak files must stay open while the stream is in use.  Reading is safe from any one thread at a time
+ */
+SDL_RWops *gfc_pak_file_open_rw(const char *filename);
+
+/**
+ * @brief set the byte budget of the extraction cache.  Compressed archive entries extracted through
+ * gfc_pak_file_extract(), gfc_pak_file_map() and gfc_pak_load_json() are kept and reused, least recently used are evicted first
+ * @param bytes how much unreferenced data the cache may hold, 0 disables the cache (the default)
+ * @note files mapped with gfc_pak_file_map() are referenced until unmapped and are never evicted while referenced
+ */
+void gfc_pak_cache_set_budget(size_t bytes);
+
+/**
+ * @brief drop everything in the extraction cache that is not currently in use
+ */
+void gfc_pak_cache_flush();
+
+/**
+ * @brief get the extraction cache statistics
+ * @param stats [output] populated with the current statistics
+ */
+void gfc_pak_cache_get_stats(GFC_PakCacheStats *stats);
+
+/**
+ * @brief reset the hit, miss, eviction and inflate counters of the extraction cache
+ */
+void gfc_pak_cache_reset_stats();
+
+/**
+ * @brief start the asynchronous loading worker threads
+ * @param workerCount how many worker threads to start, 0 to pick based on the cpu count
+ * @note called automatically by the first asynchronous load if it was not called first
+ * @note if no thread can be started, asynchronous loads are done when they are requested and still delivered by
+ * gfc_pak_poll_completions()
+ */
+void gfc_pak_async_init(Uint32 workerCount);
+
+/**
+ * @brief load a file from disk or an archive on a worker thread
+ * @param filename the name of the file to load
+ * @param callback called from gfc_pak_poll_completions() once the load is done, its data is a GFC_PakLoadResult *
+ * @param context passed along in the result's context
+ * @return 0 on error or the id of the request
+ * @note result->data is freed after the callback returns.  Set it to NULL in the callback to keep it, then free() it yourself
+ */
+Uint32 gfc_pak_load_async(const char *filename,void (*callback)(void *result),void *context);
+
+/**
+ * @brief same as gfc_pak_load_async() but with a priority.  Requests of a more urgent priority are always started first
+ */
+Uint32 gfc_pak_load_async_priority(
+    const char *filename,
+    void (*callback)(void *result),
+    void *context,
+    GFC_PakLoadPriority priority);
+
+/**
+ * @brief same as gfc_pak_load_async_priority() but with work to do on the worker thread once the file is loaded,
+ * such as decoding it, so that it does not have to be done on the main thread
+ * @param process called on a worker thread if the file was loaded.  It may replace result->data and result->size,
+ * anything left in result->data is still released with free() after the callback.  It must not touch the pak manager
+ * @note any number of process calls may run at once, one per worker
+ */
+Uint32 gfc_pak_load_async_process(
+    const char *filename,
+    void (*process)(GFC_PakLoadResult *result),
+    void (*callback)(void *result),
+    void *context,
+    GFC_PakLoadPriority priority);
+
+/**
+ * @brief cancel an asynchronous load.  Its callback will not be called
+ * @param requestId the id returned when the load was requested
+ * @return 1 if the request was cancelled, 0 if it was not found or has already been delivered
+ */
+Uint8 gfc_pak_load_cancel(Uint32 requestId);
+
+/**
+ * @brief deliver any finished asynchronous loads by calling their callbacks on the calling thread
+ * @note call this once a frame from the main thread
+ * @return the number of callbacks called
+ */
+int gfc_pak_poll_completions();
+
+/**
+ * @brief deliver one asynchronous load if it has finished, leaving every other load for gfc_pak_poll_completions()
+ * @param requestId the id returned when the load was requested
+ * @return -1 if there is no such request (already delivered or cancelled), 0 if it is not done yet,
+ * 1 if its callback was called
+ * @note unlike gfc_pak_poll_completions() this may be called from inside an asynchronous load callback
+ */
+int gfc_pak_poll_request(Uint32 requestId);
+
 /**
  * @brief parse json data from the pak files
  */
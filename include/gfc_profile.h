@@ -0,0 +1,118 @@
+#ifndef __GFC_PROFILE_H__
+#define __GFC_PROFILE_H__
+
+#include <SDL.h>
+
+/**
+ * @purpose gfc_profile times named zones of code and keeps a few counters, so a capture of where the frame went
+ * can be looked at in chrome://tracing or https://ui.perfetto.dev
+ * Each thread records into its own ring buffer, so recording takes no locks and the newest events are kept.
+ * The macros are compiled out unless GFC_PROFILE is defined, so they cost nothing in a normal build.
+ * Build the library with -DGFC_PROFILE (see the Makefile) to turn on the zones and counters gfc has built in.
+ * @note zone names are kept as pointers, so they must be string literals or otherwise live for the whole run
+ */
+
+#ifndef GFC_PROFILE_RING_SIZE
+#define GFC_PROFILE_RING_SIZE 8192      /**<how many zones each thread keeps, a power of two*/
+#endif
+#define GFC_PROFILE_MAX_DEPTH 64        /**<how deep zones can nest, deeper zones are not recorded*/
+#define GFC_PROFILE_MAX_THREADS 64      /**<how many threads can record at once, the buffers of exited SDL threads are reused*/
+
+typedef enum
+{
+    GFC_PC_ALLOCATIONS = 0,     /**<calls to gfc_allocate_array()*/
+    GFC_PC_ALLOCATED_BYTES,     /**<bytes asked for from gfc_allocate_array()*/
+    GFC_PC_BYTES_INFLATED,      /**<bytes decompressed out of pak files*/
+    GFC_PC_HASHMAP_PROBES,      /**<slots looked at by hashmap lookups*/
+    GFC_PC_MAX
+}gfcProfileCounter;
+
+/**
+ * @brief start timing a zone on this thread.  Every begin needs an end on the same thread
+ * @param name the name of the zone, it must stay valid (use a string literal)
+ */
+void gfc_profile_begin(const char *name);
+
+/**
+ * @brief finish the zone most recently started on this thread and record it
+ */
+void gfc_profile_end();
+
+/**
+ * @brief add to a counter
+ * @param counter which counter
+ * @param amount how much to add
+ */
+void gfc_profile_count(gfcProfileCounter counter,Uint64 amount);
+
+/**
+ * @brief get the total of a counter across all threads since the last reset
+ * @param counter which counter
+ * @return the total
+ */
+Uint64 gfc_profile_get_counter(gfcProfileCounter counter);
+
+/**
+ * @brief get the name of a counter, as it is written to traces
+ * @param counter which counter
+ * @return the name, "unknown" if out of range
+ */
+const char *gfc_profile_get_counter_name(gfcProfileCounter counter);
+
+/**
+ * @brief turn recording on or off.  It is on to start with
+ * @param enabled 0 to stop recording zones and counters, anything else to record them
+ * @note a zone is only recorded if recording is on both when it begins and when it ends
+ */
+void gfc_profile_set_enabled(Uint8 enabled);
+
+/**
+ * @brief forget every zone recorded and zero the counters
+ * @note only call this while no other thread is in a zone
+ */
+void gfc_profile_reset();
+
+/**
+ * @brief write everything recorded to a chrome trace event json file
+ * @param filename the file to write
+ * @return -1 on error, 0 otherwise
+ * @note threads should be quiet while this runs, zones recorded during the write may come out torn
+ */
+int gfc_profile_write_chrome_trace(const char *filename);
+
+/**
+ * used by GFC_PROFILE_ZONE, not meant to be called directly
+ */
+Uint8 gfc_profile_zone_begin(const char *name);
+void gfc_profile_zone_end(Uint8 *zone);
+
+#ifdef GFC_PROFILE
+
+#define GFC_PROFILE_BEGIN(name) gfc_profile_begin(name)
+#define GFC_PROFILE_END() gfc_profile_end()
+#define GFC_PROFILE_COUNT(counter,amount) gfc_profile_count(counter,amount)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define GFC_PROFILE_ZONE_NAME(line) gfc_profile_zone_##line
+#define GFC_PROFILE_ZONE_AT(name,line) \
+    Uint8 GFC_PROFILE_ZONE_NAME(line) __attribute__((cleanup(gfc_profile_zone_end),unused)) = gfc_profile_zone_begin(name)
+#define GFC_PROFILE_ZONE_LINE(name,line) GFC_PROFILE_ZONE_AT(name,line)
+/**
+ * @brief time from here to the end of the enclosing block, however it is left
+ */
+#define GFC_PROFILE_ZONE(name) GFC_PROFILE_ZONE_LINE(name,__LINE__)
+#else
+//scoped zones need the cleanup attribute, use GFC_PROFILE_BEGIN/END with other compilers
+#define GFC_PROFILE_ZONE(name)
+#endif
+
+#else
+
+#define GFC_PROFILE_BEGIN(name)
+#define GFC_PROFILE_END()
+#define GFC_PROFILE_COUNT(counter,amount)
+#define GFC_PROFILE_ZONE(name)
+
+#endif
+
+#endif
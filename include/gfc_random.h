@@ -0,0 +1,206 @@
+#ifndef __GFC_RANDOM_H__
+#define __GFC_RANDOM_H__
+
+#include <SDL.h>
+
+#include "gfc_vector.h"
+
+/**
+ * @purpose gfc_random is a small fast random number generator that does not share state with rand().
+ * Each gfcRng is its own stream (xoshiro128++), so systems and threads can have their own without
+ * reseeding each other.  gfc_rng_thread() gives each thread a stream of its own for code that does not
+ * want to carry one around.
+ * The hash functions are stateless: the same cell and seed always give the same number, for procedural
+ * generation where things have to come out the same no matter what order they are made in.
+ * @note none of this is suitable for cryptography
+ */
+
+/**
+ * the generator step and the hashes are defined in this header so they can be inlined, gfc_random.c defines
+ * GFC_RANDOM_IMPLEMENTATION to export the out of line versions.  See gfc_vector.h
+ */
+#ifdef GFC_RANDOM_IMPLEMENTATION
+#define GFC_RANDOM_INLINE
+#else
+#define GFC_RANDOM_INLINE static inline
+#endif
+
+typedef struct
+{
+    Uint32 s[4];    /**<xoshiro128++ state, never all zero.  Set it with gfc_rng_seed()*/
+}gfcRng;
+
+/**
+ * @brief get the next 32 random bits from a stream
+ * @param rng the stream to advance
+ * @return the random bits
+ */
+GFC_RANDOM_INLINE Uint32 gfc_rng_next(gfcRng *rng)
+{
+    Uint32 *s = rng->s;
+    Uint32 result,t;
+    result = s[0] + s[3];
+    result = ((result << 7) | (result >> 25)) + s[0];
+    t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 11) | (s[3] >> 21);
+    return result;
+}
+
+/**
+ * @brief get a random float from a stream
+ * @param rng the stream to advance
+ * @return a float from 0 up to but not including 1, in steps of 2^-24
+ */
+GFC_RANDOM_INLINE float gfc_rng_float(gfcRng *rng)
+{
+    return (gfc_rng_next(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * @brief hash a 3D cell and a seed into 32 well mixed bits
+ * @param x the cell x
+ * @param y the cell y
+ * @param z the cell z
+ * @param seed the seed, different seeds give unrelated results
+ * @return the hash
+ */
+GFC_RANDOM_INLINE Uint32 gfc_random_hash3(Sint32 x,Sint32 y,Sint32 z,Uint32 seed)
+{
+    Uint32 h = seed;
+    h ^= (Uint32)x * 0x27d4eb2du;
+    h = (h ^ (h >> 15)) * 0x2c1b3c6du;
+    h ^= (Uint32)y * 0x165667b1u;
+    h = (h ^ (h >> 12)) * 0x297a2d39u;
+    h ^= (Uint32)z * 0x9e3779b1u;
+    h = (h ^ (h >> 15)) * 0x2c1b3c6du;
+    return h ^ (h >> 16);
+}
+
+/**
+ * @brief hash a 2D cell and a seed into 32 well mixed bits, for per cell randomness
+ * @param x the cell x
+ * @param y the cell y
+ * @param seed the seed, different seeds give unrelated results
+ * @return the hash
+ */
+GFC_RANDOM_INLINE Uint32 gfc_random_hash(Sint32 x,Sint32 y,Uint32 seed)
+{
+    return gfc_random_hash3(x,y,0,seed);
+}
+
+/**
+ * @brief hash a 2D cell and a seed into a float
+ * @param x the cell x
+ * @param y the cell y
+ * @param seed the seed
+ * @return a float from 0 up to but not including 1
+ */
+GFC_RANDOM_INLINE float gfc_random_hash_float(Sint32 x,Sint32 y,Uint32 seed)
+{
+    return (gfc_random_hash(x,y,seed) >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * @brief seed a stream
+ * @param rng the stream to seed
+ * @param seed any value, including 0.  The same seed always gives the same stream
+ */
+void gfc_rng_seed(gfcRng *rng,Uint64 seed);
+
+/**
+ * @brief make a seeded stream
+ * @param seed any value, including 0
+ * @return the stream
+ */
+gfcRng gfc_rng(Uint64 seed);
+
+/**
+ * @brief get the calling thread's own stream
+ * @note it is seeded from the clock and thread id the first time it is used, unless gfc_rng_thread_seed() was called
+ * @return the stream, only use it from the thread that got it
+ */
+gfcRng *gfc_rng_thread();
+
+/**
+ * @brief seed the calling thread's stream, for repeatable runs
+ * @param seed the seed
+ */
+void gfc_rng_thread_seed(Uint64 seed);
+
+/**
+ * @brief advance a stream 2^64 steps, for splitting one seed into streams that will not overlap
+ * @note copy the stream then jump the copy, once for each extra stream needed
+ * @param rng the stream to advance
+ */
+void gfc_rng_jump(gfcRng *rng);
+
+/**
+ * @brief get a random float from -1 up to but not including 1
+ * @param rng the stream to advance
+ * @return the float
+ */
+float gfc_rng_cfloat(gfcRng *rng);
+
+/**
+ * @brief get a random integer below a limit, without the bias of % n
+ * @param rng the stream to advance
+ * @param n the limit
+ * @return 0 to n - 1, 0 if n is 0
+ */
+Uint32 gfc_rng_int(gfcRng *rng,Uint32 n);
+
+/**
+ * @brief get a random integer in a range
+ * @param rng the stream to advance
+ * @param min the lowest value it can return
+ * @param max the highest value it can return
+ * @return min to max, including both
+ */
+Sint32 gfc_rng_range(gfcRng *rng,Sint32 min,Sint32 max);
+
+/**
+ * @brief get a random float in a range
+ * @param rng the stream to advance
+ * @param min the lowest value
+ * @param max the top of the range
+ * @return min up to but not including max
+ */
+float gfc_rng_range_float(gfcRng *rng,float min,float max);
+
+/**
+ * @brief get a random 2D direction
+ * @param rng the stream to advance
+ * @return a unit vector pointing any way at all
+ */
+Vector2D gfc_rng_vector2d_unit(gfcRng *rng);
+
+/**
+ * @brief get a random 3D direction, spread evenly over the sphere
+ * @param rng the stream to advance
+ * @return a unit vector pointing any way at all
+ */
+Vector3D gfc_rng_vector3d_unit(gfcRng *rng);
+
+/**
+ * @brief get a random point in a box
+ * @param rng the stream to advance
+ * @param min the low corner
+ * @param max the high corner
+ * @return a point from min up to but not including max on each axis
+ */
+Vector3D gfc_rng_vector3d_range(gfcRng *rng,Vector3D min,Vector3D max);
+
+/**
+ * @brief fill an array with random floats, the same as calling gfc_rng_float() count times
+ * @param rng the stream to advance
+ * @param out where to write
+ * @param count how many floats to write
+ */
+void gfc_rng_fill_floats(gfcRng *rng,float *out,Uint32 count);
+
+#endif
@@ -11,7 +11,14 @@
 
 /**
  * @purpose gfc_shapes is meant to provide a common way to represent simple 2D shapes and test collisions based on them
+ * @note the shape constructors are defined in this header so they can be inlined, gfc_shape.c defines
+ * GFC_SHAPE_IMPLEMENTATION to export the out of line versions.  See gfc_vector.h
  */
+#ifdef GFC_SHAPE_IMPLEMENTATION
+#define GFC_SHAPE_INLINE
+#else
+#define GFC_SHAPE_INLINE static inline
+#endif
 
 typedef struct
 {
@@ -72,14 +79,25 @@ int gfc_shape_from_json(SJson *json,Shape *shape);
  * @param h the height of the rect
  * @return a GF2D rect
  */
-Rect gfc_rect(float x, float y, float w, float h);
+GFC_SHAPE_INLINE Rect gfc_rect(float x, float y, float w, float h)
+{
+    Rect r;
+    r.x = x;
+    r.y = y;
+    r.w = w;
+    r.h = h;
+    return r;
+}
 
 /**
  * @brief make a GF2D Rect
  * @param v the vector holding rect info
  * @return a GF2D rect
  */
-Rect gfc_rect_from_vector4(Vector4D v);
+GFC_SHAPE_INLINE Rect gfc_rect_from_vector4(Vector4D v)
+{
+    return gfc_rect(v.x,v.y,v.z,v.w);
+}
 
 /**
  * @brief make a shape based on a rect
@@ -88,26 +106,44 @@ Rect gfc_rect_from_vector4(Vector4D v);
  * @param w the width
  * @param h the height
  */
-Shape gfc_shape_rect(float x, float y, float w, float h);
+GFC_SHAPE_INLINE Shape gfc_shape_rect(float x, float y, float w, float h)
+{
+    Shape shape;
+    shape.type = ST_RECT;
+    shape.s.r = gfc_rect(x,y,w,h);
+    return shape;
+}
 
 /**
  * @brief convert a rect to a vector4d
  * @param r the rect to convert
  * @returns a vector4f
  */
-Vector4D gfc_rect_to_vector4d(Rect r);
+GFC_SHAPE_INLINE Vector4D gfc_rect_to_vector4d(Rect r)
+{
+    return vector4d(r.x,r.y,r.w,r.h);
+}
 
 /**
  * @brief make a shape based on a gf2d rect
  * @param r the rect to base it on
  */
-Shape gfc_shape_from_rect(Rect r);
+GFC_SHAPE_INLINE Shape gfc_shape_from_rect(Rect r)
+{
+    Shape shape;
+    shape.type = ST_RECT;
+    shape.s.r = r;
+    return shape;
+}
 
 /**
  * @brief make a shape based on a SDL rect
  * @param r the rect to base it on
  */
-Shape gfc_shape_from_sdl_rect(SDL_Rect r);
+GFC_SHAPE_INLINE Shape gfc_shape_from_sdl_rect(SDL_Rect r)
+{
+    return gfc_shape_rect(r.x,r.y,r.w,r.h);
+}
 
 /**
  * @brief make a shape based on a circle
@@ -115,14 +151,28 @@ Shape gfc_shape_from_sdl_rect(SDL_Rect r);
  * @param y the center y
  * @param r the radius
  */
-Shape gfc_shape_circle(float x, float y, float r);
+GFC_SHAPE_INLINE Shape gfc_shape_circle(float x, float y, float r)
+{
+    Shape shape;
+    shape.type = ST_CIRCLE;
+    shape.s.c.x = x;
+    shape.s.c.y = y;
+    shape.s.c.r = r;
+    return shape;
+}
 
 /**
  * @brief make a shape based on a gf2d Circle
  * @param c the circle to make the shape with
  * @return the shape
  */
-Shape gfc_shape_from_circle(Circle c);
+GFC_SHAPE_INLINE Shape gfc_shape_from_circle(Circle c)
+{
+    Shape shape;
+    shape.type = ST_CIRCLE;
+    shape.s.c = c;
+    return shape;
+}
 
 /**
  * @brief get a circle from the shape
@@ -139,14 +189,29 @@ Circle gfc_shape_to_circle(Shape s);
  * @param y2 the Y component of ending point
  * @return the shape
  */
-Shape gfc_shape_edge(float x1,float y1,float x2,float y2);
+GFC_SHAPE_INLINE Shape gfc_shape_edge(float x1,float y1,float x2,float y2)
+{
+    Shape shape;
+    shape.type = ST_EDGE;
+    shape.s.e.x1 = x1;
+    shape.s.e.y1 = y1;
+    shape.s.e.x2 = x2;
+    shape.s.e.y2 = y2;
+    return shape;
+}
 
 /**
  * @brief make a shape based on a gf2d Edge
  * @param e the edge to make the shape with
  * @return the shape
  */
-Shape gfc_shape_from_edge(Edge e);
+GFC_SHAPE_INLINE Shape gfc_shape_from_edge(Edge e)
+{
+    Shape shape;
+    shape.type = ST_EDGE;
+    shape.s.e = e;
+    return shape;
+}
 
 /**
  * @brief set all parameters of a GF2D rect at once
@@ -173,7 +238,13 @@ Shape gfc_shape_from_edge(Edge e);
  * @param r the rectangle to check
  * @return true if the point is inside the rectangle, false otherwise
  */
-Uint8 gfc_point_in_rect(Vector2D p,Rect r);
+GFC_SHAPE_INLINE Uint8 gfc_point_in_rect(Vector2D p,Rect r)
+{
+    if ((p.x >= r.x) && (p.x <= r.x + r.w)&&
+        (p.y >= r.y) && (p.y <= r.y + r.h))
+        return 1;
+    return 0;
+}
 
 /**
  * @brief check if two rectangles are overlapping
@@ -200,7 +271,14 @@ Uint8 gfc_rect_overlap_poc(Rect a,Rect b,Vector2D *poc, Vector2D *normal);
  * @param y the position of the circle center
  * @param r the radius of the circle
  */
-Circle gfc_circle(float x, float y, float r);
+GFC_SHAPE_INLINE Circle gfc_circle(float x, float y, float r)
+{
+    Circle c;
+    c.x = x;
+    c.y = y;
+    c.r = r;
+    return c;
+}
 
 /**
  * @brief get the bounding circle for the given rectangle
@@ -228,7 +306,11 @@ Circle gfc_edge_get_bounding_circle(Edge e);
  * @param c the circle to check
  * @return true if the point is in the circle, false otherwise
  */
-Uint8 gfc_point_in_cicle(Vector2D p,Circle c);
+GFC_SHAPE_INLINE Uint8 gfc_point_in_cicle(Vector2D p,Circle c)
+{
+    if (vector2d_magnitude_compare(vector2d(c.x-p.x,c.y-p.y),c.r) <= 0)return 1;
+    return 0;
+}
 
 /**
  * @brief check if two circles are overlapping
@@ -309,14 +391,25 @@ Uint8 /**/gfc_shape_overlap_poc(Shape a, Shape b, Vector2D *poc, Vector2D *norma
  * @param r the GF2D rect to convert
  * @return an SDL rect
  */
-SDL_Rect gfc_rect_to_sdl_rect(Rect r);
+GFC_SHAPE_INLINE SDL_Rect gfc_rect_to_sdl_rect(Rect r)
+{
+    SDL_Rect r2;
+    r2.x = r.x;
+    r2.y = r.y;
+    r2.w = r.w;
+    r2.h = r.h;
+    return r2;
+}
 
 /**
  * @brief convert an SDL Rect to a GF2D rect
  * @param r the SDL Rect to convert
  * @return a GF2D rect
  */
-Rect gfc_rect_from_sdl_rect(SDL_Rect r);
+GFC_SHAPE_INLINE Rect gfc_rect_from_sdl_rect(SDL_Rect r)
+{
+    return gfc_rect(r.x,r.y,r.w,r.h);
+}
 
 /**
  * @brief change the position of the shape based on the movement vector
@@ -340,14 +433,25 @@ void gfc_shape_copy(Shape *dst,Shape src);
  * @param y2 the Y component of ending point
  * @return a set edge
  */
-Edge gfc_edge(float x1, float y1, float x2, float y2);
+GFC_SHAPE_INLINE Edge gfc_edge(float x1, float y1, float x2, float y2)
+{
+    Edge e;
+    e.x1 = x1;
+    e.y1 = y1;
+    e.x2 = x2;
+    e.y2 = y2;
+    return e;
+}
 
 /**
  * @brief return the length of the edge
  * @param e the edge in question
  * @return the length
  */
-float gfc_edge_length(Edge e);
+GFC_SHAPE_INLINE float gfc_edge_length(Edge e)
+{
+    return vector2d_magnitude(vector2d(e.x1 - e.x2,e.y1 - e.y2));
+}
 
 /**
  * @brief make an edge from two vectors
@@ -355,7 +459,10 @@ float gfc_edge_length(Edge e);
  * @param b the ending point vector
  * @return a set edge
  */
-Edge gfc_edge_from_vectors(Vector2D a,Vector2D b);
+GFC_SHAPE_INLINE Edge gfc_edge_from_vectors(Vector2D a,Vector2D b)
+{
+    return gfc_edge(a.x,a.y,b.x,b.y);
+}
 
 /**
  * @brief set an edge
@@ -493,6 +600,9 @@ Vector2D gfc_shape_get_normal_for_cirlce(Shape s, Circle c);
  * @param r the rectangle to use
  * @return the center point of the rect
  */
-Vector2D gfc_rect_get_center_point(Rect r);
+GFC_SHAPE_INLINE Vector2D gfc_rect_get_center_point(Rect r)
+{
+    return vector2d(r.x + r.w*0.5,r.y + r.h*0.5);
+}
 
 #endif
@@ -0,0 +1,227 @@
+#ifndef __GFC_SHAPE_BATCH_H__
+#define __GFC_SHAPE_BATCH_H__
+
+#include <SDL.h>
+
+#include "gfc_shape.h"
+
+/**
+ * @purpose gfc_shape_batch tests one shape against many shapes of a single type at once.
+ * The batch is stored structure of arrays in float32 so the tests can run four at a time with SSE2 or NEON.
+ * Results are a hit bitmask, one bit per shape in the batch, or a list of contacts.
+ * @note the scalar fallback gives the same results as the matching gfc_*_overlap_poc() functions.
+ * The SIMD paths work in float32 throughout where the scalar functions mix in doubles, so shapes that
+ * exactly touch can come out differently.  Contact lists are always confirmed with the gfc_*_poc() functions.
+ * Define GFC_SHAPE_BATCH_SCALAR (or GFC_NO_SIMD for the whole library) to force the scalar path.
+ */
+
+/**
+ * @brief how many Uint32 words a hit mask for count shapes needs
+ */
+#define gfc_shape_batch_mask_words(count) (((count) + 31) / 32)
+
+/**
+ * @brief check if the nth shape was hit in a hit mask
+ */
+#define gfc_shape_batch_hit(hits,n) (((hits)[(n) >> 5] >> ((n) & 31)) & 1)
+
+typedef struct
+{
+    float  *x,*y,*r;
+    Uint32  count;
+    Uint32  size;
+}gfcCircleBatch;
+
+typedef struct
+{
+    float  *x,*y,*w,*h;
+    Uint32  count;
+    Uint32  size;
+}gfcRectBatch;
+
+typedef struct
+{
+    float  *x1,*y1,*x2,*y2;
+    Uint32  count;
+    Uint32  size;
+}gfcEdgeBatch;
+
+/**
+ * @brief a contact found by a batch test
+ */
+typedef struct
+{
+    Uint32      index;  /**<which shape in the batch*/
+    Vector2D    poc;    /**<point of contact, as the matching gfc_*_poc() function finds it*/
+    Vector2D    normal;
+}gfcBatchContact;
+
+/**
+ * @brief make a new empty batch of circles
+ * @param count how many circles to make room for, it grows as needed
+ * @return NULL on error, the batch otherwise
+ */
+gfcCircleBatch *gfc_circle_batch_new(Uint32 count);
+
+/**
+ * @brief free a batch of circles
+ * @param batch the batch to free
+ */
+void gfc_circle_batch_free(gfcCircleBatch *batch);
+
+/**
+ * @brief add a circle to the batch
+ * @param batch the batch to add to
+ * @param c the circle to add
+ * @return -1 on error, the index of the circle otherwise
+ */
+int gfc_circle_batch_append(gfcCircleBatch *batch,Circle c);
+
+/**
+ * @brief change a circle in the batch
+ * @param batch the batch to change
+ * @param n which circle
+ * @param c the new circle
+ */
+void gfc_circle_batch_set(gfcCircleBatch *batch,Uint32 n,Circle c);
+
+/**
+ * @brief get a circle out of the batch
+ * @param batch the batch
+ * @param n which circle
+ * @return the circle, a zero circle if n is out of range
+ */
+Circle gfc_circle_batch_get(gfcCircleBatch *batch,Uint32 n);
+
+/**
+ * @brief make a new empty batch of rects
+ * @param count how many rects to make room for, it grows as needed
+ * @return NULL on error, the batch otherwise
+ */
+gfcRectBatch *gfc_rect_batch_new(Uint32 count);
+
+/**
+ * @brief free a batch of rects
+ * @param batch the batch to free
+ */
+void gfc_rect_batch_free(gfcRectBatch *batch);
+
+/**
+ * @brief add a rect to the batch
+ * @param batch the batch to add to
+ * @param r the rect to add
+ * @return -1 on error, the index of the rect otherwise
+ */
+int gfc_rect_batch_append(gfcRectBatch *batch,Rect r);
+
+/**
+ * @brief change a rect in the batch
+ * @param batch the batch to change
+ * @param n which rect
+ * @param r the new rect
+ */
+void gfc_rect_batch_set(gfcRectBatch *batch,Uint32 n,Rect r);
+
+/**
+ * @brief get a rect out of the batch
+ * @param batch the batch
+ * @param n which rect
+ * @return the rect, a zero rect if n is out of range
+ */
+Rect gfc_rect_batch_get(gfcRectBatch *batch,Uint32 n);
+
+/**
+ * @brief make a new empty batch of edges
+ * @param count how many edges to make room for, it grows as needed
+ * @return NULL on error, the batch otherwise
+ */
+gfcEdgeBatch *gfc_edge_batch_new(Uint32 count);
+
+/**
+ * @brief free a batch of edges
+ * @param batch the batch to free
+ */
+void gfc_edge_batch_free(gfcEdgeBatch *batch);
+
+/**
+ * @brief add an edge to the batch
+ * @param batch the batch to add to
+ * @param e the edge to add
+ * @return -1 on error, the index of the edge otherwise
+ */
+int gfc_edge_batch_append(gfcEdgeBatch *batch,Edge e);
+
+/**
+ * @brief change an edge in the batch
+ * @param batch the batch to change
+ * @param n which edge
+ * @param e the new edge
+ */
+void gfc_edge_batch_set(gfcEdgeBatch *batch,Uint32 n,Edge e);
+
+/**
+ * @brief get an edge out of the batch
+ * @param batch the batch
+ * @param n which edge
+ * @return the edge, a zero edge if n is out of range
+ */
+Edge gfc_edge_batch_get(gfcEdgeBatch *batch,Uint32 n);
+
+/**
+ * @brief test one circle against every circle in a batch, as gfc_circle_overlap_poc()
+ * @param a the circle to test
+ * @param batch the circles to test against
+ * @param hits (optional) gfc_shape_batch_mask_words(batch->count) words that will be set to the hit mask
+ * @return how many circles were hit
+ */
+Uint32 gfc_circle_overlap_batch(Circle a,gfcCircleBatch *batch,Uint32 *hits);
+
+/**
+ * @brief test one rect against every rect in a batch, as gfc_rect_overlap_poc()
+ * @param a the rect to test
+ * @param batch the rects to test against
+ * @param hits (optional) gfc_shape_batch_mask_words(batch->count) words that will be set to the hit mask
+ * @return how many rects were hit
+ */
+Uint32 gfc_rect_overlap_batch(Rect a,gfcRectBatch *batch,Uint32 *hits);
+
+/**
+ * @brief test one edge against every edge in a batch, as gfc_edge_intersect_poc()
+ * @param a the edge to test
+ * @param batch the edges to test against
+ * @param hits (optional) gfc_shape_batch_mask_words(batch->count) words that will be set to the hit mask
+ * @return how many edges were hit
+ */
+Uint32 gfc_edge_intersect_batch(Edge a,gfcEdgeBatch *batch,Uint32 *hits);
+
+/**
+ * @brief test one circle against every circle in a batch and list the contacts
+ * @param a the circle to test
+ * @param batch the circles to test against
+ * @param contacts where to write the contacts
+ * @param maxContacts how many contacts there is room for
+ * @return how many contacts were written
+ */
+Uint32 gfc_circle_overlap_batch_contacts(Circle a,gfcCircleBatch *batch,gfcBatchContact *contacts,Uint32 maxContacts);
+
+/**
+ * @brief test one rect against every rect in a batch and list the contacts
+ * @param a the rect to test
+ * @param batch the rects to test against
+ * @param contacts where to write the contacts
+ * @param maxContacts how many contacts there is room for
+ * @return how many contacts were written
+ */
+Uint32 gfc_rect_overlap_batch_contacts(Rect a,gfcRectBatch *batch,gfcBatchContact *contacts,Uint32 maxContacts);
+
+/**
+ * @brief test one edge against every edge in a batch and list the contacts
+ * @param a the edge to test
+ * @param batch the edges to test against
+ * @param contacts where to write the contacts
+ * @param maxContacts how many contacts there is room for
+ * @return how many contacts were written
+ */
+Uint32 gfc_edge_intersect_batch_contacts(Edge a,gfcEdgeBatch *batch,gfcBatchContact *contacts,Uint32 maxContacts);
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef __GFC_SIMD_H__
+#define __GFC_SIMD_H__
+
+/**
+ * @purpose gfc_simd picks the SIMD instruction set to build the math and collision code with.
+ * It is chosen at build time from what the compiler targets:
+ *  - x86: SSE2 is always used on x86-64.  Build with -msse4.1 or -mavx to let the compiler use those as well
+ *  - ARM: NEON on aarch64
+ * Define GFC_NO_SIMD to build the plain scalar versions instead.
+ * This is an internal header, only the 4 wide float operations the library needs are here.
+ */
+
+#include <SDL.h>
+
+#if defined(_MSC_VER)
+#define GFC_ALIGN16_PRE __declspec(align(16))
+#define GFC_ALIGN16_POST
+#else
+#define GFC_ALIGN16_PRE
+#define GFC_ALIGN16_POST __attribute__((aligned(16)))
+#endif
+
+#if !defined(GFC_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define GFC_SIMD_SSE 1
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+typedef __m128 gfc_f4;
+typedef __m128 gfc_m4;
+#define gfc_f4_load(p)      _mm_loadu_ps(p)
+#define gfc_f4_store(p,a)   _mm_storeu_ps(p,a)
+#define gfc_f4_set1(v)      _mm_set1_ps(v)
+#define gfc_f4_set(x,y,z,w) _mm_setr_ps(x,y,z,w)
+#define gfc_f4_add(a,b)     _mm_add_ps(a,b)
+#define gfc_f4_sub(a,b)     _mm_sub_ps(a,b)
+#define gfc_f4_mul(a,b)     _mm_mul_ps(a,b)
+#define gfc_f4_div(a,b)     _mm_div_ps(a,b)
+#define gfc_f4_max(a,b)     _mm_max_ps(a,b)
+#define gfc_f4_min(a,b)     _mm_min_ps(a,b)
+#define gfc_f4_sqrt(a)      _mm_sqrt_ps(a)
+#define gfc_f4_le(a,b)      _mm_cmple_ps(a,b)
+#define gfc_f4_gt(a,b)      _mm_cmpgt_ps(a,b)
+#define gfc_f4_ne(a,b)      _mm_cmpneq_ps(a,b)
+#define gfc_m4_and(a,b)     _mm_and_ps(a,b)
+#define gfc_m4_or(a,b)      _mm_or_ps(a,b)
+#define gfc_m4_bits(m)      ((Uint32)_mm_movemask_ps(m))
+#define gfc_f4_select(m,a,b) _mm_or_ps(_mm_and_ps(m,a),_mm_andnot_ps(m,b))
+
+/**
+ * @brief sum each of four vectors, returns (sum a,sum b,sum c,sum d)
+ */
+static inline gfc_f4 gfc_f4_hsum4(gfc_f4 a,gfc_f4 b,gfc_f4 c,gfc_f4 d)
+{
+    _MM_TRANSPOSE4_PS(a,b,c,d);
+    return _mm_add_ps(_mm_add_ps(a,b),_mm_add_ps(c,d));
+}
+
+/**
+ * @brief load 16 floats and transpose them, so a gets p[0],p[4],p[8],p[12], b gets p[1],p[5]... etc
+ * @note good for loading four structures of four floats into one vector per field
+ */
+static inline void gfc_f4_load_transpose(const float *p,gfc_f4 *a,gfc_f4 *b,gfc_f4 *c,gfc_f4 *d)
+{
+    __m128 r0 = _mm_loadu_ps(p),r1 = _mm_loadu_ps(p + 4),r2 = _mm_loadu_ps(p + 8),r3 = _mm_loadu_ps(p + 12);
+    _MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+    *a = r0;
+    *b = r1;
+    *c = r2;
+    *d = r3;
+}
+
+/**
+ * @brief truncate four vectors to integers and store each lane as a | b << sb | c << sc | d << sd
+ * @note values must already be in 0-255, used to pack colors into pixels
+ */
+static inline void gfc_f4_store_packed(Uint32 *out,gfc_f4 a,gfc_f4 b,gfc_f4 c,gfc_f4 d,int sa,int sb,int sc,int sd)
+{
+    __m128i v = _mm_sll_epi32(_mm_cvttps_epi32(a),_mm_cvtsi32_si128(sa));
+    v = _mm_or_si128(v,_mm_sll_epi32(_mm_cvttps_epi32(b),_mm_cvtsi32_si128(sb)));
+    v = _mm_or_si128(v,_mm_sll_epi32(_mm_cvttps_epi32(c),_mm_cvtsi32_si128(sc)));
+    v = _mm_or_si128(v,_mm_sll_epi32(_mm_cvttps_epi32(d),_mm_cvtsi32_si128(sd)));
+    _mm_storeu_si128((__m128i *)out,v);
+}
+
+/**
+ * @brief fast 1/sqrt(v), accurate to about 22 bits
+ */
+static inline float gfc_rsqrt(float v)
+{
+    __m128 x = _mm_set_ss(v);
+    __m128 r = _mm_rsqrt_ss(x);
+    //one newton raphson step: r * (1.5 - 0.5 * x * r * r)
+    r = _mm_mul_ss(r,_mm_sub_ss(_mm_set_ss(1.5f),_mm_mul_ss(_mm_mul_ss(_mm_set_ss(0.5f),x),_mm_mul_ss(r,r))));
+    return _mm_cvtss_f32(r);
+}
+
+#elif !defined(GFC_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#define GFC_SIMD_NEON 1
+#include <arm_neon.h>
+typedef float32x4_t gfc_f4;
+typedef uint32x4_t gfc_m4;
+#define gfc_f4_load(p)      vld1q_f32(p)
+#define gfc_f4_store(p,a)   vst1q_f32(p,a)
+#define gfc_f4_set1(v)      vdupq_n_f32(v)
+#define gfc_f4_add(a,b)     vaddq_f32(a,b)
+#define gfc_f4_sub(a,b)     vsubq_f32(a,b)
+#define gfc_f4_mul(a,b)     vmulq_f32(a,b)
+#define gfc_f4_div(a,b)     vdivq_f32(a,b)
+#define gfc_f4_max(a,b)     vmaxq_f32(a,b)
+#define gfc_f4_min(a,b)     vminq_f32(a,b)
+#define gfc_f4_sqrt(a)      vsqrtq_f32(a)
+#define gfc_f4_le(a,b)      vcleq_f32(a,b)
+#define gfc_f4_gt(a,b)      vcgtq_f32(a,b)
+#define gfc_f4_ne(a,b)      vmvnq_u32(vceqq_f32(a,b))
+#define gfc_m4_and(a,b)     vandq_u32(a,b)
+#define gfc_m4_or(a,b)      vorrq_u32(a,b)
+#define gfc_f4_select(m,a,b) vbslq_f32(m,a,b)
+
+static inline gfc_f4 gfc_f4_set(float x,float y,float z,float w)
+{
+    float v[4] = {x,y,z,w};
+    return vld1q_f32(v);
+}
+
+static inline Uint32 gfc_m4_bits(gfc_m4 m)
+{
+    static const uint32_t bits[4] = {1,2,4,8};
+    return vaddvq_u32(vandq_u32(m,vld1q_u32(bits)));
+}
+
+static inline gfc_f4 gfc_f4_hsum4(gfc_f4 a,gfc_f4 b,gfc_f4 c,gfc_f4 d)
+{
+    return vpaddq_f32(vpaddq_f32(a,b),vpaddq_f32(c,d));
+}
+
+static inline void gfc_f4_load_transpose(const float *p,gfc_f4 *a,gfc_f4 *b,gfc_f4 *c,gfc_f4 *d)
+{
+    float32x4x4_t v = vld4q_f32(p);
+    *a = v.val[0];
+    *b = v.val[1];
+    *c = v.val[2];
+    *d = v.val[3];
+}
+
+static inline void gfc_f4_store_packed(Uint32 *out,gfc_f4 a,gfc_f4 b,gfc_f4 c,gfc_f4 d,int sa,int sb,int sc,int sd)
+{
+    uint32x4_t v = vshlq_u32(vcvtq_u32_f32(a),vdupq_n_s32(sa));
+    v = vorrq_u32(v,vshlq_u32(vcvtq_u32_f32(b),vdupq_n_s32(sb)));
+    v = vorrq_u32(v,vshlq_u32(vcvtq_u32_f32(c),vdupq_n_s32(sc)));
+    v = vorrq_u32(v,vshlq_u32(vcvtq_u32_f32(d),vdupq_n_s32(sd)));
+    vst1q_u32((uint32_t *)out,v);
+}
+
+static inline float gfc_rsqrt(float v)
+{
+    float32x2_t x = vdup_n_f32(v);
+    float32x2_t r = vrsqrte_f32(x);
+    //the estimate is only about 8 bits, each vrsqrts step roughly doubles that
+    r = vmul_f32(r,vrsqrts_f32(vmul_f32(x,r),r));
+    r = vmul_f32(r,vrsqrts_f32(vmul_f32(x,r),r));
+    return vget_lane_f32(r,0);
+}
+
+#else
+#include <math.h>
+static inline float gfc_rsqrt(float v)
+{
+    return 1.0f / sqrtf(v);
+}
+#endif
+
+#if defined(GFC_SIMD_SSE) || defined(GFC_SIMD_NEON)
+#define GFC_SIMD 1
+#endif
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef __GFC_SPATIAL_H__
+#define __GFC_SPATIAL_H__
+
+#include <SDL.h>
+
+#include "gfc_shape.h"
+
+/**
+ * @purpose gfc_spatial is a broadphase for gfc_shapes.  Shapes are bucketed into a uniform grid by their bounds
+ * so queries and overlap pair generation only test shapes that share grid cells, instead of every pair.
+ * Results are confirmed with the exact gfc_shape tests before they are reported.
+ * @note cells are hashed, so the world does not need to be bounded.  Pick a cell size around the size of a typical shape
+ * @note do not insert, move or remove shapes from within a query or pair callback
+ */
+typedef struct gfcSpatialIndex_S gfcSpatialIndex;
+
+/**
+ * @brief called for each shape found by a query
+ * @param proxy the handle of the shape that was found
+ * @param data the data it was inserted with
+ * @param context the context passed to the query
+ * @return 0 to stop the query, anything else to keep going
+ */
+typedef Uint8 (*gfcSpatialQueryFunc)(Uint32 proxy,void *data,void *context);
+
+/**
+ * @brief called for each overlapping pair of shapes
+ * @param a the handle of one shape
+ * @param b the handle of the other shape
+ * @param context the context passed to gfc_spatial_index_overlap_pairs()
+ */
+typedef void (*gfcSpatialPairFunc)(Uint32 a,Uint32 b,void *context);
+
+/**
+ * @brief make a new empty spatial index
+ * @param cellSize the width and height of a grid cell
+ * @return NULL on error, the index otherwise.  Free with gfc_spatial_index_free()
+ */
+gfcSpatialIndex *gfc_spatial_index_new(float cellSize);
+
+/**
+ * @brief free a spatial index
+ * @note does not touch any of the data the shapes were inserted with
+ * @param index the index to free
+ */
+void gfc_spatial_index_free(gfcSpatialIndex *index);
+
+/**
+ * @brief remove every shape from the index, keeping the shape storage for reuse and releasing the grid cells
+ * @param index the index to clear
+ */
+void gfc_spatial_index_clear(gfcSpatialIndex *index);
+
+/**
+ * @brief add a shape to the index
+ * @param index the index to add to
+ * @param shape the shape, it is copied
+ * @param data user data to keep with the shape
+ * @return 0 on error, a handle for the shape otherwise
+ */
+Uint32 gfc_spatial_index_insert(gfcSpatialIndex *index,Shape shape,void *data);
+
+/**
+ * @brief update a shape in the index; it only changes cells if its bounds moved to different cells
+ * @param index the index the shape is in
+ * @param proxy the handle from gfc_spatial_index_insert()
+ * @param shape the new shape
+ */
+void gfc_spatial_index_move(gfcSpatialIndex *index,Uint32 proxy,Shape shape);
+
+/**
+ * @brief remove a shape from the index.  The handle may be reused by a later insert
+ * @param index the index the shape is in
+ * @param proxy the handle from gfc_spatial_index_insert()
+ */
+void gfc_spatial_index_remove(gfcSpatialIndex *index,Uint32 proxy);
+
+/**
+ * @brief get the data a shape was inserted with
+ * @param index the index the shape is in
+ * @param proxy the handle of the shape
+ * @return NULL if not found, the data otherwise
+ */
+void *gfc_spatial_index_get_data(gfcSpatialIndex *index,Uint32 proxy);
+
+/**
+ * @brief get the shape for a handle
+ * @param index the index the shape is in
+ * @param proxy the handle of the shape
+ * @return NULL if not found, a pointer to the indexed shape otherwise.  Change it with gfc_spatial_index_move()
+ */
+const Shape *gfc_spatial_index_get_shape(gfcSpatialIndex *index,Uint32 proxy);
+
+/**
+ * @brief get how many shapes are in the index
+ * @param index the index to check
+ * @return the count
+ */
+Uint32 gfc_spatial_index_get_count(gfcSpatialIndex *index);
+
+/**
+ * @brief find every shape whose bounds overlap a region
+ * @param index the index to search
+ * @param region the area to search
+ * @param func (optional) called for each shape found
+ * @param context passed to func
+ * @return how many shapes were found
+ */
+Uint32 gfc_spatial_index_query_rect(gfcSpatialIndex *index,Rect region,gfcSpatialQueryFunc func,void *context);
+
+/**
+ * @brief find every shape that overlaps a shape, using gfc_shape_overlap()
+ * @param index the index to search
+ * @param shape the shape to test against
+ * @param func (optional) called for each shape found
+ * @param context passed to func
+ * @return how many shapes were found
+ */
+Uint32 gfc_spatial_index_query_shape(gfcSpatialIndex *index,Shape shape,gfcSpatialQueryFunc func,void *context);
+
+/**
+ * @brief find every shape an edge intersects, roughly in order from the start of the edge to the end
+ * @param index the index to search
+ * @param edge the edge to cast
+ * @param func (optional) called for each shape found
+ * @param context passed to func
+ * @return how many shapes were found
+ */
+Uint32 gfc_spatial_index_edge_cast(gfcSpatialIndex *index,Edge edge,gfcSpatialQueryFunc func,void *context);
+
+/**
+ * @brief find the shape an edge hits nearest its start
+ * @param index the index to search
+ * @param edge the edge to cast, from (x1,y1) to (x2,y2)
+ * @param poc (optional) if provided this will be populated with the point of contact
+ * @param normal (optional) if provided this will be populated with the normal at the point of contact
+ * @return 0 if nothing was hit, the handle of the shape otherwise
+ */
+Uint32 gfc_spatial_index_edge_cast_first(gfcSpatialIndex *index,Edge edge,Vector2D *poc,Vector2D *normal);
+
+/**
+ * @brief find every pair of shapes in the index that overlap, using gfc_shape_overlap()
+ * @note each pair is reported once
+ * @param index the index to search
+ * @param func (optional) called for each overlapping pair
+ * @param context passed to func
+ * @return how many pairs were found
+ */
+Uint32 gfc_spatial_index_overlap_pairs(gfcSpatialIndex *index,gfcSpatialPairFunc func,void *context);
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef __GFC_STRING_H__
+#define __GFC_STRING_H__
+
+#include <string.h>
+#include <SDL.h>
+
+#include "gfc_allocator.h"
+
+/**
+ * @purpose gfcString is a small string for names and keys that are kept in hot structures.
+ * Strings that fit in GFC_STRING_LOCAL_SIZE - 1 bytes are stored inside the struct, so most names never allocate.
+ * Longer strings are allocated.  The length and a hash are kept with the text, so two strings that differ are
+ * almost always told apart without looking at the text at all.
+ * A gfcString must be zeroed before it is first set, and cleared with gfc_string_clear() when done with it.
+ */
+
+/**
+ * the accessors and compares are defined in this header so they can be inlined, gfc_string.c defines
+ * GFC_STRING_IMPLEMENTATION to export the out of line versions.  See gfc_vector.h
+ */
+#ifdef GFC_STRING_IMPLEMENTATION
+#define GFC_STRING_INLINE
+#else
+#define GFC_STRING_INLINE static inline
+#endif
+
+#define GFC_STRING_LOCAL_SIZE 24    /**<strings shorter than this are stored in the struct*/
+#define GFC_STRING_HASH_SEED 5381   /**<the seed of the cached hash, the same as the default hashmap seed*/
+
+typedef struct
+{
+    union
+    {
+        char    local[GFC_STRING_LOCAL_SIZE];   /**<the text when it is short enough, nul terminated*/
+        char   *heap;                           /**<the text otherwise, nul terminated*/
+    }text;
+    Uint32      length;     /**<length of the text, not counting the nul*/
+    Uint32      hash;       /**<gfc_string_hash_seeded() of the text with GFC_STRING_HASH_SEED, zero for empty strings*/
+}gfcString;
+
+/**
+ * @brief hash text of a known length
+ * @param text the text to hash
+ * @param length how many bytes of text to hash
+ * @param seed the seed, different seeds give unrelated hashes
+ * @return the hash, never zero
+ */
+Uint32 gfc_string_hash_seeded(const char *text,size_t length,Uint32 seed);
+
+/**
+ * @brief hash a nul terminated string and measure it in one pass
+ * @param text the string to hash
+ * @param seed the seed
+ * @param length [output] if provided, set to the length of text
+ * @return the hash, the same as gfc_string_hash_seeded() gives for the same text
+ */
+Uint32 gfc_string_hash_cstr(const char *text,Uint32 seed,size_t *length);
+
+/**
+ * @brief get the text of a string
+ * @param str the string
+ * @return the nul terminated text, "" if str is NULL or was never set.  Valid until the string is set or cleared
+ */
+GFC_STRING_INLINE const char *gfc_string_cstr(const gfcString *str)
+{
+    if (!str)return "";
+    if (str->length < GFC_STRING_LOCAL_SIZE)return str->text.local;
+    return str->text.heap;
+}
+
+/**
+ * @brief get the length of a string
+ * @param str the string
+ * @return the length, 0 if str is NULL
+ */
+GFC_STRING_INLINE Uint32 gfc_string_length(const gfcString *str)
+{
+    if (!str)return 0;
+    return str->length;
+}
+
+/**
+ * @brief check if two strings are the same
+ * @param a one string
+ * @param b the other string
+ * @return 1 if they hold the same text, 0 otherwise
+ */
+GFC_STRING_INLINE Uint8 gfc_string_equal(const gfcString *a,const gfcString *b)
+{
+    if ((!a)||(!b))return 0;
+    if ((a->length != b->length)||(a->hash != b->hash))return 0;
+    return memcmp(gfc_string_cstr(a),gfc_string_cstr(b),a->length) == 0;
+}
+
+/**
+ * @brief check if a string holds the given text
+ * @param a the string
+ * @param text the text to compare to, does not need to be nul terminated
+ * @param length the length of text
+ * @return 1 if they match, 0 otherwise
+ */
+GFC_STRING_INLINE Uint8 gfc_string_equal_n(const gfcString *a,const char *text,size_t length)
+{
+    if ((!a)||(!text))return 0;
+    if (a->length != length)return 0;
+    return memcmp(gfc_string_cstr(a),text,length) == 0;
+}
+
+/**
+ * @brief check if a string holds the same text as a nul terminated string
+ * @param a the string
+ * @param text the text to compare to
+ * @return 1 if they match, 0 otherwise
+ */
+Uint8 gfc_string_equal_cstr(const gfcString *a,const char *text);
+
+/**
+ * @brief order two strings, for sorting
+ * @param a one string
+ * @param b the other string
+ * @return less than zero if a comes first, greater than zero if b does, 0 if they are the same, as strcmp()
+ */
+int gfc_string_cmp(const gfcString *a,const gfcString *b);
+
+/**
+ * @brief set the text of a string, freeing any text it had before
+ * @param str the string to set, zeroed or previously set
+ * @param text the text to copy in, NULL sets it empty
+ * @return -1 on error (the string is left empty), 0 otherwise
+ */
+int gfc_string_set(gfcString *str,const char *text);
+
+/**
+ * @brief set the text of a string from text of a known length
+ * @param str the string to set, zeroed or previously set
+ * @param text the text to copy in, it does not need to be nul terminated
+ * @param length how many bytes of text to copy
+ * @return -1 on error (the string is left empty), 0 otherwise
+ */
+int gfc_string_set_n(gfcString *str,const char *text,size_t length);
+
+/**
+ * @brief gfc_string_set_n() for strings that live in an allocator, long text is allocated from it
+ * @param str the string to set, zeroed or previously set from the same allocator
+ * @param text the text to copy in
+ * @param length how many bytes of text to copy
+ * @param allocator where to allocate long text from, NULL for the heap
+ * @return -1 on error (the string is left empty), 0 otherwise
+ */
+int gfc_string_set_allocator(gfcString *str,const char *text,size_t length,gfcAllocator *allocator);
+
+/**
+ * @brief copy one string into another, without hashing it again
+ * @param dst the string to set, zeroed or previously set
+ * @param src the string to copy
+ * @return -1 on error, 0 otherwise
+ */
+int gfc_string_copy(gfcString *dst,const gfcString *src);
+
+/**
+ * @brief free the text of a string and leave it empty and zeroed
+ * @param str the string to clear
+ */
+void gfc_string_clear(gfcString *str);
+
+/**
+ * @brief gfc_string_clear() for a string set with gfc_string_set_allocator()
+ * @param str the string to clear
+ * @param allocator the allocator its text came from
+ */
+void gfc_string_clear_allocator(gfcString *str,gfcAllocator *allocator);
+
+#endif
@@ -40,6 +40,7 @@ typedef short int Bool;
 
 /**
  * @brief generate a random float (0 -1) based on the provided seed
+ * @note the same seed always gives the same float.  It does not touch rand(), see gfc_random.h for streams
  * @param seed the seed for the random number
  */
 float gfc_random_seeded(Uint32 seed);
@@ -81,6 +82,15 @@ void *gfc_allocate_array(size_t typeSize,size_t count);
  */
 long get_file_Size(FILE *file);
 
+/**
+ * @brief marks a static as having its own copy in each thread
+ */
+#if defined(_MSC_VER)
+#define GFC_THREAD_LOCAL __declspec(thread)
+#else
+#define GFC_THREAD_LOCAL __thread
+#endif
+
 #if defined(WIN32)
 #ifndef snprintf
 #define snprintf _snprintf
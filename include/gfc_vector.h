@@ -22,8 +22,20 @@
     SOFTWARE.
  */
 
+#include <math.h>
 #include "gfc_types.h"
 
+/**
+ * The constructors and small component wise helpers are defined in this header so calls to them can be inlined.
+ * gfc_vector.c defines GFC_VECTOR_IMPLEMENTATION before including it, which makes them the out of line
+ * functions the library exports, so code built against older headers still links.
+ */
+#ifdef GFC_VECTOR_IMPLEMENTATION
+#define GFC_VECTOR_INLINE
+#else
+#define GFC_VECTOR_INLINE static inline
+#endif
+
 /*
  * The Vector Types
  * Not to be confused with the vector lists from STL
@@ -54,17 +66,38 @@ typedef struct
 /**
  * @brief create and return an Vector2D
  */
-Vector2D vector2d(float x, float y);
+GFC_VECTOR_INLINE Vector2D vector2d(float x, float y)
+{
+    Vector2D vec;
+    vec.x = x;
+    vec.y = y;
+    return vec;
+}
 
 /**
  * @brief create and return an Vector3D
  */
-Vector3D vector3d(float x, float y, float z);
+GFC_VECTOR_INLINE Vector3D vector3d(float x, float y, float z)
+{
+    Vector3D vec;
+    vec.x = x;
+    vec.y = y;
+    vec.z = z;
+    return vec;
+}
 
 /**
  * @brief create and return an Vector4D
  */
-Vector4D vector4d(float x, float y, float z, float w);
+GFC_VECTOR_INLINE Vector4D vector4d(float x, float y, float z, float w)
+{
+    Vector4D vec;
+    vec.x = x;
+    vec.y = y;
+    vec.z = z;
+    vec.w = w;
+    return vec;
+}
 
 /**
  * @brief sets the outvector to a unit vector pointing at the angle specified
@@ -173,9 +206,20 @@ void vector3d_cross_product(Vector3D *out, Vector3D v1, Vector3D v2);
  * @param b component of the multiplication
  * @return a vector multiplication product
  */
-Vector2D vector2d_multiply(Vector2D a, Vector2D b);
-Vector3D vector3d_multiply(Vector3D a, Vector3D b);
-Vector4D vector4d_multiply(Vector4D a, Vector4D b);
+GFC_VECTOR_INLINE Vector2D vector2d_multiply(Vector2D a, Vector2D b)
+{
+    return vector2d(a.x * b.x, a.y * b.y);
+}
+
+GFC_VECTOR_INLINE Vector3D vector3d_multiply(Vector3D a, Vector3D b)
+{
+    return vector3d(a.x * b.x, a.y * b.y, a.z * b.z);
+}
+
+GFC_VECTOR_INLINE Vector4D vector4d_multiply(Vector4D a, Vector4D b)
+{
+    return vector4d(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
+}
 
 /**
  * @brief copies the data from one vector into another
@@ -338,30 +382,72 @@ void vector4d_reflect(Vector4D *out, Vector4D normal,Vector4D in);
  *
  * @param v pointer to the vector to be normalized.
  */
-float vector2d_magnitude(Vector2D V);
-float vector3d_magnitude(Vector3D V);
-float vector4d_magnitude(Vector4D V);
+GFC_VECTOR_INLINE float vector2d_magnitude(Vector2D V)
+{
+    return sqrt(V.x * V.x + V.y * V.y);
+}
+
+GFC_VECTOR_INLINE float vector3d_magnitude(Vector3D V)
+{
+    return sqrt(V.x * V.x + V.y * V.y + V.z * V.z);
+}
+
+GFC_VECTOR_INLINE float vector4d_magnitude(Vector4D V)
+{
+    return sqrt(V.x * V.x + V.y * V.y + V.z * V.z + V.w * V.w);
+}
 
 /**
  * @brief get the magnitude of the difference of the two vectors
  */
-float vector2d_magnitude_between(Vector2D a,Vector2D b);
-float vector3d_magnitude_between(Vector3D a,Vector3D b);
-float vector4d_magnitude_between(Vector4D a,Vector4D b);
+GFC_VECTOR_INLINE float vector2d_magnitude_between(Vector2D a,Vector2D b)
+{
+    return vector2d_magnitude(vector2d(a.x - b.x,a.y - b.y));
+}
+
+GFC_VECTOR_INLINE float vector3d_magnitude_between(Vector3D a,Vector3D b)
+{
+    return vector3d_magnitude(vector3d(a.x - b.x,a.y - b.y,a.z - b.z));
+}
+
+GFC_VECTOR_INLINE float vector4d_magnitude_between(Vector4D a,Vector4D b)
+{
+    return vector4d_magnitude(vector4d(a.x - b.x,a.y - b.y,a.z - b.z,a.w - b.w));
+}
 
 void vector2d_normalize (Vector2D *V);
 void vector3d_normalize (Vector3D *V);
 void vector4d_normalize (Vector4D *V);
 
+/**
+ * @brief normalize the vector with a fast reciprocal square root.  does nothing for a zero length vector.
+ * @note the result is accurate to about 1 part in a million, use vector*_normalize where exact length matters
+ * @param V pointer to the vector to be normalized.
+ */
+void vector2d_normalize_fast (Vector2D *V);
+void vector3d_normalize_fast (Vector3D *V);
+void vector4d_normalize_fast (Vector4D *V);
+
 /**
  * @brief returns the magnitude squared, which is faster than getting the magnitude
  * which would involve taking the square root of a floating point number.
  * @param V the vector to get the magnitude for
  * @return the square of the magnitude of V
  */
-float vector2d_magnitude_squared(Vector2D V);
-float vector3d_magnitude_squared(Vector3D V);
-float vector4d_magnitude_squared(Vector4D V);
+GFC_VECTOR_INLINE float vector2d_magnitude_squared(Vector2D V)
+{
+    return (V.x * V.x + V.y * V.y);
+}
+
+GFC_VECTOR_INLINE float vector3d_magnitude_squared(Vector3D V)
+{
+    return (V.x * V.x + V.y * V.y + V.z * V.z);
+}
+
+GFC_VECTOR_INLINE float vector4d_magnitude_squared(Vector4D V)
+{
+    return (V.x * V.x + V.y * V.y + V.z * V.z + V.w * V.w);
+}
 
 /**
  * @brief checks if the magnitude of V against size.  It does this without
@@ -370,9 +456,32 @@ float vector4d_magnitude_squared(Vector4D V);
  * @param size the magnitude to check against
  * @return -1 f V is less than size, 0 if equal or 1 if size is greater than V
  */
-int  vector2d_magnitude_compare(Vector2D V,float size);
-int  vector3d_magnitude_compare(Vector3D V,float size);
-int  vector4d_magnitude_compare(Vector4D V,float size);
+GFC_VECTOR_INLINE int vector2d_magnitude_compare(Vector2D V,float size)
+{
+    float ms = vector2d_magnitude_squared(V);
+    float ss = size * size;
+    if (ms < ss)return -1;
+    if (ms == ss)return 0;
+    return 1;
+}
+
+GFC_VECTOR_INLINE int vector3d_magnitude_compare(Vector3D V,float size)
+{
+    float ms = vector3d_magnitude_squared(V);
+    float ss = size * size;
+    if (ms < ss)return -1;
+    if (ms == ss)return 0;
+    return 1;
+}
+
+GFC_VECTOR_INLINE int vector4d_magnitude_compare(Vector4D V,float size)
+{
+    float ms = vector4d_magnitude_squared(V);
+    float ss = size * size;
+    if (ms < ss)return -1;
+    if (ms == ss)return 0;
+    return 1;
+}
 
 /**
  * @brief scales the vector to the specified length without changing direction
@@ -391,9 +500,23 @@ void vector4d_set_magnitude(Vector4D * V,float magnitude);
  * @param size the value to check against
  * @return true if the distance between P1 and P2 is less than size, false otherwise
  */
-Bool vector2d_distance_between_less_than(Vector2D p1,Vector2D p2,float size);
-Bool vector3d_distance_between_less_than(Vector3D p1,Vector3D p2,float size);
-Bool vector4d_distance_between_less_than(Vector4D p1,Vector4D p2,float size);
+GFC_VECTOR_INLINE Bool vector2d_distance_between_less_than(Vector2D p1,Vector2D p2,float size)
+{
+    if (vector2d_magnitude_between(p1,p2) < size)return 1;
+    return 0;
+}
+
+GFC_VECTOR_INLINE Bool vector3d_distance_between_less_than(Vector3D p1,Vector3D p2,float size)
+{
+    if (vector3d_magnitude_between(p1,p2) < size)return 1;
+    return 0;
+}
+
+GFC_VECTOR_INLINE Bool vector4d_distance_between_less_than(Vector4D p1,Vector4D p2,float size)
+{
+    if (vector4d_magnitude_between(p1,p2) < size)return 1;
+    return 0;
+}
 
 /**
  * @brief given a rotation, get the component vectors  (in degrees!)
@@ -0,0 +1,61 @@
+#ifndef __GFC_WATCH_H__
+#define __GFC_WATCH_H__
+
+#include <SDL.h>
+
+#include "gfc_callbacks.h"
+
+/**
+ * @purpose gfc_watch tells subscribers when a content file changes while the game is running, so it can be
+ * reloaded on its own instead of restarting or reloading everything.
+ * Files are looked up through gfc_pak, so a watched file can be a loose file on disk or an entry in a pak.
+ * Each check looks at the modification time of each loose file and pak, which is cheap.  Only when that changed is
+ * the content hashed (the crc of a pak entry is already in the pak), and subscribers are only told when it differs,
+ * so saving a file without changing it, or rebuilding a pak where only one file changed, wakes only what changed.
+ * Files that do not exist yet can be watched, subscribers are told when they appear or go away.
+ * Checks poll the file system rather than use change notifications, so they work the same everywhere.
+ */
+
+/**
+ * @brief call a function whenever a file changes
+ * @param filename the file to watch, as it is loaded through gfc_pak
+ * @param onChange called after the file changes, on the thread calling gfc_watch_update(), or through the queue
+ * @param data passed to onChange
+ * @return 0 on error, an id for gfc_watch_remove() otherwise
+ */
+Uint32 gfc_watch_add(const char *filename,void (*onChange)(void *data),void *data);
+
+/**
+ * @brief stop calling a function for a file.  It is safe to call from an onChange callback
+ * @param watchId the id returned by gfc_watch_add()
+ */
+void gfc_watch_remove(Uint32 watchId);
+
+/**
+ * @brief check watched files for changes, at most once per interval
+ * @return how many watched files changed
+ * @note call once a frame.  gfc_pak_manager_refresh() is called first so changed paks are reopened
+ */
+Uint32 gfc_watch_update();
+
+/**
+ * @brief check every watched file for changes now, ignoring the interval
+ * @return how many watched files changed
+ */
+Uint32 gfc_watch_check();
+
+/**
+ * @brief set how often gfc_watch_update() looks at the files
+ * @param milliseconds time between checks, 0 checks on every update.  The default is 250
+ */
+void gfc_watch_set_interval(Uint32 milliseconds);
+
+/**
+ * @brief deliver change callbacks through a queue instead of calling them during gfc_watch_update()
+ * @param queue the queue to post to, NULL to call them right away again
+ * @note the queue is not owned by gfc_watch, drain it where reloading fits in the frame.  Callbacks of watches
+ * removed before the queue is drained are skipped
+ */
+void gfc_watch_set_callback_queue(gfcCallbackQueue *queue);
+
+#endif
@@ -0,0 +1,365 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_allocator.h"
+
+#define GFC_ALLOCATOR_ALIGN 16
+#define gfc_allocator_align(size) (((size) + (GFC_ALLOCATOR_ALIGN - 1)) & ~((size_t)GFC_ALLOCATOR_ALIGN - 1))
+
+struct gfcArenaBlock_S
+{
+    gfcArenaBlock  *next;
+    size_t          size;       /**<bytes of data after the header*/
+    size_t          offset;     /**<bytes of data in use*/
+};
+
+struct gfcPoolChunk_S
+{
+    gfcPoolChunk   *next;
+};
+
+#define gfc_arena_block_data(block) ((Uint8 *)(block) + gfc_allocator_align(sizeof(gfcArenaBlock)))
+#define gfc_pool_chunk_data(chunk) ((Uint8 *)(chunk) + gfc_allocator_align(sizeof(gfcPoolChunk)))
+
+#ifdef GFC_ALLOCATION_STATS
+/*heap allocations made through a NULL allocator are counted here, see gfc_allocator_heap_stats()*/
+static gfcAllocator gfc_heap_stats = {0};
+
+gfcAllocator *gfc_allocator_heap_stats()
+{
+    return &gfc_heap_stats;
+}
+#endif
+
+void *gfc_allocator_alloc(gfcAllocator *allocator,size_t typeSize,size_t count)
+{
+    if (!allocator)
+    {
+#ifdef GFC_ALLOCATION_STATS
+        gfc_heap_stats.allocations++;
+        gfc_heap_stats.bytes += typeSize * count;
+#endif
+        return gfc_allocate_array(typeSize,count);
+    }
+    if ((!typeSize)||(!count))
+    {
+        slog("cannot allocate zero bytes");
+        return NULL;
+    }
+    if (!allocator->allocate)
+    {
+        slog("allocator has no allocate function");
+        return NULL;
+    }
+    allocator->allocations++;
+    allocator->bytes += typeSize * count;
+    return allocator->allocate(allocator->context,typeSize * count);
+}
+
+void *gfc_allocator_realloc(gfcAllocator *allocator,void *ptr,size_t oldSize,size_t newSize)
+{
+    void *newPtr;
+    if (!allocator)
+    {
+#ifdef GFC_ALLOCATION_STATS
+        gfc_heap_stats.allocations++;
+        gfc_heap_stats.bytes += newSize;
+#endif
+        return realloc(ptr,newSize);
+    }
+    if (!ptr)return gfc_allocator_alloc(allocator,newSize,1);
+    if (newSize <= oldSize)return ptr;
+    if (allocator->reallocate)
+    {
+        allocator->allocations++;
+        allocator->bytes += newSize;
+        return allocator->reallocate(allocator->context,ptr,oldSize,newSize);
+    }
+    newPtr = gfc_allocator_alloc(allocator,newSize,1);
+    if (!newPtr)return NULL;
+    memcpy(newPtr,ptr,oldSize);
+    gfc_allocator_free(allocator,ptr);
+    return newPtr;
+}
+
+void gfc_allocator_free(gfcAllocator *allocator,void *ptr)
+{
+    if (!ptr)return;
+    if (!allocator)
+    {
+#ifdef GFC_ALLOCATION_STATS
+        gfc_heap_stats.releases++;
+#endif
+        free(ptr);
+        return;
+    }
+    allocator->releases++;
+    if (allocator->release)allocator->release(allocator->context,ptr);
+}
+
+void gfc_allocator_reset_stats(gfcAllocator *allocator)
+{
+    if (!allocator)return;
+    allocator->allocations = 0;
+    allocator->releases = 0;
+    allocator->bytes = 0;
+}
+
+/*arena*/
+
+static void *gfc_arena_allocator_allocate(void *context,size_t size)
+{
+    return gfc_arena_alloc((gfcArena *)context,size);
+}
+
+static void *gfc_arena_allocator_reallocate(void *context,void *ptr,size_t oldSize,size_t newSize)
+{
+    gfcArena *arena = (gfcArena *)context;
+    gfcArenaBlock *block;
+    void *newPtr;
+    block = arena->current;
+    if ((block)&&
+        ((Uint8 *)ptr + gfc_allocator_align(oldSize) == gfc_arena_block_data(block) + block->offset)&&
+        ((Uint8 *)ptr + newSize <= gfc_arena_block_data(block) + block->size))
+    {
+        //it was the last thing allocated, grow it in place
+        block->offset = ((Uint8 *)ptr - gfc_arena_block_data(block)) + gfc_allocator_align(newSize);
+        arena->used += gfc_allocator_align(newSize) - gfc_allocator_align(oldSize);
+        return ptr;
+    }
+    newPtr = gfc_arena_alloc(arena,newSize);
+    if (!newPtr)return NULL;
+    memcpy(newPtr,ptr,oldSize);
+    return newPtr;
+}
+
+gfcArena *gfc_arena_new(size_t blockSize)
+{
+    gfcArena *arena;
+    arena = gfc_allocate_array(sizeof(gfcArena),1);
+    if (!arena)return NULL;
+    arena->blockSize = blockSize?gfc_allocator_align(blockSize):65536;
+    arena->allocator.allocate = gfc_arena_allocator_allocate;
+    arena->allocator.reallocate = gfc_arena_allocator_reallocate;
+    arena->allocator.context = arena;
+    return arena;
+}
+
+void gfc_arena_free(gfcArena *arena)
+{
+    gfcArenaBlock *block,*next;
+    if (!arena)return;
+    for (block = arena->first; block != NULL; block = next)
+    {
+        next = block->next;
+        free(block);
+    }
+    free(arena);
+}
+
+static gfcArenaBlock *gfc_arena_block_new(size_t size)
+{
+    gfcArenaBlock *block;
+    block = malloc(gfc_allocator_align(sizeof(gfcArenaBlock)) + size);
+    if (!block)
+    {
+        slog("failed to allocate an arena block of %lu bytes",(unsigned long)size);
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+    block->offset = 0;
+    return block;
+}
+
+void *gfc_arena_alloc(gfcArena *arena,size_t size)
+{
+    gfcArenaBlock *block;
+    void *ptr;
+    if (!arena)return NULL;
+    size = gfc_allocator_align(size?size:1);
+    block = arena->current;
+    if ((!block)||(block->offset + size > block->size))
+    {
+        if ((block)&&(block->next)&&(size <= block->next->size))
+        {
+            //reuse a block left over from before the last reset
+            block = block->next;
+            block->offset = 0;
+        }
+        else
+        {
+            block = gfc_arena_block_new(MAX(size,arena->blockSize));
+            if (!block)return NULL;
+            if (arena->current)
+            {
+                block->next = arena->current->next;
+                arena->current->next = block;
+            }
+            else
+            {
+                block->next = arena->first;
+                arena->first = block;
+            }
+        }
+        arena->current = block;
+    }
+    ptr = gfc_arena_block_data(block) + block->offset;
+    block->offset += size;
+    arena->used += size;
+    memset(ptr,0,size);
+    return ptr;
+}
+
+void gfc_arena_reset(gfcArena *arena)
+{
+    if (!arena)return;
+    arena->current = arena->first;
+    if (arena->current)arena->current->offset = 0;
+    arena->used = 0;
+}
+
+gfcArenaMark gfc_arena_mark(gfcArena *arena)
+{
+    gfcArenaMark mark = {0};
+    if (!arena)return mark;
+    mark.block = arena->current;
+    mark.offset = arena->current?arena->current->offset:0;
+    mark.used = arena->used;
+    return mark;
+}
+
+void gfc_arena_rewind(gfcArena *arena,gfcArenaMark mark)
+{
+    if (!arena)return;
+    if (!mark.block)
+    {
+        gfc_arena_reset(arena);
+        return;
+    }
+    arena->current = mark.block;
+    arena->current->offset = mark.offset;
+    arena->used = mark.used;
+}
+
+gfcAllocator *gfc_arena_allocator(gfcArena *arena)
+{
+    if (!arena)return NULL;
+    return &arena->allocator;
+}
+
+/*pool*/
+
+static void *gfc_pool_allocator_allocate(void *context,size_t size)
+{
+    gfcPool *pool = (gfcPool *)context;
+    if (size > pool->elementSize)
+    {
+        slog("cannot allocate %lu bytes from a pool of %lu byte elements",(unsigned long)size,(unsigned long)pool->elementSize);
+        return NULL;
+    }
+    return gfc_pool_alloc(pool);
+}
+
+static void gfc_pool_allocator_release(void *context,void *ptr)
+{
+    gfc_pool_release((gfcPool *)context,ptr);
+}
+
+gfcPool *gfc_pool_new(size_t elementSize,Uint32 chunkCount)
+{
+    gfcPool *pool;
+    if (!elementSize)
+    {
+        slog("cannot make a pool of zero sized elements");
+        return NULL;
+    }
+    pool = gfc_allocate_array(sizeof(gfcPool),1);
+    if (!pool)return NULL;
+    //every element must be able to hold the free list link
+    pool->elementSize = gfc_allocator_align(MAX(elementSize,sizeof(void *)));
+    pool->chunkCount = chunkCount?chunkCount:64;
+    pool->allocator.allocate = gfc_pool_allocator_allocate;
+    pool->allocator.release = gfc_pool_allocator_release;
+    pool->allocator.context = pool;
+    return pool;
+}
+
+void gfc_pool_free(gfcPool *pool)
+{
+    gfcPoolChunk *chunk,*next;
+    if (!pool)return;
+    for (chunk = pool->chunks; chunk != NULL; chunk = next)
+    {
+        next = chunk->next;
+        free(chunk);
+    }
+    free(pool);
+}
+
+static void gfc_pool_chunk_link(gfcPool *pool,gfcPoolChunk *chunk)
+{
+    Uint32 i;
+    Uint8 *element;
+    for (i = pool->chunkCount; i > 0; i--)
+    {
+        element = gfc_pool_chunk_data(chunk) + (pool->elementSize * (i - 1));
+        *(void **)element = pool->freeList;
+        pool->freeList = element;
+    }
+}
+
+void *gfc_pool_alloc(gfcPool *pool)
+{
+    gfcPoolChunk *chunk;
+    void *element;
+    if (!pool)return NULL;
+    if (!pool->freeList)
+    {
+        chunk = malloc(gfc_allocator_align(sizeof(gfcPoolChunk)) + (pool->elementSize * pool->chunkCount));
+        if (!chunk)
+        {
+            slog("failed to allocate a pool chunk");
+            return NULL;
+        }
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+        gfc_pool_chunk_link(pool,chunk);
+    }
+    element = pool->freeList;
+    pool->freeList = *(void **)element;
+    pool->inUse++;
+    memset(element,0,pool->elementSize);
+    return element;
+}
+
+void gfc_pool_release(gfcPool *pool,void *element)
+{
+    if ((!pool)||(!element))return;
+    *(void **)element = pool->freeList;
+    pool->freeList = element;
+    if (pool->inUse)pool->inUse--;
+}
+
+void gfc_pool_reset(gfcPool *pool)
+{
+    gfcPoolChunk *chunk;
+    if (!pool)return;
+    pool->freeList = NULL;
+    for (chunk = pool->chunks; chunk != NULL; chunk = chunk->next)
+    {
+        gfc_pool_chunk_link(pool,chunk);
+    }
+    pool->inUse = 0;
+}
+
+gfcAllocator *gfc_pool_allocator(gfcPool *pool)
+{
+    if (!pool)return NULL;
+    return &pool->allocator;
+}
+
+/*eol@eof*/
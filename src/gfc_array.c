@@ -0,0 +1,180 @@
+#include <stdlib.h>
+
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_array.h"
+
+#define gfc_array_element(array,n) ((Uint8 *)(array)->elements + ((size_t)(n) * (array)->elementSize))
+
+gfcArray *gfc_array_new(Uint32 elementSize)
+{
+    return gfc_array_new_size(elementSize,16);
+}
+
+gfcArray *gfc_array_new_size(Uint32 elementSize,Uint32 count)
+{
+    gfcArray *array;
+    if (!elementSize)
+    {
+        slog("cannot make an array of zero sized elements");
+        return NULL;
+    }
+    if (!count)count = 1;
+    array = gfc_allocate_array(sizeof(gfcArray),1);
+    if (!array)
+    {
+        slog("failed to allocate space for the array");
+        return NULL;
+    }
+    array->elementSize = elementSize;
+    array->elements = gfc_allocate_array(elementSize,count);
+    if (!array->elements)
+    {
+        slog("failed to allocate space for array elements");
+        free(array);
+        return NULL;
+    }
+    array->size = count;
+    return array;
+}
+
+void gfc_array_delete(gfcArray *array)
+{
+    if (!array)return;
+    if (array->elements)free(array->elements);
+    free(array);
+}
+
+int gfc_array_reserve(gfcArray *array,Uint32 count)
+{
+    void *elements;
+    if (!array)
+    {
+        slog("no array provided");
+        return -1;
+    }
+    if (count <= array->size)return 0;
+    elements = realloc(array->elements,(size_t)array->elementSize * count);
+    if (!elements)
+    {
+        slog("failed to allocate space for array elements");
+        return -1;
+    }
+    array->elements = elements;
+    array->size = count;
+    return 0;
+}
+
+void *gfc_array_append(gfcArray *array,const void *element)
+{
+    void *slot;
+    if (!array)
+    {
+        slog("no array provided");
+        return NULL;
+    }
+    if ((array->count >= array->size)&&(gfc_array_reserve(array,array->size * 2) != 0))
+    {
+        slog("append failed due to lack of memory");
+        return NULL;
+    }
+    slot = gfc_array_element(array,array->count);
+    if (element)memcpy(slot,element,array->elementSize);
+    else memset(slot,0,array->elementSize);
+    array->count++;
+    return slot;
+}
+
+void *gfc_array_get_nth(gfcArray *array,Uint32 n)
+{
+    if ((!array)||(n >= array->count))return NULL;
+    return gfc_array_element(array,n);
+}
+
+void gfc_array_set_nth(gfcArray *array,Uint32 n,const void *element)
+{
+    if ((!array)||(!element)||(n >= array->count))return;
+    memcpy(gfc_array_element(array,n),element,array->elementSize);
+}
+
+int gfc_array_delete_nth(gfcArray *array,Uint32 n)
+{
+    if (!array)
+    {
+        slog("no array provided");
+        return -1;
+    }
+    if (n >= array->count)
+    {
+        slog("attempting to delete beyond the length of the array");
+        return -1;
+    }
+    array->count--;
+    if (n < array->count)
+    {
+        memmove(gfc_array_element(array,n),gfc_array_element(array,n + 1),(size_t)array->elementSize * (array->count - n));
+    }
+    return 0;
+}
+
+int gfc_array_swap_remove_nth(gfcArray *array,Uint32 n)
+{
+    if (!array)
+    {
+        slog("no array provided");
+        return -1;
+    }
+    if (n >= array->count)
+    {
+        slog("attempting to delete beyond the length of the array");
+        return -1;
+    }
+    array->count--;
+    if (n < array->count)
+    {
+        memcpy(gfc_array_element(array,n),gfc_array_element(array,array->count),array->elementSize);
+    }
+    return 0;
+}
+
+void gfc_array_clear(gfcArray *array)
+{
+    if (!array)return;
+    array->count = 0;
+}
+
+Uint32 gfc_array_get_count(gfcArray *array)
+{
+    if (!array)return 0;
+    return array->count;
+}
+
+void gfc_array_sort(gfcArray *array,int (*compare)(const void *a,const void *b))
+{
+    if ((!array)||(!compare))return;
+    if (array->count < 2)return;
+    qsort(array->elements,array->count,array->elementSize,compare);
+}
+
+void gfc_array_foreach(gfcArray *array,gfc_work_func function)
+{
+    Uint32 i;
+    if ((!array)||(!function))return;
+    for (i = 0; i < array->count; i++)
+    {
+        function(gfc_array_element(array,i));
+    }
+}
+
+void gfc_array_foreach_context(gfcArray *array,gfc_work_func_context function,void *contextData)
+{
+    Uint32 i;
+    if ((!array)||(!function))return;
+    for (i = 0; i < array->count; i++)
+    {
+        function(gfc_array_element(array,i),contextData);
+    }
+}
+
+/*eol@eof*/
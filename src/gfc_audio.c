@@ -1,8 +1,12 @@
+#include <stdio.h>
+
+#include "miniz.h"
 #include "simple_logger.h"
 #include "simple_json.h"
 
 #include "gfc_pak.h"
 #include "gfc_hashmap.h"
+#include "gfc_profile.h"
 #include "gfc_audio.h"
 
 
@@ -10,12 +14,55 @@ typedef struct
 {
     Uint32  max_sounds;
     Sound * sound_list;
-    gfcList  * sound_sequences;
+    HashMap *sound_index;   /**<filepath to Sound for every loaded sound*/
+    Uint32  *free_slots;    /**<stack of the slots that hold no sound*/
+    Uint32   free_count;
+    Sint32  *unused_next;   /**<links for the loaded sounds that are no longer referenced, oldest first*/
+    Sint32  *unused_prev;
+    Sint32   unused_head;
+    Sint32   unused_tail;
+    TextLine pcm_cache;     /**<directory decoded sounds are cached in by gfc_sound_pack_preload(), empty for none*/
 }SoundManager;
 
 static SoundManager sound_manager={0,NULL};
 
+/**
+ * @brief single producer single consumer ring of pointers.
+ * Only the producer moves tail and only the consumer moves head, so neither side ever waits on the other
+ */
+typedef struct
+{
+    void      **items;
+    Uint32      mask;   /**<size - 1, the size is a power of two*/
+    SDL_atomic_t head;  /**<next item to read*/
+    SDL_atomic_t tail;  /**<next item to write*/
+}SoundRing;
+
+#define GFC_SOUND_SEQUENCE_MAX 64   /**<how many sequences may be queued or playing at once*/
+
+/**
+ * @brief sequences are filled on the game thread and sent to the audio thread in the command ring.
+ * Only the audio thread touches the per channel queues and it sends finished sequences back in the free ring
+ */
+typedef struct
+{
+    SoundSequence  *pool;           /**<every sequence there is*/
+    SoundRing       commands;       /**<game to audio: sequences to queue*/
+    SoundRing       finished;       /**<audio to game: sequences that can be reused*/
+    SoundSequence  *spare;          /**<game thread only: a free sequence that was popped but not sent, used before popping another*/
+    int             channels;       /**<how many channels the queues cover*/
+    SoundSequence **channel_head;   /**<per channel, the playing sequence then the ones queued behind it*/
+    SoundSequence **channel_tail;
+    Uint32          pending;        /**<how many sequences are in the channel queues*/
+    gfcCallbackQueue *finished_queue;   /**<where channel finished callbacks are posted*/
+    void          (*finished_callback)(void *data);
+}SoundScheduler;
+
+static SoundScheduler sound_scheduler = {0};
+
 void gfc_sound_sequence_channel_callback(int channel);
+static void gfc_sound_sequence_postmix(int chan,void *stream,int len,void *udata);
+static void gfc_sound_sequence_init(int channels);
 
 void gfc_audio_close();
 void gfc_sound_init(Uint32 max);
@@ -48,9 +95,14 @@ void gfc_audio_init(
     {
         slog("failed to initialize some audio support: %s",SDL_GetError());
     }
+    if (channels)
+    {
+        Mix_AllocateChannels(channels);
+    }
     atexit(Mix_Quit);
     atexit(gfc_audio_close);
     gfc_sound_init(maxSounds);
+    gfc_sound_sequence_init(Mix_AllocateChannels(-1));
 }
 
 void gfc_audio_close()
@@ -60,12 +112,31 @@ void gfc_audio_close()
 void gfc_sound_close()
 {
     gfc_sound_clear_all();
+    if (sound_manager.sound_index != NULL)
+    {
+        gfc_hashmap_free(sound_manager.sound_index);
+    }
+    if (sound_manager.free_slots != NULL)free(sound_manager.free_slots);
+    if (sound_manager.unused_next != NULL)free(sound_manager.unused_next);
+    if (sound_manager.unused_prev != NULL)free(sound_manager.unused_prev);
     if (sound_manager.sound_list != NULL)
     {
         free(sound_manager.sound_list);
     }
-    sound_manager.sound_list = NULL;
-    sound_manager.max_sounds = 0;
+    memset(&sound_manager,0,sizeof(SoundManager));
+}
+
+static void gfc_sound_reset_slots()
+{
+    Uint32 i;
+    //pushed in reverse so slots are handed out from the front of the list first
+    for (i = 0; i < sound_manager.max_sounds; i++)
+    {
+        sound_manager.free_slots[i] = sound_manager.max_sounds - 1 - i;
+    }
+    sound_manager.free_count = sound_manager.max_sounds;
+    sound_manager.unused_head = -1;
+    sound_manager.unused_tail = -1;
 }
 
 void gfc_sound_init(Uint32 max)
@@ -77,11 +148,46 @@ void gfc_sound_init(Uint32 max)
     }
     sound_manager.max_sounds = max;
     sound_manager.sound_list = gfc_allocate_array(sizeof(Sound),max);
-    sound_manager.sound_sequences = gfc_list_new();
-    Mix_ChannelFinished(gfc_sound_sequence_channel_callback);
+    sound_manager.free_slots = gfc_allocate_array(sizeof(Uint32),max);
+    sound_manager.unused_next = gfc_allocate_array(sizeof(Sint32),max);
+    sound_manager.unused_prev = gfc_allocate_array(sizeof(Sint32),max);
+    sound_manager.sound_index = gfc_hashmap_new_size(max);
+    if ((!sound_manager.sound_list)||(!sound_manager.free_slots)||(!sound_manager.unused_next)||
+        (!sound_manager.unused_prev)||(!sound_manager.sound_index))
+    {
+        slog("failed to allocate the sound manager for %i sounds",max);
+        gfc_sound_close();
+        return;
+    }
+    gfc_sound_reset_slots();
     atexit(gfc_sound_close);
 }
 
+static Sint32 gfc_sound_get_slot(Sound *sound)
+{
+    return (Sint32)(sound - sound_manager.sound_list);
+}
+
+static void gfc_sound_unused_push(Sint32 slot)
+{
+    sound_manager.unused_next[slot] = -1;
+    sound_manager.unused_prev[slot] = sound_manager.unused_tail;
+    if (sound_manager.unused_tail >= 0)sound_manager.unused_next[sound_manager.unused_tail] = slot;
+    else sound_manager.unused_head = slot;
+    sound_manager.unused_tail = slot;
+}
+
+static void gfc_sound_unused_remove(Sint32 slot)
+{
+    Sint32 next,prev;
+    next = sound_manager.unused_next[slot];
+    prev = sound_manager.unused_prev[slot];
+    if (prev >= 0)sound_manager.unused_next[prev] = next;
+    else sound_manager.unused_head = next;
+    if (next >= 0)sound_manager.unused_prev[next] = prev;
+    else sound_manager.unused_tail = prev;
+}
+
 void gfc_sound_delete(Sound *sound)
 {
     if (!sound)return;
@@ -89,109 +195,206 @@ void gfc_sound_delete(Sound *sound)
     {
         Mix_FreeChunk(sound->sound);
     }    
+    gfc_string_clear(&sound->filepath);
     memset(sound,0,sizeof(Sound));//clean up all other data
 }
 
+/**
+ * @brief delete the sound in a slot and put the slot back on the free stack
+ * @note the slot must not be in the unused list
+ */
+static void gfc_sound_release_slot(Sint32 slot)
+{
+    Sound *sound = &sound_manager.sound_list[slot];
+    if (sound->filepath.length)
+    {
+        gfc_hashmap_delete_by_string(sound_manager.sound_index,&sound->filepath);
+    }
+    gfc_sound_delete(sound);
+    sound_manager.free_slots[sound_manager.free_count++] = slot;
+}
+
 void gfc_sound_free(Sound *sound)
 {
     if (!sound) return;
+    if (!sound->ref_count)return;
     sound->ref_count--;
+    if (sound->ref_count)return;
+    if (sound->sound)
+    {
+        //keep it loaded in case it is asked for again, until the slot is needed
+        gfc_sound_unused_push(gfc_sound_get_slot(sound));
+    }
+    else gfc_sound_release_slot(gfc_sound_get_slot(sound));
+}
+
+Uint32 gfc_sound_purge_unused()
+{
+    Sint32 slot;
+    Uint32 count = 0;
+    while (sound_manager.unused_head >= 0)
+    {
+        slot = sound_manager.unused_head;
+        gfc_sound_unused_remove(slot);
+        gfc_sound_release_slot(slot);
+        count++;
+    }
+    return count;
 }
 
 void gfc_sound_clear_all()
 {
     int i;
+    if (!sound_manager.sound_list)return;
     for (i = 0;i < sound_manager.max_sounds;i++)
     {
         gfc_sound_delete(&sound_manager.sound_list[i]);// clean up the data
     }
+    if (!sound_manager.free_slots)return;
+    //dropping the whole index is cheaper than deleting every key from it
+    gfc_hashmap_free(sound_manager.sound_index);
+    sound_manager.sound_index = gfc_hashmap_new_size(sound_manager.max_sounds);
+    gfc_sound_reset_slots();
 }
 
 Sound *gfc_sound_new()
 {
-    int i;
-    /*search for an unused sound address*/
-    for (i = 0;i < sound_manager.max_sounds;i++)
+    Sint32 slot;
+    if (sound_manager.free_count)
     {
-        if ((sound_manager.sound_list[i].ref_count == 0)&&(sound_manager.sound_list[i].sound == NULL))
-        {
-            sound_manager.sound_list[i].ref_count = 1;//set ref count
-            return &sound_manager.sound_list[i];//return address of this array element        }
-        }
+        slot = sound_manager.free_slots[--sound_manager.free_count];
     }
-    /*find an unused sound address and clean up the old data*/
-    for (i = 0;i < sound_manager.max_sounds;i++)
+    else if (sound_manager.unused_head >= 0)
     {
-        if (sound_manager.sound_list[i].ref_count == 0)
-        {
-            gfc_sound_delete(&sound_manager.sound_list[i]);// clean up the old data
-            sound_manager.sound_list[i].ref_count = 1;//set ref count
-            return &sound_manager.sound_list[i];//return address of this array element
-        }
+        //evict the sound that has gone unused the longest
+        slot = sound_manager.unused_head;
+        gfc_sound_unused_remove(slot);
+        gfc_sound_release_slot(slot);
+        slot = sound_manager.free_slots[--sound_manager.free_count];
     }
-    slog("error: out of sound addresses");
-    return NULL;
+    else
+    {
+        slog("error: out of sound addresses");
+        return NULL;
+    }
+    sound_manager.sound_list[slot].ref_count = 1;//set ref count
+    return &sound_manager.sound_list[slot];
 }
 
 Sound *gfc_sound_get_by_filename(const char * filename)
 {
-    int i;
-    for (i = 0;i < sound_manager.max_sounds;i++)
-    {
-        if (gfc_line_cmp(sound_manager.sound_list[i].filepath,filename)==0)
-        {
-            return &sound_manager.sound_list[i];
-        }
-    }
-    return NULL;// not found
+    if ((!filename)||(!sound_manager.sound_index))return NULL;
+    return gfc_hashmap_get(sound_manager.sound_index,filename);
 }
 
-Sound *gfc_sound_load(const char *filename,float volume,int defaultChannel)
+/**
+ * @brief get a sound that is already loaded, or a fresh slot to load it into
+ * @return NULL if there are no slots left.  Check sound->sound to see if it still needs loading
+ */
+static Sound *gfc_sound_find_or_new(const char *filename)
 {
     Sound *sound;
-    SDL_RWops* rwops;
-    void *mem = NULL;
-    size_t fileSize = 0;
-    if (!filename)return NULL;
-    if (strlen(filename) == 0)return NULL;
     sound = gfc_sound_get_by_filename(filename);
     if (sound)
     {
+        if (!sound->ref_count)gfc_sound_unused_remove(gfc_sound_get_slot(sound));
         sound->ref_count++;
         return sound;
     }
-    sound = gfc_sound_new();
-    if (!sound)
+    return gfc_sound_new();
+}
+
+/**
+ * @brief decode a sound into a slot from gfc_sound_find_or_new() and register it
+ * @param rwops the source to decode, this closes it
+ * @return NULL on error, the slot is released.  The sound otherwise
+ */
+static Sound *gfc_sound_load_rw(Sound *sound,SDL_RWops *rwops,const char *filename,float volume,int defaultChannel)
+{
+    sound->sound = Mix_LoadWAV_RW(rwops, 1);
+    if (!sound->sound)
     {
+        slog("failed to load sound file %s",filename);
+        gfc_sound_free(sound);
         return NULL;
     }
-    mem = gfc_pak_file_extract(filename,&fileSize);
+    sound->volume = volume;
+    sound->defaultChannel = defaultChannel;
+    gfc_string_set(&sound->filepath,filename);
+    gfc_hashmap_insert_string(sound_manager.sound_index,&sound->filepath,sound);
+    return sound;
+}
+
+Sound *gfc_sound_load(const char *filename,float volume,int defaultChannel)
+{
+    Sound *sound;
+    SDL_RWops* rwops;
+    const void *mem = NULL;
+    size_t fileSize = 0;
+    GFC_PROFILE_ZONE("gfc_sound_load");
+    if (!filename)return NULL;
+    if (strlen(filename) == 0)return NULL;
+    sound = gfc_sound_find_or_new(filename);
+    if (!sound)return NULL;
+    if (sound->sound)return sound;
+    mem = gfc_pak_file_map(filename,&fileSize);
     if (!mem)
     {
         slog("failed to load sound file %s",filename);
+        gfc_sound_free(sound);
         return NULL;
     }
-    rwops = SDL_RWFromMem(mem, fileSize);
+    rwops = SDL_RWFromConstMem(mem, fileSize);
     if (!rwops)
     {
         slog("failed to read sound file %s",filename);
-        free(mem);
-        return NULL;
-    }
-    sound->sound = Mix_LoadWAV_RW(rwops, 1);
-    free(mem);
-    if (!sound->sound)
-    {
-        slog("failed to load sound file %s",filename);
+        gfc_pak_file_unmap(mem);
         gfc_sound_free(sound);
         return NULL;
     }
+    sound = gfc_sound_load_rw(sound,rwops,filename,volume,defaultChannel);
+    gfc_pak_file_unmap(mem);
+    return sound;
+}
+
+/**
+ * @brief get a sound registered under filename without decoding it, see gfc_sound_pack_preload()
+ * @return NULL if there are no slots left.  The sound otherwise, which may already be loaded
+ */
+static Sound *gfc_sound_reserve(const char *filename,float volume,int defaultChannel)
+{
+    Sound *sound;
+    if (!filename)return NULL;
+    if (strlen(filename) == 0)return NULL;
+    sound = gfc_sound_find_or_new(filename);
+    if (!sound)return NULL;
+    if (sound->filepath.length)return sound;//loaded or already waiting to be
     sound->volume = volume;
     sound->defaultChannel = defaultChannel;
-    gfc_line_cpy(sound->filepath,filename);
+    gfc_string_set(&sound->filepath,filename);
+    gfc_hashmap_insert_string(sound_manager.sound_index,&sound->filepath,sound);
     return sound;
 }
 
+Sound *gfc_sound_load_streamed(const char *filename,float volume,int defaultChannel)
+{
+    Sound *sound;
+    SDL_RWops* rwops;
+    if (!filename)return NULL;
+    if (strlen(filename) == 0)return NULL;
+    sound = gfc_sound_find_or_new(filename);
+    if (!sound)return NULL;
+    if (sound->sound)return sound;
+    rwops = gfc_pak_file_open_rw(filename);
+    if (!rwops)
+    {
+        slog("failed to open sound file %s",filename);
+        gfc_sound_free(sound);
+        return NULL;
+    }
+    return gfc_sound_load_rw(sound,rwops,filename,volume,defaultChannel);
+}
+
 void gfc_sound_play(Sound *sound,int loops,float volume,int channel,int group)
 {
     int chan;
@@ -224,20 +427,41 @@ void gfc_sound_pack_play(HashMap *pack, const char *name,int loops,float volume,
     gfc_sound_play(sound,loops,volume,channel,group);
 }
 
+void gfc_sound_pack_play_by_id(HashMap *pack, gfcStringId nameId,int loops,float volume,int channel,int group)
+{
+    Sound *sound;
+    if (!pack)return;
+    sound = gfc_hashmap_get_by_id(pack,nameId);
+    if (!sound)return;
+    gfc_sound_play(sound,loops,volume,channel,group);
+}
 
-void gfc_sound_pack_load_sound(HashMap *pack, const char *name,const char *file)
+/**
+ * @brief put a sound in a pack under name, replacing any sound there
+ * @param reserve if set the sound is only registered, for gfc_sound_pack_preload() to decode, otherwise it is loaded now
+ */
+static void gfc_sound_pack_insert(HashMap *pack, const char *name,const char *file,Uint8 reserve)
 {
     Sound *sound;
+    gfcStringId nameId;
     if ((!pack)||(!name)||(!file))return;
-    sound = gfc_hashmap_get(pack,name);
+    nameId = gfc_str_intern(name);
+    if (nameId == GFC_STRING_ID_NONE)return;
+    sound = gfc_hashmap_get_by_id(pack,nameId);
     if (sound)
     {
         gfc_sound_free(sound);//delete the old one
-        gfc_hashmap_delete_by_key(pack,name);
+        gfc_hashmap_delete_by_id(pack,nameId);
     }
-    sound = gfc_sound_load(file,1,-1);
+    if (reserve)sound = gfc_sound_reserve(file,1,-1);
+    else sound = gfc_sound_load(file,1,-1);
     if (!sound)return;
-    gfc_hashmap_insert(pack,name,sound);
+    gfc_hashmap_insert_by_id(pack,nameId,sound);
+}
+
+void gfc_sound_pack_load_sound(HashMap *pack, const char *name,const char *file)
+{
+    gfc_sound_pack_insert(pack,name,file,0);
 }
 
 void gfc_sound_pack_free(HashMap *pack)
@@ -287,87 +511,520 @@ HashMap *gfc_sound_pack_parse(SJson *sounds)
         if (!sound)continue;
         name = sj_get_string_value(sj_object_get_value(sound,"name"));
         text = sj_get_string_value(sj_object_get_value(sound,"file"));
-        gfc_sound_pack_load_sound(pack, name,text);
+        gfc_sound_pack_insert(pack,name,text,1);
     }
+    gfc_sound_pack_preload(pack);
     return pack;
 }
 
-void gfc_sound_sequence_free(SoundSequence *sequence)
+//pack preloading section
+
+#define GFC_SOUND_PCM_VERSION 1
+
+/**
+ * @brief the header of a cached sound file, followed by the samples.  It is only ever read back by the same build
+ */
+typedef struct
+{
+    char    magic[4];       /**<GPCM*/
+    Uint32  version;
+    Sint32  frequency;      /**<the device format the samples are in*/
+    Uint16  format;
+    Uint16  channels;
+    Uint32  sourceCrc;      /**<of the file the samples were decoded from*/
+    Uint64  sourceSize;
+    Uint32  length;         /**<bytes of samples*/
+    TextLine filename;      /**<the file the samples were decoded from, in case two names hash the same*/
+}SoundPCMHeader;
+
+typedef struct
+{
+    Sound      *sound;
+    Mix_Chunk  *chunk;          /**<set on the worker*/
+    int         frequency;      /**<the device format, queried on the main thread*/
+    Uint16      format;
+    int         channels;
+    TextLine    cachePath;      /**<empty if not caching*/
+    Uint32      requestId;      /**<of its async load, 0 if it was loaded now*/
+    Uint8       done;
+}SoundPreload;
+
+void gfc_sound_set_pcm_cache(const char *directory)
+{
+    if ((!directory)||(!strlen(directory)))
+    {
+        sound_manager.pcm_cache[0] = 0;
+        return;
+    }
+    if (strlen(directory) >= GFCLINELEN - 14)
+    {
+        slog("sound pcm cache directory %s is too long",directory);
+        sound_manager.pcm_cache[0] = 0;
+        return;
+    }
+    gfc_line_cpy(sound_manager.pcm_cache,directory);
+}
+
+static void gfc_sound_pcm_cache_path(TextLine path,const char *filename)
 {
-    if (!sequence)return;
-    if (sequence->sequence)gfc_list_delete(sequence->sequence);
-    free(sequence);
+    Uint32 hash = 2166136261u;//fnv-1a
+    const char *c;
+    path[0] = 0;
+    if (!sound_manager.pcm_cache[0])return;
+    for (c = filename; *c; c++)
+    {
+        hash = (hash ^ (Uint8)*c) * 16777619u;
+    }
+    snprintf(path,GFCLINELEN,"%s/%08x.pcm",sound_manager.pcm_cache,hash);
 }
 
-SoundSequence *gfc_sound_sequence_new()
+static void gfc_sound_pcm_header(SoundPreload *load,SoundPCMHeader *header,Uint32 crc,size_t size,Uint32 length)
 {
-    SoundSequence *sequence;
-    sequence = gfc_allocate_array(sizeof(SoundSequence),1);
-    if (!sequence)return NULL;
-    sequence->sequence = gfc_list_new();
-    return sequence;
+    memset(header,0,sizeof(SoundPCMHeader));
+    memcpy(header->magic,"GPCM",4);
+    header->version = GFC_SOUND_PCM_VERSION;
+    header->frequency = load->frequency;
+    header->format = load->format;
+    header->channels = load->channels;
+    header->sourceCrc = crc;
+    header->sourceSize = size;
+    header->length = length;
+    gfc_line_cpy(header->filename,gfc_string_cstr(&load->sound->filepath));
+}
+
+static Mix_Chunk *gfc_sound_pcm_cache_read(SoundPreload *load,Uint32 crc,size_t size)
+{
+    FILE *file;
+    SoundPCMHeader header,expected;
+    Uint8 *samples;
+    Mix_Chunk *chunk;
+    file = fopen(load->cachePath,"rb");
+    if (!file)return NULL;
+    if (fread(&header,sizeof(SoundPCMHeader),1,file) != 1)
+    {
+        fclose(file);
+        return NULL;
+    }
+    gfc_sound_pcm_header(load,&expected,crc,size,header.length);
+    if ((!header.length)||(memcmp(&header,&expected,sizeof(SoundPCMHeader)) != 0))
+    {
+        fclose(file);//stale, it will be written over
+        return NULL;
+    }
+    //Mix_FreeChunk() frees allocated samples with SDL_free
+    samples = SDL_malloc(header.length);
+    if (!samples)
+    {
+        fclose(file);
+        return NULL;
+    }
+    if (fread(samples,header.length,1,file) != 1)
+    {
+        SDL_free(samples);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    chunk = Mix_QuickLoad_RAW(samples,header.length);
+    if (!chunk)
+    {
+        SDL_free(samples);
+        return NULL;
+    }
+    chunk->allocated = 1;
+    return chunk;
+}
+
+static void gfc_sound_pcm_cache_write(SoundPreload *load,Uint32 crc,size_t size)
+{
+    FILE *file;
+    SoundPCMHeader header;
+    char temp[GFCLINELEN + 4];
+    gfc_sound_pcm_header(load,&header,crc,size,load->chunk->alen);
+    //written to the side and moved into place, so a partly written file is never read back
+    snprintf(temp,sizeof(temp),"%s.tmp",load->cachePath);
+    file = fopen(temp,"wb");
+    if (!file)return;
+    if ((fwrite(&header,sizeof(SoundPCMHeader),1,file) != 1)||
+        (fwrite(load->chunk->abuf,load->chunk->alen,1,file) != 1))
+    {
+        fclose(file);
+        remove(temp);
+        return;
+    }
+    fclose(file);
+    remove(load->cachePath);
+    rename(temp,load->cachePath);
+}
+
+/**
+ * @brief decode a sound, or read it back from the pcm cache.  Runs on a pak worker thread
+ */
+static void gfc_sound_preload_process(GFC_PakLoadResult *result)
+{
+    SoundPreload *load = result->context;
+    SDL_RWops *rwops;
+    Uint32 crc = 0;
+    if (load->cachePath[0])
+    {
+        crc = (Uint32)mz_crc32(MZ_CRC32_INIT,result->data,result->size);
+        load->chunk = gfc_sound_pcm_cache_read(load,crc,result->size);
+        if (load->chunk)return;
+    }
+    rwops = SDL_RWFromConstMem(result->data,(int)result->size);
+    if (!rwops)return;
+    load->chunk = Mix_LoadWAV_RW(rwops,1);
+    if ((load->chunk)&&(load->cachePath[0]))
+    {
+        gfc_sound_pcm_cache_write(load,crc,result->size);
+    }
+}
+
+static void gfc_sound_preload_done(void *data)
+{
+    GFC_PakLoadResult *result = data;
+    SoundPreload *load = result->context;
+    load->done = 1;
+    if (!load->chunk)
+    {
+        slog("failed to load sound file %s",gfc_string_cstr(&load->sound->filepath));
+        return;
+    }
+    if (load->sound->sound)
+    {
+        Mix_FreeChunk(load->chunk);//something loaded it while we were waiting
+        return;
+    }
+    load->sound->sound = load->chunk;
+}
+
+/**
+ * @brief the same work as a worker would do, for when there are no workers
+ */
+static void gfc_sound_preload_now(SoundPreload *load)
+{
+    GFC_PakLoadResult result = {0};
+    result.context = load;
+    result.data = gfc_pak_file_extract(gfc_string_cstr(&load->sound->filepath),&result.size);
+    if (result.data)gfc_sound_preload_process(&result);
+    gfc_sound_preload_done(&result);
+    if (result.data)free(result.data);
+}
+
+Uint32 gfc_sound_pack_preload(HashMap *pack)
+{
+    gfcList *sounds;
+    HashMap *seen;
+    SoundPreload *loads;
+    Sound *sound;
+    int i,c,n = 0;
+    int frequency = 0,channels = 0;
+    Uint16 format = 0;
+    Uint32 remaining,loaded = 0;
+    if (!pack)return 0;
+    if (!Mix_QuerySpec(&frequency,&format,&channels))
+    {
+        slog("cannot preload sounds, audio is not open");
+        return 0;
+    }
+    sounds = gfc_hashmap_get_all_values(pack);
+    c = gfc_list_get_count(sounds);
+    loads = gfc_allocate_array(sizeof(SoundPreload),c ? c : 1);
+    seen = gfc_hashmap_new_size(c ? c : 1);
+    if ((!loads)||(!seen))
+    {
+        if (loads)free(loads);
+        if (seen)gfc_hashmap_free(seen);
+        gfc_list_delete(sounds);
+        return 0;
+    }
+    for (i = 0; i < c; i++)
+    {
+        sound = gfc_list_get_nth(sounds,i);
+        if ((!sound)||(sound->sound)||(!sound->filepath.length))continue;
+        if (gfc_hashmap_get_string(seen,&sound->filepath))continue;//two names for the same file
+        gfc_hashmap_insert_string(seen,&sound->filepath,sound);
+        sound->ref_count++;//keep the slot while it is loading
+        loads[n].sound = sound;
+        loads[n].frequency = frequency;
+        loads[n].format = format;
+        loads[n].channels = channels;
+        gfc_sound_pcm_cache_path(loads[n].cachePath,gfc_string_cstr(&sound->filepath));
+        loads[n].requestId = gfc_pak_load_async_process(gfc_string_cstr(&sound->filepath),gfc_sound_preload_process,gfc_sound_preload_done,&loads[n],PLP_Normal);
+        if (!loads[n].requestId)
+        {
+            gfc_sound_preload_now(&loads[n]);
+        }
+        n++;
+    }
+    //only our own loads are delivered, anything else waiting is left for the game's own poll
+    do
+    {
+        remaining = 0;
+        for (i = 0; i < n; i++)
+        {
+            if (loads[i].done)continue;
+            if (gfc_pak_poll_request(loads[i].requestId) < 0)loads[i].done = 1;//cancelled, it will never be delivered
+            else if (!loads[i].done)remaining++;
+        }
+        if (remaining)SDL_Delay(1);
+    }while (remaining);
+    for (i = 0; i < n; i++)
+    {
+        if (loads[i].sound->sound)loaded++;
+        gfc_sound_free(loads[i].sound);
+    }
+    gfc_hashmap_free(seen);
+    free(loads);
+    gfc_list_delete(sounds);
+    return loaded;
+}
+
+static Uint8 gfc_sound_ring_init(SoundRing *ring,Uint32 count)
+{
+    Uint32 size = 1;
+    while (size < count)size <<= 1;
+    ring->items = gfc_allocate_array(sizeof(void *),size);
+    if (!ring->items)return 0;
+    ring->mask = size - 1;
+    SDL_AtomicSet(&ring->head,0);
+    SDL_AtomicSet(&ring->tail,0);
+    return 1;
+}
+
+static Uint8 gfc_sound_ring_push(SoundRing *ring,void *item)
+{
+    Uint32 head,tail;
+    tail = (Uint32)SDL_AtomicGet(&ring->tail);
+    head = (Uint32)SDL_AtomicGet(&ring->head);
+    if (tail - head > ring->mask)return 0;//full
+    ring->items[tail & ring->mask] = item;
+    SDL_MemoryBarrierRelease();//the item must be written before the consumer can see it
+    SDL_AtomicSet(&ring->tail,(int)(tail + 1));
+    return 1;
+}
+
+static void *gfc_sound_ring_pop(SoundRing *ring)
+{
+    Uint32 head,tail;
+    void *item;
+    head = (Uint32)SDL_AtomicGet(&ring->head);
+    tail = (Uint32)SDL_AtomicGet(&ring->tail);
+    if (head == tail)return NULL;//empty
+    SDL_MemoryBarrierAcquire();
+    item = ring->items[head & ring->mask];
+    SDL_AtomicSet(&ring->head,(int)(head + 1));
+    return item;
+}
+
+static void gfc_sound_sequence_close()
+{
+    int i;
+    if (!sound_scheduler.pool)return;
+    //both of these wait on the mixer lock, so no callback is running once they return
+    Mix_ChannelFinished(NULL);
+    Mix_UnregisterEffect(MIX_CHANNEL_POST,gfc_sound_sequence_postmix);
+    for (i = 0; i < GFC_SOUND_SEQUENCE_MAX; i++)
+    {
+        if (sound_scheduler.pool[i].sounds)free(sound_scheduler.pool[i].sounds);
+    }
+    free(sound_scheduler.pool);
+    if (sound_scheduler.commands.items)free(sound_scheduler.commands.items);
+    if (sound_scheduler.finished.items)free(sound_scheduler.finished.items);
+    if (sound_scheduler.channel_head)free(sound_scheduler.channel_head);
+    if (sound_scheduler.channel_tail)free(sound_scheduler.channel_tail);
+    memset(&sound_scheduler,0,sizeof(SoundScheduler));
+}
+
+static void gfc_sound_sequence_init(int channels)
+{
+    int i;
+    if (channels <= 0)
+    {
+        slog("no audio channels allocated, sound sequences are disabled");
+        return;
+    }
+    sound_scheduler.pool = gfc_allocate_array(sizeof(SoundSequence),GFC_SOUND_SEQUENCE_MAX);
+    sound_scheduler.channel_head = gfc_allocate_array(sizeof(SoundSequence *),channels);
+    sound_scheduler.channel_tail = gfc_allocate_array(sizeof(SoundSequence *),channels);
+    if ((!sound_scheduler.pool)||(!sound_scheduler.channel_head)||(!sound_scheduler.channel_tail)||
+        (!gfc_sound_ring_init(&sound_scheduler.commands,GFC_SOUND_SEQUENCE_MAX))||
+        (!gfc_sound_ring_init(&sound_scheduler.finished,GFC_SOUND_SEQUENCE_MAX)))
+    {
+        slog("failed to allocate sound sequences");
+        gfc_sound_sequence_close();
+        return;
+    }
+    sound_scheduler.channels = channels;
+    //every sequence starts out free, the audio thread is not running the callbacks yet
+    for (i = 0; i < GFC_SOUND_SEQUENCE_MAX; i++)
+    {
+        gfc_sound_ring_push(&sound_scheduler.finished,&sound_scheduler.pool[i]);
+    }
+    Mix_ChannelFinished(gfc_sound_sequence_channel_callback);
+    if (!Mix_RegisterEffect(MIX_CHANNEL_POST,gfc_sound_sequence_postmix,NULL,NULL))
+    {
+        slog("failed to register the sound sequence effect: %s",Mix_GetError());
+    }
+    atexit(gfc_sound_sequence_close);
 }
 
 void gfc_sound_queue_sequence(gfcList *sounds,int channel)
 {
     SoundSequence *sequence;
+    Sound **list;
+    Uint32 i,c;
     if (!sounds)return;
-    sequence = gfc_sound_sequence_new();
-    if (!sequence)return;
+    if (!sound_scheduler.pool)return;
+    if ((channel < 0)||(channel >= sound_scheduler.channels))
+    {
+        slog("cannot queue a sound sequence on channel %i, there are %i channels",channel,sound_scheduler.channels);
+        return;
+    }
+    c = gfc_list_get_count(sounds);
+    if (!c)return;
+    sequence = sound_scheduler.spare;
+    if (sequence)sound_scheduler.spare = NULL;
+    else sequence = gfc_sound_ring_pop(&sound_scheduler.finished);
+    if (!sequence)
+    {
+        slog("cannot queue a sound sequence, %i are already queued",GFC_SOUND_SEQUENCE_MAX);
+        return;
+    }
+    if (c > sequence->size)
+    {
+        //this side owns the sequence until it is pushed, so it is safe to grow it here
+        list = realloc(sequence->sounds,sizeof(Sound *) * c);
+        if (!list)
+        {
+            slog("failed to allocate a sound sequence of %i sounds",c);
+            sound_scheduler.spare = sequence;//only the audio thread may push to the free ring
+            return;
+        }
+        sequence->sounds = list;
+        sequence->size = c;
+    }
+    for (i = 0; i < c; i++)
+    {
+        sequence->sounds[i] = gfc_list_get_nth(sounds,i);
+    }
+    sequence->count = c;
+    sequence->current = 0;
     sequence->channel = channel;
-    sequence->sequence = gfc_list_copy(sounds);
-    gfc_list_append(sound_manager.sound_sequences,sequence);
-    if (!Mix_Playing(channel))
+    sequence->next = NULL;
+    gfc_sound_ring_push(&sound_scheduler.commands,sequence);
+}
+
+/*everything below runs on the audio thread, or under the mixer lock*/
+
+static void gfc_sound_sequence_take_commands()
+{
+    SoundSequence *sequence;
+    while ((sequence = gfc_sound_ring_pop(&sound_scheduler.commands)) != NULL)
     {
-        gfc_sound_sequence_channel_callback(channel);
+        if (sound_scheduler.channel_tail[sequence->channel])
+        {
+            sound_scheduler.channel_tail[sequence->channel]->next = sequence;
+        }
+        else sound_scheduler.channel_head[sequence->channel] = sequence;
+        sound_scheduler.channel_tail[sequence->channel] = sequence;
+        sound_scheduler.pending++;
     }
 }
 
-void gfc_sound_sequence_channel_callback(int channel)
+static void gfc_sound_sequence_pop_channel(int channel)
+{
+    SoundSequence *sequence;
+    sequence = sound_scheduler.channel_head[channel];
+    sound_scheduler.channel_head[channel] = sequence->next;
+    if (!sequence->next)sound_scheduler.channel_tail[channel] = NULL;
+    sound_scheduler.pending--;
+    gfc_sound_ring_push(&sound_scheduler.finished,sequence);
+}
+
+static void gfc_sound_sequence_advance(int channel)
 {
     Sound *sound;
     SoundSequence *sequence;
-    int i,c;
-    c = gfc_list_get_count(sound_manager.sound_sequences);
-    for (i = 0; i < c;i++)
+    while ((sequence = sound_scheduler.channel_head[channel]) != NULL)
     {
-        sequence = gfc_list_get_nth(sound_manager.sound_sequences,i);
-        if (!sequence)continue;
-        if (sequence->channel != channel)continue;
-        sound = gfc_list_get_nth(sequence->sequence,sequence->current);
-        if (!sound)continue;
-        sequence->current++;
-        gfc_sound_play(sound,0,sound->volume,channel,-1);
-        if (sequence->current >= gfc_list_get_count(sequence->sequence))//we are finished with this sequence
+        if (sequence->current >= sequence->count)
+        {
+            gfc_sound_sequence_pop_channel(channel);
+            continue;
+        }
+        sound = sequence->sounds[sequence->current++];
+        if (sequence->current >= sequence->count)//we are finished with this sequence
         {
-            gfc_list_delete_data(sound_manager.sound_sequences,sequence);
-            gfc_sound_sequence_free(sequence);
+            gfc_sound_sequence_pop_channel(channel);
         }
+        if (!sound)continue;
+        gfc_sound_play(sound,0,sound->volume,channel,-1);
+        return;
+    }
+}
+
+void gfc_sound_sequence_channel_callback(int channel)
+{
+    static Uint8 running = 0;
+    if (sound_scheduler.finished_callback)
+    {
+        gfc_callback_queue_post(sound_scheduler.finished_queue,sound_scheduler.finished_callback,(void *)(size_t)channel);
+    }
+    if (!sound_scheduler.pool)return;
+    if ((channel < 0)||(channel >= sound_scheduler.channels))return;
+    //Mix_HaltChannel() calls back before the channel stops, so playing on it calls back again from in here
+    if (running)return;
+    running = 1;
+    gfc_sound_sequence_take_commands();
+    gfc_sound_sequence_advance(channel);
+    running = 0;
+}
+
+void gfc_sound_set_finished_callback(gfcCallbackQueue *queue,void (*callback)(void *data))
+{
+    if ((callback)&&(!queue))
+    {
+        slog("no callback queue provided for sound finished callbacks");
         return;
     }
+    sound_scheduler.finished_queue = queue;
+    sound_scheduler.finished_callback = callback;
+}
+
+/**
+ * @brief runs after every mix buffer.  It leaves the stream alone and starts any sequence queued on an idle channel
+ */
+static void gfc_sound_sequence_postmix(int chan,void *stream,int len,void *udata)
+{
+    int i;
+    gfc_sound_sequence_take_commands();
+    if (!sound_scheduler.pending)return;
+    for (i = 0; i < sound_scheduler.channels; i++)
+    {
+        if (!sound_scheduler.channel_head[i])continue;
+        if (Mix_Playing(i))continue;
+        gfc_sound_sequence_advance(i);
+    }
 }
 
 Mix_Music *gfc_sound_load_music(const char *filename)
 {
     Mix_Music *music;
     SDL_RWops* rwops;
-    void *mem = NULL;
-    size_t fileSize = 0;
-    mem = gfc_pak_file_extract(filename,&fileSize);
-    if (!mem)
+    if (!filename)return NULL;
+    //music is decoded as it plays, so it reads from the pak as it goes instead of sitting in memory
+    rwops = gfc_pak_file_open_rw(filename);
+    if (!rwops)
     {
         slog("failed to load music file %s",filename);
         return NULL;
     }
-    rwops = SDL_RWFromMem(mem, fileSize);
-    if (!rwops)
+    music = Mix_LoadMUS_RW(rwops, 1);//the music closes the stream when it is freed
+    if (!music)
     {
-        slog("failed to read music file %s",filename);
-        free(mem);
-        return NULL;
+        slog("failed to read music file %s: %s",filename,Mix_GetError());
     }
-    music = Mix_LoadMUS_RW(rwops, 1);
-    free(mem);
     return music;
 }
 /*eol@eof*/
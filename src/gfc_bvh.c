@@ -0,0 +1,835 @@
+#include <math.h>
+#include <float.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_simd.h"
+#include "gfc_jobs.h"
+#include "gfc_bvh.h"
+
+#define GFC_BVH_BINS 16
+#define GFC_BVH_MIN_LEAF 4          /**<a four wide leaf test costs the same as a test of one, so never split below this*/
+#define GFC_BVH_MAX_LEAF 16         /**<leaves are never bigger than this unless the triangles can not be split*/
+#define GFC_BVH_MAX_DEPTH 64
+#define GFC_BVH_TRAVERSE_COST 1.0f  /**<cost of visiting a node, relative to testing a triangle*/
+#define GFC_BVH_MIN_TASK 2048       /**<subtrees with fewer triangles than this are not worth handing to a thread*/
+#define GFC_BVH_MAX_TASK_DEPTH 8
+
+typedef struct
+{
+    float   bmin[3];
+    Uint32  count;      /**<triangles in a leaf, 0 for inner nodes*/
+    float   bmax[3];
+    Uint32  index;      /**<first leaf slot of a leaf, or the left child of an inner node.  The right child follows it*/
+}GFC_BVHNode;
+
+struct gfcTriangleBVH_S
+{
+    Triangle3D     *triangles;  /**<copy of the triangles in the order they were given*/
+    Uint32          count;
+    Uint32         *order;      /**<for each leaf slot, which triangle is in it*/
+    float          *soa;        /**<the one allocation the arrays below point into*/
+    float          *v0[3];      /**<leaf slot triangles, structure of arrays: the first vertex*/
+    float          *e1[3];      /**<b - a*/
+    float          *e2[3];      /**<c - a*/
+    GFC_BVHNode    *nodes;
+    Uint32          nodeCount;
+};
+
+typedef struct
+{
+    float   bmin[3];
+    float   bmax[3];
+    float   center[3];
+}GFC_BVHPrim;
+
+typedef struct
+{
+    Uint32  node;
+    Uint32  first;
+    Uint32  count;
+    Uint32  cursor;
+    Uint32  depth;
+}GFC_BVHTask;
+
+typedef struct
+{
+    GFC_BVHPrim    *prims;
+    Uint32         *order;
+    GFC_BVHNode    *nodes;      /**<room for 2 * count - 1 nodes.  Every subtree owns a fixed range of it so subtrees can build in parallel*/
+    GFC_BVHTask    *tasks;
+    Uint32          taskCount;
+    Uint32          taskDepth;  /**<subtrees at this depth are handed to the threads, 0 for no threads*/
+    SDL_atomic_t    nextTask;
+}GFC_BVHBuild;
+
+typedef struct
+{
+    float   o[3];
+    float   d[3];
+    float   inv[3];
+    float   best;       /**<t of the nearest hit so far, nodes further than this are skipped*/
+    Uint32  slot;       /**<leaf slot of the nearest hit*/
+    Uint8   hit;
+}GFC_BVHRay;
+
+static float gfc_bvh_half_area(const float *bmin,const float *bmax)
+{
+    float dx,dy,dz;
+    dx = bmax[0] - bmin[0];
+    dy = bmax[1] - bmin[1];
+    dz = bmax[2] - bmin[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+static void gfc_bvh_grow(float *bmin,float *bmax,const float *omin,const float *omax)
+{
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        if (omin[i] < bmin[i])bmin[i] = omin[i];
+        if (omax[i] > bmax[i])bmax[i] = omax[i];
+    }
+}
+
+static void gfc_bvh_make_leaf(GFC_BVHNode *node,Uint32 first,Uint32 count)
+{
+    node->count = count;
+    node->index = first;
+}
+
+static void gfc_bvh_build_node(GFC_BVHBuild *build,Uint32 nodeIndex,Uint32 first,Uint32 count,Uint32 cursor,Uint32 depth,Uint8 defer)
+{
+    GFC_BVHNode *node;
+    GFC_BVHPrim *prim;
+    GFC_BVHTask *task;
+    float cmin[3],cmax[3];
+    float binMin[GFC_BVH_BINS][3],binMax[GFC_BVH_BINS][3];
+    Uint32 binCount[GFC_BVH_BINS];
+    float rightArea[GFC_BVH_BINS];
+    Uint32 rightCount[GFC_BVH_BINS];
+    float accMin[3],accMax[3];
+    float extent,scale,area,cost,bestCost;
+    Uint32 i,j,axis,bin,bestPlane,leftCount,mid,swap;
+    int b;
+
+    if ((defer)&&(depth == build->taskDepth)&&(count >= GFC_BVH_MIN_TASK))
+    {
+        task = &build->tasks[build->taskCount++];
+        task->node = nodeIndex;
+        task->first = first;
+        task->count = count;
+        task->cursor = cursor;
+        task->depth = depth;
+        return;
+    }
+    node = &build->nodes[nodeIndex];
+    for (i = 0; i < 3; i++)
+    {
+        node->bmin[i] = cmin[i] = FLT_MAX;
+        node->bmax[i] = cmax[i] = -FLT_MAX;
+    }
+    for (i = first; i < first + count; i++)
+    {
+        prim = &build->prims[build->order[i]];
+        gfc_bvh_grow(node->bmin,node->bmax,prim->bmin,prim->bmax);
+        gfc_bvh_grow(cmin,cmax,prim->center,prim->center);
+    }
+    if ((count <= GFC_BVH_MIN_LEAF)||(depth >= GFC_BVH_MAX_DEPTH))
+    {
+        gfc_bvh_make_leaf(node,first,count);
+        return;
+    }
+    axis = 0;
+    if (cmax[1] - cmin[1] > cmax[axis] - cmin[axis])axis = 1;
+    if (cmax[2] - cmin[2] > cmax[axis] - cmin[axis])axis = 2;
+    extent = cmax[axis] - cmin[axis];
+    mid = first + count / 2;
+    if (extent <= 0)
+    {
+        //every centroid is in the same place, there is no good split
+        if (count <= GFC_BVH_MAX_LEAF)
+        {
+            gfc_bvh_make_leaf(node,first,count);
+            return;
+        }
+    }
+    else
+    {
+        //bin the centroids along the longest axis and pick the plane with the lowest surface area cost
+        scale = (GFC_BVH_BINS * 0.9999f) / extent;
+        for (i = 0; i < GFC_BVH_BINS; i++)
+        {
+            binCount[i] = 0;
+            for (j = 0; j < 3; j++)
+            {
+                binMin[i][j] = FLT_MAX;
+                binMax[i][j] = -FLT_MAX;
+            }
+        }
+        for (i = first; i < first + count; i++)
+        {
+            prim = &build->prims[build->order[i]];
+            bin = (Uint32)((prim->center[axis] - cmin[axis]) * scale);
+            if (bin >= GFC_BVH_BINS)bin = GFC_BVH_BINS - 1;
+            binCount[bin]++;
+            gfc_bvh_grow(binMin[bin],binMax[bin],prim->bmin,prim->bmax);
+        }
+        for (j = 0; j < 3; j++)
+        {
+            accMin[j] = FLT_MAX;
+            accMax[j] = -FLT_MAX;
+        }
+        rightCount[GFC_BVH_BINS - 1] = 0;
+        for (b = GFC_BVH_BINS - 1; b > 0; b--)
+        {
+            gfc_bvh_grow(accMin,accMax,binMin[b],binMax[b]);
+            rightCount[b - 1] = rightCount[b] + binCount[b];
+            rightArea[b - 1] = rightCount[b - 1] ? gfc_bvh_half_area(accMin,accMax) : 0;
+        }
+        for (j = 0; j < 3; j++)
+        {
+            accMin[j] = FLT_MAX;
+            accMax[j] = -FLT_MAX;
+        }
+        leftCount = 0;
+        bestCost = FLT_MAX;
+        bestPlane = 0;
+        for (i = 0; i < GFC_BVH_BINS - 1; i++)
+        {
+            gfc_bvh_grow(accMin,accMax,binMin[i],binMax[i]);
+            leftCount += binCount[i];
+            if ((!leftCount)||(!rightCount[i]))continue;
+            cost = gfc_bvh_half_area(accMin,accMax) * leftCount + rightArea[i] * rightCount[i];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestPlane = i;
+            }
+        }
+        area = gfc_bvh_half_area(node->bmin,node->bmax);
+        if ((count <= GFC_BVH_MAX_LEAF)&&(GFC_BVH_TRAVERSE_COST * area + bestCost >= area * count))
+        {
+            gfc_bvh_make_leaf(node,first,count);
+            return;
+        }
+        //partition the slots so everything left of the plane comes first
+        i = first;
+        j = first + count;
+        while (i < j)
+        {
+            prim = &build->prims[build->order[i]];
+            bin = (Uint32)((prim->center[axis] - cmin[axis]) * scale);
+            if (bin >= GFC_BVH_BINS)bin = GFC_BVH_BINS - 1;
+            if (bin <= bestPlane)
+            {
+                i++;
+                continue;
+            }
+            j--;
+            swap = build->order[i];
+            build->order[i] = build->order[j];
+            build->order[j] = swap;
+        }
+        if ((i > first)&&(i < first + count))mid = i;
+    }
+    //children are a pair, and the rest of this node's range is split between their subtrees
+    leftCount = mid - first;
+    node->count = 0;
+    node->index = cursor;
+    gfc_bvh_build_node(build,cursor,first,leftCount,cursor + 2,depth + 1,defer);
+    gfc_bvh_build_node(build,cursor + 1,mid,count - leftCount,cursor + 2 + (leftCount * 2 - 2),depth + 1,defer);
+}
+
+static void gfc_bvh_build_worker(void *data)
+{
+    GFC_BVHBuild *build = data;
+    GFC_BVHTask *task;
+    int n;
+    while ((n = SDL_AtomicAdd(&build->nextTask,1)) < (int)build->taskCount)
+    {
+        task = &build->tasks[n];
+        gfc_bvh_build_node(build,task->node,task->first,task->count,task->cursor,task->depth,0);
+    }
+}
+
+static Uint32 gfc_bvh_count_nodes(GFC_BVHNode *nodes,Uint32 n)
+{
+    if (nodes[n].count)return 1;
+    return 1 + gfc_bvh_count_nodes(nodes,nodes[n].index) + gfc_bvh_count_nodes(nodes,nodes[n].index + 1);
+}
+
+static void gfc_bvh_compact(GFC_BVHNode *src,Uint32 from,GFC_BVHNode *dst,Uint32 to,Uint32 *next)
+{
+    Uint32 left;
+    dst[to] = src[from];
+    if (src[from].count)return;
+    left = *next;
+    *next += 2;
+    dst[to].index = left;
+    gfc_bvh_compact(src,src[from].index,dst,left,next);
+    gfc_bvh_compact(src,src[from].index + 1,dst,left + 1,next);
+}
+
+static gfcTriangleBVH *gfc_bvh_build(Triangle3D *triangles,Uint32 count,Uint32 threads)
+{
+    gfcTriangleBVH *bvh;
+    GFC_BVHBuild build = {0};
+    GFC_BVHPrim *prim;
+    Triangle3D *t;
+    Uint32 i,j,next,slots;
+    if ((!triangles)||(!count))
+    {
+        slog("no triangles to build a bvh from");
+        return NULL;
+    }
+    bvh = gfc_allocate_array(sizeof(gfcTriangleBVH),1);
+    if (!bvh)return NULL;
+    bvh->count = count;
+    bvh->triangles = gfc_allocate_array(sizeof(Triangle3D),count);
+    bvh->order = gfc_allocate_array(sizeof(Uint32),count);
+    build.prims = gfc_allocate_array(sizeof(GFC_BVHPrim),count);
+    build.nodes = gfc_allocate_array(sizeof(GFC_BVHNode),count * 2 - 1);
+    if ((!bvh->triangles)||(!bvh->order)||(!build.prims)||(!build.nodes))
+    {
+        slog("failed to allocate bvh build data for %i triangles",count);
+        goto fail;
+    }
+    memcpy(bvh->triangles,triangles,sizeof(Triangle3D)*count);
+    for (i = 0; i < count; i++)
+    {
+        t = &triangles[i];
+        prim = &build.prims[i];
+        prim->bmin[0] = MIN(MIN(t->a.x,t->b.x),t->c.x);
+        prim->bmin[1] = MIN(MIN(t->a.y,t->b.y),t->c.y);
+        prim->bmin[2] = MIN(MIN(t->a.z,t->b.z),t->c.z);
+        prim->bmax[0] = MAX(MAX(t->a.x,t->b.x),t->c.x);
+        prim->bmax[1] = MAX(MAX(t->a.y,t->b.y),t->c.y);
+        prim->bmax[2] = MAX(MAX(t->a.z,t->b.z),t->c.z);
+        for (j = 0; j < 3; j++)
+        {
+            prim->center[j] = (prim->bmin[j] + prim->bmax[j]) * 0.5f;
+        }
+        bvh->order[i] = i;
+    }
+    build.order = bvh->order;
+    if ((threads > 1)&&(count >= GFC_BVH_MIN_TASK * 2))
+    {
+        //split the top of the tree here, then hand the subtrees below taskDepth out to the threads
+        for (build.taskDepth = 1; (build.taskDepth < GFC_BVH_MAX_TASK_DEPTH)&&((1u << build.taskDepth) < threads * 4); build.taskDepth++);
+        build.tasks = gfc_allocate_array(sizeof(GFC_BVHTask),1 << build.taskDepth);
+        if (!build.tasks)goto fail;
+    }
+    gfc_bvh_build_node(&build,0,0,count,1,0,build.tasks != NULL);
+    if (build.taskCount)
+    {
+        SDL_AtomicSet(&build.nextTask,0);
+        gfc_jobs_run_parallel(gfc_bvh_build_worker,&build,threads);
+    }
+    //the build leaves gaps in the node ranges, pack the tree down
+    bvh->nodeCount = gfc_bvh_count_nodes(build.nodes,0);
+    bvh->nodes = gfc_allocate_array(sizeof(GFC_BVHNode),bvh->nodeCount);
+    if (!bvh->nodes)goto fail;
+    next = 1;
+    gfc_bvh_compact(build.nodes,0,bvh->nodes,0,&next);
+
+    //leaf slots, padded so four wide loads can always read past the last one.  The padding is zero and never hits
+    slots = count + 4;
+    bvh->soa = gfc_allocate_array(sizeof(float),slots * 9);
+    if (!bvh->soa)goto fail;
+    for (j = 0; j < 3; j++)
+    {
+        bvh->v0[j] = bvh->soa + slots * j;
+        bvh->e1[j] = bvh->soa + slots * (j + 3);
+        bvh->e2[j] = bvh->soa + slots * (j + 6);
+    }
+    for (i = 0; i < count; i++)
+    {
+        t = &bvh->triangles[bvh->order[i]];
+        bvh->v0[0][i] = t->a.x;
+        bvh->v0[1][i] = t->a.y;
+        bvh->v0[2][i] = t->a.z;
+        bvh->e1[0][i] = t->b.x - t->a.x;
+        bvh->e1[1][i] = t->b.y - t->a.y;
+        bvh->e1[2][i] = t->b.z - t->a.z;
+        bvh->e2[0][i] = t->c.x - t->a.x;
+        bvh->e2[1][i] = t->c.y - t->a.y;
+        bvh->e2[2][i] = t->c.z - t->a.z;
+    }
+    free(build.prims);
+    free(build.nodes);
+    if (build.tasks)free(build.tasks);
+    return bvh;
+fail:
+    if (build.prims)free(build.prims);
+    if (build.nodes)free(build.nodes);
+    if (build.tasks)free(build.tasks);
+    gfc_triangle_bvh_free(bvh);
+    return NULL;
+}
+
+gfcTriangleBVH *gfc_triangle_bvh_new(Triangle3D *triangles,Uint32 count)
+{
+    return gfc_bvh_build(triangles,count,1);
+}
+
+gfcTriangleBVH *gfc_triangle_bvh_new_threaded(Triangle3D *triangles,Uint32 count,Uint32 threads)
+{
+    if (!threads)
+    {
+        threads = gfc_jobs_get_thread_count();
+        if (!threads)threads = SDL_GetCPUCount();
+        if (threads < 1)threads = 1;
+    }
+    return gfc_bvh_build(triangles,count,threads);
+}
+
+void gfc_triangle_bvh_free(gfcTriangleBVH *bvh)
+{
+    if (!bvh)return;
+    if (bvh->triangles)free(bvh->triangles);
+    if (bvh->order)free(bvh->order);
+    if (bvh->soa)free(bvh->soa);
+    if (bvh->nodes)free(bvh->nodes);
+    free(bvh);
+}
+
+Uint32 gfc_triangle_bvh_get_count(gfcTriangleBVH *bvh)
+{
+    if (!bvh)return 0;
+    return bvh->count;
+}
+
+const Triangle3D *gfc_triangle_bvh_get_triangle(gfcTriangleBVH *bvh,Uint32 n)
+{
+    if ((!bvh)||(n >= bvh->count))return NULL;
+    return &bvh->triangles[n];
+}
+
+Box gfc_triangle_bvh_get_bounds(gfcTriangleBVH *bvh)
+{
+    Box b = {0};
+    GFC_BVHNode *root;
+    if ((!bvh)||(!bvh->nodes))return b;
+    root = &bvh->nodes[0];
+    return gfc_box(root->bmin[0],root->bmin[1],root->bmin[2],
+                   root->bmax[0] - root->bmin[0],root->bmax[1] - root->bmin[1],root->bmax[2] - root->bmin[2]);
+}
+
+/**
+ * @brief slab test an edge against a node's box, within the nearest hit so far
+ * @return 1 if it overlaps, with where the edge enters the box in tnear
+ */
+static Uint8 gfc_bvh_ray_box(GFC_BVHNode *node,GFC_BVHRay *ray,float *tnear)
+{
+    float t1,t2,tmin = 0,tmax = ray->best;
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        t1 = (node->bmin[i] - ray->o[i]) * ray->inv[i];
+        t2 = (node->bmax[i] - ray->o[i]) * ray->inv[i];
+        if (t1 > t2)
+        {
+            if (t2 > tmin)tmin = t2;
+            if (t1 < tmax)tmax = t1;
+        }
+        else
+        {
+            if (t1 > tmin)tmin = t1;
+            if (t2 < tmax)tmax = t2;
+        }
+        if (tmin > tmax)return 0;
+    }
+    if (tnear)*tnear = tmin;
+    return 1;
+}
+
+/**
+ * @brief Moller-Trumbore against every triangle in a leaf, keeping the nearest hit in ray
+ */
+static void gfc_bvh_leaf_edge(gfcTriangleBVH *bvh,GFC_BVHNode *leaf,GFC_BVHRay *ray,Uint8 any)
+{
+    Uint32 s,end;
+#ifdef GFC_SIMD
+    gfc_f4 dx,dy,dz,ox,oy,oz,zero,one,best;
+    gfc_f4 e1x,e1y,e1z,e2x,e2y,e2z,tx,ty,tz,px,py,pz,qx,qy,qz,det,inv,u,v,t;
+    gfc_m4 mask;
+    float tt[4];
+    Uint32 bits,k;
+    dx = gfc_f4_set1(ray->d[0]);
+    dy = gfc_f4_set1(ray->d[1]);
+    dz = gfc_f4_set1(ray->d[2]);
+    ox = gfc_f4_set1(ray->o[0]);
+    oy = gfc_f4_set1(ray->o[1]);
+    oz = gfc_f4_set1(ray->o[2]);
+    zero = gfc_f4_set1(0);
+    one = gfc_f4_set1(1);
+    end = leaf->index + leaf->count;
+    for (s = leaf->index; s < end; s += 4)
+    {
+        e1x = gfc_f4_load(&bvh->e1[0][s]);
+        e1y = gfc_f4_load(&bvh->e1[1][s]);
+        e1z = gfc_f4_load(&bvh->e1[2][s]);
+        e2x = gfc_f4_load(&bvh->e2[0][s]);
+        e2y = gfc_f4_load(&bvh->e2[1][s]);
+        e2z = gfc_f4_load(&bvh->e2[2][s]);
+        //p = d x e2
+        px = gfc_f4_sub(gfc_f4_mul(dy,e2z),gfc_f4_mul(dz,e2y));
+        py = gfc_f4_sub(gfc_f4_mul(dz,e2x),gfc_f4_mul(dx,e2z));
+        pz = gfc_f4_sub(gfc_f4_mul(dx,e2y),gfc_f4_mul(dy,e2x));
+        det = gfc_f4_add(gfc_f4_add(gfc_f4_mul(e1x,px),gfc_f4_mul(e1y,py)),gfc_f4_mul(e1z,pz));
+        inv = gfc_f4_div(one,det);
+        tx = gfc_f4_sub(ox,gfc_f4_load(&bvh->v0[0][s]));
+        ty = gfc_f4_sub(oy,gfc_f4_load(&bvh->v0[1][s]));
+        tz = gfc_f4_sub(oz,gfc_f4_load(&bvh->v0[2][s]));
+        u = gfc_f4_mul(gfc_f4_add(gfc_f4_add(gfc_f4_mul(tx,px),gfc_f4_mul(ty,py)),gfc_f4_mul(tz,pz)),inv);
+        //q = t x e1
+        qx = gfc_f4_sub(gfc_f4_mul(ty,e1z),gfc_f4_mul(tz,e1y));
+        qy = gfc_f4_sub(gfc_f4_mul(tz,e1x),gfc_f4_mul(tx,e1z));
+        qz = gfc_f4_sub(gfc_f4_mul(tx,e1y),gfc_f4_mul(ty,e1x));
+        v = gfc_f4_mul(gfc_f4_add(gfc_f4_add(gfc_f4_mul(dx,qx),gfc_f4_mul(dy,qy)),gfc_f4_mul(dz,qz)),inv);
+        t = gfc_f4_mul(gfc_f4_add(gfc_f4_add(gfc_f4_mul(e2x,qx),gfc_f4_mul(e2y,qy)),gfc_f4_mul(e2z,qz)),inv);
+        best = gfc_f4_set1(ray->best);
+        mask = gfc_m4_and(gfc_f4_ne(det,zero),gfc_f4_le(zero,u));
+        mask = gfc_m4_and(mask,gfc_m4_and(gfc_f4_le(zero,v),gfc_f4_le(gfc_f4_add(u,v),one)));
+        mask = gfc_m4_and(mask,gfc_m4_and(gfc_f4_gt(t,zero),gfc_f4_le(t,best)));
+        bits = gfc_m4_bits(mask);
+        if (end - s < 4)bits &= (1u << (end - s)) - 1;
+        if (!bits)continue;
+        gfc_f4_store(tt,t);
+        for (k = 0; k < 4; k++)
+        {
+            if (!(bits & (1u << k)))continue;
+            if ((ray->hit)&&(tt[k] >= ray->best))continue;
+            ray->best = tt[k];
+            ray->slot = s + k;
+            ray->hit = 1;
+            if (any)return;
+        }
+    }
+#else
+    float e1[3],e2[3],p[3],q[3],tv[3],det,inv,u,v,t;
+    Uint32 i;
+    end = leaf->index + leaf->count;
+    for (s = leaf->index; s < end; s++)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            e1[i] = bvh->e1[i][s];
+            e2[i] = bvh->e2[i][s];
+            tv[i] = ray->o[i] - bvh->v0[i][s];
+        }
+        p[0] = ray->d[1] * e2[2] - ray->d[2] * e2[1];
+        p[1] = ray->d[2] * e2[0] - ray->d[0] * e2[2];
+        p[2] = ray->d[0] * e2[1] - ray->d[1] * e2[0];
+        det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+        if (det == 0)continue;
+        inv = 1.0f / det;
+        u = (tv[0] * p[0] + tv[1] * p[1] + tv[2] * p[2]) * inv;
+        if ((u < 0)||(u > 1))continue;
+        q[0] = tv[1] * e1[2] - tv[2] * e1[1];
+        q[1] = tv[2] * e1[0] - tv[0] * e1[2];
+        q[2] = tv[0] * e1[1] - tv[1] * e1[0];
+        v = (ray->d[0] * q[0] + ray->d[1] * q[1] + ray->d[2] * q[2]) * inv;
+        if ((v < 0)||(u + v > 1))continue;
+        t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+        if ((t <= 0)||(t > ray->best))continue;
+        if ((ray->hit)&&(t >= ray->best))continue;
+        ray->best = t;
+        ray->slot = s;
+        ray->hit = 1;
+        if (any)return;
+    }
+#endif
+}
+
+static Uint8 gfc_bvh_cast(gfcTriangleBVH *bvh,Edge3D e,GFC_BVHRay *ray,Uint8 any)
+{
+    Uint32 stack[GFC_BVH_MAX_DEPTH + 2];
+    Uint32 sp = 0,node,left;
+    GFC_BVHNode *n;
+    float tl,tr;
+    Uint8 hl,hr;
+    int i;
+    if ((!bvh)||(!bvh->nodes))return 0;
+    ray->o[0] = e.a.x;
+    ray->o[1] = e.a.y;
+    ray->o[2] = e.a.z;
+    ray->d[0] = e.b.x - e.a.x;
+    ray->d[1] = e.b.y - e.a.y;
+    ray->d[2] = e.b.z - e.a.z;
+    for (i = 0; i < 3; i++)
+    {
+        //a huge finite inverse instead of infinity keeps 0 * inv from making a NaN on the slab planes
+        ray->inv[i] = (ray->d[i] != 0) ? 1.0f / ray->d[i] : 1e30f;
+    }
+    ray->best = 1;
+    ray->hit = 0;
+    ray->slot = 0;
+    if (!gfc_bvh_ray_box(&bvh->nodes[0],ray,NULL))return 0;
+    node = 0;
+    for (;;)
+    {
+        n = &bvh->nodes[node];
+        if (n->count)
+        {
+            gfc_bvh_leaf_edge(bvh,n,ray,any);
+            if ((any)&&(ray->hit))return 1;
+        }
+        else
+        {
+            //visit the nearer child first, so the far one can be skipped once there is a hit
+            left = n->index;
+            hl = gfc_bvh_ray_box(&bvh->nodes[left],ray,&tl);
+            hr = gfc_bvh_ray_box(&bvh->nodes[left + 1],ray,&tr);
+            if ((hl)&&(hr))
+            {
+                if (tl <= tr)
+                {
+                    stack[sp++] = left + 1;
+                    node = left;
+                }
+                else
+                {
+                    stack[sp++] = left;
+                    node = left + 1;
+                }
+                continue;
+            }
+            if (hl)
+            {
+                node = left;
+                continue;
+            }
+            if (hr)
+            {
+                node = left + 1;
+                continue;
+            }
+        }
+        do
+        {
+            if (!sp)return ray->hit;
+            node = stack[--sp];
+        }while (!gfc_bvh_ray_box(&bvh->nodes[node],ray,NULL));
+    }
+}
+
+Uint8 gfc_triangle_bvh_edge_test(gfcTriangleBVH *bvh,Edge3D e,gfcBVHHit *hit)
+{
+    GFC_BVHRay ray;
+    Vector3D normal;
+    Uint32 s;
+    if (!gfc_bvh_cast(bvh,e,&ray,0))return 0;
+    if (hit)
+    {
+        s = ray.slot;
+        hit->triangle = bvh->order[s];
+        hit->t = ray.best;
+        hit->poc = vector3d(ray.o[0] + ray.d[0] * ray.best,ray.o[1] + ray.d[1] * ray.best,ray.o[2] + ray.d[2] * ray.best);
+        vector3d_cross_product(&normal,
+            vector3d(bvh->e1[0][s],bvh->e1[1][s],bvh->e1[2][s]),
+            vector3d(bvh->e2[0][s],bvh->e2[1][s],bvh->e2[2][s]));
+        vector3d_normalize(&normal);
+        hit->normal = normal;
+    }
+    return 1;
+}
+
+Uint8 gfc_triangle_bvh_edge_test_any(gfcTriangleBVH *bvh,Edge3D e)
+{
+    GFC_BVHRay ray;
+    return gfc_bvh_cast(bvh,e,&ray,1);
+}
+
+/**
+ * @brief the point on a triangle nearest to p, from Real-Time Collision Detection 5.1.5
+ */
+static Vector3D gfc_bvh_closest_point_on_triangle(Vector3D p,Triangle3D *tri)
+{
+    Vector3D ab,ac,ap,bp,cp,out;
+    float d1,d2,d3,d4,d5,d6,va,vb,vc,v,w,denom;
+    vector3d_sub(ab,tri->b,tri->a);
+    vector3d_sub(ac,tri->c,tri->a);
+    vector3d_sub(ap,p,tri->a);
+    d1 = vector3d_dot_product(ab,ap);
+    d2 = vector3d_dot_product(ac,ap);
+    if ((d1 <= 0)&&(d2 <= 0))return tri->a;
+    vector3d_sub(bp,p,tri->b);
+    d3 = vector3d_dot_product(ab,bp);
+    d4 = vector3d_dot_product(ac,bp);
+    if ((d3 >= 0)&&(d4 <= d3))return tri->b;
+    vc = d1 * d4 - d3 * d2;
+    if ((vc <= 0)&&(d1 >= 0)&&(d3 <= 0))
+    {
+        v = d1 / (d1 - d3);
+        return vector3d(tri->a.x + ab.x * v,tri->a.y + ab.y * v,tri->a.z + ab.z * v);
+    }
+    vector3d_sub(cp,p,tri->c);
+    d5 = vector3d_dot_product(ab,cp);
+    d6 = vector3d_dot_product(ac,cp);
+    if ((d6 >= 0)&&(d5 <= d6))return tri->c;
+    vb = d5 * d2 - d1 * d6;
+    if ((vb <= 0)&&(d2 >= 0)&&(d6 <= 0))
+    {
+        w = d2 / (d2 - d6);
+        return vector3d(tri->a.x + ac.x * w,tri->a.y + ac.y * w,tri->a.z + ac.z * w);
+    }
+    va = d3 * d6 - d5 * d4;
+    if ((va <= 0)&&((d4 - d3) >= 0)&&((d5 - d6) >= 0))
+    {
+        w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return vector3d(tri->b.x + (tri->c.x - tri->b.x) * w,tri->b.y + (tri->c.y - tri->b.y) * w,tri->b.z + (tri->c.z - tri->b.z) * w);
+    }
+    if (va + vb + vc == 0)return tri->a;//degenerate
+    denom = 1.0f / (va + vb + vc);
+    v = vb * denom;
+    w = vc * denom;
+    out.x = tri->a.x + ab.x * v + ac.x * w;
+    out.y = tri->a.y + ab.y * v + ac.y * w;
+    out.z = tri->a.z + ab.z * v + ac.z * w;
+    return out;
+}
+
+static float gfc_bvh_box_distance_squared(GFC_BVHNode *node,const float *p)
+{
+    float d = 0,v;
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        if (p[i] < node->bmin[i])
+        {
+            v = node->bmin[i] - p[i];
+            d += v * v;
+        }
+        else if (p[i] > node->bmax[i])
+        {
+            v = p[i] - node->bmax[i];
+            d += v * v;
+        }
+    }
+    return d;
+}
+
+/**
+ * @brief walk every leaf within sqrt(limit) of center.  visit returns 0 to stop
+ */
+static Uint32 gfc_bvh_sphere_walk(
+    gfcTriangleBVH *bvh,
+    Sphere s,
+    float *limit,
+    Uint8 (*visit)(gfcTriangleBVH *bvh,Uint32 slot,Vector3D poc,float d2,void *data),
+    void *data)
+{
+    Uint32 stack[GFC_BVH_MAX_DEPTH * 2 + 2];
+    Uint32 sp = 0,node,slot,found = 0;
+    GFC_BVHNode *n;
+    Vector3D center,poc,diff;
+    float c[3],d2;
+    if ((!bvh)||(!bvh->nodes))return 0;
+    center = vector3d(s.x,s.y,s.z);
+    c[0] = s.x;
+    c[1] = s.y;
+    c[2] = s.z;
+    stack[sp++] = 0;
+    while (sp)
+    {
+        n = &bvh->nodes[stack[--sp]];
+        if (gfc_bvh_box_distance_squared(n,c) > *limit)continue;
+        if (!n->count)
+        {
+            node = n->index;
+            stack[sp++] = node + 1;
+            stack[sp++] = node;
+            continue;
+        }
+        for (slot = n->index; slot < n->index + n->count; slot++)
+        {
+            poc = gfc_bvh_closest_point_on_triangle(center,&bvh->triangles[bvh->order[slot]]);
+            vector3d_sub(diff,center,poc);
+            d2 = vector3d_magnitude_squared(diff);
+            if (d2 > *limit)continue;
+            found++;
+            if (!visit(bvh,slot,poc,d2,data))return found;
+        }
+    }
+    return found;
+}
+
+typedef struct
+{
+    Uint32      slot;
+    Vector3D    poc;
+    float       d2;
+    float      *limit;
+    Uint8       hit;
+}GFC_BVHNearest;
+
+static Uint8 gfc_bvh_sphere_nearest(gfcTriangleBVH *bvh,Uint32 slot,Vector3D poc,float d2,void *data)
+{
+    GFC_BVHNearest *nearest = data;
+    if ((nearest->hit)&&(d2 >= nearest->d2))return 1;
+    nearest->slot = slot;
+    nearest->poc = poc;
+    nearest->d2 = d2;
+    nearest->hit = 1;
+    *nearest->limit = d2;//only nearer triangles are interesting now
+    return 1;
+}
+
+Uint8 gfc_triangle_bvh_sphere_test(gfcTriangleBVH *bvh,Sphere s,gfcBVHHit *hit)
+{
+    GFC_BVHNearest nearest = {0};
+    Vector3D normal;
+    float limit;
+    Uint32 s0;
+    limit = s.r * s.r;
+    nearest.limit = &limit;
+    gfc_bvh_sphere_walk(bvh,s,&limit,gfc_bvh_sphere_nearest,&nearest);
+    if (!nearest.hit)return 0;
+    if (hit)
+    {
+        s0 = nearest.slot;
+        hit->triangle = bvh->order[s0];
+        hit->t = sqrt(nearest.d2);
+        hit->poc = nearest.poc;
+        normal = vector3d(s.x - nearest.poc.x,s.y - nearest.poc.y,s.z - nearest.poc.z);
+        if (vector3d_is_zero(normal))
+        {
+            //the center is on the triangle, use its face
+            vector3d_cross_product(&normal,
+                vector3d(bvh->e1[0][s0],bvh->e1[1][s0],bvh->e1[2][s0]),
+                vector3d(bvh->e2[0][s0],bvh->e2[1][s0],bvh->e2[2][s0]));
+        }
+        vector3d_normalize(&normal);
+        hit->normal = normal;
+    }
+    return 1;
+}
+
+typedef struct
+{
+    gfcTriangleBVHQueryFunc func;
+    void                   *context;
+}GFC_BVHQuery;
+
+static Uint8 gfc_bvh_sphere_report(gfcTriangleBVH *bvh,Uint32 slot,Vector3D poc,float d2,void *data)
+{
+    GFC_BVHQuery *query = data;
+    if (!query->func)return 1;
+    return query->func(bvh->order[slot],query->context);
+}
+
+Uint32 gfc_triangle_bvh_sphere_query(gfcTriangleBVH *bvh,Sphere s,gfcTriangleBVHQueryFunc func,void *context)
+{
+    GFC_BVHQuery query;
+    float limit;
+    query.func = func;
+    query.context = context;
+    limit = s.r * s.r;
+    return gfc_bvh_sphere_walk(bvh,s,&limit,gfc_bvh_sphere_report,&query);
+}
+
+/*eol@eof*/
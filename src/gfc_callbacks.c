@@ -1,3 +1,4 @@
+#include "gfc_types.h"
 #include "gfc_callbacks.h"
 #include "simple_logger.h"
 #include <stdlib.h>
@@ -5,15 +6,20 @@
 #include <string.h> 
 
 Callback *gfc_callback_new(void (*callback)(void *data),void *data)
+{
+    return gfc_callback_new_allocator(callback,data,NULL);
+}
+
+Callback *gfc_callback_new_allocator(void (*callback)(void *data),void *data,gfcAllocator *allocator)
 {
     Callback *c;
-    c = (Callback *)malloc(sizeof(Callback));
+    c = (Callback *)gfc_allocator_alloc(allocator,sizeof(Callback),1);
     if (!c)
     {
         slog("failed to allocate callback");
         return NULL;
     }
-    memset(c,0,sizeof(Callback));
+    c->allocator = allocator;
     c->callback = callback;
     c->data = data;
     return c;
@@ -22,7 +28,7 @@ Callback *gfc_callback_new(void (*callback)(void *data),void *data)
 void gfc_callback_free(Callback *callback)
 {
     if (!callback)return;
-    free(callback);
+    gfc_allocator_free(callback->allocator,callback);
 }
 
 void gfc_callback_call(Callback *callback)
@@ -34,4 +40,115 @@ void gfc_callback_call(Callback *callback)
     }
 }
 
+typedef struct GFC_CallbackNode_S
+{
+    void (*callback)(void *data);
+    void *data;
+    struct GFC_CallbackNode_S *next;
+}GFC_CallbackNode;
+
+gfcCallbackQueue *gfc_callback_queue_new(Uint32 count)
+{
+    gfcCallbackQueue *queue;
+    queue = gfc_allocate_array(sizeof(gfcCallbackQueue),1);
+    if (!queue)return NULL;
+    queue->pool = gfc_pool_new(sizeof(GFC_CallbackNode),count);
+    if (!queue->pool)
+    {
+        slog("failed to allocate callback queue nodes");
+        free(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+void gfc_callback_queue_free(gfcCallbackQueue *queue)
+{
+    if (!queue)return;
+    gfc_pool_free(queue->pool);
+    free(queue);
+}
+
+int gfc_callback_queue_post(gfcCallbackQueue *queue,void (*callback)(void *data),void *data)
+{
+    GFC_CallbackNode *node;
+    void *old;
+    if ((!queue)||(!callback))return -1;
+    SDL_AtomicLock(&queue->poolLock);
+    node = gfc_pool_alloc(queue->pool);
+    SDL_AtomicUnlock(&queue->poolLock);
+    if (!node)
+    {
+        slog("failed to post callback, out of memory");
+        return -1;
+    }
+    node->callback = callback;
+    node->data = data;
+    //only ever pushed to here and taken whole by the drain, so there is no ABA problem without a lock
+    do
+    {
+        old = SDL_AtomicGetPtr(&queue->posted);
+        node->next = old;
+    }while (!SDL_AtomicCASPtr(&queue->posted,old,node));
+    SDL_AtomicIncRef(&queue->count);
+    return 0;
+}
+
+int gfc_callback_queue_post_callback(gfcCallbackQueue *queue,Callback *callback)
+{
+    if (!callback)return -1;
+    return gfc_callback_queue_post(queue,callback->callback,callback->data);
+}
+
+Uint32 gfc_callback_queue_drain(gfcCallbackQueue *queue,float budget)
+{
+    GFC_CallbackNode *node,*next,*first = NULL,*last = NULL,*done = NULL;
+    Uint64 start,limit = 0;
+    Uint32 ran = 0;
+    if (!queue)return 0;
+    start = SDL_GetPerformanceCounter();
+    if (budget > 0)limit = (Uint64)(budget * 0.001 * SDL_GetPerformanceFrequency());
+    //take everything posted so far, it is newest first so flip it onto the end of the run list
+    for (node = SDL_AtomicSetPtr(&queue->posted,NULL); node; node = next)
+    {
+        next = node->next;
+        node->next = first;
+        first = node;
+        if (!last)last = node;
+    }
+    if (first)
+    {
+        if (queue->tail)((GFC_CallbackNode *)queue->tail)->next = first;
+        else queue->head = first;
+        queue->tail = last;
+    }
+    while (queue->head)
+    {
+        node = queue->head;
+        queue->head = node->next;
+        if (!queue->head)queue->tail = NULL;
+        node->callback(node->data);
+        SDL_AtomicAdd(&queue->count,-1);
+        ran++;
+        node->next = done;
+        done = node;
+        if ((limit)&&(SDL_GetPerformanceCounter() - start >= limit))break;
+    }
+    if (!done)return 0;
+    SDL_AtomicLock(&queue->poolLock);
+    for (node = done; node; node = next)
+    {
+        next = node->next;
+        gfc_pool_release(queue->pool,node);
+    }
+    SDL_AtomicUnlock(&queue->poolLock);
+    return ran;
+}
+
+Uint32 gfc_callback_queue_get_count(gfcCallbackQueue *queue)
+{
+    if (!queue)return 0;
+    return SDL_AtomicGet(&queue->count);
+}
+
 /*eol@eof*/
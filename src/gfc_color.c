@@ -1,4 +1,10 @@
+#define GFC_COLOR_IMPLEMENTATION
+#include <math.h>
+#include <string.h>
+
 #include "simple_logger.h"
+
+#include "gfc_simd.h"
 #include "gfc_color.h"
 
 
@@ -14,28 +20,6 @@ int gfc_color_cmp(Color a, Color b)
     return 1;
 }
 
-Color gfc_color(float r,float g,float b,float a)
-{
-    Color color;
-    color.r = MIN(MAX(r,-1),1);
-    color.g = MIN(MAX(g,-1),1);
-    color.b = MIN(MAX(b,-1),1);
-    color.a = MIN(MAX(a,-1),1);
-    color.ct = CT_RGBAf;
-    return color;
-}
-
-Color gfc_color8(Uint8 r,Uint8 g,Uint8 b,Uint8 a)
-{
-    Color color;
-    color.r = (float)r;
-    color.g = (float)g;
-    color.b = (float)b;
-    color.a = (float)a;
-    color.ct = CT_RGBA8;
-    return color;
-}
-
 Color gfc_color_hsl(float h,float s,float l,float a)
 {
     Color color;
@@ -49,14 +33,6 @@ Color gfc_color_hsl(float h,float s,float l,float a)
     return color;
 }
 
-Color gfc_color_hex(Uint32 hex)
-{
-    Color color;
-    color.r = (float)hex;
-    color.ct = CT_HEX;
-    return color;
-}
-
 Color gfc_color_to_float(Color color)
 {
     Color nc;
@@ -211,29 +187,6 @@ Uint32 gfc_color_to_hex(Color color)
     return hex;
 }
 
-Color gfc_color_from_vector4(Vector4D vector)
-{
-    Color color;
-    color.ct = CT_RGBA8;
-    color.r = vector.x;
-    color.g = vector.y;
-    color.b = vector.z;
-    color.a = vector.w;
-    return color;
-}
-
-Color gfc_color_from_vector4f(Vector4D vector)
-{
-    Color color;
-    color.ct = CT_RGBAf;
-    color.r = vector.x;
-    color.g = vector.y;
-    color.b = vector.z;
-    color.a = vector.w;
-    return color;
-}
-
-
 Vector4D gfc_color_to_vector4(Color color)
 {
     Vector4D vector;
@@ -263,18 +216,6 @@ float gfc_color_get_hue(Color color)
     return color.r;
 }
 
-Color gfc_color_from_sdl(SDL_Color color)
-{
-    Color nc;
-    float factor = 1.0/255.0;
-    nc.ct = CT_RGBAf;
-    nc.r = color.r *factor;
-    nc.g = color.r *factor;
-    nc.b = color.r *factor;
-    nc.a = color.r *factor;
-    return nc;
-}
-
 SDL_Color gfc_color_to_sdl(Color color)
 {
     SDL_Color nc;
@@ -468,4 +409,265 @@ Color gfc_color_clamp(Color color)
     return color;
 }
 
+/*array conversion*/
+
+#define GFC_COLOR_BATCH 256
+
+typedef struct
+{
+    int     shift[4];   /**<where r,g,b and a go in the pixel*/
+    float   alpha;      /**<255, or 0 if the pixel has no alpha*/
+}GFC_ColorPacking;
+
+static const GFC_ColorPacking gfc_color_rgba8 = {{24,16,8,0},255};
+
+/**
+ * @brief get a color as floating point channels, or as h,s,l,a if it is CT_HSL
+ * @return 1 if v is hsl, 0 if it is rgba
+ */
+static Uint8 gfc_color_unit(const Color *color,float *r,float *g,float *b,float *a,Uint8 hsl)
+{
+    Uint32 hex;
+    float factor = 1.0/255.0;
+    if ((hsl)||(color->ct == CT_HSL))
+    {
+        *r = color->r;
+        if ((*r < 0)||(*r >= 360))*r -= 360 * floorf(*r / 360);
+        *g = color->g;
+        *b = color->b;
+        *a = color->a;
+        return 1;
+    }
+    switch (color->ct)
+    {
+        case CT_RGBA8:
+            *r = color->r * factor;
+            *g = color->g * factor;
+            *b = color->b * factor;
+            *a = color->a * factor;
+            return 0;
+        case CT_HEX:
+            hex = (Uint32)color->r;
+            *r = ((hex >> 24) & 0xff) * factor;
+            *g = ((hex >> 16) & 0xff) * factor;
+            *b = ((hex >> 8) & 0xff) * factor;
+            *a = (hex & 0xff) * factor;
+            return 0;
+        case CT_RGBAf:
+        case CT_HSL:
+        default:
+            *r = color->r;
+            *g = color->g;
+            *b = color->b;
+            *a = color->a;
+            return 0;
+    }
+}
+
+#ifdef GFC_SIMD
+
+/**
+ * @brief one channel of hsl to rgb without the sector branches: l - a * clamp(min(k - 3,9 - k),-1,1)
+ * where k = (n + h / 30) mod 12 and a = s * min(l,1 - l).  n is 0 for red, 8 for green and 4 for blue
+ */
+static inline gfc_f4 gfc_colors_hsl_channel(gfc_f4 hk,gfc_f4 l,gfc_f4 a,float n)
+{
+    gfc_f4 k,twelve = gfc_f4_set1(12);
+    k = gfc_f4_add(hk,gfc_f4_set1(n));
+    k = gfc_f4_select(gfc_f4_le(twelve,k),gfc_f4_sub(k,twelve),k);
+    k = gfc_f4_min(gfc_f4_min(gfc_f4_sub(k,gfc_f4_set1(3)),gfc_f4_sub(gfc_f4_set1(9),k)),gfc_f4_set1(1));
+    k = gfc_f4_max(k,gfc_f4_set1(-1));
+    return gfc_f4_sub(l,gfc_f4_mul(a,k));
+}
+
+/**
+ * @brief load four colors as rgba channels from 0-1
+ */
+static inline void gfc_colors_load4(const Color *colors,Uint32 count,Uint8 hsl,gfc_f4 *r,gfc_f4 *g,gfc_f4 *b,gfc_f4 *a)
+{
+    GFC_ALIGN16_PRE float v[4][4] GFC_ALIGN16_POST;
+    gfc_f4 hk,l,sa,one = gfc_f4_set1(1);
+    gfc_m4 lanes;
+    Uint32 i,mask = 0;
+    memset(v,0,sizeof(v));
+    for (i = 0; i < count; i++)
+    {
+        if (gfc_color_unit(&colors[i],&v[0][i],&v[1][i],&v[2][i],&v[3][i],hsl))mask |= 1 << i;
+    }
+    *r = gfc_f4_load(v[0]);
+    *g = gfc_f4_load(v[1]);
+    *b = gfc_f4_load(v[2]);
+    *a = gfc_f4_load(v[3]);
+    if (!mask)return;
+    l = *b;
+    sa = gfc_f4_mul(*g,gfc_f4_min(l,gfc_f4_sub(one,l)));
+    hk = gfc_f4_mul(*r,gfc_f4_set1(1.0 / 30.0));
+    lanes = gfc_f4_gt(gfc_f4_set((mask & 1),(mask & 2),(mask & 4),(mask & 8)),gfc_f4_set1(0));
+    *r = gfc_f4_select(lanes,gfc_colors_hsl_channel(hk,l,sa,0),*r);
+    *g = gfc_f4_select(lanes,gfc_colors_hsl_channel(hk,l,sa,8),*g);
+    *b = gfc_f4_select(lanes,gfc_colors_hsl_channel(hk,l,sa,4),*b);
+}
+
+static inline gfc_f4 gfc_colors_scale(gfc_f4 v,gfc_f4 scale)
+{
+    return gfc_f4_mul(gfc_f4_min(gfc_f4_max(v,gfc_f4_set1(0)),gfc_f4_set1(1)),scale);
+}
+
+static void gfc_colors_pack(Uint32 *dst,const Color *a,const Color *b,float t,Uint32 count,const GFC_ColorPacking *pk,Uint8 hsl)
+{
+    GFC_ALIGN16_PRE Uint32 tail[4] GFC_ALIGN16_POST;
+    gfc_f4 r,g,bl,al,r2,g2,b2,a2,ft,full,alpha;
+    Uint32 i,n;
+    full = gfc_f4_set1(255);
+    alpha = gfc_f4_set1(pk->alpha);
+    ft = gfc_f4_set1(t);
+    for (i = 0; i < count; i += 4)
+    {
+        n = MIN(count - i,4);
+        gfc_colors_load4(&a[i],n,hsl,&r,&g,&bl,&al);
+        if (b)
+        {
+            gfc_colors_load4(&b[i],n,0,&r2,&g2,&b2,&a2);
+            r = gfc_f4_add(r,gfc_f4_mul(gfc_f4_sub(r2,r),ft));
+            g = gfc_f4_add(g,gfc_f4_mul(gfc_f4_sub(g2,g),ft));
+            bl = gfc_f4_add(bl,gfc_f4_mul(gfc_f4_sub(b2,bl),ft));
+            al = gfc_f4_add(al,gfc_f4_mul(gfc_f4_sub(a2,al),ft));
+        }
+        r = gfc_colors_scale(r,full);
+        g = gfc_colors_scale(g,full);
+        bl = gfc_colors_scale(bl,full);
+        al = gfc_colors_scale(al,alpha);
+        if (n == 4)
+        {
+            gfc_f4_store_packed(&dst[i],r,g,bl,al,pk->shift[0],pk->shift[1],pk->shift[2],pk->shift[3]);
+            continue;
+        }
+        gfc_f4_store_packed(tail,r,g,bl,al,pk->shift[0],pk->shift[1],pk->shift[2],pk->shift[3]);
+        memcpy(&dst[i],tail,sizeof(Uint32) * n);
+    }
+}
+
+#else
+
+static float gfc_colors_hsl_channel(float h,float l,float a,float n)
+{
+    float k = n + h * (1.0 / 30.0);
+    if (k >= 12)k -= 12;
+    k = MIN(MIN(k - 3,9 - k),1);
+    k = MAX(k,-1);
+    return l - a * k;
+}
+
+static void gfc_colors_load(const Color *color,Uint8 hsl,float v[4])
+{
+    float h,s,l,sa;
+    if (!gfc_color_unit(color,&v[0],&v[1],&v[2],&v[3],hsl))return;
+    h = v[0];
+    s = v[1];
+    l = v[2];
+    sa = s * MIN(l,1 - l);
+    v[0] = gfc_colors_hsl_channel(h,l,sa,0);
+    v[1] = gfc_colors_hsl_channel(h,l,sa,8);
+    v[2] = gfc_colors_hsl_channel(h,l,sa,4);
+}
+
+static void gfc_colors_pack(Uint32 *dst,const Color *a,const Color *b,float t,Uint32 count,const GFC_ColorPacking *pk,Uint8 hsl)
+{
+    float v[4],w[4],scale;
+    Uint32 i,c,pixel;
+    for (i = 0; i < count; i++)
+    {
+        gfc_colors_load(&a[i],hsl,v);
+        if (b)
+        {
+            gfc_colors_load(&b[i],0,w);
+            for (c = 0; c < 4; c++)v[c] += (w[c] - v[c]) * t;
+        }
+        pixel = 0;
+        for (c = 0; c < 4; c++)
+        {
+            scale = (c == 3)?pk->alpha:255;
+            pixel |= (Uint32)(MIN(MAX(v[c],0),1) * scale) << pk->shift[c];
+        }
+        dst[i] = pixel;
+    }
+}
+
+#endif
+
+void gfc_colors_to_int8(Uint32 *dst,const Color *colors,Uint32 count)
+{
+    if ((!dst)||(!colors))return;
+    gfc_colors_pack(dst,colors,NULL,0,count,&gfc_color_rgba8,0);
+}
+
+void gfc_colors_hsl_to_rgb(Uint32 *dst,const Color *colors,Uint32 count)
+{
+    if ((!dst)||(!colors))return;
+    gfc_colors_pack(dst,colors,NULL,0,count,&gfc_color_rgba8,1);
+}
+
+void gfc_colors_blend(Uint32 *dst,const Color *a,const Color *b,float t,Uint32 count)
+{
+    if ((!dst)||(!a)||(!b))return;
+    gfc_colors_pack(dst,a,b,t,count,&gfc_color_rgba8,0);
+}
+
+void gfc_colors_to_pixels(void *pixels,const Color *colors,Uint32 count,const SDL_PixelFormat *format)
+{
+    GFC_ColorPacking pk;
+    Uint32 batch[GFC_COLOR_BATCH];
+    Uint32 i,j,n,pixel;
+    Uint8 *out;
+    if ((!pixels)||(!colors)||(!format))return;
+    if ((format->BytesPerPixel == 4)&&
+        (format->Rmask == (0xffu << format->Rshift))&&
+        (format->Gmask == (0xffu << format->Gshift))&&
+        (format->Bmask == (0xffu << format->Bshift))&&
+        ((!format->Amask)||(format->Amask == (0xffu << format->Ashift))))
+    {
+        pk.shift[0] = format->Rshift;
+        pk.shift[1] = format->Gshift;
+        pk.shift[2] = format->Bshift;
+        pk.shift[3] = format->Ashift;
+        pk.alpha = format->Amask?255:0;
+        gfc_colors_pack((Uint32 *)pixels,colors,NULL,0,count,&pk,0);
+        return;
+    }
+    //anything else is mapped pixel by pixel, in batches so the conversion still runs four at a time
+    out = (Uint8 *)pixels;
+    for (i = 0; i < count; i += n)
+    {
+        n = MIN(count - i,GFC_COLOR_BATCH);
+        gfc_colors_pack(batch,&colors[i],NULL,0,n,&gfc_color_rgba8,0);
+        for (j = 0; j < n; j++,out += format->BytesPerPixel)
+        {
+            pixel = SDL_MapRGBA(format,batch[j] >> 24,(batch[j] >> 16) & 0xff,(batch[j] >> 8) & 0xff,batch[j] & 0xff);
+            switch (format->BytesPerPixel)
+            {
+                case 1:
+                    *out = (Uint8)pixel;
+                    break;
+                case 2:
+                    *(Uint16 *)out = (Uint16)pixel;
+                    break;
+                case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+                    out[0] = (pixel >> 16) & 0xff;
+                    out[1] = (pixel >> 8) & 0xff;
+                    out[2] = pixel & 0xff;
+#else
+                    out[0] = pixel & 0xff;
+                    out[1] = (pixel >> 8) & 0xff;
+                    out[2] = (pixel >> 16) & 0xff;
+#endif
+                    break;
+                default:
+                    *(Uint32 *)out = pixel;
+                    break;
+            }
+        }
+    }
+}
+
 /*eol@eof*/
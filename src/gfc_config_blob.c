@@ -0,0 +1,752 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+#include "simple_json_parse.h"
+
+#include "gfc_types.h"
+#include "gfc_array.h"
+#include "gfc_string.h"
+#include "gfc_pak.h"
+#include "gfc_profile.h"
+#include "gfc_config_blob.h"
+
+typedef struct
+{
+    gfcArray *resources;    /**<GFC_ConfigBlobResource*/
+    gfcArray *defs;         /**<GFC_ConfigBlobDef*/
+    gfcArray *slots;        /**<Uint32, every resource's name table*/
+    gfcArray *resourceTable;/**<Uint32*/
+    gfcArray *strings;      /**<bytes*/
+    gfcArray *text;         /**<bytes*/
+}ConfigBlobBuild;
+
+#define gfc_config_bytes(array) ((char *)(array)->elements)
+
+//compile section
+
+static void gfc_config_build_free(ConfigBlobBuild *build)
+{
+    gfc_array_delete(build->resources);
+    gfc_array_delete(build->defs);
+    gfc_array_delete(build->slots);
+    gfc_array_delete(build->resourceTable);
+    gfc_array_delete(build->strings);
+    gfc_array_delete(build->text);
+}
+
+static int gfc_config_build_init(ConfigBlobBuild *build)
+{
+    memset(build,0,sizeof(ConfigBlobBuild));
+    build->resources = gfc_array_new_type(GFC_ConfigBlobResource);
+    build->defs = gfc_array_new_type(GFC_ConfigBlobDef);
+    build->slots = gfc_array_new_type(Uint32);
+    build->resourceTable = gfc_array_new_type(Uint32);
+    build->strings = gfc_array_new_size(1,4096);
+    build->text = gfc_array_new_size(1,65536);
+    if ((build->resources)&&(build->defs)&&(build->slots)&&(build->resourceTable)&&(build->strings)&&(build->text))return 0;
+    gfc_config_build_free(build);
+    return -1;
+}
+
+/**
+ * @brief append bytes to a byte array, with a nul after them
+ * @param offset [output] where they start
+ */
+static int gfc_config_build_bytes(gfcArray *bytes,const void *data,size_t length,Uint32 *offset)
+{
+    if ((Uint64)bytes->count + length + 1 > 0xFFFFFFF0)return -1;
+    if (gfc_array_reserve(bytes,bytes->count + (Uint32)length + 1) != 0)return -1;
+    if (offset)*offset = bytes->count;
+    memcpy(gfc_config_bytes(bytes) + bytes->count,data,length);
+    bytes->count += (Uint32)length;
+    gfc_config_bytes(bytes)[bytes->count++] = 0;
+    return 0;
+}
+
+static const char *gfc_config_scan_ws(const char *p,const char *end)
+{
+    while ((p < end)&&((*p == ' ')||(*p == '\t')||(*p == '\n')||(*p == '\r')))p++;
+    return p;
+}
+
+/**
+ * @brief skip a json string
+ * @return just past its closing quote, NULL if it is not a string
+ */
+static const char *gfc_config_scan_string(const char *p,const char *end)
+{
+    if ((p >= end)||(*p != '"'))return NULL;
+    for (p++; p < end; p++)
+    {
+        if (*p == '\\')
+        {
+            p++;
+            continue;
+        }
+        if (*p == '"')return p + 1;
+    }
+    return NULL;
+}
+
+/**
+ * @brief skip any json value, the file has already been checked by the json parser so this only finds where it ends
+ * @return just past the value, NULL if it runs off the end
+ */
+static const char *gfc_config_scan_value(const char *p,const char *end)
+{
+    int depth = 0;
+    if (p >= end)return NULL;
+    if (*p == '"')return gfc_config_scan_string(p,end);
+    if ((*p != '{')&&(*p != '['))
+    {
+        while ((p < end)&&(!strchr(",}] \t\r\n",*p)))p++;
+        return p;
+    }
+    while (p < end)
+    {
+        if (*p == '"')
+        {
+            p = gfc_config_scan_string(p,end);
+            if (!p)return NULL;
+            continue;
+        }
+        if ((*p == '{')||(*p == '['))depth++;
+        else if ((*p == '}')||(*p == ']'))
+        {
+            depth--;
+            if (!depth)return p + 1;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+static int gfc_config_scan_hex(const char *p,const char *end,Uint32 *value)
+{
+    int i;
+    *value = 0;
+    if (end - p < 4)return -1;
+    for (i = 0; i < 4; i++)
+    {
+        *value <<= 4;
+        if ((p[i] >= '0')&&(p[i] <= '9'))*value |= p[i] - '0';
+        else if ((p[i] >= 'a')&&(p[i] <= 'f'))*value |= p[i] - 'a' + 10;
+        else if ((p[i] >= 'A')&&(p[i] <= 'F'))*value |= p[i] - 'A' + 10;
+        else return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief decode the text of a json string, the decoded text is never longer than the escaped text
+ * @param start just past the opening quote
+ * @param stop the closing quote
+ * @param out room for stop - start bytes
+ * @return -1 on a bad escape, the decoded length otherwise
+ */
+static int gfc_config_scan_decode(const char *start,const char *stop,char *out)
+{
+    char *o = out;
+    Uint32 code,low;
+    const char *p;
+    for (p = start; p < stop; p++)
+    {
+        if (*p != '\\')
+        {
+            *o++ = *p;
+            continue;
+        }
+        if (++p >= stop)return -1;
+        switch (*p)
+        {
+            case 'b': *o++ = '\b'; break;
+            case 'f': *o++ = '\f'; break;
+            case 'n': *o++ = '\n'; break;
+            case 'r': *o++ = '\r'; break;
+            case 't': *o++ = '\t'; break;
+            case 'u':
+                if (gfc_config_scan_hex(p + 1,stop,&code) != 0)return -1;
+                p += 4;
+                if ((code >= 0xD800)&&(code < 0xDC00)&&(stop - p > 6)&&(p[1] == '\\')&&(p[2] == 'u')&&
+                    (gfc_config_scan_hex(p + 3,stop,&low) == 0)&&(low >= 0xDC00)&&(low < 0xE000))
+                {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+                if (code < 0x80)*o++ = (char)code;
+                else if (code < 0x800)
+                {
+                    *o++ = (char)(0xC0 | (code >> 6));
+                    *o++ = (char)(0x80 | (code & 0x3F));
+                }
+                else if (code < 0x10000)
+                {
+                    *o++ = (char)(0xE0 | (code >> 12));
+                    *o++ = (char)(0x80 | ((code >> 6) & 0x3F));
+                    *o++ = (char)(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    *o++ = (char)(0xF0 | (code >> 18));
+                    *o++ = (char)(0x80 | ((code >> 12) & 0x3F));
+                    *o++ = (char)(0x80 | ((code >> 6) & 0x3F));
+                    *o++ = (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            default:
+                *o++ = *p;//quote, backslash and slash
+        }
+    }
+    return (int)(o - out);
+}
+
+/**
+ * @brief decode a json string into the string table
+ * @param str the opening quote
+ * @param strEnd just past the closing quote
+ */
+static int gfc_config_build_string(ConfigBlobBuild *build,const char *str,const char *strEnd,Uint32 *offset,Uint32 *length,Uint32 *hash)
+{
+    char *decoded;
+    int size;
+    decoded = malloc(strEnd - str);
+    if (!decoded)return -1;
+    size = gfc_config_scan_decode(str + 1,strEnd - 1,decoded);
+    if ((size < 0)||(gfc_config_build_bytes(build->strings,decoded,size,offset) != 0))
+    {
+        free(decoded);
+        return -1;
+    }
+    *length = size;
+    *hash = gfc_string_hash_seeded(decoded,size,GFC_STRING_HASH_SEED);
+    free(decoded);
+    return 0;
+}
+
+static Uint8 gfc_config_build_string_equal(ConfigBlobBuild *build,Uint32 a,Uint32 aLength,Uint32 b,Uint32 bLength)
+{
+    if (aLength != bLength)return 0;
+    return memcmp(gfc_config_bytes(build->strings) + a,gfc_config_bytes(build->strings) + b,aLength) == 0;
+}
+
+/**
+ * @brief find the "name" string of a def object, the first one wins as it does for sj_object_get_value()
+ */
+static int gfc_config_build_def_name(ConfigBlobBuild *build,const char *p,const char *end,GFC_ConfigBlobDef *def)
+{
+    const char *key,*keyEnd,*value,*valueEnd;
+    def->name = GFC_CONFIG_BLOB_NONE;
+    if (*p != '{')return 0;
+    for (p++;;)
+    {
+        p = gfc_config_scan_ws(p,end);
+        if ((p >= end)||(*p == '}'))return 0;
+        key = p;
+        keyEnd = gfc_config_scan_string(p,end);
+        if (!keyEnd)return -1;
+        p = gfc_config_scan_ws(keyEnd,end);
+        if ((p >= end)||(*p != ':'))return -1;
+        value = gfc_config_scan_ws(p + 1,end);
+        valueEnd = gfc_config_scan_value(value,end);
+        if (!valueEnd)return -1;
+        if ((keyEnd - key == 6)&&(memcmp(key,"\"name\"",6) == 0))
+        {
+            if (*value != '"')return 0;
+            return gfc_config_build_string(build,value,valueEnd,&def->name,&def->nameLength,&def->hash);
+        }
+        p = gfc_config_scan_ws(valueEnd,end);
+        if ((p < end)&&(*p == ','))p++;
+    }
+}
+
+static Uint32 gfc_config_build_table_size(Uint32 count)
+{
+    Uint32 size = 1;
+    if (!count)return 0;
+    while (size < count * 2)size <<= 1;
+    return size;
+}
+
+/**
+ * @brief hash the defs of a resource by name, the first def with a name keeps it
+ */
+static int gfc_config_build_name_table(ConfigBlobBuild *build,GFC_ConfigBlobResource *res)
+{
+    GFC_ConfigBlobDef *defs,*other;
+    Uint32 *slots;
+    Uint32 i,named = 0,slot,zero = 0;
+    defs = gfc_array_data(build->defs,GFC_ConfigBlobDef) + res->firstDef;
+    for (i = 0; i < res->defCount; i++)
+    {
+        if (defs[i].name != GFC_CONFIG_BLOB_NONE)named++;
+    }
+    res->nameSlots = build->slots->count;
+    res->nameSlotCount = gfc_config_build_table_size(named);
+    for (i = 0; i < res->nameSlotCount; i++)
+    {
+        if (!gfc_array_append(build->slots,&zero))return -1;
+    }
+    slots = gfc_array_data(build->slots,Uint32) + res->nameSlots;
+    for (i = 0; i < res->defCount; i++)
+    {
+        if (defs[i].name == GFC_CONFIG_BLOB_NONE)continue;
+        for (slot = defs[i].hash & (res->nameSlotCount - 1); slots[slot]; slot = (slot + 1) & (res->nameSlotCount - 1))
+        {
+            other = &defs[slots[slot] - 1];
+            if ((other->hash == defs[i].hash)&&
+                (gfc_config_build_string_equal(build,other->name,other->nameLength,defs[i].name,defs[i].nameLength)))break;
+        }
+        if (!slots[slot])slots[slot] = i + 1;
+    }
+    return 0;
+}
+
+static int gfc_config_build_resource(ConfigBlobBuild *build,GFC_ConfigBlobResource *res,const char *p,const char *end)
+{
+    GFC_ConfigBlobDef def;
+    const char *defEnd;
+    res->firstDef = build->defs->count;
+    res->defCount = 0;
+    for (p++;;)
+    {
+        p = gfc_config_scan_ws(p,end);
+        if (p >= end)return -1;
+        if (*p == ']')break;
+        if (*p != '{')
+        {
+            //sj_parse_buffer() starts at the first '{' it finds, so anything else would come back as some other value
+            slog("def %u of %s is not an object, only objects can be compiled",res->defCount,gfc_config_bytes(build->strings) + res->name);
+            return -1;
+        }
+        defEnd = gfc_config_scan_value(p,end);
+        if (!defEnd)return -1;
+        memset(&def,0,sizeof(GFC_ConfigBlobDef));
+        def.textLength = (Uint32)(defEnd - p);
+        //each def is nul terminated so it can be parsed straight out of the blob
+        if (gfc_config_build_bytes(build->text,p,defEnd - p,&def.text) != 0)return -1;
+        if (gfc_config_build_def_name(build,p,defEnd,&def) != 0)return -1;
+        if (!gfc_array_append(build->defs,&def))return -1;
+        res->defCount++;
+        p = gfc_config_scan_ws(defEnd,end);
+        if ((p < end)&&(*p == ','))p++;
+    }
+    return gfc_config_build_name_table(build,res);
+}
+
+static int gfc_config_build_resource_table(ConfigBlobBuild *build)
+{
+    GFC_ConfigBlobResource *resources;
+    Uint32 *table;
+    Uint32 i,slot,size,zero = 0;
+    size = gfc_config_build_table_size(build->resources->count);
+    for (i = 0; i < size; i++)
+    {
+        if (!gfc_array_append(build->resourceTable,&zero))return -1;
+    }
+    resources = gfc_array_data(build->resources,GFC_ConfigBlobResource);
+    table = gfc_array_data(build->resourceTable,Uint32);
+    for (i = 0; i < build->resources->count; i++)
+    {
+        for (slot = resources[i].hash & (size - 1); table[slot]; slot = (slot + 1) & (size - 1));
+        table[slot] = i + 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief walk the top level object of a config def file, every array in it is a resource list
+ */
+static int gfc_config_build_scan(ConfigBlobBuild *build,const char *p,const char *end)
+{
+    GFC_ConfigBlobResource res,*other;
+    const char *key,*keyEnd,*value,*valueEnd;
+    Uint32 i;
+    Uint8 duplicate;
+    if ((end - p >= 3)&&(memcmp(p,"\xEF\xBB\xBF",3) == 0))p += 3;
+    p = gfc_config_scan_ws(p,end);
+    if ((p >= end)||(*p != '{'))return -1;
+    for (p++;;)
+    {
+        p = gfc_config_scan_ws(p,end);
+        if (p >= end)return -1;
+        if (*p == '}')return 0;
+        key = p;
+        keyEnd = gfc_config_scan_string(p,end);
+        if (!keyEnd)return -1;
+        p = gfc_config_scan_ws(keyEnd,end);
+        if ((p >= end)||(*p != ':'))return -1;
+        value = gfc_config_scan_ws(p + 1,end);
+        valueEnd = gfc_config_scan_value(value,end);
+        if (!valueEnd)return -1;
+        if (*value == '[')
+        {
+            memset(&res,0,sizeof(GFC_ConfigBlobResource));
+            if (gfc_config_build_string(build,key,keyEnd,&res.name,&res.nameLength,&res.hash) != 0)return -1;
+            duplicate = 0;
+            for (i = 0; i < build->resources->count; i++)
+            {
+                other = gfc_array_get_nth(build->resources,i);
+                if ((other->hash == res.hash)&&
+                    (gfc_config_build_string_equal(build,other->name,other->nameLength,res.name,res.nameLength)))
+                {
+                    duplicate = 1;
+                    break;
+                }
+            }
+            if (duplicate)build->strings->count = res.name;//first one wins
+            else
+            {
+                if (gfc_config_build_resource(build,&res,value,valueEnd) != 0)return -1;
+                if (!gfc_array_append(build->resources,&res))return -1;
+            }
+        }
+        p = gfc_config_scan_ws(valueEnd,end);
+        if ((p < end)&&(*p == ','))p++;
+    }
+}
+
+static Uint32 gfc_config_blob_align(Uint32 offset)
+{
+    return (offset + 3) & ~3u;
+}
+
+static int gfc_config_build_write(ConfigBlobBuild *build,Uint32 sourceCrc,const char *outFile)
+{
+    GFC_ConfigBlobHeader header;
+    FILE *file;
+    const gfcArray *sections[6];
+    Uint32 *offsets[6];
+    Uint64 offset;
+    Uint32 i,size,pad = 0;
+    memset(&header,0,sizeof(GFC_ConfigBlobHeader));
+    memcpy(header.magic,"GCDB",4);
+    header.version = GFC_CONFIG_BLOB_VERSION;
+    header.sourceCrc = sourceCrc;
+    header.resourceCount = build->resources->count;
+    header.resourceSlots = build->resourceTable->count;
+    header.defCount = build->defs->count;
+    header.slotCount = build->slots->count;
+    header.stringsSize = build->strings->count;
+    header.textSize = build->text->count;
+    sections[0] = build->resources;     offsets[0] = &header.resources;
+    sections[1] = build->resourceTable; offsets[1] = &header.resourceTable;
+    sections[2] = build->defs;          offsets[2] = &header.defs;
+    sections[3] = build->slots;         offsets[3] = &header.slots;
+    sections[4] = build->strings;       offsets[4] = &header.strings;
+    sections[5] = build->text;          offsets[5] = &header.text;
+    offset = sizeof(GFC_ConfigBlobHeader);
+    for (i = 0; i < 6; i++)
+    {
+        offset = gfc_config_blob_align((Uint32)offset);
+        *offsets[i] = (Uint32)offset;
+        offset += (Uint64)sections[i]->count * sections[i]->elementSize;
+        if (offset > 0xFFFFFFF0)
+        {
+            slog("config def blob %s would be too large",outFile);
+            return -1;
+        }
+    }
+    header.size = (Uint32)offset;
+    file = fopen(outFile,"wb");
+    if (!file)
+    {
+        slog("failed to open %s to write a config def blob",outFile);
+        return -1;
+    }
+    fwrite(&header,sizeof(GFC_ConfigBlobHeader),1,file);
+    offset = sizeof(GFC_ConfigBlobHeader);
+    for (i = 0; i < 6; i++)
+    {
+        fwrite(&pad,1,*offsets[i] - offset,file);
+        size = sections[i]->count * sections[i]->elementSize;
+        if (size)fwrite(sections[i]->elements,1,size,file);
+        offset = *offsets[i] + size;
+    }
+    if ((ferror(file))||(fclose(file) != 0))
+    {
+        slog("failed to finish writing config def blob %s",outFile);
+        return -1;
+    }
+    return 0;
+}
+
+int gfc_config_blob_get_name(const char *filename,TextLine compiled)
+{
+    size_t length;
+    if ((!filename)||(!compiled))return -1;
+    length = strlen(filename);
+    if (gfc_str_suffix(filename,".json"))length -= 5;
+    if (length + strlen(GFC_CONFIG_BLOB_EXT) >= GFCLINELEN)return -1;
+    memcpy(compiled,filename,length);
+    strcpy(compiled + length,GFC_CONFIG_BLOB_EXT);
+    return 0;
+}
+
+int gfc_config_blob_compile(const char *filename,const char *outFile)
+{
+    ConfigBlobBuild build;
+    SJson *json;
+    char *data;
+    size_t size = 0;
+    Uint32 crc = 0;
+    int result;
+    GFC_PROFILE_ZONE("gfc_config_blob_compile");
+    if ((!filename)||(!outFile))return -1;
+    //the scan below only finds where things are, the real parser is the one to say if it is valid
+    json = gfc_pak_load_json(filename);
+    if (!json)
+    {
+        slog("config def file %s could not be parsed, not compiling it",filename);
+        return -1;
+    }
+    sj_free(json);
+    if (gfc_pak_file_get_crc(filename,&crc) != 0)return -1;
+    data = gfc_pak_file_extract(filename,&size);
+    if (!data)return -1;
+    if (gfc_config_build_init(&build) != 0)
+    {
+        free(data);
+        return -1;
+    }
+    result = gfc_config_build_scan(&build,data,data + size);
+    if (result != 0)slog("failed to compile config def file %s",filename);
+    if (result == 0)result = gfc_config_build_resource_table(&build);
+    if (result == 0)result = gfc_config_build_write(&build,crc,outFile);
+    gfc_config_build_free(&build);
+    free(data);
+    return result;
+}
+
+//load section
+
+static Uint8 gfc_config_blob_section_ok(const GFC_ConfigBlobHeader *header,Uint32 offset,Uint32 count,Uint32 elementSize)
+{
+    if (offset & 3)return 0;
+    if (offset < sizeof(GFC_ConfigBlobHeader))return 0;
+    return (Uint64)offset + (Uint64)count * elementSize <= header->size;
+}
+
+static Uint8 gfc_config_blob_string_ok(GFC_ConfigBlob *blob,Uint32 offset,Uint32 length)
+{
+    if ((Uint64)offset + length >= blob->header->stringsSize)return 0;
+    return blob->strings[offset + length] == 0;
+}
+
+static Uint8 gfc_config_blob_table_ok(const Uint32 *slots,Uint32 count,Uint32 max)
+{
+    Uint32 i;
+    if ((count)&&(count & (count - 1)))return 0;//has to be a power of two
+    for (i = 0; i < count; i++)
+    {
+        if (slots[i] > max)return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief check every offset in the blob, so that lookups never have to
+ */
+static int gfc_config_blob_validate(GFC_ConfigBlob *blob,const Uint8 *data,size_t size)
+{
+    const GFC_ConfigBlobHeader *header;
+    const GFC_ConfigBlobResource *res;
+    const GFC_ConfigBlobDef *def;
+    Uint32 i;
+    if (size < sizeof(GFC_ConfigBlobHeader))return -1;
+    header = (const GFC_ConfigBlobHeader *)data;
+    if (memcmp(header->magic,"GCDB",4) != 0)return -1;
+    if ((header->version != GFC_CONFIG_BLOB_VERSION)||(header->size != size))return -1;
+    if (!gfc_config_blob_section_ok(header,header->resources,header->resourceCount,sizeof(GFC_ConfigBlobResource)))return -1;
+    if (!gfc_config_blob_section_ok(header,header->resourceTable,header->resourceSlots,sizeof(Uint32)))return -1;
+    if (!gfc_config_blob_section_ok(header,header->defs,header->defCount,sizeof(GFC_ConfigBlobDef)))return -1;
+    if (!gfc_config_blob_section_ok(header,header->slots,header->slotCount,sizeof(Uint32)))return -1;
+    if (!gfc_config_blob_section_ok(header,header->strings,header->stringsSize,1))return -1;
+    if (!gfc_config_blob_section_ok(header,header->text,header->textSize,1))return -1;
+    if ((header->resourceCount)&&(header->resourceSlots < header->resourceCount))return -1;
+    blob->header = header;
+    blob->resources = (const GFC_ConfigBlobResource *)(data + header->resources);
+    blob->resourceTable = (const Uint32 *)(data + header->resourceTable);
+    blob->defs = (const GFC_ConfigBlobDef *)(data + header->defs);
+    blob->slots = (const Uint32 *)(data + header->slots);
+    blob->strings = (const char *)(data + header->strings);
+    blob->text = (const char *)(data + header->text);
+    if (!gfc_config_blob_table_ok(blob->resourceTable,header->resourceSlots,header->resourceCount))return -1;
+    for (i = 0; i < header->resourceCount; i++)
+    {
+        res = &blob->resources[i];
+        if (!gfc_config_blob_string_ok(blob,res->name,res->nameLength))return -1;
+        if ((Uint64)res->firstDef + res->defCount > header->defCount)return -1;
+        if ((Uint64)res->nameSlots + res->nameSlotCount > header->slotCount)return -1;
+        if (!gfc_config_blob_table_ok(blob->slots + res->nameSlots,res->nameSlotCount,res->defCount))return -1;
+    }
+    for (i = 0; i < header->defCount; i++)
+    {
+        def = &blob->defs[i];
+        if ((Uint64)def->text + def->textLength >= header->textSize)return -1;
+        if (blob->text[def->text + def->textLength] != 0)return -1;
+        if ((def->name != GFC_CONFIG_BLOB_NONE)&&(!gfc_config_blob_string_ok(blob,def->name,def->nameLength)))return -1;
+    }
+    return 0;
+}
+
+GFC_ConfigBlob *gfc_config_blob_load(const char *filename)
+{
+    GFC_ConfigBlob *blob;
+    const void *data;
+    size_t size = 0;
+    GFC_PROFILE_ZONE("gfc_config_blob_load");
+    if (!filename)return NULL;
+    blob = gfc_allocate_array(sizeof(GFC_ConfigBlob),1);
+    if (!blob)return NULL;
+    blob->map = gfc_pak_file_map(filename,&size);
+    if (!blob->map)
+    {
+        slog("failed to load config def blob %s",filename);
+        free(blob);
+        return NULL;
+    }
+    data = blob->map;
+    if ((size_t)data & 3)
+    {
+        //a stored pak entry can start anywhere
+        blob->copy = malloc(size);
+        if (!blob->copy)
+        {
+            gfc_config_blob_free(blob);
+            return NULL;
+        }
+        memcpy(blob->copy,data,size);
+        data = blob->copy;
+    }
+    if (gfc_config_blob_validate(blob,data,size) != 0)
+    {
+        slog("config def blob %s is not valid, or was built by a different version",filename);
+        gfc_config_blob_free(blob);
+        return NULL;
+    }
+    if (blob->header->defCount)blob->parsed = gfc_allocate_array(sizeof(SJson *),blob->header->defCount);
+    if (blob->header->resourceCount)blob->lists = gfc_allocate_array(sizeof(SJson *),blob->header->resourceCount);
+    if (((blob->header->defCount)&&(!blob->parsed))||((blob->header->resourceCount)&&(!blob->lists)))
+    {
+        gfc_config_blob_free(blob);
+        return NULL;
+    }
+    return blob;
+}
+
+void gfc_config_blob_free(GFC_ConfigBlob *blob)
+{
+    Uint32 i;
+    if (!blob)return;
+    if ((blob->parsed)&&(blob->header))
+    {
+        for (i = 0; i < blob->header->defCount; i++)
+        {
+            if (blob->parsed[i])sj_free(blob->parsed[i]);
+        }
+    }
+    if ((blob->lists)&&(blob->header))
+    {
+        for (i = 0; i < blob->header->resourceCount; i++)
+        {
+            if (blob->lists[i])sj_free(blob->lists[i]);
+        }
+    }
+    free(blob->parsed);
+    free(blob->lists);
+    gfc_pak_file_unmap(blob->map);
+    free(blob->copy);
+    free(blob);
+}
+
+int gfc_config_blob_find_resource(GFC_ConfigBlob *blob,const char *resource)
+{
+    const GFC_ConfigBlobResource *res;
+    Uint32 hash,slot,mask,i;
+    size_t length;
+    if ((!blob)||(!resource))return -1;
+    if (!blob->header->resourceSlots)return -1;
+    hash = gfc_string_hash_cstr(resource,GFC_STRING_HASH_SEED,&length);
+    mask = blob->header->resourceSlots - 1;
+    for (i = 0,slot = hash & mask; i <= mask; i++,slot = (slot + 1) & mask)
+    {
+        if (!blob->resourceTable[slot])return -1;
+        res = &blob->resources[blob->resourceTable[slot] - 1];
+        if ((res->hash != hash)||(res->nameLength != length))continue;
+        if (memcmp(blob->strings + res->name,resource,length) == 0)return blob->resourceTable[slot] - 1;
+    }
+    return -1;
+}
+
+Uint32 gfc_config_blob_get_def_count(GFC_ConfigBlob *blob,int resource)
+{
+    if ((!blob)||(resource < 0)||((Uint32)resource >= blob->header->resourceCount))return 0;
+    return blob->resources[resource].defCount;
+}
+
+int gfc_config_blob_find_def(GFC_ConfigBlob *blob,int resource,const char *name)
+{
+    const GFC_ConfigBlobResource *res;
+    const GFC_ConfigBlobDef *def;
+    const Uint32 *slots;
+    Uint32 hash,slot,mask,i;
+    size_t length;
+    if ((!blob)||(!name)||(resource < 0)||((Uint32)resource >= blob->header->resourceCount))return -1;
+    res = &blob->resources[resource];
+    if (!res->nameSlotCount)return -1;
+    hash = gfc_string_hash_cstr(name,GFC_STRING_HASH_SEED,&length);
+    slots = blob->slots + res->nameSlots;
+    mask = res->nameSlotCount - 1;
+    for (i = 0,slot = hash & mask; i <= mask; i++,slot = (slot + 1) & mask)
+    {
+        if (!slots[slot])return -1;
+        def = &blob->defs[res->firstDef + slots[slot] - 1];
+        if ((def->hash != hash)||(def->nameLength != length))continue;
+        if (memcmp(blob->strings + def->name,name,length) == 0)return slots[slot] - 1;
+    }
+    return -1;
+}
+
+const char *gfc_config_blob_get_def_name(GFC_ConfigBlob *blob,int resource,Uint32 n)
+{
+    const GFC_ConfigBlobDef *def;
+    if (n >= gfc_config_blob_get_def_count(blob,resource))return NULL;
+    def = &blob->defs[blob->resources[resource].firstDef + n];
+    if (def->name == GFC_CONFIG_BLOB_NONE)return NULL;
+    return blob->strings + def->name;
+}
+
+SJson *gfc_config_blob_get_def(GFC_ConfigBlob *blob,int resource,Uint32 n)
+{
+    const GFC_ConfigBlobDef *def;
+    Uint32 index;
+    if (n >= gfc_config_blob_get_def_count(blob,resource))return NULL;
+    index = blob->resources[resource].firstDef + n;
+    if (blob->parsed[index])return blob->parsed[index];
+    def = &blob->defs[index];
+    blob->parsed[index] = sj_parse_buffer((char *)blob->text + def->text,def->textLength);
+    if (!blob->parsed[index])slog("failed to parse def %u of %s",n,blob->strings + blob->resources[resource].name);
+    return blob->parsed[index];
+}
+
+SJson *gfc_config_blob_get_list(GFC_ConfigBlob *blob,int resource)
+{
+    SJson *list,*def;
+    Uint32 i,c;
+    c = gfc_config_blob_get_def_count(blob,resource);
+    if ((!blob)||(resource < 0)||((Uint32)resource >= blob->header->resourceCount))return NULL;
+    if (blob->lists[resource])return blob->lists[resource];
+    list = sj_array_new();
+    if (!list)return NULL;
+    for (i = 0; i < c; i++)
+    {
+        def = gfc_config_blob_get_def(blob,resource,i);
+        if (def)sj_array_append(list,sj_copy(def));
+    }
+    blob->lists[resource] = list;
+    return list;
+}
+
+/*eol@eof*/
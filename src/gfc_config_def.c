@@ -2,25 +2,189 @@
 
 #include "gfc_types.h"
 #include "gfc_list.h"
+#include "gfc_string.h"
+#include "gfc_hashmap.h"
+#include "gfc_callbacks.h"
 #include "gfc_pak.h"
+#include "gfc_profile.h"
+#include "gfc_watch.h"
+#include "gfc_config_blob.h"
 
 #include "gfc_config_def.h"
 
 typedef struct
 {
-    gfcList *defs;
+    SJson *json;            /**<the parsed file*/
+    GFC_ConfigBlob *blob;   /**<or its compiled form, only one of the two is set*/
+}ConfigSource;
+
+typedef struct
+{
+    TextLine filename;
+    ConfigSource source;
+    Uint32 watchId;         /**<set while the file is watched for changes*/
+}ConfigFile;
+
+typedef struct
+{
+    gfcString name;         /**<the resource name it is kept under*/
+    ConfigFile *file;       /**<the file the list was found in, NULL if it was not found*/
+    SJson *list;            /**<the json array of defs, owned by the file it was loaded from, NULL for a blob*/
+    int blobResource;       /**<the resource index in file's blob*/
+    HashMap *byName;        /**<"name" value to def, a blob has its own*/
+    HashMap *byParameter;   /**<parameter key to a HashMap of value to def, built on first use*/
+}ConfigResource;
+
+typedef struct
+{
+    Uint32 id;
+    gfcString resource;
+    Callback callback;      /**<callback.callback is NULL once unsubscribed*/
+}ConfigSubscriber;
+
+typedef struct
+{
+    gfcList *defs;          /**<ConfigFile *, searched in the order loaded*/
+    HashMap *resources;     /**<resource name to ConfigResource, built as resources are asked for*/
+    gfcList *subscribers;   /**<ConfigSubscriber **/
+    Uint32 nextId;
+    Uint8 notifying;        /**<unsubscribing waits until subscribers have been told*/
+    Uint8 watching;
 }ConfigManager;
 
 static ConfigManager config_manager = {0};
 
+static void gfc_config_resource_free(ConfigResource *resource)
+{
+    if (!resource)return;
+    gfc_hashmap_free(resource->byName);
+    if (resource->byParameter)
+    {
+        gfc_hashmap_foreach(resource->byParameter,(gfc_work_func*)gfc_hashmap_free);
+        gfc_hashmap_free(resource->byParameter);
+    }
+    gfc_string_clear(&resource->name);
+    free(resource);
+}
+
+static void gfc_config_source_free(ConfigSource *source)
+{
+    if (source->json)sj_free(source->json);
+    gfc_config_blob_free(source->blob);
+    memset(source,0,sizeof(ConfigSource));
+}
+
+static Uint8 gfc_config_source_has(ConfigSource *source,const char *resource)
+{
+    if (source->json)return sj_object_get_value(source->json,resource)?1:0;
+    return gfc_config_blob_find_resource(source->blob,resource) >= 0;
+}
+
+/**
+ * @brief load a config def file, from its compiled form if there is one that was built from the file as it is now
+ * @return -1 if neither could be loaded, 0 otherwise
+ */
+static int gfc_config_source_load(const char *filename,ConfigSource *source)
+{
+    TextLine compiled;
+    GFC_PakFileStamp stamp;
+    Uint32 crc;
+    memset(source,0,sizeof(ConfigSource));
+    if (gfc_str_suffix(filename,GFC_CONFIG_BLOB_EXT))
+    {
+        source->blob = gfc_config_blob_load(filename);
+        return source->blob?0:-1;
+    }
+    if ((gfc_config_blob_get_name(filename,compiled) == 0)&&
+        (gfc_pak_file_get_stamp(compiled,&stamp) == 0)&&(stamp.found))
+    {
+        source->blob = gfc_config_blob_load(compiled);
+        //a blob shipped without its json is used as is
+        if ((source->blob)&&(gfc_pak_file_get_crc(filename,&crc) == 0)&&(crc != source->blob->header->sourceCrc))
+        {
+            slog("compiled config def %s is out of date, loading %s instead",compiled,filename);
+            gfc_config_blob_free(source->blob);
+            source->blob = NULL;
+        }
+        if (source->blob)return 0;
+    }
+    source->json = gfc_pak_load_json(filename);
+    return source->json?0:-1;
+}
+
+static void gfc_config_file_free(ConfigFile *file)
+{
+    if (!file)return;
+    gfc_watch_remove(file->watchId);
+    gfc_config_source_free(&file->source);
+    free(file);
+}
+
+static void gfc_config_subscriber_free(ConfigSubscriber *subscriber)
+{
+    if (!subscriber)return;
+    gfc_string_clear(&subscriber->resource);
+    free(subscriber);
+}
+
+static void gfc_config_def_clear_index()
+{
+    if (!config_manager.resources)return;
+    gfc_hashmap_foreach(config_manager.resources,(gfc_work_func*)gfc_config_resource_free);
+    gfc_hashmap_free(config_manager.resources);
+    config_manager.resources = NULL;
+}
+
+static Uint32 gfc_config_resource_count(ConfigResource *res)
+{
+    if (res->list)return sj_array_get_count(res->list);
+    if (!res->file)return 0;
+    return gfc_config_blob_get_def_count(res->file->source.blob,res->blobResource);
+}
+
+static SJson *gfc_config_resource_nth(ConfigResource *res,Uint32 n)
+{
+    if (res->list)return sj_array_get_nth(res->list,n);
+    if (!res->file)return NULL;
+    return gfc_config_blob_get_def(res->file->source.blob,res->blobResource,n);
+}
+
+/**
+ * @brief index the defs of a resource list by the value of one of their string keys
+ * @note the first def with a given value wins, same as searching the list in order
+ */
+static HashMap *gfc_config_resource_index(ConfigResource *res,const char *parameter)
+{
+    int i,c;
+    const char *str;
+    SJson *item;
+    HashMap *index;
+    c = gfc_config_resource_count(res);
+    index = gfc_hashmap_new_size(c);
+    if (!index)return NULL;
+    for (i = 0; i < c;i++)
+    {
+        item = gfc_config_resource_nth(res,i);
+        if (!item)continue;
+        str = sj_object_get_value_as_string(item,parameter);
+        if (!str)continue;
+        if (gfc_hashmap_get(index,str))continue;
+        gfc_hashmap_insert(index,str,item);
+    }
+    return index;
+}
+
 void gfc_config_def_close()
 {
+    gfc_config_def_clear_index();
     if (config_manager.defs)
     {
-        gfc_list_foreach(config_manager.defs,(void (*)(void *))sj_free);
+        gfc_list_foreach(config_manager.defs,(gfc_work_func*)gfc_config_file_free);
         gfc_list_delete(config_manager.defs);
         config_manager.defs = NULL;
     }
+    gfc_list_foreach(config_manager.subscribers,(gfc_work_func*)gfc_config_subscriber_free);
+    gfc_list_delete(config_manager.subscribers);
     memset(&config_manager,0,sizeof(ConfigManager));
 }
 
@@ -30,50 +194,324 @@ void gfc_config_def_init()
     atexit(gfc_config_def_close);
 }
 
+static void gfc_config_def_file_changed(void *data);
+
 void gfc_config_def_load(const char *filename)
 {
-    SJson *json;
+    ConfigSource source;
+    ConfigFile *file;
+    GFC_PROFILE_ZONE("gfc_config_def_load");
     if (!filename)return;
     
 
-    json = gfc_pak_load_json(filename);
-    if (!json)
+    if (gfc_config_source_load(filename,&source) != 0)
+    {
+        slog("failed to load config def file %s",filename);
+        return;
+    }
+    file = gfc_allocate_array(sizeof(ConfigFile),1);
+    if (!file)
     {
-        slog("failed to load config def file %s");
+        gfc_config_source_free(&source);
         return;
     }
-    gfc_list_append(config_manager.defs,json);
+    gfc_line_cpy(file->filename,filename);
+    file->source = source;
+    if (config_manager.watching)file->watchId = gfc_watch_add(filename,gfc_config_def_file_changed,file);
+    gfc_list_append(config_manager.defs,file);
+    //a new file can add resources we already cached as missing
+    gfc_config_def_clear_index();
 }
 
-SJson *gfc_config_def_get_resource_by_name(const char *resource)
+/**
+ * @brief forget the cached resources that could be found differently once the file at index changes
+ * resources found in an earlier file are still found there, so they are kept
+ */
+static void gfc_config_def_forget_from(int index)
+{
+    gfcList *resources;
+    ConfigResource *res;
+    int i,c,fileIndex;
+    resources = gfc_hashmap_get_all_values(config_manager.resources);
+    c = gfc_list_get_count(resources);
+    for (i = 0; i < c; i++)
+    {
+        res = gfc_list_get_nth(resources,i);
+        if (!res)continue;
+        if (res->file)
+        {
+            fileIndex = gfc_list_get_item_index(config_manager.defs,res->file);
+            if ((fileIndex >= 0)&&(fileIndex < index))continue;
+        }
+        gfc_hashmap_delete_by_key(config_manager.resources,gfc_string_cstr(&res->name));
+        gfc_config_resource_free(res);
+    }
+    gfc_list_delete(resources);
+}
+
+/**
+ * @brief check if a resource would be found in the file at index if it held source
+ */
+static Uint8 gfc_config_def_provides(int index,ConfigSource *source,const char *resource)
+{
+    ConfigFile *file;
+    int i;
+    for (i = 0; i < index; i++)
+    {
+        file = gfc_list_get_nth(config_manager.defs,i);
+        if ((file)&&(gfc_config_source_has(&file->source,resource)))return 0;
+    }
+    return gfc_config_source_has(source,resource);
+}
+
+static void gfc_config_def_purge_subscribers()
+{
+    ConfigSubscriber *subscriber;
+    int i;
+    for (i = gfc_list_get_count(config_manager.subscribers) - 1; i >= 0; i--)
+    {
+        subscriber = gfc_list_get_nth(config_manager.subscribers,i);
+        if ((subscriber)&&(subscriber->callback.callback))continue;
+        gfc_list_delete_nth(config_manager.subscribers,i);
+        gfc_config_subscriber_free(subscriber);
+    }
+}
+
+/**
+ * @brief tell the subscribers of every resource the file at index had before or has now
+ */
+static void gfc_config_def_notify(int index,ConfigSource *oldSource,ConfigSource *newSource)
+{
+    ConfigSubscriber *subscriber;
+    const char *resource;
+    Uint32 i,c;
+    c = gfc_list_get_count(config_manager.subscribers);
+    config_manager.notifying = 1;
+    for (i = 0; i < c; i++)
+    {
+        subscriber = gfc_list_get_nth(config_manager.subscribers,i);
+        if ((!subscriber)||(!subscriber->callback.callback))continue;
+        resource = gfc_string_cstr(&subscriber->resource);
+        if ((!gfc_config_def_provides(index,oldSource,resource))&&
+            (!gfc_config_def_provides(index,newSource,resource)))continue;
+        gfc_callback_call(&subscriber->callback);
+    }
+    config_manager.notifying = 0;
+    gfc_config_def_purge_subscribers();
+}
+
+static int gfc_config_def_reload_file(ConfigFile *file)
+{
+    ConfigSource source,old;
+    int index;
+    GFC_PROFILE_ZONE("gfc_config_def_reload");
+    index = gfc_list_get_item_index(config_manager.defs,file);
+    if (index < 0)return -1;
+    if (gfc_config_source_load(file->filename,&source) != 0)
+    {
+        slog("failed to reload config def file %s, keeping what was loaded before",file->filename);
+        return -1;
+    }
+    //nothing cached may point into the old file once it is freed
+    gfc_config_def_forget_from(index);
+    old = file->source;
+    file->source = source;
+    gfc_config_def_notify(index,&old,&file->source);
+    gfc_config_source_free(&old);
+    return 0;
+}
+
+static void gfc_config_def_file_changed(void *data)
+{
+    gfc_config_def_reload_file(data);
+}
+
+int gfc_config_def_reload(const char *filename)
+{
+    ConfigFile *file;
+    int i,c,found = 0,result = 0;
+    if (!filename)return -1;
+    c = gfc_list_get_count(config_manager.defs);
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(config_manager.defs,i);
+        if ((!file)||(gfc_strlcmp(filename,file->filename) != 0))continue;
+        found = 1;
+        if (gfc_config_def_reload_file(file) != 0)result = -1;
+    }
+    if (!found)
+    {
+        slog("config def file %s was not loaded, it can not be reloaded",filename);
+        return -1;
+    }
+    return result;
+}
+
+void gfc_config_def_watch(Uint8 enable)
 {
-    SJson *list,*item;
+    ConfigFile *file;
     int i,c;
+    config_manager.watching = enable?1:0;
+    c = gfc_list_get_count(config_manager.defs);
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(config_manager.defs,i);
+        if (!file)continue;
+        if ((enable)&&(!file->watchId))
+        {
+            file->watchId = gfc_watch_add(file->filename,gfc_config_def_file_changed,file);
+        }
+        else if ((!enable)&&(file->watchId))
+        {
+            gfc_watch_remove(file->watchId);
+            file->watchId = 0;
+        }
+    }
+}
+
+Uint32 gfc_config_def_subscribe(const char *resource,void (*onReload)(void *data),void *data)
+{
+    ConfigSubscriber *subscriber;
+    if ((!resource)||(!onReload))return 0;
+    subscriber = gfc_allocate_array(sizeof(ConfigSubscriber),1);
+    if (!subscriber)return 0;
+    if (gfc_string_set(&subscriber->resource,resource) != 0)
+    {
+        free(subscriber);
+        return 0;
+    }
+    if (!++config_manager.nextId)config_manager.nextId = 1;//zero means no subscription
+    subscriber->id = config_manager.nextId;
+    subscriber->callback.callback = onReload;
+    subscriber->callback.data = data;
+    config_manager.subscribers = gfc_list_append(config_manager.subscribers,subscriber);
+    return subscriber->id;
+}
+
+void gfc_config_def_unsubscribe(Uint32 subscriptionId)
+{
+    ConfigSubscriber *subscriber;
+    Uint32 i,c;
+    if (!subscriptionId)return;
+    c = gfc_list_get_count(config_manager.subscribers);
+    for (i = 0; i < c; i++)
+    {
+        subscriber = gfc_list_get_nth(config_manager.subscribers,i);
+        if ((!subscriber)||(subscriber->id != subscriptionId))continue;
+        subscriber->callback.callback = NULL;
+        if (!config_manager.notifying)gfc_config_def_purge_subscribers();
+        return;
+    }
+}
+
+/**
+ * @brief find a resource list and index it, results (including misses) are kept until the next load
+ */
+static ConfigResource *gfc_config_def_get_resource(const char *resource)
+{
+    SJson *item = NULL;
+    ConfigFile *file = NULL;
+    ConfigResource *res;
+    int i,c,blobResource = -1;
     if (!resource)return NULL;
     if (!config_manager.defs)return NULL;
+    if (!config_manager.resources)
+    {
+        config_manager.resources = gfc_hashmap_new();
+        if (!config_manager.resources)return NULL;
+    }
+    res = gfc_hashmap_get(config_manager.resources,resource);
+    if (res)return res;
     c = gfc_list_get_count(config_manager.defs);
     for (i = 0; i < c;i++)
     {
-        list = gfc_list_get_nth(config_manager.defs,i);
-        if (!list)continue;
-        item = sj_object_get_value(list,resource);
-        if (item)return item;
+        file = gfc_list_get_nth(config_manager.defs,i);
+        if (!file)continue;
+        if (file->source.blob)
+        {
+            blobResource = gfc_config_blob_find_resource(file->source.blob,resource);
+            if (blobResource >= 0)break;
+            continue;
+        }
+        item = sj_object_get_value(file->source.json,resource);
+        if (item)break;
+    }
+    if ((!item)&&(blobResource < 0))file = NULL;
+    res = gfc_allocate_array(sizeof(ConfigResource),1);
+    if (!res)return NULL;
+    if (gfc_string_set(&res->name,resource) != 0)
+    {
+        free(res);
+        return NULL;
+    }
+    res->list = item;
+    res->file = file;
+    res->blobResource = blobResource;
+    if (item)res->byName = gfc_config_resource_index(res,"name");
+    gfc_hashmap_insert(config_manager.resources,resource,res);
+    return res;
+}
+
+SJson *gfc_config_def_get_resource_by_name(const char *resource)
+{
+    ConfigResource *res;
+    res = gfc_config_def_get_resource(resource);
+    if ((!res)||(!res->file))return NULL;
+    if (res->list)return res->list;
+    return gfc_config_blob_get_list(res->file->source.blob,res->blobResource);
+}
+
+/**
+ * @brief search a resource list the slow way, for values too long to be hash keys
+ */
+static SJson *gfc_config_def_search(ConfigResource *res,const char *parameter,const char *name)
+{
+    const char *str;
+    int i,c;
+    SJson *item;
+    c = gfc_config_resource_count(res);
+    for (i = 0; i < c;i++)
+    {
+        item = gfc_config_resource_nth(res,i);
+        if (!item)continue;
+        str = sj_object_get_value_as_string(item,parameter);
+        if (!str)continue;
+        if (strcmp(name,str)==0)return item;
     }
     return NULL;
 }
 
+/**
+ * @brief look up a def by the value of a key through an index
+ */
+static SJson *gfc_config_def_find(ConfigResource *res,HashMap *index,const char *parameter,const char *name)
+{
+    const char *str;
+    SJson *item;
+    if (strlen(name) >= GFCLINELEN - 1)return gfc_config_def_search(res,parameter,name);
+    item = gfc_hashmap_get(index,name);
+    if (!item)return NULL;
+    str = sj_object_get_value_as_string(item,parameter);
+    if ((!str)||(strcmp(str,name) != 0))
+    {
+        //keys are truncated to a TextLine, a long value can share a key with a different one
+        return gfc_config_def_search(res,parameter,name);
+    }
+    return item;
+}
+
 SJson *gfc_config_def_get_by_index(const char *resource,Uint8 index)
 {
-    SJson *list;
+    ConfigResource *res;
     if (!config_manager.defs)
     {
         slog("config def file not loaded");
         return NULL;
     }
     if (!resource)return NULL;
-    list = gfc_config_def_get_resource_by_name(resource);
-    if (!list)return NULL;
-    return sj_array_get_nth(list,index);
+    res = gfc_config_def_get_resource(resource);
+    if ((!res)||(!res->file))return NULL;
+    return gfc_config_resource_nth(res,index);
 }
 
 SJson *gfc_config_def_get_value(const char *resource, const char *name, const char *key)
@@ -87,7 +525,7 @@ SJson *gfc_config_def_get_value(const char *resource, const char *name, const ch
 
 const char *gfc_config_def_get_name_by_index(const char *resource,Uint8 index)
 {
-    SJson *list;
+    ConfigResource *res;
     SJson *def;
     if (!config_manager.defs)
     {
@@ -95,9 +533,11 @@ const char *gfc_config_def_get_name_by_index(const char *resource,Uint8 index)
         return NULL;
     }
     if (!resource)return NULL;
-    list = gfc_config_def_get_resource_by_name(resource);
-    if (!list)return NULL;
-    def = sj_array_get_nth(list,index);
+    res = gfc_config_def_get_resource(resource);
+    if ((!res)||(!res->file))return NULL;
+    //a blob has every name in its string table, so the def does not have to be parsed
+    if (!res->list)return gfc_config_blob_get_def_name(res->file->source.blob,res->blobResource,index);
+    def = sj_array_get_nth(res->list,index);
     if (!def)return NULL;
     return sj_object_get_value_as_string(def,"name");
 }
@@ -105,55 +545,55 @@ const char *gfc_config_def_get_name_by_index(const char *resource,Uint8 index)
 
 Uint32 gfc_config_def_get_resource_count(const char *resource)
 {
-    SJson *list;
+    ConfigResource *res;
     if (!config_manager.defs)return 0;
-    list = gfc_config_def_get_resource_by_name(resource);
-    if (!list)return 0;
-    return sj_array_get_count(list);
+    res = gfc_config_def_get_resource(resource);
+    if (!res)return 0;
+    return gfc_config_resource_count(res);
 }
 
 SJson *gfc_config_def_get_by_parameter(const char *resource,const char *parameter,const char *name)
 {
-    const char *str;
-    int i,c;
-    SJson *item,*list;
-    if (!config_manager.defs)return NULL;
-    list = gfc_config_def_get_resource_by_name(resource);
-    if (!list)return NULL;
-    c = sj_array_get_count(list);
-    for (i = 0; i < c;i++)
+    ConfigResource *res;
+    HashMap *index;
+    SJson *item;
+    if ((!parameter)||(!name))return NULL;
+    if (strcmp(parameter,"name")==0)return gfc_config_def_get_by_name(resource,name);
+    res = gfc_config_def_get_resource(resource);
+    if ((!res)||(!res->file))return NULL;
+    if (!res->byParameter)
     {
-        item = sj_array_get_nth(list,i);
-        if (!item)continue;
-        str = sj_object_get_value_as_string(item,parameter);
-        if (!str)continue;
-        if (strlen(str) != strlen(name))continue;
-        if (strcmp(name,str)==0)return item;
+        res->byParameter = gfc_hashmap_new();
+        if (!res->byParameter)return NULL;
     }
-    slog("no resource of %s found by parameter of %s and name of %s",resource,parameter,name);
-    return NULL;
+    index = gfc_hashmap_get(res->byParameter,parameter);
+    if (!index)
+    {
+        index = gfc_config_resource_index(res,parameter);
+        if (!index)return NULL;
+        gfc_hashmap_insert(res->byParameter,parameter,index);
+    }
+    item = gfc_config_def_find(res,index,parameter,name);
+    if (!item)slog("no resource of %s found by parameter of %s and name of %s",resource,parameter,name);
+    return item;
 }
 
 SJson *gfc_config_def_get_by_name(const char *resource,const char *name)
 {
-    const char *str;
-    int i,c;
-    SJson *item,*list;
-    if (!config_manager.defs)return NULL;
-    list = gfc_config_def_get_resource_by_name(resource);
-    if (!list)return NULL;
-    c = sj_array_get_count(list);
-    for (i = 0; i < c;i++)
+    ConfigResource *res;
+    SJson *item;
+    int n;
+    if (!name)return NULL;
+    res = gfc_config_def_get_resource(resource);
+    if ((!res)||(!res->file))return NULL;
+    if (res->list)item = gfc_config_def_find(res,res->byName,"name",name);
+    else
     {
-        item = sj_array_get_nth(list,i);
-        if (!item)continue;
-        str = sj_object_get_value_as_string(item,"name");
-        if (!str)continue;
-        if (strlen(str) != strlen(name))continue;
-        if (strcmp(name,str)==0)return item;
+        n = gfc_config_blob_find_def(res->file->source.blob,res->blobResource,name);
+        item = (n >= 0)?gfc_config_resource_nth(res,n):NULL;
     }
-    slog("no resource of %s found by name of %s",resource,name);
-    return NULL;
+    if (!item)slog("no resource of %s found by name of %s",resource,name);
+    return item;
 }
 
 /*eol@eof*/
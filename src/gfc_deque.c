@@ -0,0 +1,148 @@
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_deque.h"
+
+gfcDeque *gfc_deque_new()
+{
+    return gfc_deque_new_size(16);
+}
+
+gfcDeque *gfc_deque_new_size(Uint32 count)
+{
+    gfcDeque *deque;
+    Uint32 size = 8;
+    while ((size < count)&&(size < 0x80000000))size <<= 1;
+    deque = gfc_allocate_array(sizeof(gfcDeque),1);
+    if (!deque)
+    {
+        slog("failed to allocate space for the deque");
+        return NULL;
+    }
+    deque->elements = gfc_allocate_array(sizeof(void *),size);
+    if (!deque->elements)
+    {
+        slog("failed to allocate space for deque elements");
+        free(deque);
+        return NULL;
+    }
+    deque->size = size;
+    return deque;
+}
+
+void gfc_deque_delete(gfcDeque *deque)
+{
+    if (!deque)return;
+    if (deque->elements)free(deque->elements);
+    free(deque);
+}
+
+static int gfc_deque_grow(gfcDeque *deque)
+{
+    void **elements;
+    Uint32 tail;
+    if (deque->size >= 0x80000000)
+    {
+        slog("deque cannot grow any further");
+        return -1;
+    }
+    elements = realloc(deque->elements,sizeof(void *)*deque->size * 2);
+    if (!elements)
+    {
+        slog("failed to allocate space for deque elements");
+        return -1;
+    }
+    //the part that wrapped around to the start now goes after the old end
+    tail = deque->head + deque->count;
+    if (tail > deque->size)
+    {
+        memcpy(&elements[deque->size],elements,sizeof(void *)*(tail - deque->size));
+    }
+    deque->elements = elements;
+    deque->size *= 2;
+    return 0;
+}
+
+int gfc_deque_push_front(gfcDeque *deque,void *data)
+{
+    if (!deque)return -1;
+    if ((deque->count >= deque->size)&&(gfc_deque_grow(deque) != 0))return -1;
+    deque->head = (deque->head + deque->size - 1) & (deque->size - 1);
+    deque->elements[deque->head] = data;
+    deque->count++;
+    return 0;
+}
+
+int gfc_deque_push_back(gfcDeque *deque,void *data)
+{
+    if (!deque)return -1;
+    if ((deque->count >= deque->size)&&(gfc_deque_grow(deque) != 0))return -1;
+    deque->elements[(deque->head + deque->count) & (deque->size - 1)] = data;
+    deque->count++;
+    return 0;
+}
+
+void *gfc_deque_pop_front(gfcDeque *deque)
+{
+    void *data;
+    if ((!deque)||(!deque->count))return NULL;
+    data = deque->elements[deque->head];
+    deque->elements[deque->head] = NULL;
+    deque->head = (deque->head + 1) & (deque->size - 1);
+    deque->count--;
+    return data;
+}
+
+void *gfc_deque_pop_back(gfcDeque *deque)
+{
+    void *data;
+    Uint32 index;
+    if ((!deque)||(!deque->count))return NULL;
+    deque->count--;
+    index = (deque->head + deque->count) & (deque->size - 1);
+    data = deque->elements[index];
+    deque->elements[index] = NULL;
+    return data;
+}
+
+void *gfc_deque_get_nth(gfcDeque *deque,Uint32 n)
+{
+    if ((!deque)||(n >= deque->count))return NULL;
+    return deque->elements[(deque->head + n) & (deque->size - 1)];
+}
+
+int gfc_deque_delete_data(gfcDeque *deque,void *data)
+{
+    Uint32 i,mask;
+    if (!deque)return -1;
+    mask = deque->size - 1;
+    for (i = 0; i < deque->count; i++)
+    {
+        if (deque->elements[(deque->head + i) & mask] != data)continue;
+        //close the gap from the back
+        for (; i + 1 < deque->count; i++)
+        {
+            deque->elements[(deque->head + i) & mask] = deque->elements[(deque->head + i + 1) & mask];
+        }
+        deque->count--;
+        deque->elements[(deque->head + deque->count) & mask] = NULL;
+        return 0;
+    }
+    return -1;
+}
+
+Uint32 gfc_deque_get_count(gfcDeque *deque)
+{
+    if (!deque)return 0;
+    return deque->count;
+}
+
+void gfc_deque_clear(gfcDeque *deque)
+{
+    if (!deque)return;
+    memset(deque->elements,0,sizeof(void *)*deque->size);
+    deque->head = 0;
+    deque->count = 0;
+}
+
+/*eol@eof*/
@@ -0,0 +1,184 @@
+#include <math.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_simd.h"
+#include "gfc_frustum.h"
+
+static const Uint8 gfc_frustum_lane_count[16] = {0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4};
+
+static Plane3D gfc_frustum_plane(Matrix4 m,int column,float sign)
+{
+    Plane3D p;
+    float length;
+    //with points as row vectors clip = v * m, so each clip coordinate is a column of m.  Gribb & Hartmann
+    p.x = m[0][3] + sign * m[0][column];
+    p.y = m[1][3] + sign * m[1][column];
+    p.z = m[2][3] + sign * m[2][column];
+    p.d = m[3][3] + sign * m[3][column];
+    length = sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+    if (length == 0)return p;
+    p.x /= length;
+    p.y /= length;
+    p.z /= length;
+    p.d /= length;
+    return p;
+}
+
+gfcFrustum gfc_frustum_from_matrix(Matrix4 viewproj)
+{
+    gfcFrustum f;
+    f.planes[FP_LEFT] = gfc_frustum_plane(viewproj,0,1);
+    f.planes[FP_RIGHT] = gfc_frustum_plane(viewproj,0,-1);
+    f.planes[FP_BOTTOM] = gfc_frustum_plane(viewproj,1,1);
+    f.planes[FP_TOP] = gfc_frustum_plane(viewproj,1,-1);
+    f.planes[FP_NEAR] = gfc_frustum_plane(viewproj,2,1);
+    f.planes[FP_FAR] = gfc_frustum_plane(viewproj,2,-1);
+    return f;
+}
+
+Uint8 gfc_frustum_test_point(gfcFrustum *f,Vector3D p)
+{
+    Plane3D *pl;
+    int i;
+    if (!f)return 0;
+    for (i = 0; i < FP_MAX; i++)
+    {
+        pl = &f->planes[i];
+        if (pl->x * p.x + pl->y * p.y + pl->z * p.z + pl->d < 0)return 0;
+    }
+    return 1;
+}
+
+Uint8 gfc_frustum_test_sphere(gfcFrustum *f,Sphere s)
+{
+    Plane3D *pl;
+    int i;
+    if (!f)return 0;
+    for (i = 0; i < FP_MAX; i++)
+    {
+        pl = &f->planes[i];
+        if (pl->x * s.x + pl->y * s.y + pl->z * s.z + pl->d < -s.r)return 0;
+    }
+    return 1;
+}
+
+Uint8 gfc_frustum_test_box(gfcFrustum *f,Box b)
+{
+    Plane3D *pl;
+    int i;
+    if (!f)return 0;
+    for (i = 0; i < FP_MAX; i++)
+    {
+        pl = &f->planes[i];
+        //test the corner furthest along the plane normal, if it is behind the whole box is
+        if (pl->x * b.x + pl->y * b.y + pl->z * b.z + pl->d +
+            MAX(pl->x,0) * b.w + MAX(pl->y,0) * b.h + MAX(pl->z,0) * b.d < 0)return 0;
+    }
+    return 1;
+}
+
+Uint32 gfc_frustum_cull_spheres(gfcFrustum *f,Sphere *spheres,Uint32 count,Uint32 *visible)
+{
+    Uint32 i = 0,hits = 0;
+#ifdef GFC_SIMD
+    gfc_f4 nx[FP_MAX],ny[FP_MAX],nz[FP_MAX],nd[FP_MAX];
+    gfc_f4 x,y,z,r,nr,dist,zero;
+    gfc_m4 in;
+    Uint32 bits;
+    int p;
+#endif
+    if ((!f)||(!spheres))return 0;
+    if (visible)memset(visible,0,sizeof(Uint32) * gfc_frustum_mask_words(count));
+#ifdef GFC_SIMD
+    for (p = 0; p < FP_MAX; p++)
+    {
+        nx[p] = gfc_f4_set1(f->planes[p].x);
+        ny[p] = gfc_f4_set1(f->planes[p].y);
+        nz[p] = gfc_f4_set1(f->planes[p].z);
+        nd[p] = gfc_f4_set1(f->planes[p].d);
+    }
+    zero = gfc_f4_set1(0);
+    for (; i + 4 <= count; i += 4)
+    {
+        //Sphere is four floats, so four of them transpose straight into x,y,z,r
+        gfc_f4_load_transpose(&spheres[i].x,&x,&y,&z,&r);
+        nr = gfc_f4_sub(zero,r);
+        in = gfc_f4_le(nr,gfc_f4_add(gfc_f4_add(gfc_f4_add(gfc_f4_mul(nx[0],x),gfc_f4_mul(ny[0],y)),gfc_f4_mul(nz[0],z)),nd[0]));
+        for (p = 1; p < FP_MAX; p++)
+        {
+            dist = gfc_f4_add(gfc_f4_add(gfc_f4_add(gfc_f4_mul(nx[p],x),gfc_f4_mul(ny[p],y)),gfc_f4_mul(nz[p],z)),nd[p]);
+            in = gfc_m4_and(in,gfc_f4_le(nr,dist));
+        }
+        bits = gfc_m4_bits(in);
+        hits += gfc_frustum_lane_count[bits];
+        if (visible)visible[i >> 5] |= bits << (i & 31);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        if (!gfc_frustum_test_sphere(f,spheres[i]))continue;
+        hits++;
+        if (visible)visible[i >> 5] |= 1u << (i & 31);
+    }
+    return hits;
+}
+
+Uint32 gfc_frustum_cull_boxes(gfcFrustum *f,Box *boxes,Uint32 count,Uint32 *visible)
+{
+    Uint32 i = 0,hits = 0;
+#ifdef GFC_SIMD
+    gfc_f4 nx[FP_MAX],ny[FP_MAX],nz[FP_MAX],nd[FP_MAX],px[FP_MAX],py[FP_MAX],pz[FP_MAX];
+    gfc_f4 x,y,z,w,h,d,dist,zero;
+    gfc_m4 in;
+    Box *b;
+    Uint32 bits;
+    int p;
+#endif
+    if ((!f)||(!boxes))return 0;
+    if (visible)memset(visible,0,sizeof(Uint32) * gfc_frustum_mask_words(count));
+#ifdef GFC_SIMD
+    for (p = 0; p < FP_MAX; p++)
+    {
+        nx[p] = gfc_f4_set1(f->planes[p].x);
+        ny[p] = gfc_f4_set1(f->planes[p].y);
+        nz[p] = gfc_f4_set1(f->planes[p].z);
+        nd[p] = gfc_f4_set1(f->planes[p].d);
+        //the positive parts of the normal pick out the corner of the box furthest along it
+        px[p] = gfc_f4_set1(MAX(f->planes[p].x,0));
+        py[p] = gfc_f4_set1(MAX(f->planes[p].y,0));
+        pz[p] = gfc_f4_set1(MAX(f->planes[p].z,0));
+    }
+    zero = gfc_f4_set1(0);
+    for (; i + 4 <= count; i += 4)
+    {
+        b = &boxes[i];
+        x = gfc_f4_set(b[0].x,b[1].x,b[2].x,b[3].x);
+        y = gfc_f4_set(b[0].y,b[1].y,b[2].y,b[3].y);
+        z = gfc_f4_set(b[0].z,b[1].z,b[2].z,b[3].z);
+        w = gfc_f4_set(b[0].w,b[1].w,b[2].w,b[3].w);
+        h = gfc_f4_set(b[0].h,b[1].h,b[2].h,b[3].h);
+        d = gfc_f4_set(b[0].d,b[1].d,b[2].d,b[3].d);
+        in = gfc_f4_le(zero,zero);
+        for (p = 0; p < FP_MAX; p++)
+        {
+            dist = gfc_f4_add(gfc_f4_add(gfc_f4_add(gfc_f4_mul(nx[p],x),gfc_f4_mul(ny[p],y)),gfc_f4_mul(nz[p],z)),nd[p]);
+            dist = gfc_f4_add(gfc_f4_add(gfc_f4_add(dist,gfc_f4_mul(px[p],w)),gfc_f4_mul(py[p],h)),gfc_f4_mul(pz[p],d));
+            in = gfc_m4_and(in,gfc_f4_le(zero,dist));
+        }
+        bits = gfc_m4_bits(in);
+        hits += gfc_frustum_lane_count[bits];
+        if (visible)visible[i >> 5] |= bits << (i & 31);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        if (!gfc_frustum_test_box(f,boxes[i]))continue;
+        hits++;
+        if (visible)visible[i >> 5] |= 1u << (i & 31);
+    }
+    return hits;
+}
+
+/*eol@eof*/
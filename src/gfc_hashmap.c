@@ -1,220 +1,353 @@
 #include "simple_logger.h"
+#include "gfc_profile.h"
 #include "gfc_hashmap.h"
 
+#define GFC_HASHMAP_MIN_SIZE 8
+#define GFC_HASHMAP_SEED GFC_STRING_HASH_SEED   //the same as gfcString's cached hash, so it can be used as is
+
+typedef struct
+{
+    char *str;
+    Uint32 length;
+    Uint32 hashValue;   /**<hash of str using the default seed*/
+}GFC_InternedString;
+
+typedef struct
+{
+    HashMap *lookup;                /**<string to id*/
+    GFC_InternedString *strings;    /**<id - 1 to string*/
+    Uint32 count;
+    Uint32 size;
+}GFC_StringTable;
+
+static GFC_StringTable gfc_string_table = {0};
+
 Uint32 gfc_hash(HashMap *map,const char *key)
 {
-    Uint32 h;
-    const char *p;
-    if (!map)return 0;
-    h = map->seed;
-    for (p = key;*p != 0;p++)
-    {
-        h = h * 33 + *p;
-    }
-    return h;
+    if ((!map)||(!key))return 0;
+    return gfc_string_hash_cstr(key,map->seed,NULL);
+}
+
+static Uint32 gfc_hashmap_hash_string(HashMap *map,const gfcString *key)
+{
+    if ((key->hash)&&(map->seed == GFC_STRING_HASH_SEED))return key->hash;
+    return gfc_string_hash_seeded(gfc_string_cstr(key),key->length,map->seed);
 }
 
 void gfc_hashmap_set_seed(HashMap *map,Uint32 seed)
 {
     if (!map)return;
+    if (map->count)
+    {
+        slog("cannot change the seed of a hashmap that is in use");
+        return;
+    }
     map->seed = seed;
 }
 
-HashMap *gfc_hashmap_new_size(Uint32 size)
+static Uint32 gfc_hashmap_round_size(Uint32 count)
+{
+    Uint32 size = GFC_HASHMAP_MIN_SIZE;
+    //leave room for the load factor
+    count = count + (count / 3);
+    while ((size < count)&&(size < 0x80000000))size <<= 1;
+    return size;
+}
+
+static Uint32 gfc_hashmap_probe_distance(HashMap *map,Uint32 hashValue,Uint32 slot)
+{
+    return (slot + map->size - (hashValue & (map->size - 1))) & (map->size - 1);
+}
+
+HashMap *gfc_hashmap_new_size(Uint32 count)
+{
+    return gfc_hashmap_new_size_allocator(count,NULL);
+}
+
+HashMap *gfc_hashmap_new_size_allocator(Uint32 count,gfcAllocator *allocator)
 {
     HashMap *map = NULL;
-    map = (HashMap *)gfc_allocate_array(sizeof(HashMap),1);
+    map = (HashMap *)gfc_allocator_alloc(allocator,sizeof(HashMap),1);
     if (!map)return NULL;
-    map->seed = 5381;   //re: Glib did it
-    map->map = gfc_list_new_size(size);
-    map->size = size;
+    map->seed = GFC_HASHMAP_SEED;
+    map->allocator = allocator;
+    map->size = gfc_hashmap_round_size(count);
+    map->elements = gfc_allocator_alloc(allocator,sizeof(HashElement),map->size);
+    if (!map->elements)
+    {
+        gfc_allocator_free(allocator,map);
+        return NULL;
+    }
     return map;
 }
 
 HashMap *gfc_hashmap_new()
 {
-    return gfc_hashmap_new_size(4);
+    return gfc_hashmap_new_size(GFC_HASHMAP_MIN_SIZE/2);
 }
 
 void gfc_hashmap_free(HashMap *map)
 {
-    HashElement *element;
-    int i;
+    Uint32 i;
     if (!map)return;
-    //free all the keys
-    // TODO redo this based on how we are using the list
-    if (map->map)
+    if (map->elements)
     {
-        for (i = 0; i < map->map->size; i++)
+        for (i = 0; (map->longKeys)&&(i < map->size); i++)
         {
-            element = map->map->elements[i].data;
-            if (!element)continue;
-            free(element);
-            map->map->elements[i].data = NULL;
+            if (map->elements[i].key.length < GFC_STRING_LOCAL_SIZE)continue;
+            gfc_string_clear_allocator(&map->elements[i].key,map->allocator);
+            map->longKeys--;
         }
-        gfc_list_delete(map->map);
+        gfc_allocator_free(map->allocator,map->elements);
     }
-    free(map);
+    gfc_allocator_free(map->allocator,map);
 }
 
-void gfc_hashmap_rehash(HashMap *map)
+/**
+ * @brief place an element into the table using robin hood ordering
+ * @note the key must not already be in the table and there must be a free slot
+ */
+static void gfc_hashmap_place(HashMap *map,HashElement *element)
 {
-    int i;
-    HashMap *newmap;
-    HashElement*element;
-    if (!map)return;
-    newmap = gfc_hashmap_new_size(map->size * 2);
-    for (i = 0; i < map->map->size;i++)
+    HashElement incoming,temp;
+    Uint32 i,dist,slotDist;
+    memcpy(&incoming,element,sizeof(HashElement));
+    i = incoming.hashValue & (map->size - 1);
+    dist = 0;
+    for (;;)
     {
-        if (map->map->elements[i].data == NULL)continue;
-        
-        element = map->map->elements[i].data;
-        gfc_hashmap_insert(newmap,element->key,element->data);
-        free(element);
+        if (map->elements[i].hashValue == 0)
+        {
+            memcpy(&map->elements[i],&incoming,sizeof(HashElement));
+            map->count++;
+            return;
+        }
+        slotDist = gfc_hashmap_probe_distance(map,map->elements[i].hashValue,i);
+        if (slotDist < dist)
+        {
+            //take from the rich, the resident is closer to home than we are
+            memcpy(&temp,&map->elements[i],sizeof(HashElement));
+            memcpy(&map->elements[i],&incoming,sizeof(HashElement));
+            memcpy(&incoming,&temp,sizeof(HashElement));
+            dist = slotDist;
+        }
+        i = (i + 1) & (map->size - 1);
+        dist++;
     }
-    gfc_list_delete(map->map);
-    map->map = newmap->map;
-    map->size = newmap->size;
-    map->seed = newmap->seed;
-    newmap->map = NULL;
-    gfc_hashmap_free(newmap);
 }
 
-void gfc_hashmap_insert(HashMap *map,const char *key,void *data)
+void gfc_hashmap_rehash(HashMap *map)
 {
-    Uint32 h,i;
-    HashElement *element = NULL;
-    HashElement *collision;
+    Uint32 i,oldSize;
+    HashElement *oldElements,*newElements;
+    GFC_PROFILE_ZONE("gfc_hashmap_rehash");
     if (!map)return;
-    if (!key)
+    if (map->size >= 0x80000000)
     {
-        slog("cannot insert into hashmap, no key provided");
+        slog("hashmap cannot grow any further");
         return;
     }
-    element = gfc_allocate_array(sizeof(HashElement),1);
-    if (!element)return;
-    h = gfc_hash(map,key);
-    h = h %map->size;
-    i = h;
-    while (map->map->elements[i].data != NULL)
-    {   //collision
-        collision = (HashElement *)map->map->elements[i].data;
-        if (collision->hashValue != h)
-        {
-            //no room to chain, we need to expand and rehash.
-            gfc_hashmap_rehash(map);
-            h = gfc_hash(map,key);
-            h = h %map->size;
-            i = h;
-            if (map->map->elements[i].data == NULL)break;
-        }
-        i++;
-        if (i >= map->map->size)
+    newElements = gfc_allocator_alloc(map->allocator,sizeof(HashElement),map->size * 2);
+    if (!newElements)return;
+    oldElements = map->elements;
+    oldSize = map->size;
+    map->elements = newElements;
+    map->size = oldSize * 2;
+    map->count = 0;
+    for (i = 0; i < oldSize;i++)
+    {
+        if (!oldElements[i].hashValue)continue;
+        gfc_hashmap_place(map,&oldElements[i]);
+    }
+    gfc_allocator_free(map->allocator,oldElements);
+}
+
+static Sint64 gfc_hashmap_find_index(HashMap *map,const char *key,size_t length,Uint32 h)
+{
+    Uint32 i,dist;
+    HashElement *element;
+    i = h & (map->size - 1);
+    for (dist = 0;dist < map->size;dist++)
+    {
+        element = &map->elements[i];
+        GFC_PROFILE_COUNT(GFC_PC_HASHMAP_PROBES,1);
+        if (!element->hashValue)return -1;
+        //robin hood invariant: if the resident is closer to home than we are, we would have been placed here
+        if (gfc_hashmap_probe_distance(map,element->hashValue,i) < dist)return -1;
+        if ((element->hashValue == h)&&(gfc_string_equal_n(&element->key,key,length)))
         {
-            gfc_hashmap_rehash(map);
-            h = gfc_hash(map,key);
-            h = h %map->size;
-            i = h;
-            if (map->map->elements[i].data == NULL)break;
+            return i;
         }
+        i = (i + 1) & (map->size - 1);
     }
-    element->hashValue = h;
-    element->data = data;
-    gfc_line_cpy(element->key,key);
-    map->map->elements[i].data = element;
+    return -1;//not found
 }
 
 Sint64 gfc_hashmap_get_index(HashMap *map,const char *key)
 {
-    Uint32 h,i;
-    HashElement *element;
+    size_t length;
+    Uint32 h;
     if (!map)return -1;
-    if (!map->map)
+    if (!map->elements)
     {
         slog("hashmap missing map of values");
         return -1;
     }
     if (!key)return -1;
-    h = gfc_hash(map,key);
-    h = h %map->size;
-    i = h;
-    element = (HashElement *)map->map->elements[h].data;
-    if (!element)return -1;
-    do
+    h = gfc_string_hash_cstr(key,map->seed,&length);
+    return gfc_hashmap_find_index(map,key,length,h);
+}
+
+static void gfc_hashmap_insert_new(HashMap *map,const char *key,size_t length,Uint32 h,gfcStringId id,void *data)
+{
+    HashElement element = {0};
+    if ((map->count + 1) * 4 > map->size * 3)
     {
-        if ((strcmp(key,element->key)==0)&&(strlen(key) == strlen(element->key)))
+        //keep the load factor under 3/4
+        gfc_hashmap_rehash(map);
+        if (map->count + 1 >= map->size)
         {
-            return i;
+            slog("hashmap is full, cannot insert key %s",key);
+            return;
         }
-        //keys don't match, so look at the next element in the array
-        if ((i +1) >= map->size)return -1;// we seeked too far
-        element = (HashElement *)map->map->elements[++i].data;
     }
-    while ((element)&&(element->hashValue == h));
-    return -1;//not found
+    if (gfc_string_set_allocator(&element.key,key,length,map->allocator) != 0)
+    {
+        slog("failed to copy key %s into hashmap",key);
+        return;
+    }
+    if (element.key.length >= GFC_STRING_LOCAL_SIZE)map->longKeys++;
+    element.hashValue = h;
+    element.keyId = id;
+    element.data = data;
+    gfc_hashmap_place(map,&element);
+}
+
+void gfc_hashmap_insert(HashMap *map,const char *key,void *data)
+{
+    size_t length;
+    Uint32 h;
+    Sint64 index;
+    if ((!map)||(!map->elements))return;
+    if (!key)
+    {
+        slog("cannot insert into hashmap, no key provided");
+        return;
+    }
+    h = gfc_string_hash_cstr(key,map->seed,&length);
+    index = gfc_hashmap_find_index(map,key,length,h);
+    if (index >= 0)
+    {
+        map->elements[index].data = data;
+        return;
+    }
+    gfc_hashmap_insert_new(map,key,length,h,GFC_STRING_ID_NONE,data);
+}
+
+void gfc_hashmap_insert_string(HashMap *map,const gfcString *key,void *data)
+{
+    Uint32 h;
+    Sint64 index;
+    if ((!map)||(!map->elements))return;
+    if (!key)
+    {
+        slog("cannot insert into hashmap, no key provided");
+        return;
+    }
+    h = gfc_hashmap_hash_string(map,key);
+    index = gfc_hashmap_find_index(map,gfc_string_cstr(key),key->length,h);
+    if (index >= 0)
+    {
+        map->elements[index].data = data;
+        return;
+    }
+    gfc_hashmap_insert_new(map,gfc_string_cstr(key),key->length,h,GFC_STRING_ID_NONE,data);
+}
+
+void *gfc_hashmap_get_string(HashMap *map,const gfcString *key)
+{
+    Sint64 index;
+    if ((!map)||(!map->elements)||(!key))return NULL;
+    index = gfc_hashmap_find_index(map,gfc_string_cstr(key),key->length,gfc_hashmap_hash_string(map,key));
+    if (index < 0)return NULL;
+    return map->elements[index].data;
 }
 
 void *gfc_hashmap_get(HashMap *map,const char *key)
 {
-    HashElement *element;
     Sint64 index;
-    if ((!map)||(!map->map)||(!map->map->elements))return NULL;
+    if ((!map)||(!map->elements))return NULL;
     index = gfc_hashmap_get_index(map,key);
     if (index < 0)return NULL;
-    if (index >= map->size)return NULL;
-    element = (HashElement *)map->map->elements[index].data;
-    return element->data;
+    return map->elements[index].data;
+}
+
+Uint32 gfc_hashmap_get_count(HashMap *map)
+{
+    if (!map)return 0;
+    return map->count;
 }
 
 void gfc_hashmap_slog(HashMap *map)
 {
-    int i;
+    Uint32 i;
     HashElement *element;
-    if ((!map) || (!map->map))return;
-    slog("Hashmap:");
-    for (i = 0; i < map->map->size; i++)
+    if ((!map) || (!map->elements))return;
+    slog("Hashmap: %i items in %i slots",map->count,map->size);
+    for (i = 0; i < map->size; i++)
+    {
+        element = &map->elements[i];
+        if (!element->hashValue)continue;
+        slog("Hash key: '%s' hashValue: %u, hashIndex: %i, probe: %i",gfc_string_cstr(&element->key),element->hashValue,i,gfc_hashmap_probe_distance(map,element->hashValue,i));
+    }
+}
+
+static void gfc_hashmap_remove_index(HashMap *map,Uint32 i)
+{
+    Uint32 next;
+    if (map->elements[i].key.length >= GFC_STRING_LOCAL_SIZE)map->longKeys--;
+    gfc_string_clear_allocator(&map->elements[i].key,map->allocator);
+    //backward shift deletion, no tombstones needed
+    for (;;)
     {
-        if (map->map->elements[i].data == NULL)continue;
-        element = (HashElement*)map->map->elements[i].data;
-        slog("Hash key: '%s' hashValue: %i, hashIndex: %i",element->key,element->hashValue,i);
+        next = (i + 1) & (map->size - 1);
+        if (!map->elements[next].hashValue)break;
+        if (gfc_hashmap_probe_distance(map,map->elements[next].hashValue,next) == 0)break;
+        memcpy(&map->elements[i],&map->elements[next],sizeof(HashElement));
+        i = next;
     }
+    memset(&map->elements[i],0,sizeof(HashElement));
+    map->count--;
 }
 
 void gfc_hashmap_delete_by_key(HashMap *map,const char *key)
 {
-    HashElement *element, *target;
     Sint64 index;
-    Uint32 hashValue;
     if (!map)return;
     index = gfc_hashmap_get_index(map,key);
     if (index < 0)return; // not found, nothing to do
-    target = (HashElement *)map->map->elements[index].data;
-    map->map->elements[index].data = NULL;
-    hashValue = target->hashValue;
-    free(target);
-    while ((index + 1) < map->map->size)
-    {
-        element = (HashElement *)map->map->elements[index + 1].data;
-        if (!element)return; // chain has ended;
-        if (element->hashValue != hashValue)return; // done, the chain has ended
-        map->map->elements[index].data = map->map->elements[index + 1].data;
-        map->map->elements[index + 1].data = NULL;
-        index++;
-    }
+    gfc_hashmap_remove_index(map,(Uint32)index);
+}
+
+void gfc_hashmap_delete_by_string(HashMap *map,const gfcString *key)
+{
+    Sint64 index;
+    if ((!map)||(!map->elements)||(!key))return;
+    index = gfc_hashmap_find_index(map,gfc_string_cstr(key),key->length,gfc_hashmap_hash_string(map,key));
+    if (index < 0)return;
+    gfc_hashmap_remove_index(map,(Uint32)index);
 }
 
 gfcList *gfc_hashmap_get_all_values(HashMap *map)
 {
-    int i;
-    HashElement *element;
+    Uint32 i;
     gfcList *valueList = NULL;
-    if ((!map) || (!map->map))return NULL;
-    valueList = gfc_list_new();
-    for (i = 0; i < map->map->size; i++)
+    if ((!map) || (!map->elements))return NULL;
+    valueList = gfc_list_new_size(map->count?map->count:1);
+    for (i = 0; i < map->size; i++)
     {
-        element = (HashElement *)map->map->elements[i].data;
-        if (!element)continue;
-        valueList = gfc_list_append(valueList,element);
+        if (!map->elements[i].hashValue)continue;
+        valueList = gfc_list_append(valueList,map->elements[i].data);
     }
     return valueList;
 }
@@ -225,6 +358,7 @@ void gfc_hashmap_foreach(HashMap *map, gfc_work_func func)
     void *item;
     gfcList *items;
     if ((!map)||(!func))return;
+    //work from a snapshot so func may safely change the map
     items = gfc_hashmap_get_all_values(map);
     if (!items)return;
     c = gfc_list_get_count(items);
@@ -255,5 +389,149 @@ void gfc_hashmap_foreach_context(HashMap *map, gfc_work_func_context func,void *
     gfc_list_delete(items);
 }
 
+void gfc_str_intern_close()
+{
+    Uint32 i;
+    for (i = 0; i < gfc_string_table.count;i++)
+    {
+        free(gfc_string_table.strings[i].str);
+    }
+    if (gfc_string_table.strings)free(gfc_string_table.strings);
+    gfc_hashmap_free(gfc_string_table.lookup);
+    memset(&gfc_string_table,0,sizeof(GFC_StringTable));
+}
+
+static GFC_InternedString *gfc_str_get_interned(gfcStringId id)
+{
+    if ((id == GFC_STRING_ID_NONE)||(id > gfc_string_table.count))return NULL;
+    return &gfc_string_table.strings[id - 1];
+}
+
+gfcStringId gfc_str_find(const char *str)
+{
+    if ((!str)||(!gfc_string_table.lookup))return GFC_STRING_ID_NONE;
+    return (gfcStringId)(size_t)gfc_hashmap_get(gfc_string_table.lookup,str);
+}
+
+gfcStringId gfc_str_intern(const char *str)
+{
+    size_t len;
+    gfcStringId id;
+    GFC_InternedString *strings;
+    if (!str)return GFC_STRING_ID_NONE;
+    if (!gfc_string_table.lookup)
+    {
+        gfc_string_table.lookup = gfc_hashmap_new_size(64);
+        if (!gfc_string_table.lookup)return GFC_STRING_ID_NONE;
+        atexit(gfc_str_intern_close);
+    }
+    id = gfc_str_find(str);
+    if (id != GFC_STRING_ID_NONE)return id;
+    if (gfc_string_table.count >= gfc_string_table.size)
+    {
+        strings = realloc(gfc_string_table.strings,sizeof(GFC_InternedString)*(gfc_string_table.size?gfc_string_table.size * 2:64));
+        if (!strings)
+        {
+            slog("failed to grow the string intern table");
+            return GFC_STRING_ID_NONE;
+        }
+        gfc_string_table.strings = strings;
+        gfc_string_table.size = gfc_string_table.size?gfc_string_table.size * 2:64;
+    }
+    strings = &gfc_string_table.strings[gfc_string_table.count];
+    strings->hashValue = gfc_string_hash_cstr(str,GFC_HASHMAP_SEED,&len);
+    strings->str = gfc_allocate_array(len + 1,1);
+    if (!strings->str)return GFC_STRING_ID_NONE;
+    memcpy(strings->str,str,len);
+    strings->length = (Uint32)len;
+    id = ++gfc_string_table.count;
+    gfc_hashmap_insert(gfc_string_table.lookup,strings->str,(void *)(size_t)id);
+    return id;
+}
+
+const char *gfc_str_from_id(gfcStringId id)
+{
+    GFC_InternedString *interned;
+    interned = gfc_str_get_interned(id);
+    if (!interned)return NULL;
+    return interned->str;
+}
+
+static Sint64 gfc_hashmap_find_index_by_id(HashMap *map,GFC_InternedString *interned,gfcStringId id,Uint32 h)
+{
+    Uint32 i,dist;
+    HashElement *element;
+    i = h & (map->size - 1);
+    for (dist = 0;dist < map->size;dist++)
+    {
+        element = &map->elements[i];
+        GFC_PROFILE_COUNT(GFC_PC_HASHMAP_PROBES,1);
+        if (!element->hashValue)return -1;
+        if (gfc_hashmap_probe_distance(map,element->hashValue,i) < dist)return -1;
+        if (element->hashValue == h)
+        {
+            if (element->keyId == id)return i;
+            if ((element->keyId == GFC_STRING_ID_NONE)&&(gfc_string_equal_n(&element->key,interned->str,interned->length)))
+            {
+                element->keyId = id;//remember for next time
+                return i;
+            }
+        }
+        i = (i + 1) & (map->size - 1);
+    }
+    return -1;
+}
+
+static Uint32 gfc_hashmap_hash_interned(HashMap *map,GFC_InternedString *interned)
+{
+    if (map->seed == GFC_HASHMAP_SEED)return interned->hashValue;
+    return gfc_string_hash_seeded(interned->str,interned->length,map->seed);
+}
+
+void gfc_hashmap_insert_by_id(HashMap *map,gfcStringId id,void *data)
+{
+    Uint32 h;
+    Sint64 index;
+    GFC_InternedString *interned;
+    if ((!map)||(!map->elements))return;
+    interned = gfc_str_get_interned(id);
+    if (!interned)
+    {
+        slog("cannot insert into hashmap, invalid string id %u",id);
+        return;
+    }
+    h = gfc_hashmap_hash_interned(map,interned);
+    index = gfc_hashmap_find_index_by_id(map,interned,id,h);
+    if (index >= 0)
+    {
+        map->elements[index].data = data;
+        return;
+    }
+    gfc_hashmap_insert_new(map,interned->str,interned->length,h,id,data);
+}
+
+void *gfc_hashmap_get_by_id(HashMap *map,gfcStringId id)
+{
+    Sint64 index;
+    GFC_InternedString *interned;
+    if ((!map)||(!map->elements))return NULL;
+    interned = gfc_str_get_interned(id);
+    if (!interned)return NULL;
+    index = gfc_hashmap_find_index_by_id(map,interned,id,gfc_hashmap_hash_interned(map,interned));
+    if (index < 0)return NULL;
+    return map->elements[index].data;
+}
+
+void gfc_hashmap_delete_by_id(HashMap *map,gfcStringId id)
+{
+    Sint64 index;
+    GFC_InternedString *interned;
+    if ((!map)||(!map->elements))return;
+    interned = gfc_str_get_interned(id);
+    if (!interned)return;
+    index = gfc_hashmap_find_index_by_id(map,interned,id,gfc_hashmap_hash_interned(map,interned));
+    if (index < 0)return;
+    gfc_hashmap_remove_index(map,(Uint32)index);
+}
 
 /**/
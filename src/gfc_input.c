@@ -1,12 +1,28 @@
+#include <stdio.h>
 #include <simple_json.h>
 #include "simple_logger.h"
 #include "gfc_list.h"
 #include "gfc_pak.h"
+#include "gfc_profile.h"
+#include "gfc_watch.h"
 #include "gfc_input.h"
 
+typedef struct
+{
+    TextLine filename;
+    Uint32 watchId;                                     /**<set while the file is watched for changes*/
+}InputCommandFile;
+
 typedef struct
 {
     gfcList *input_list;
+    gfcList *command_files;                             /**<InputCommandFile *, the files commands were loaded from*/
+    Uint8 watching;                                     /**<command files are reloaded when they change*/
+    HashMap *input_map;                                 /**<command name to Input*/
+    gfcList *scancode_commands[SDL_NUM_SCANCODES];      /**<for each scancode, the commands that use it*/
+    gfcList *active_commands;                           /**<commands that were not idle after the last update*/
+    gfcList *pending_commands;                          /**<commands to evaluate this update*/
+    Uint32 frame;                                       /**<incremented every update*/
     const Uint8 * input_keys;
     Uint8 * input_old_keys;
     int input_key_count;
@@ -17,13 +33,39 @@ typedef struct
     gfcList *controllers;
     SJson *controller_button_map;
     SJson *controller_axis_map;
+    gfcCallbackQueue *callback_queue;                   /**<if set command callbacks are posted here instead of called*/
+    Uint64 time_base;                                   /**<performance counter at init, event times count from it*/
+    Uint8 events_on;                                    /**<updating from events instead of the device state*/
+    Uint8 event_quit;                                   /**<the window was closed during this update*/
+    Uint32 event_frame;                                 /**<incremented every update while updating from events*/
+    Uint64 event_last_time;                             /**<live events are stamped in order*/
+    Uint8 event_key_state[SDL_NUM_SCANCODES];           /**<what input_keys points to while updating from events*/
+    GFC_InputEventState event_keys[SDL_NUM_SCANCODES];
+    GFC_InputEvent *events;                             /**<the event ring buffer*/
+    Uint32 event_size;                                  /**<a power of two*/
+    Uint64 events_written;
+    FILE *record_file;
+    Uint32 record_frame;                                /**<the event frame of the first recorded update*/
+    GFC_InputEvent *replay;
+    Uint32 replay_count;
+    Uint32 replay_next;                                 /**<the next replay event to apply*/
+    Uint32 replay_frame;                                /**<updates since the replay started*/
 }GFC_InputData;
 
+typedef struct
+{
+    char   magic[4];        /**<"GINP"*/
+    Uint32 version;
+    Uint32 eventSize;       /**<sizeof(GFC_InputEvent) when it was written*/
+    Uint32 reserved;
+}InputRecordHeader;
+
+#define GFC_INPUT_RECORD_VERSION 1
+
 static GFC_InputData gfc_input_data = {0};
 
 
 void gfc_input_close();
-Input *gfc_input_get_by_name(const char *name);
 
 void gfc_controller_update(GFC_InputController *controller)
 {
@@ -46,9 +88,24 @@ void gfc_controller_update(GFC_InputController *controller)
     }
 }
 
+static void gfc_controller_clear_commands(GFC_InputController *controller)
+{
+    Uint32 i;
+    if ((!controller)||(!controller->button_commands))return;
+    for (i = 0; i < controller->num_buttons;i++)
+    {
+        if (!controller->button_commands[i])continue;
+        gfc_list_delete(controller->button_commands[i]);// just references
+        controller->button_commands[i] = NULL;
+    }
+}
+
 void gfc_controller_free(GFC_InputController *controller)
 {
     if (!controller)return;
+    gfc_controller_clear_commands(controller);
+    if (controller->button_commands)free(controller->button_commands);
+    if (controller->button_events)free(controller->button_events);
     if (controller->buttons)free(controller->buttons);
     if (controller->old_buttons)free(controller->old_buttons);
     if (controller->axis)free(controller->axis);
@@ -99,7 +156,9 @@ void gfc_input_init(char *configFile)
         return;
     }
     gfc_input_data.input_list = gfc_list_new();
+    gfc_input_data.input_map = gfc_hashmap_new();
     gfc_input_data.controllers = gfc_list_new();
+    gfc_input_data.time_base = SDL_GetPerformanceCounter();
 
     gfc_input_data.input_keys = SDL_GetKeyboardState(&gfc_input_data.input_key_count);
     if (!gfc_input_data.input_key_count)
@@ -126,6 +185,8 @@ void gfc_input_init(char *configFile)
             {
                 controller->buttons = gfc_allocate_array(sizeof(Uint8),controller->num_buttons);
                 controller->old_buttons = gfc_allocate_array(sizeof(Uint8),controller->num_buttons);
+                controller->button_commands = gfc_allocate_array(sizeof(gfcList *),controller->num_buttons);
+                controller->button_events = gfc_allocate_array(sizeof(GFC_InputEventState),controller->num_buttons);
             }
             controller->num_axis = SDL_JoystickNumAxes(joystick);
             if (controller->num_axis)
@@ -143,6 +204,16 @@ void gfc_input_init(char *configFile)
     gfc_input_commands_load(configFile);
 }
 
+Uint64 gfc_input_get_time()
+{
+    Uint64 frequency,delta;
+    frequency = SDL_GetPerformanceFrequency();
+    delta = SDL_GetPerformanceCounter() - gfc_input_data.time_base;
+    if (!frequency)return 0;
+    //split so the multiply can not overflow
+    return (delta / frequency) * 1000000000 + ((delta % frequency) * 1000000000) / frequency;
+}
+
 int gfc_input_controller_get_button_index(const char *button)
 {
     int i,c;
@@ -276,6 +347,7 @@ void gfc_input_delete(Input *in)
     gfc_list_delete(in->keyCodes);// data in the list is just integers
     gfc_list_delete(in->buttons);// data in the list is just integers
     gfc_list_delete(in->axes);// data in the list is just integers
+    gfc_string_clear(&in->command);
     free(in);
 }
 
@@ -327,13 +399,43 @@ void gfc_input_close()
         gfc_controller_free(controller);
     }
     gfc_list_delete(gfc_input_data.controllers);
+    gfc_input_record_stop();
+    if (gfc_input_data.events)free(gfc_input_data.events);
+    if (gfc_input_data.replay)free(gfc_input_data.replay);
     memset(&gfc_input_data,0,sizeof(GFC_InputData));
 }
 
+static void gfc_input_command_file_free(InputCommandFile *file)
+{
+    if (!file)return;
+    gfc_watch_remove(file->watchId);
+    free(file);
+}
+
 void gfc_input_commands_purge()
 {
     Uint32 c,i;
     void *data;
+    gfc_list_foreach(gfc_input_data.command_files,(gfc_work_func*)gfc_input_command_file_free);
+    gfc_list_delete(gfc_input_data.command_files);
+    gfc_input_data.command_files = NULL;
+    for (i = 0;i < SDL_NUM_SCANCODES;i++)
+    {
+        if (!gfc_input_data.scancode_commands[i])continue;
+        gfc_list_delete(gfc_input_data.scancode_commands[i]);// just references
+        gfc_input_data.scancode_commands[i] = NULL;
+    }
+    c = gfc_list_get_count(gfc_input_data.controllers);
+    for (i = 0; i < c; i++)
+    {
+        gfc_controller_clear_commands(gfc_list_get_nth(gfc_input_data.controllers,i));
+    }
+    gfc_hashmap_free(gfc_input_data.input_map);
+    gfc_input_data.input_map = NULL;
+    gfc_list_delete(gfc_input_data.active_commands);
+    gfc_input_data.active_commands = NULL;
+    gfc_list_delete(gfc_input_data.pending_commands);
+    gfc_input_data.pending_commands = NULL;
     if (!gfc_input_data.input_list)return;
     c = gfc_list_get_count(gfc_input_data.input_list);
     for (i = 0;i < c;i++)
@@ -343,6 +445,107 @@ void gfc_input_commands_purge()
         gfc_input_delete((Input*)data);
     }
     gfc_list_delete(gfc_input_data.input_list);
+    gfc_input_data.input_list = NULL;
+}
+
+static void gfc_input_fire(void (*callback)(void *data),void *data)
+{
+    if (!callback)return;
+    if ((gfc_input_data.callback_queue)&&(gfc_callback_queue_post(gfc_input_data.callback_queue,callback,data) == 0))return;
+    callback(data);
+}
+
+void gfc_input_set_callback_queue(gfcCallbackQueue *queue)
+{
+    gfc_input_data.callback_queue = queue;
+}
+
+/**
+ * @brief keep the time of a key if it is down and changed later than the time so far
+ */
+static void gfc_input_key_event_time(Uint32 kc,Uint64 *time,Uint32 *ticks)
+{
+    GFC_InputEventState *state;
+    if ((kc >= SDL_NUM_SCANCODES)||(!gfc_input_data.event_key_state[kc]))return;
+    state = &gfc_input_data.event_keys[kc];
+    if (state->time < *time)return;
+    *time = state->time;
+    *ticks = state->ticks;
+}
+
+/**
+ * @brief set when a command was pressed, from the event of the last of its keys to go down if there are events
+ */
+static void gfc_input_command_press_time(Input *command)
+{
+    Uint64 time = 0;
+    Uint32 ticks = 0;
+    Uint32 c,i,kc;
+    if (!gfc_input_data.events_on)
+    {
+        command->pressTime = SDL_GetTicks();
+        command->pressTimestamp = gfc_input_get_time();
+        return;
+    }
+    c = gfc_list_get_count(command->keyCodes);
+    for (i = 0; i < c; i++)
+    {
+#pragma GCC diagnostic ignored "-Wpointer-to-int-cast"
+        kc = (Uint32)gfc_list_get_nth(command->keyCodes,i);
+        switch (kc)
+        {
+            case EMK_Shift:
+                gfc_input_key_event_time(SDL_SCANCODE_LSHIFT,&time,&ticks);
+                gfc_input_key_event_time(SDL_SCANCODE_RSHIFT,&time,&ticks);
+                break;
+            case EMK_Alt:
+                gfc_input_key_event_time(SDL_SCANCODE_LALT,&time,&ticks);
+                gfc_input_key_event_time(SDL_SCANCODE_RALT,&time,&ticks);
+                break;
+            case EMK_Ctrl:
+                gfc_input_key_event_time(SDL_SCANCODE_LCTRL,&time,&ticks);
+                gfc_input_key_event_time(SDL_SCANCODE_RCTRL,&time,&ticks);
+                break;
+            case EMK_Super:
+                gfc_input_key_event_time(SDL_SCANCODE_LGUI,&time,&ticks);
+                gfc_input_key_event_time(SDL_SCANCODE_RGUI,&time,&ticks);
+                break;
+            default:
+                gfc_input_key_event_time(kc,&time,&ticks);
+        }
+    }
+    command->pressTime = ticks;
+    command->pressTimestamp = time;
+}
+
+/**
+ * @brief gfc_input_command_press_time() for a command pressed on a controller
+ */
+static void gfc_input_controller_press_time(Input *command,GFC_InputController *controller)
+{
+    GFC_InputEventState *state;
+    Uint64 time = 0;
+    Uint32 ticks = 0;
+    Uint32 c,i,index;
+    if ((!gfc_input_data.events_on)||(!controller->button_events))
+    {
+        command->pressTime = SDL_GetTicks();
+        command->pressTimestamp = gfc_input_get_time();
+        return;
+    }
+    c = gfc_list_get_count(command->buttons);
+    for (i = 0; i < c; i++)
+    {
+#pragma GCC diagnostic ignored "-Wpointer-to-int-cast"
+        index = (Uint32)gfc_list_get_nth(command->buttons,i);
+        if (index >= controller->num_buttons)continue;
+        state = &controller->button_events[index];
+        if (state->time < time)continue;
+        time = state->time;
+        ticks = state->ticks;
+    }
+    command->pressTime = ticks;
+    command->pressTimestamp = time;
 }
 
 void gfc_input_update_controller(Input *command)
@@ -374,27 +577,18 @@ void gfc_input_update_controller(Input *command)
     if ((old == c)&&(new == c))
     {
         command->state = IET_Hold;
-        if (command->onHold)
-        {
-            command->onHold(command->data);
-        }
+        gfc_input_fire(command->onHold,command->data);
     }
     else if ((old == c)&&(new != c))
     {
         command->state = IET_Release;
-        if (command->onRelease)
-        {
-            command->onRelease(command->data);
-        }
+        gfc_input_fire(command->onRelease,command->data);
     }
     else if ((old != c)&&(new == c))
     {
         command->state = IET_Press;
-        command->pressTime = SDL_GetTicks();
-        if (command->onPress)
-        {
-            command->onPress(command->data);
-        }
+        gfc_input_controller_press_time(command,controller);
+        gfc_input_fire(command->onPress,command->data);
     }
     else
     {
@@ -466,27 +660,18 @@ void gfc_input_update_command(Input *command)
     if ((old == c)&&(new == c))
     {
         command->state = IET_Hold;
-        if (command->onHold)
-        {
-            command->onHold(command->data);
-        }
+        gfc_input_fire(command->onHold,command->data);
     }
     else if ((old == c)&&(new != c))
     {
         command->state = IET_Release;
-        if (command->onRelease)
-        {
-            command->onRelease(command->data);
-        }
+        gfc_input_fire(command->onRelease,command->data);
     }
     else if ((old != c)&&(new == c))
     {
         command->state = IET_Press;
-        command->pressTime = SDL_GetTicks();
-        if (command->onPress)
-        {
-            command->onPress(command->data);
-        }
+        gfc_input_command_press_time(command);
+        gfc_input_fire(command->onPress,command->data);
     }
     else
     {
@@ -497,54 +682,38 @@ void gfc_input_update_command(Input *command)
 
 Input *gfc_input_get_by_name(const char *name)
 {
-    Uint32 c,i;
-    Input *in;
     if (!name)
     {
         return NULL;
     }
-    c = gfc_list_get_count(gfc_input_data.input_list);
-    for (i = 0;i < c;i++)
-    {
-        in = (Input *)gfc_list_get_nth(gfc_input_data.input_list,i);
-        if (!in)continue;
-        if (gfc_line_cmp(in->command,name)==0)
-        {
-            return in;
-        }
-    }
-    return 0;
+    return (Input *)gfc_hashmap_get(gfc_input_data.input_map,name);
 }
 
-Uint8 gfc_input_command_pressed(const char *command)
+Input *gfc_input_get_by_id(gfcStringId commandId)
 {
-    Input *in;
-    in = gfc_input_get_by_name(command);
-    if (!in)return 0;
-    if (in->state == IET_Press)return 1;
+    return (Input *)gfc_hashmap_get_by_id(gfc_input_data.input_map,commandId);
+}
+
+static Uint8 gfc_input_pressed(Input *in)
+{
+    if ((in)&&(in->state == IET_Press))return 1;
     return 0;
 }
 
-Uint8 gfc_input_command_held(const char *command)
+static Uint8 gfc_input_held(Input *in)
 {
-    Input *in;
-    in = gfc_input_get_by_name(command);
     if ((in)&&(in->state == IET_Hold))return 1;
     return 0;
 }
 
-Uint8 gfc_input_command_released(const char *command)
+static Uint8 gfc_input_released(Input *in)
 {
-    Input *in;
-    in = gfc_input_get_by_name(command);
     if ((in)&&(in->state == IET_Release))return 1;
     return 0;
 }
 
-Uint8 gfc_input_command_down(const char *command)
+static Uint8 gfc_input_down(Input *in)
 {
-    Input *in;
-    in = gfc_input_get_by_name(command);
     if (in)
     {
         if((in->state == IET_Press)||(in->state == IET_Hold))return 1;
@@ -552,368 +721,1138 @@ Uint8 gfc_input_command_down(const char *command)
     return 0;
 }
 
-InputEventType gfc_input_command_get_state(const char *command)
+static InputEventType gfc_input_get_state(Input *in)
 {
-    Input *in;
-    in = gfc_input_get_by_name(command);
     if (!in)return 0;
     return in->state;
 }
 
+Uint8 gfc_input_command_pressed(const char *command)
+{
+    return gfc_input_pressed(gfc_input_get_by_name(command));
+}
+
+Uint8 gfc_input_command_held(const char *command)
+{
+    return gfc_input_held(gfc_input_get_by_name(command));
+}
+
+Uint8 gfc_input_command_released(const char *command)
+{
+    return gfc_input_released(gfc_input_get_by_name(command));
+}
+
+Uint8 gfc_input_command_down(const char *command)
+{
+    return gfc_input_down(gfc_input_get_by_name(command));
+}
+
+InputEventType gfc_input_command_get_state(const char *command)
+{
+    return gfc_input_get_state(gfc_input_get_by_name(command));
+}
+
+Uint8 gfc_input_command_pressed_by_id(gfcStringId commandId)
+{
+    return gfc_input_pressed(gfc_input_get_by_id(commandId));
+}
+
+Uint8 gfc_input_command_held_by_id(gfcStringId commandId)
+{
+    return gfc_input_held(gfc_input_get_by_id(commandId));
+}
+
+Uint8 gfc_input_command_released_by_id(gfcStringId commandId)
+{
+    return gfc_input_released(gfc_input_get_by_id(commandId));
+}
+
+Uint8 gfc_input_command_down_by_id(gfcStringId commandId)
+{
+    return gfc_input_down(gfc_input_get_by_id(commandId));
+}
+
+InputEventType gfc_input_command_get_state_by_id(gfcStringId commandId)
+{
+    return gfc_input_get_state(gfc_input_get_by_id(commandId));
+}
+
 gfcList *gfc_input_get_by_scancode(SDL_Scancode keysym)
 {
-    int i,c,kc,ki;
-    Input *in;
-    gfcList *keylist = NULL;
-    keylist = gfc_list_new();
-    
-    c = gfc_list_get_count(gfc_input_data.input_list);
-    for (i = 0;i < c;i++)
+    if ((keysym < 0)||(keysym >= SDL_NUM_SCANCODES))return NULL;
+    return gfc_input_data.scancode_commands[keysym];
+}
+
+/**
+ * @brief queue a command for evaluation this update, once
+ */
+static void gfc_input_queue_command(Input *in)
+{
+    if ((!in)||(in->updateFrame == gfc_input_data.frame))return;
+    in->updateFrame = gfc_input_data.frame;
+    gfc_input_data.pending_commands = gfc_list_append(gfc_input_data.pending_commands,in);
+}
+
+/**
+ * @brief make sure a command whose state was set outside of evaluation gets updated next time
+ */
+static void gfc_input_activate_command(Input *in)
+{
+    if (!in)return;
+    if ((gfc_input_data.active_commands)&&(gfc_list_get_item_index(gfc_input_data.active_commands,in) >= 0))return;
+    gfc_input_data.active_commands = gfc_list_append(gfc_input_data.active_commands,in);
+}
+
+static void gfc_input_queue_list(gfcList *commands)
+{
+    Uint32 c,i;
+    c = gfc_list_get_count(commands);
+    for (i = 0; i < c; i++)
     {
-        in = (Input *)gfc_list_get_nth(gfc_input_data.input_list,i);
-        if (!in)continue;
-        kc = gfc_list_get_count(in->keyCodes);
-        if (!kc)continue;
-        for (ki = 0;ki < kc;ki++)
+        gfc_input_queue_command(gfc_list_get_nth(commands,i));
+    }
+}
+
+/**
+ * @brief queue every command bound to a key that changed since the last update
+ */
+static void gfc_input_queue_changed_keys()
+{
+    Uint64 oldWord,newWord;
+    int i,j,count;
+    const int wordSize = sizeof(Uint64);
+    if ((!gfc_input_data.input_old_keys)||(!gfc_input_data.input_keys))return;
+    count = MIN(gfc_input_data.input_key_count,SDL_NUM_SCANCODES);
+    //compare a word at a time, almost every word matches on a typical frame
+    for (i = 0; i + wordSize <= count; i += wordSize)
+    {
+        memcpy(&oldWord,&gfc_input_data.input_old_keys[i],sizeof(Uint64));
+        memcpy(&newWord,&gfc_input_data.input_keys[i],sizeof(Uint64));
+        if (oldWord == newWord)continue;
+        for (j = i; j < i + wordSize; j++)
         {
-            if ((SDL_Scancode)gfc_list_get_nth(in->keyCodes,ki) == keysym)
-            {
-                keylist = gfc_list_append(keylist,in);
-                break;
-            }
+            if (gfc_input_data.input_old_keys[j] == gfc_input_data.input_keys[j])continue;
+            gfc_input_queue_list(gfc_input_data.scancode_commands[j]);
         }
     }
-    
-    if (gfc_list_get_count(keylist) == 0)
+    for (; i < count; i++)
     {
-        gfc_list_delete(keylist);
-        return NULL;
+        if (gfc_input_data.input_old_keys[i] == gfc_input_data.input_keys[i])continue;
+        gfc_input_queue_list(gfc_input_data.scancode_commands[i]);
     }
-    return keylist;
 }
 
-void gfc_input_update()
+/**
+ * @brief queue every command bound to a controller button that changed since the last update
+ */
+static void gfc_input_queue_changed_buttons()
 {
-    Input *in = NULL;
     GFC_InputController *controller;
-    Uint32 c,i;
-    SDL_Event event = {0};
-    
-    memcpy(gfc_input_data.input_old_keys,gfc_input_data.input_keys,sizeof(Uint8)*gfc_input_data.input_key_count);
-    gfc_input_data.mouse_wheel_x_old = gfc_input_data.mouse_wheel_x;
-    gfc_input_data.mouse_wheel_y_old = gfc_input_data.mouse_wheel_y;
-    gfc_input_data.mouse_wheel_x = 0;
-    gfc_input_data.mouse_wheel_y = 0;
-
-    SDL_PumpEvents();   // update SDL's internal event structures
-    //grab all the input from SDL now
+    Uint32 c,i,b;
     c = gfc_list_get_count(gfc_input_data.controllers);
     for (i = 0; i < c; i++)
     {
         controller = gfc_list_get_nth(gfc_input_data.controllers,i);
-        if (!controller)continue;
-        gfc_controller_update(controller);
+        if ((!controller)||(!controller->button_commands))continue;
+        if (memcmp(controller->old_buttons,controller->buttons,sizeof(Uint8)*controller->num_buttons)==0)continue;
+        for (b = 0; b < controller->num_buttons; b++)
+        {
+            if (controller->old_buttons[b] == controller->buttons[b])continue;
+            gfc_input_queue_list(controller->button_commands[b]);
+        }
     }
+}
 
-    gfc_input_data.input_keys = SDL_GetKeyboardState(&gfc_input_data.input_key_count);
-
-    c = gfc_list_get_count(gfc_input_data.input_list);
+/**
+ * @brief evaluate the commands that could have changed state this update
+ * idle commands whose inputs did not change would stay idle, so they are skipped entirely
+ */
+static void gfc_input_update_commands()
+{
+    Uint32 c,i;
+    Input *in;
+    gfc_input_data.frame++;
+    if (!gfc_input_data.frame)gfc_input_data.frame = 1;//0 is never a queued frame
+    gfc_list_clear(gfc_input_data.pending_commands);
+    //anything that was pressed, held or released needs to move on to its next state
+    gfc_input_queue_list(gfc_input_data.active_commands);
+    gfc_input_queue_changed_keys();
+    gfc_input_queue_changed_buttons();
+    gfc_list_clear(gfc_input_data.active_commands);
+    c = gfc_list_get_count(gfc_input_data.pending_commands);
     for (i = 0;i < c;i++)
     {
-        in = gfc_list_get_nth(gfc_input_data.input_list,i);
+        in = gfc_list_get_nth(gfc_input_data.pending_commands,i);
         if (!in)continue;
         gfc_input_update_command(in);
-    }
-    while(SDL_PollEvent(&event))
-    {
-        if (event.type == SDL_WINDOWEVENT)
-        {
-            if (event.window.event == SDL_WINDOWEVENT_CLOSE)
-            {
-                in = gfc_input_get_by_name("exit");
-                if (in)
-                {
-                    in->state = IET_Press;
-                }
-            }
-        }
-        if (event.type == SDL_MOUSEWHEEL)
+        if (in->state != IET_Idle)
         {
-            if(event.wheel.y > 0) // scroll up
-            {
-                gfc_input_data.mouse_wheel_y = 1;
-            }
-            else if(event.wheel.y < 0) // scroll down
-            {
-                gfc_input_data.mouse_wheel_y = -1;
-            }
-
-            if(event.wheel.x > 0) // scroll right
-            {
-                gfc_input_data.mouse_wheel_x = 1;
-            }
-            else if(event.wheel.x < 0) // scroll left
-            {
-                gfc_input_data.mouse_wheel_x = -1;
-            }
+            gfc_input_data.active_commands = gfc_list_append(gfc_input_data.active_commands,in);
         }
     }
+}
 
+/**
+ * @brief the window was closed, press the exit command if there is one
+ */
+static void gfc_input_exit_pressed()
+{
+    Input *in;
+    in = gfc_input_get_by_name("exit");
+    if (!in)return;
+    in->state = IET_Press;
+    gfc_input_activate_command(in);
 }
 
-InputModKey gfc_input_key_mod_check(const char * buffer)
+//event section
+
+/**
+ * @brief change a key or button from an event
+ * The first change in an update is reported right away.  Any more only change the live state, which is
+ * reported the next update, so a tap between two updates is still pressed for one and released the next.
+ */
+static void gfc_input_event_state_set(GFC_InputEventState *state,Uint8 *reported,const GFC_InputEvent *event)
 {
-    if (!buffer)return EMK_None;
-    if (strcmp(buffer,"SHIFT")==0)return EMK_Shift;
-    if (strcmp(buffer,"ALT")==0)return EMK_Alt;
-    if (strcmp(buffer,"CTRL")==0)return EMK_Ctrl;
-    if (strcmp(buffer,"SUPER")==0)return EMK_Super;
-    return EMK_None;
+    Uint8 down = event->value?1:0;
+    if (state->live == down)return;
+    state->live = down;
+    state->liveTime = event->time;
+    state->liveTicks = event->ticks;
+    if (state->frame == gfc_input_data.event_frame)return;
+    *reported = down;
+    state->frame = gfc_input_data.event_frame;
+    state->time = event->time;
+    state->ticks = event->ticks;
 }
 
-SDL_Scancode gfc_input_key_to_scancode(const char * buffer)
+/**
+ * @brief report the changes held back from the last update
+ */
+static void gfc_input_event_states_begin(GFC_InputEventState *states,Uint8 *reported,Uint32 count)
 {
-    int F = 0;
-    SDL_Scancode kc = -1;
-    if (strlen(buffer) == 1)
+    Uint32 i;
+    for (i = 0; i < count; i++)
     {
-        //single letter code
-        if ((buffer[0] >= 'a')&&(buffer[0] <= 'z'))
-        {
-            kc = SDL_SCANCODE_A + buffer[0] - 'a';
-        }
-        else if (buffer[0] == '0')
-        {
-            kc = SDL_SCANCODE_0;
-        }
-        else if (buffer[0] == '1')
-        {
-            kc = SDL_SCANCODE_1;
-        }
-        else if (buffer[0] == '2')
-        {
-            kc = SDL_SCANCODE_2;
-        }
-        else if (buffer[0] == '3')
+        if (reported[i] == states[i].live)continue;
+        reported[i] = states[i].live;
+        states[i].frame = gfc_input_data.event_frame;
+        states[i].time = states[i].liveTime;
+        states[i].ticks = states[i].liveTicks;
+    }
+}
+
+/**
+ * @brief start the event state over
+ * @param fromDevices if set it starts from what the keyboard and controllers hold now, otherwise from nothing down
+ */
+static int gfc_input_events_reset(Uint8 fromDevices)
+{
+    GFC_InputController *controller;
+    const Uint8 *keys = NULL;
+    Uint8 *oldKeys;
+    int count = 0;
+    Uint32 c,i,b;
+    if ((!gfc_input_data.input_old_keys)||(gfc_input_data.input_key_count < SDL_NUM_SCANCODES))
+    {
+        oldKeys = (Uint8*)realloc(gfc_input_data.input_old_keys,sizeof(Uint8)*SDL_NUM_SCANCODES);
+        if (!oldKeys)
         {
-            kc = SDL_SCANCODE_3;
+            slog("gfc_input: failed to allocate key state for events");
+            return -1;
         }
-        else if (buffer[0] == '4')
+        memset(oldKeys,0,sizeof(Uint8)*SDL_NUM_SCANCODES);
+        gfc_input_data.input_old_keys = oldKeys;
+    }
+    memset(gfc_input_data.event_key_state,0,sizeof(gfc_input_data.event_key_state));
+    memset(gfc_input_data.event_keys,0,sizeof(gfc_input_data.event_keys));
+    if (fromDevices)keys = SDL_GetKeyboardState(&count);
+    if (keys)memcpy(gfc_input_data.event_key_state,keys,sizeof(Uint8)*MIN(count,SDL_NUM_SCANCODES));
+    for (i = 0; i < SDL_NUM_SCANCODES; i++)
+    {
+        gfc_input_data.event_keys[i].live = gfc_input_data.event_key_state[i];
+    }
+    gfc_input_data.input_keys = gfc_input_data.event_key_state;
+    gfc_input_data.input_key_count = SDL_NUM_SCANCODES;
+    c = gfc_list_get_count(gfc_input_data.controllers);
+    for (i = 0; i < c; i++)
+    {
+        controller = gfc_list_get_nth(gfc_input_data.controllers,i);
+        if (!controller)continue;
+        if ((!fromDevices)&&(controller->num_axis))memset(controller->axis,0,sizeof(Sint16)*controller->num_axis);
+        if (!controller->button_events)continue;
+        memset(controller->button_events,0,sizeof(GFC_InputEventState)*controller->num_buttons);
+        if (!fromDevices)memset(controller->buttons,0,sizeof(Uint8)*controller->num_buttons);
+        for (b = 0; b < controller->num_buttons; b++)
         {
-            kc = SDL_SCANCODE_4;
-        }
-        else if (buffer[0] == '5')
-        {
-            kc = SDL_SCANCODE_5;
-        }
-        else if (buffer[0] == '6')
-        {
-            kc = SDL_SCANCODE_6;
-        }
-        else if (buffer[0] == '7')
-        {
-            kc = SDL_SCANCODE_7;
-        }
-        else if (buffer[0] == '8')
-        {
-            kc = SDL_SCANCODE_8;
-        }
-        else if (buffer[0] == '9')
-        {
-            kc = SDL_SCANCODE_9;
-        }
-        else if (buffer[0] == '-')
-        {
-            kc = SDL_SCANCODE_MINUS;
-        }
-        else if (buffer[0] == '=')
-        {
-            kc = SDL_SCANCODE_EQUALS;
-        }
-        else if (buffer[0] == '[')
-        {
-            kc = SDL_SCANCODE_LEFTBRACKET;
-        }
-        else if (buffer[0] == ']')
-        {
-            kc = SDL_SCANCODE_RIGHTBRACKET;
-        }
-        else if (buffer[0] == '.')
-        {
-            kc = SDL_SCANCODE_PERIOD;
-        }
-        else if (buffer[0] == ',')
-        {
-            kc = SDL_SCANCODE_COMMA;
-        }
-        else if (buffer[0] == ';')
-        {
-            kc = SDL_SCANCODE_SEMICOLON;
-        }
-        else if (buffer[0] == '\\')
-        {
-            kc = SDL_SCANCODE_BACKSLASH;
-        }
-        else if (buffer[0] == '/')
-        {
-            kc = SDL_SCANCODE_SLASH;
-        }
-        else if (buffer[0] == '\'')
-        {
-            kc = SDL_SCANCODE_APOSTROPHE;
-        }
-        else if (buffer[0] == ';')
-        {
-            kc = SDL_SCANCODE_SEMICOLON;
-        }
-        else if (buffer[0] == '`')
-        {
-            kc = SDL_SCANCODE_GRAVE;
-        }
-        else if ((buffer[0] >= ' ')&&(buffer[0] <= '`'))
-        {
-            kc = SDL_SCANCODE_SPACE + buffer[0] - ' ';
+            controller->button_events[b].live = controller->buttons[b];
         }
     }
-    else
+    return 0;
+}
+
+/**
+ * @brief switch between updating from events and from the device state when what needs events changes
+ */
+static int gfc_input_events_refresh()
+{
+    if ((gfc_input_data.events)||(gfc_input_data.record_file)||(gfc_input_data.replay))
+    {
+        if (gfc_input_data.events_on)return 0;
+        if (gfc_input_events_reset(gfc_input_data.replay == NULL) != 0)return -1;
+        gfc_input_data.events_on = 1;
+        return 0;
+    }
+    if (!gfc_input_data.events_on)return 0;
+    gfc_input_data.events_on = 0;
+    gfc_input_data.input_keys = SDL_GetKeyboardState(&gfc_input_data.input_key_count);
+    return 0;
+}
+
+static void gfc_input_event_store(const GFC_InputEvent *event)
+{
+    GFC_InputEvent record;
+    if (gfc_input_data.events)
+    {
+        gfc_input_data.events[gfc_input_data.events_written & (gfc_input_data.event_size - 1)] = *event;
+        gfc_input_data.events_written++;
+    }
+    if (!gfc_input_data.record_file)return;
+    record = *event;
+    record.frame = event->frame - gfc_input_data.record_frame;
+    if (fwrite(&record,sizeof(GFC_InputEvent),1,gfc_input_data.record_file) == 1)return;
+    slog("gfc_input: failed to write an event to the recording, recording stopped");
+    fclose(gfc_input_data.record_file);
+    gfc_input_data.record_file = NULL;
+}
+
+static void gfc_input_event_apply(const GFC_InputEvent *event)
+{
+    GFC_InputController *controller;
+    gfc_input_event_store(event);
+    switch (event->kind)
     {
-        if (buffer[0] == 'F')
+        case IEK_Key:
+            if ((event->code < 0)||(event->code >= SDL_NUM_SCANCODES))break;
+            gfc_input_event_state_set(
+                &gfc_input_data.event_keys[event->code],
+                &gfc_input_data.event_key_state[event->code],
+                event);
+            break;
+        case IEK_Button:
+            controller = gfc_list_get_nth(gfc_input_data.controllers,event->controller);
+            if ((!controller)||(!controller->button_events))break;
+            if ((event->code < 0)||((Uint32)event->code >= controller->num_buttons))break;
+            gfc_input_event_state_set(
+                &controller->button_events[event->code],
+                &controller->buttons[event->code],
+                event);
+            break;
+        case IEK_Axis:
+            controller = gfc_list_get_nth(gfc_input_data.controllers,event->controller);
+            if (!controller)break;
+            if ((event->code < 0)||((Uint32)event->code >= controller->num_axis))break;
+            controller->axis[event->code] = (Sint16)event->value;
+            break;
+        case IEK_Wheel:
+            if (event->value > 0)gfc_input_data.mouse_wheel_y = 1;
+            else if (event->value < 0)gfc_input_data.mouse_wheel_y = -1;
+            if (event->code > 0)gfc_input_data.mouse_wheel_x = 1;
+            else if (event->code < 0)gfc_input_data.mouse_wheel_x = -1;
+            break;
+        case IEK_Quit:
+            gfc_input_data.event_quit = 1;
+            break;
+    }
+}
+
+static int gfc_input_controller_by_instance(SDL_JoystickID which)
+{
+    GFC_InputController *controller;
+    Uint32 c,i;
+    c = gfc_list_get_count(gfc_input_data.controllers);
+    for (i = 0; i < c; i++)
+    {
+        controller = gfc_list_get_nth(gfc_input_data.controllers,i);
+        if ((!controller)||(!controller->controller))continue;
+        if (SDL_JoystickInstanceID(controller->controller) == which)return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief make an input event from an SDL event
+ * @return 0 if it is not an event input keeps, 1 otherwise
+ */
+static Uint8 gfc_input_event_from_sdl(const SDL_Event *event,GFC_InputEvent *item)
+{
+    Uint64 now,age;
+    int controller;
+    memset(item,0,sizeof(GFC_InputEvent));
+    switch (event->type)
+    {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            if (event->key.repeat)return 0;
+            item->kind = IEK_Key;
+            item->code = event->key.keysym.scancode;
+            item->value = (event->type == SDL_KEYDOWN);
+            break;
+        case SDL_JOYBUTTONDOWN:
+        case SDL_JOYBUTTONUP:
+            controller = gfc_input_controller_by_instance(event->jbutton.which);
+            if (controller < 0)return 0;
+            item->kind = IEK_Button;
+            item->controller = controller;
+            item->code = event->jbutton.button;
+            item->value = (event->type == SDL_JOYBUTTONDOWN);
+            break;
+        case SDL_JOYAXISMOTION:
+            controller = gfc_input_controller_by_instance(event->jaxis.which);
+            if (controller < 0)return 0;
+            item->kind = IEK_Axis;
+            item->controller = controller;
+            item->code = event->jaxis.axis;
+            item->value = event->jaxis.value;
+            break;
+        case SDL_MOUSEWHEEL:
+            item->kind = IEK_Wheel;
+            item->code = event->wheel.x;
+            item->value = event->wheel.y;
+            break;
+        case SDL_WINDOWEVENT:
+            if (event->window.event != SDL_WINDOWEVENT_CLOSE)return 0;
+            item->kind = IEK_Quit;
+            break;
+        default:
+            return 0;
+    }
+    //SDL stamps events in milliseconds, so place them on the input clock by how long ago that was
+    item->ticks = event->common.timestamp;
+    now = gfc_input_get_time();
+    age = (Uint64)(Uint32)(SDL_GetTicks() - item->ticks) * 1000000;
+    item->time = (age < now)?now - age:0;
+    if (item->time < gfc_input_data.event_last_time)item->time = gfc_input_data.event_last_time;
+    gfc_input_data.event_last_time = item->time;
+    item->frame = gfc_input_data.event_frame;
+    return 1;
+}
+
+static void gfc_input_replay_update()
+{
+    GFC_InputEvent event;
+    while (gfc_input_data.replay_next < gfc_input_data.replay_count)
+    {
+        event = gfc_input_data.replay[gfc_input_data.replay_next];
+        if (event.frame > gfc_input_data.replay_frame)break;
+        gfc_input_data.replay_next++;
+        if (event.kind == IEK_None)continue;
+        event.frame = gfc_input_data.event_frame;
+        gfc_input_event_apply(&event);
+    }
+    gfc_input_data.replay_frame++;
+}
+
+/**
+ * @brief bring the keys and buttons up to date from this update's events
+ */
+static void gfc_input_update_events()
+{
+    GFC_InputController *controller;
+    GFC_InputEvent item;
+    SDL_Event event;
+    Uint32 c,i;
+    gfc_input_data.event_frame++;
+    if (!gfc_input_data.event_frame)gfc_input_data.event_frame = 1;//states start out changed on frame 0
+    gfc_input_data.event_quit = 0;
+    gfc_input_event_states_begin(gfc_input_data.event_keys,gfc_input_data.event_key_state,SDL_NUM_SCANCODES);
+    c = gfc_list_get_count(gfc_input_data.controllers);
+    for (i = 0; i < c; i++)
+    {
+        controller = gfc_list_get_nth(gfc_input_data.controllers,i);
+        if (!controller)continue;
+        //a controller may have axes and no buttons
+        if (controller->num_axis)memcpy(controller->old_axis,controller->axis,sizeof(Sint16)*controller->num_axis);
+        if (!controller->button_events)continue;
+        memcpy(controller->old_buttons,controller->buttons,sizeof(Uint8)*controller->num_buttons);
+        gfc_input_event_states_begin(controller->button_events,controller->buttons,controller->num_buttons);
+    }
+    SDL_PumpEvents();
+    while(SDL_PollEvent(&event))
+    {
+        if (!gfc_input_event_from_sdl(&event,&item))continue;
+        //a replay stands in for the devices, but closing the window still works
+        if ((gfc_input_data.replay)&&(item.kind != IEK_Quit))continue;
+        gfc_input_event_apply(&item);
+    }
+    if (gfc_input_data.replay)gfc_input_replay_update();
+}
+
+int gfc_input_event_buffer_enable(Uint32 count)
+{
+    GFC_InputEvent *events;
+    Uint32 size = 1;
+    if (count)
+    {
+        while (size < count)
         {
-            F = atoi(&buffer[1]);
-            if (F <= 12)
-            {
-                kc = SDL_SCANCODE_F1 + F - 1; 
-            }
-            else if (F <= 24)
+            if (size >= 0x80000000)
             {
-                kc = SDL_SCANCODE_F13 + F - 1; 
+                slog("gfc_input: event buffer of %u events is too large",count);
+                return -1;
             }
+            size <<= 1;
         }
-        else if (strcmp(buffer,"BACKSPACE") == 0)
+        events = gfc_allocate_array(sizeof(GFC_InputEvent),size);
+        if (!events)
         {
-            kc = SDL_SCANCODE_BACKSPACE;
+            slog("gfc_input: failed to allocate an event buffer of %u events",size);
+            return -1;
         }
-        else if (strcmp(buffer,"RIGHT") == 0)
-        {
-            kc = SDL_SCANCODE_RIGHT;
-        }
-        else if (strcmp(buffer,"LEFT") == 0)
-        {
-            kc = SDL_SCANCODE_LEFT;
-        }
-        else if (strcmp(buffer,"UP") == 0)
-        {
-            kc = SDL_SCANCODE_UP;
-        }
-        else if (strcmp(buffer,"DOWN") == 0)
-        {
-            kc = SDL_SCANCODE_DOWN;
-        }
-        else if (strcmp(buffer,"LALT") == 0)
-        {
-            kc = SDL_SCANCODE_LALT;
-        }
-        else if (strcmp(buffer,"RALT") == 0)
-        {
-            kc = SDL_SCANCODE_RALT;
-        }
-        else if (strcmp(buffer,"LSHIFT") == 0)
-        {
-            kc = SDL_SCANCODE_LSHIFT;
-        }
-        else if (strcmp(buffer,"RSHIFT") == 0)
-        {
-            kc = SDL_SCANCODE_RSHIFT;
-        }
-        else if (strcmp(buffer,"LCTRL") == 0)
-        {
-            kc = SDL_SCANCODE_LCTRL;
-        }
-        else if (strcmp(buffer,"RCTRL") == 0)
+    }
+    else
+    {
+        events = NULL;
+        size = 0;
+    }
+    if (gfc_input_data.events)free(gfc_input_data.events);
+    gfc_input_data.events = events;
+    gfc_input_data.event_size = size;
+    gfc_input_data.events_written = 0;
+    return gfc_input_events_refresh();
+}
+
+Uint32 gfc_input_event_get_count()
+{
+    if (!gfc_input_data.events)return 0;
+    if (gfc_input_data.events_written < gfc_input_data.event_size)return (Uint32)gfc_input_data.events_written;
+    return gfc_input_data.event_size;
+}
+
+const GFC_InputEvent *gfc_input_event_get_nth(Uint32 n)
+{
+    Uint32 count;
+    Uint64 first;
+    count = gfc_input_event_get_count();
+    if (n >= count)return NULL;
+    first = gfc_input_data.events_written - count;
+    return &gfc_input_data.events[(first + n) & (gfc_input_data.event_size - 1)];
+}
+
+int gfc_input_record_start(const char *filename)
+{
+    InputRecordHeader header = {0};
+    if (!filename)return -1;
+    gfc_input_record_stop();
+    gfc_input_data.record_file = fopen(filename,"wb");
+    if (!gfc_input_data.record_file)
+    {
+        slog("gfc_input: failed to open %s to record input",filename);
+        return -1;
+    }
+    memcpy(header.magic,"GINP",4);
+    header.version = GFC_INPUT_RECORD_VERSION;
+    header.eventSize = sizeof(GFC_InputEvent);
+    if (fwrite(&header,sizeof(InputRecordHeader),1,gfc_input_data.record_file) != 1)
+    {
+        slog("gfc_input: failed to write to %s",filename);
+        fclose(gfc_input_data.record_file);
+        gfc_input_data.record_file = NULL;
+        return -1;
+    }
+    //the next update is frame 0 of the recording
+    gfc_input_data.record_frame = gfc_input_data.event_frame + 1;
+    if (gfc_input_events_refresh() != 0)
+    {
+        gfc_input_record_stop();
+        return -1;
+    }
+    return 0;
+}
+
+void gfc_input_record_stop()
+{
+    GFC_InputEvent end = {0};
+    if (!gfc_input_data.record_file)return;
+    //so the replay runs as many updates as were recorded, even if the last ones had no events
+    end.kind = IEK_None;
+    end.time = gfc_input_get_time();
+    end.ticks = SDL_GetTicks();
+    if (gfc_input_data.event_frame >= gfc_input_data.record_frame)
+    {
+        end.frame = gfc_input_data.event_frame - gfc_input_data.record_frame;
+    }
+    if (fwrite(&end,sizeof(GFC_InputEvent),1,gfc_input_data.record_file) != 1)
+    {
+        slog("gfc_input: failed to finish the recording");
+    }
+    if (fclose(gfc_input_data.record_file) != 0)
+    {
+        slog("gfc_input: failed to finish the recording");
+    }
+    gfc_input_data.record_file = NULL;
+    gfc_input_events_refresh();
+}
+
+/**
+ * @brief check that a replayed controller event has a connected controller button or axis to drive
+ * @return 0 if it can be applied, -1 if it would be lost
+ */
+static int gfc_input_replay_check_controller(const GFC_InputEvent *event)
+{
+    GFC_InputController *controller;
+    if ((event->kind != IEK_Button)&&(event->kind != IEK_Axis))return 0;
+    controller = gfc_list_get_nth(gfc_input_data.controllers,event->controller);
+    if (!controller)
+    {
+        slog("gfc_input: the replay uses controller %u, which is not connected",event->controller);
+        return -1;
+    }
+    if (event->kind == IEK_Button)
+    {
+        if ((!controller->button_events)||(event->code < 0)||((Uint32)event->code >= controller->num_buttons))
         {
-            kc = SDL_SCANCODE_RCTRL;
+            slog("gfc_input: the replay uses button %i of controller %u, which it does not have",event->code,event->controller);
+            return -1;
         }
-        else if (strcmp(buffer,"TAB") == 0)
+        return 0;
+    }
+    if ((event->code < 0)||((Uint32)event->code >= controller->num_axis))
+    {
+        slog("gfc_input: the replay uses axis %i of controller %u, which it does not have",event->code,event->controller);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief start a replay, taking ownership of events
+ */
+static int gfc_input_replay_take(GFC_InputEvent *events,Uint32 count)
+{
+    Uint32 i;
+    for (i = 0; i < count; i++)
+    {
+        if ((i)&&(events[i].frame < events[i - 1].frame))
         {
-            kc = SDL_SCANCODE_TAB;
+            slog("gfc_input: replay events are out of frame order at event %u",i);
+            free(events);
+            return -1;
         }
-        else if (strcmp(buffer,"RETURN") == 0)
+        //rather than play it back without the controller input it was recorded with
+        if (gfc_input_replay_check_controller(&events[i]) != 0)
         {
-            kc = SDL_SCANCODE_RETURN;
+            free(events);
+            return -1;
         }
-        else if (strcmp(buffer,"DELETE") == 0)
+    }
+    gfc_input_replay_stop();
+    gfc_input_data.replay = events;
+    gfc_input_data.replay_count = count;
+    gfc_input_data.replay_next = 0;
+    gfc_input_data.replay_frame = 0;
+    if (gfc_input_data.events_on)return gfc_input_events_reset(0);
+    return gfc_input_events_refresh();
+}
+
+int gfc_input_replay_events(const GFC_InputEvent *events,Uint32 count)
+{
+    GFC_InputEvent *copy;
+    if ((!events)||(!count))
+    {
+        slog("gfc_input: no events to replay");
+        return -1;
+    }
+    copy = gfc_allocate_array(sizeof(GFC_InputEvent),count);
+    if (!copy)
+    {
+        slog("gfc_input: failed to allocate %u replay events",count);
+        return -1;
+    }
+    memcpy(copy,events,sizeof(GFC_InputEvent)*count);
+    return gfc_input_replay_take(copy,count);
+}
+
+int gfc_input_replay_load(const char *filename)
+{
+    FILE *file;
+    InputRecordHeader header;
+    GFC_InputEvent *events;
+    long size;
+    Uint32 count;
+    if (!filename)return -1;
+    file = fopen(filename,"rb");
+    if (!file)
+    {
+        slog("gfc_input: failed to open input recording %s",filename);
+        return -1;
+    }
+    if ((fread(&header,sizeof(InputRecordHeader),1,file) != 1)||
+        (memcmp(header.magic,"GINP",4) != 0)||
+        (header.version != GFC_INPUT_RECORD_VERSION)||
+        (header.eventSize != sizeof(GFC_InputEvent)))
+    {
+        slog("gfc_input: %s is not an input recording this build can replay",filename);
+        fclose(file);
+        return -1;
+    }
+    fseek(file,0,SEEK_END);
+    size = ftell(file);
+    fseek(file,sizeof(InputRecordHeader),SEEK_SET);
+    if (size < (long)(sizeof(InputRecordHeader) + sizeof(GFC_InputEvent)))
+    {
+        slog("gfc_input: input recording %s is empty",filename);
+        fclose(file);
+        return -1;
+    }
+    count = (Uint32)((size - sizeof(InputRecordHeader)) / sizeof(GFC_InputEvent));
+    events = gfc_allocate_array(sizeof(GFC_InputEvent),count);
+    if (!events)
+    {
+        slog("gfc_input: failed to allocate %u replay events",count);
+        fclose(file);
+        return -1;
+    }
+    if (fread(events,sizeof(GFC_InputEvent),count,file) != count)
+    {
+        slog("gfc_input: failed to read input recording %s",filename);
+        free(events);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    return gfc_input_replay_take(events,count);
+}
+
+Uint8 gfc_input_replay_active()
+{
+    if (!gfc_input_data.replay)return 0;
+    return gfc_input_data.replay_next < gfc_input_data.replay_count;
+}
+
+void gfc_input_replay_stop()
+{
+    if (!gfc_input_data.replay)return;
+    free(gfc_input_data.replay);
+    gfc_input_data.replay = NULL;
+    gfc_input_data.replay_count = 0;
+    gfc_input_data.replay_next = 0;
+    //nothing replayed is left held down if events are still in use
+    if (gfc_input_data.events_on)gfc_input_events_reset(1);
+    gfc_input_events_refresh();
+}
+
+void gfc_input_update()
+{
+    GFC_InputController *controller;
+    Uint32 c,i;
+    SDL_Event event = {0};
+    GFC_PROFILE_ZONE("gfc_input_update");
+
+    
+    memcpy(gfc_input_data.input_old_keys,gfc_input_data.input_keys,sizeof(Uint8)*gfc_input_data.input_key_count);
+    gfc_input_data.mouse_wheel_x_old = gfc_input_data.mouse_wheel_x;
+    gfc_input_data.mouse_wheel_y_old = gfc_input_data.mouse_wheel_y;
+    gfc_input_data.mouse_wheel_x = 0;
+    gfc_input_data.mouse_wheel_y = 0;
+
+    //after the old keys are kept, so a finished replay hands back to the devices with a press or release
+    if ((gfc_input_data.replay)&&(!gfc_input_replay_active()))gfc_input_replay_stop();
+    gfc_input_events_refresh();
+
+    if (gfc_input_data.events_on)
+    {
+        gfc_input_update_events();
+        gfc_input_update_commands();
+        if (gfc_input_data.event_quit)gfc_input_exit_pressed();
+        return;
+    }
+
+    SDL_PumpEvents();   // update SDL's internal event structures
+    //grab all the input from SDL now
+    c = gfc_list_get_count(gfc_input_data.controllers);
+    for (i = 0; i < c; i++)
+    {
+        controller = gfc_list_get_nth(gfc_input_data.controllers,i);
+        if (!controller)continue;
+        gfc_controller_update(controller);
+    }
+
+    gfc_input_data.input_keys = SDL_GetKeyboardState(&gfc_input_data.input_key_count);
+
+    gfc_input_update_commands();
+    while(SDL_PollEvent(&event))
+    {
+        if (event.type == SDL_WINDOWEVENT)
         {
-            kc = SDL_SCANCODE_DELETE;
+            if (event.window.event == SDL_WINDOWEVENT_CLOSE)
+            {
+                gfc_input_exit_pressed();
+            }
         }
-        else if (strcmp(buffer,"ESCAPE") == 0)
+        if (event.type == SDL_MOUSEWHEEL)
         {
-            kc = SDL_SCANCODE_ESCAPE;
+            if(event.wheel.y > 0) // scroll up
+            {
+                gfc_input_data.mouse_wheel_y = 1;
+            }
+            else if(event.wheel.y < 0) // scroll down
+            {
+                gfc_input_data.mouse_wheel_y = -1;
+            }
+
+            if(event.wheel.x > 0) // scroll right
+            {
+                gfc_input_data.mouse_wheel_x = 1;
+            }
+            else if(event.wheel.x < 0) // scroll left
+            {
+                gfc_input_data.mouse_wheel_x = -1;
+            }
         }
     }
-    if (kc == -1)
+
+}
+
+typedef struct
+{
+    const char *name;
+    Sint32      code;   /**<the SDL_Scancode, or the InputModKey for keys that mean either side*/
+}GFC_InputKeyName;
+
+/**
+ * every key name that can be used in an input config, sorted by strcmp() so it can be binary searched
+ * keep it sorted when adding to it
+ */
+static const GFC_InputKeyName gfc_input_key_names[] =
+{
+    {" ",SDL_SCANCODE_SPACE},
+    {"'",SDL_SCANCODE_APOSTROPHE},
+    {",",SDL_SCANCODE_COMMA},
+    {"-",SDL_SCANCODE_MINUS},
+    {".",SDL_SCANCODE_PERIOD},
+    {"/",SDL_SCANCODE_SLASH},
+    {"0",SDL_SCANCODE_0},
+    {"1",SDL_SCANCODE_1},
+    {"2",SDL_SCANCODE_2},
+    {"3",SDL_SCANCODE_3},
+    {"4",SDL_SCANCODE_4},
+    {"5",SDL_SCANCODE_5},
+    {"6",SDL_SCANCODE_6},
+    {"7",SDL_SCANCODE_7},
+    {"8",SDL_SCANCODE_8},
+    {"9",SDL_SCANCODE_9},
+    {";",SDL_SCANCODE_SEMICOLON},
+    {"=",SDL_SCANCODE_EQUALS},
+    {"ALT",EMK_Alt},
+    {"BACKSPACE",SDL_SCANCODE_BACKSPACE},
+    {"CTRL",EMK_Ctrl},
+    {"DELETE",SDL_SCANCODE_DELETE},
+    {"DOWN",SDL_SCANCODE_DOWN},
+    {"ESCAPE",SDL_SCANCODE_ESCAPE},
+    {"F1",SDL_SCANCODE_F1},
+    {"F10",SDL_SCANCODE_F10},
+    {"F11",SDL_SCANCODE_F11},
+    {"F12",SDL_SCANCODE_F12},
+    {"F13",SDL_SCANCODE_F13},
+    {"F14",SDL_SCANCODE_F14},
+    {"F15",SDL_SCANCODE_F15},
+    {"F16",SDL_SCANCODE_F16},
+    {"F17",SDL_SCANCODE_F17},
+    {"F18",SDL_SCANCODE_F18},
+    {"F19",SDL_SCANCODE_F19},
+    {"F2",SDL_SCANCODE_F2},
+    {"F20",SDL_SCANCODE_F20},
+    {"F21",SDL_SCANCODE_F21},
+    {"F22",SDL_SCANCODE_F22},
+    {"F23",SDL_SCANCODE_F23},
+    {"F24",SDL_SCANCODE_F24},
+    {"F3",SDL_SCANCODE_F3},
+    {"F4",SDL_SCANCODE_F4},
+    {"F5",SDL_SCANCODE_F5},
+    {"F6",SDL_SCANCODE_F6},
+    {"F7",SDL_SCANCODE_F7},
+    {"F8",SDL_SCANCODE_F8},
+    {"F9",SDL_SCANCODE_F9},
+    {"LALT",SDL_SCANCODE_LALT},
+    {"LCTRL",SDL_SCANCODE_LCTRL},
+    {"LEFT",SDL_SCANCODE_LEFT},
+    {"LSHIFT",SDL_SCANCODE_LSHIFT},
+    {"RALT",SDL_SCANCODE_RALT},
+    {"RCTRL",SDL_SCANCODE_RCTRL},
+    {"RETURN",SDL_SCANCODE_RETURN},
+    {"RIGHT",SDL_SCANCODE_RIGHT},
+    {"RSHIFT",SDL_SCANCODE_RSHIFT},
+    {"SHIFT",EMK_Shift},
+    {"SUPER",EMK_Super},
+    {"TAB",SDL_SCANCODE_TAB},
+    {"UP",SDL_SCANCODE_UP},
+    {"[",SDL_SCANCODE_LEFTBRACKET},
+    {"\\",SDL_SCANCODE_BACKSLASH},
+    {"]",SDL_SCANCODE_RIGHTBRACKET},
+    {"`",SDL_SCANCODE_GRAVE},
+    {"a",SDL_SCANCODE_A},
+    {"b",SDL_SCANCODE_B},
+    {"c",SDL_SCANCODE_C},
+    {"d",SDL_SCANCODE_D},
+    {"e",SDL_SCANCODE_E},
+    {"f",SDL_SCANCODE_F},
+    {"g",SDL_SCANCODE_G},
+    {"h",SDL_SCANCODE_H},
+    {"i",SDL_SCANCODE_I},
+    {"j",SDL_SCANCODE_J},
+    {"k",SDL_SCANCODE_K},
+    {"l",SDL_SCANCODE_L},
+    {"m",SDL_SCANCODE_M},
+    {"n",SDL_SCANCODE_N},
+    {"o",SDL_SCANCODE_O},
+    {"p",SDL_SCANCODE_P},
+    {"q",SDL_SCANCODE_Q},
+    {"r",SDL_SCANCODE_R},
+    {"s",SDL_SCANCODE_S},
+    {"t",SDL_SCANCODE_T},
+    {"u",SDL_SCANCODE_U},
+    {"v",SDL_SCANCODE_V},
+    {"w",SDL_SCANCODE_W},
+    {"x",SDL_SCANCODE_X},
+    {"y",SDL_SCANCODE_Y},
+    {"z",SDL_SCANCODE_Z},
+};
+
+#define GFC_INPUT_KEY_NAME_COUNT (sizeof(gfc_input_key_names)/sizeof(GFC_InputKeyName))
+
+/**
+ * @brief look up a key name
+ * @return -1 if it is not a key name, its scancode or InputModKey otherwise
+ */
+static Sint32 gfc_input_key_code(const char *buffer)
+{
+    int low = 0,high = GFC_INPUT_KEY_NAME_COUNT - 1,mid,cmp;
+    if (!buffer)return -1;
+    while (low <= high)
+    {
+        mid = (low + high) / 2;
+        cmp = strcmp(buffer,gfc_input_key_names[mid].name);
+        if (!cmp)return gfc_input_key_names[mid].code;
+        if (cmp < 0)high = mid - 1;
+        else low = mid + 1;
+    }
+    if ((buffer[0] >= ' ')&&(buffer[0] <= '`')&&(buffer[1] == 0))
+    {
+        //other single symbols have always been mapped by their offset from space
+        return SDL_SCANCODE_SPACE + buffer[0] - ' ';
+    }
+    return -1;
+}
+
+InputModKey gfc_input_key_mod_check(const char * buffer)
+{
+    Sint32 code;
+    code = gfc_input_key_code(buffer);
+    if (code < EMK_Shift)return EMK_None;
+    return (InputModKey)code;
+}
+
+SDL_Scancode gfc_input_key_to_scancode(const char * buffer)
+{
+    Sint32 code;
+    if (!buffer)return -1;
+    code = gfc_input_key_code(buffer);
+    if ((code < 0)||(code >= EMK_Shift))
     {
         slog("no input mapping available for %s",buffer);
+        return -1;
     }
-    return kc;
+    return (SDL_Scancode)code;
 }
 
-Uint8 gfc_input_key_pressed(const char *key)
+Uint8 gfc_input_scancode_pressed(SDL_Scancode kc)
 {
-    SDL_Scancode kc;
-    kc = gfc_input_key_to_scancode(key);
-    if (kc == -1)return 0;
+    if (((int)kc < 0)||((int)kc >= gfc_input_data.input_key_count))return 0;
     if ((!gfc_input_data.input_old_keys[kc])&&(gfc_input_data.input_keys[kc]))return 1;
     return 0;
 }
 
-Uint8 gfc_input_key_released(const char *key)
+Uint8 gfc_input_scancode_released(SDL_Scancode kc)
 {
-    SDL_Scancode kc;
-    kc = gfc_input_key_to_scancode(key);
-    if (kc == -1)return 0;
+    if (((int)kc < 0)||((int)kc >= gfc_input_data.input_key_count))return 0;
     if ((gfc_input_data.input_old_keys[kc])&&(!gfc_input_data.input_keys[kc]))return 1;
     return 0;
 }
 
-Uint8 gfc_input_key_held(const char *key)
+Uint8 gfc_input_scancode_held(SDL_Scancode kc)
 {
-    SDL_Scancode kc;
-    kc = gfc_input_key_to_scancode(key);
-    if (kc == -1)return 0;
+    if (((int)kc < 0)||((int)kc >= gfc_input_data.input_key_count))return 0;
     if ((gfc_input_data.input_old_keys[kc])&&(gfc_input_data.input_keys[kc]))return 1;
     return 0;
 }
 
+Uint8 gfc_input_scancode_down(SDL_Scancode kc)
+{
+    if (((int)kc < 0)||((int)kc >= gfc_input_data.input_key_count))return 0;
+    if (gfc_input_data.input_keys[kc])return 1;
+    return 0;
+}
+
+Uint8 gfc_input_key_pressed(const char *key)
+{
+    return gfc_input_scancode_pressed(gfc_input_key_to_scancode(key));
+}
+
+Uint8 gfc_input_key_released(const char *key)
+{
+    return gfc_input_scancode_released(gfc_input_key_to_scancode(key));
+}
+
+Uint8 gfc_input_key_held(const char *key)
+{
+    return gfc_input_scancode_held(gfc_input_key_to_scancode(key));
+}
+
 Uint8 gfc_input_key_down(const char *key)
 {
-    SDL_Scancode kc;
-    kc = gfc_input_key_to_scancode(key);
-    if (kc == -1)return 0;
-    if (gfc_input_data.input_keys[kc])
+    return gfc_input_scancode_down(gfc_input_key_to_scancode(key));
+}
+
+static void gfc_input_index_scancode(Uint32 kc,Input *in)
+{
+    gfcList *commands;
+    if (kc >= SDL_NUM_SCANCODES)return;
+    commands = gfc_input_data.scancode_commands[kc];
+    if ((commands)&&(gfc_list_get_item_index(commands,in) >= 0))return;//key listed twice
+    gfc_input_data.scancode_commands[kc] = gfc_list_append(commands,in);
+}
+
+/**
+ * @brief take a command out of a lookup list, if it is in it
+ */
+static void gfc_input_list_remove(gfcList *commands,Input *in)
+{
+    int index;
+    if (!commands)return;
+    index = gfc_list_get_item_index(commands,in);
+    if (index < 0)return;
+    gfc_list_delete_nth(commands,index);
+}
+
+static void gfc_input_unindex_scancode(Uint32 kc,Input *in)
+{
+    if (kc >= SDL_NUM_SCANCODES)return;
+    gfc_input_list_remove(gfc_input_data.scancode_commands[kc],in);
+}
+
+/**
+ * @brief get the scancodes a key code is indexed under, mod keys stand for both their left and right keys
+ * @return how many scancodes were written to scancodes
+ */
+static Uint32 gfc_input_key_code_scancodes(Uint32 kc,Uint32 scancodes[2])
+{
+    switch (kc)
     {
-        return 1;
+        case EMK_Shift:
+            scancodes[0] = SDL_SCANCODE_LSHIFT;
+            scancodes[1] = SDL_SCANCODE_RSHIFT;
+            return 2;
+        case EMK_Alt:
+            scancodes[0] = SDL_SCANCODE_LALT;
+            scancodes[1] = SDL_SCANCODE_RALT;
+            return 2;
+        case EMK_Ctrl:
+            scancodes[0] = SDL_SCANCODE_LCTRL;
+            scancodes[1] = SDL_SCANCODE_RCTRL;
+            return 2;
+        case EMK_Super:
+            scancodes[0] = SDL_SCANCODE_LGUI;
+            scancodes[1] = SDL_SCANCODE_RGUI;
+            return 2;
+        default:
+            scancodes[0] = kc;
+            return 1;
     }
-    return 0;
 }
 
-void gfc_input_parse_command_json(SJson *command)
+/**
+ * @brief add a newly parsed command to the name, scancode and controller button lookups
+ */
+static void gfc_input_index_command(Input *in)
+{
+    Uint32 c,i,j,s;
+    Uint32 kc,button;
+    Uint32 scancodes[2];
+    gfcList *commands;
+    GFC_InputController *controller;
+    if (!gfc_input_data.input_map)
+    {
+        gfc_input_data.input_map = gfc_hashmap_new();
+        if (!gfc_input_data.input_map)return;
+    }
+    if (gfc_hashmap_get_by_id(gfc_input_data.input_map,in->commandId) == NULL)
+    {
+        //first definition wins, matching the old linear search
+        gfc_hashmap_insert_by_id(gfc_input_data.input_map,in->commandId,in);
+    }
+    c = gfc_list_get_count(in->keyCodes);
+    for (i = 0; i < c; i++)
+    {
+        kc = (Uint32)gfc_list_get_nth(in->keyCodes,i);
+        s = gfc_input_key_code_scancodes(kc,scancodes);
+        for (j = 0; j < s; j++)
+        {
+            gfc_input_index_scancode(scancodes[j],in);
+        }
+    }
+    if (!in->controller)return;
+    controller = gfc_list_get_nth(gfc_input_data.controllers,in->controller - 1);
+    if ((!controller)||(!controller->button_commands))return;
+    c = gfc_list_get_count(in->buttons);
+    for (i = 0; i < c; i++)
+    {
+        button = (Uint32)gfc_list_get_nth(in->buttons,i);
+        if (button >= controller->num_buttons)continue;
+        commands = controller->button_commands[button];
+        if ((commands)&&(gfc_list_get_item_index(commands,in) >= 0))continue;
+        controller->button_commands[button] = gfc_list_append(commands,in);
+    }
+}
+
+/**
+ * @brief take a command out of the scancode and controller button lookups, it stays listed by name
+ */
+static void gfc_input_unindex_command(Input *in)
+{
+    Uint32 c,i,j,s;
+    Uint32 button;
+    Uint32 scancodes[2];
+    GFC_InputController *controller;
+    c = gfc_list_get_count(in->keyCodes);
+    for (i = 0; i < c; i++)
+    {
+        s = gfc_input_key_code_scancodes((Uint32)gfc_list_get_nth(in->keyCodes,i),scancodes);
+        for (j = 0; j < s; j++)
+        {
+            gfc_input_unindex_scancode(scancodes[j],in);
+        }
+    }
+    if (!in->controller)return;
+    controller = gfc_list_get_nth(gfc_input_data.controllers,in->controller - 1);
+    if ((!controller)||(!controller->button_commands))return;
+    c = gfc_list_get_count(in->buttons);
+    for (i = 0; i < c; i++)
+    {
+        button = (Uint32)gfc_list_get_nth(in->buttons,i);
+        if (button >= controller->num_buttons)continue;
+        gfc_input_list_remove(controller->button_commands[button],in);
+    }
+}
+
+/**
+ * @brief parse the keys and controller buttons of a command into in, which has none yet
+ */
+static void gfc_input_parse_bindings(Input *in,SJson *command)
 {
     SJson *value,*list;
     const char * buffer;
-    Input *in;
     int count,i,index;
     Sint32 kc = 0;
-    if (!command)return;
-    value = sj_object_get_value(command,"command");
-    if (!value)
-    {
-        slog("input command missing 'command' key");
-        return;
-    }
-    in = gfc_input_new();
-    if (!in)return;
-    buffer = sj_get_string_value(value);
-    gfc_line_cpy(in->command,buffer);
     list = sj_object_get_value(command,"keys");
     count = sj_array_get_count(list);
     for (i = 0; i< count; i++)
@@ -926,12 +1865,8 @@ void gfc_input_parse_command_json(SJson *command)
             slog("error in key list, empty value");
             continue;   //error
         }
-        kc =  gfc_input_key_mod_check(buffer);
-        if (kc == EMK_None)
-        {
-            //not a meta mod key
-            kc = gfc_input_key_to_scancode(buffer);
-        }
+        kc = gfc_input_key_code(buffer);//a scancode or a meta mod key
+        if (kc == -1)slog("no input mapping available for %s",buffer);
 #pragma GCC diagnostic ignored "-Wint-to-pointer-cast"
         if (kc != -1)
         {
@@ -966,33 +1901,230 @@ void gfc_input_parse_command_json(SJson *command)
             }
         }
     }
+}
+
+static Input *gfc_input_parse_command(SJson *command,Uint32 sourceFile)
+{
+    SJson *value;
+    Input *in;
+    if (!command)return NULL;
+    value = sj_object_get_value(command,"command");
+    if (!value)
+    {
+        slog("input command missing 'command' key");
+        return NULL;
+    }
+    in = gfc_input_new();
+    if (!in)return NULL;
+    gfc_string_set(&in->command,sj_get_string_value(value));
+    in->commandId = gfc_str_intern(gfc_string_cstr(&in->command));
+    in->sourceFile = sourceFile;
+    gfc_input_parse_bindings(in,command);
     gfc_input_data.input_list = gfc_list_append(gfc_input_data.input_list,(void *)in);
+    gfc_input_index_command(in);
+    return in;
+}
+
+void gfc_input_parse_command_json(SJson *command)
+{
+    gfc_input_parse_command(command,0);
+}
+
+/**
+ * @brief get the commands array of a command file
+ * @return the json to free when done with commands, NULL on error
+ */
+static SJson *gfc_input_commands_file_load(const char *configFile,SJson **commands)
+{
+    SJson *json;
+    json = gfc_pak_load_json(configFile);
+    if (!json)return NULL;
+    *commands = sj_object_get_value(json,"commands");
+    if (!*commands)
+    {
+        slog("config file %s does not contain 'commands' object",configFile);
+        sj_free(json);
+        return NULL;
+    }
+    return json;
+}
+
+/**
+ * @brief find the command file, by name
+ * @return its index in command_files, -1 if it was never loaded
+ */
+static int gfc_input_command_file_find(const char *configFile)
+{
+    InputCommandFile *file;
+    int i,c;
+    c = gfc_list_get_count(gfc_input_data.command_files);
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(gfc_input_data.command_files,i);
+        if ((file)&&(gfc_strlcmp(file->filename,configFile) == 0))return i;
+    }
+    return -1;
+}
+
+static void gfc_input_command_file_changed(void *data)
+{
+    InputCommandFile *file = data;
+    if (!file)return;
+    gfc_input_commands_reload(file->filename);
 }
 
 void gfc_input_commands_load(char *configFile)
 {
     SJson *json;
-    SJson *commands;
+    SJson *commands = NULL;
     SJson *value;
-    int count,i;
+    InputCommandFile *file;
+    int count,i,index;
     if (!configFile)return;
-    json = gfc_pak_load_json(configFile);
+    json = gfc_input_commands_file_load(configFile,&commands);
     if (!json)return;
-    commands = sj_object_get_value(json,"commands");
-    if (!commands)
+    index = gfc_input_command_file_find(configFile);
+    if (index < 0)
     {
-        slog("config file %s does not contain 'commands' object",configFile);
-        sj_free(json);
-        return;
+        file = gfc_allocate_array(sizeof(InputCommandFile),1);
+        if (file)
+        {
+            gfc_line_cpy(file->filename,configFile);
+            if (gfc_input_data.watching)file->watchId = gfc_watch_add(configFile,gfc_input_command_file_changed,file);
+            gfc_input_data.command_files = gfc_list_append(gfc_input_data.command_files,file);
+            index = gfc_list_get_count(gfc_input_data.command_files) - 1;
+        }
     }
     count = sj_array_get_count(commands);
     for (i = 0; i< count; i++)
     {
         value = sj_array_get_nth(commands,i);
         if (!value)continue;
-        gfc_input_parse_command_json(value);
+        gfc_input_parse_command(value,index + 1);
+    }
+    sj_free(json);
+}
+
+/**
+ * @brief drop the keys and buttons of a command, releasing it if it was down
+ */
+static void gfc_input_command_unbind(Input *in)
+{
+    gfc_input_unindex_command(in);
+    if ((in->state == IET_Press)||(in->state == IET_Hold))
+    {
+        //with no keys left it would never be evaluated again to see the release
+        gfc_input_fire(in->onRelease,in->data);
+    }
+    in->state = IET_Idle;
+    in->downCount = 0;
+    in->controller = 0;
+    gfc_list_clear(in->keyCodes);
+    gfc_list_clear(in->buttons);
+    gfc_list_clear(in->axes);
+    gfc_input_list_remove(gfc_input_data.active_commands,in);
+}
+
+/**
+ * @brief find a command loaded from sourceFile by name, that this reload has not rebound yet
+ */
+static Input *gfc_input_find_reloadable(gfcList *rebound,Uint32 sourceFile,const char *name)
+{
+    Input *in;
+    int i,c;
+    c = gfc_list_get_count(gfc_input_data.input_list);
+    for (i = 0; i < c; i++)
+    {
+        in = gfc_list_get_nth(gfc_input_data.input_list,i);
+        if ((!in)||(in->sourceFile != sourceFile))continue;
+        if (!gfc_string_equal_cstr(&in->command,name))continue;
+        if ((rebound)&&(gfc_list_get_item_index(rebound,in) >= 0))continue;
+        return in;
+    }
+    return NULL;
+}
+
+int gfc_input_commands_reload(const char *configFile)
+{
+    SJson *json;
+    SJson *commands = NULL;
+    SJson *value;
+    Input *in;
+    gfcList *rebound;
+    const char *name;
+    Uint32 sourceFile;
+    int count,i,index;
+    GFC_PROFILE_ZONE("gfc_input_commands_reload");
+    if (!configFile)return -1;
+    index = gfc_input_command_file_find(configFile);
+    if (index < 0)
+    {
+        slog("input command file %s was not loaded, it can not be reloaded",configFile);
+        return -1;
+    }
+    json = gfc_input_commands_file_load(configFile,&commands);
+    if (!json)
+    {
+        slog("failed to reload input command file %s, keeping the old bindings",configFile);
+        return -1;
+    }
+    sourceFile = index + 1;
+    rebound = gfc_list_new();
+    count = sj_array_get_count(commands);
+    for (i = 0; i < count; i++)
+    {
+        value = sj_array_get_nth(commands,i);
+        if (!value)continue;
+        name = sj_get_string_value(sj_object_get_value(value,"command"));
+        in = NULL;
+        if (name)in = gfc_input_find_reloadable(rebound,sourceFile,name);
+        if (!in)
+        {
+            in = gfc_input_parse_command(value,sourceFile);
+        }
+        else
+        {
+            //rebound in place, so pointers to it and its callbacks stay good
+            gfc_input_command_unbind(in);
+            gfc_input_parse_bindings(in,value);
+            gfc_input_index_command(in);
+        }
+        if (in)rebound = gfc_list_append(rebound,in);
+    }
+    //commands taken out of the file stop responding, but they stay valid for anything holding on to them
+    count = gfc_list_get_count(gfc_input_data.input_list);
+    for (i = 0; i < count; i++)
+    {
+        in = gfc_list_get_nth(gfc_input_data.input_list,i);
+        if ((!in)||(in->sourceFile != sourceFile))continue;
+        if (gfc_list_get_item_index(rebound,in) >= 0)continue;
+        gfc_input_command_unbind(in);
     }
+    gfc_list_delete(rebound);
     sj_free(json);
+    return 0;
+}
+
+void gfc_input_watch(Uint8 enable)
+{
+    InputCommandFile *file;
+    int i,c;
+    gfc_input_data.watching = enable?1:0;
+    c = gfc_list_get_count(gfc_input_data.command_files);
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(gfc_input_data.command_files,i);
+        if (!file)continue;
+        if ((enable)&&(!file->watchId))
+        {
+            file->watchId = gfc_watch_add(file->filename,gfc_input_command_file_changed,file);
+        }
+        else if ((!enable)&&(file->watchId))
+        {
+            gfc_watch_remove(file->watchId);
+            file->watchId = 0;
+        }
+    }
 }
 
 
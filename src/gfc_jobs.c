@@ -0,0 +1,464 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_random.h"
+#include "gfc_jobs.h"
+
+#define GFC_JOBS_QUEUE_SIZE 1024        /**<jobs each queue can hold, a power of two.  When full, jobs run as they are posted*/
+#define GFC_JOBS_CHUNKS_PER_THREAD 4    /**<how many chunks gfc_parallel_for() aims for per thread, so threads that finish early can steal*/
+
+typedef struct
+{
+    gfc_work_func_context  *fn;
+    void                   *data;
+    void                   *context;
+    gfcJobCounter          *counter;
+}GFC_Job;
+
+typedef struct GFC_JobWait_S
+{
+    GFC_Job                 job;
+    struct GFC_JobWait_S   *next;
+}GFC_JobWait;
+
+typedef struct
+{
+    GFC_Job         jobs[GFC_JOBS_QUEUE_SIZE];
+    Uint32          head;   /**<the oldest job, where other threads steal from*/
+    Uint32          tail;   /**<one past the newest job, where the owner pushes and pops*/
+    SDL_SpinLock    lock;
+}GFC_JobQueue;
+
+typedef struct
+{
+    Uint8           running;
+    SDL_Thread    **threads;
+    Uint32          workerCount;
+    GFC_JobQueue   *queues;     /**<0 is shared by threads outside of the pool, 1 is the thread that started it, then one per worker*/
+    Uint32          queueCount;
+    SDL_sem        *wake;
+    SDL_atomic_t    sleeping;   /**<workers that found nothing to do and are waiting on wake*/
+    SDL_atomic_t    quit;
+}GFC_JobManager;
+
+typedef struct
+{
+    gfc_work_func  *fn;
+    void           *data;
+}GFC_JobCall;
+
+typedef struct
+{
+    gfc_work_func_context  *fn;
+    void                   *context;
+    Uint32                  begin,end,grain,chunks;
+    SDL_atomic_t            next;
+}GFC_JobFor;
+
+typedef struct
+{
+    gfcList    *list;
+    void      (*function)(void *data,void *context);
+    void       *context;
+}GFC_JobForeach;
+
+static GFC_JobManager gfc_jobs = {0};
+static GFC_THREAD_LOCAL Uint32 gfc_jobs_queue = 0;   /**<which queue the calling thread owns*/
+
+static void gfc_jobs_close();
+
+static Uint8 gfc_jobs_queue_push(GFC_JobQueue *queue,GFC_Job *job)
+{
+    SDL_AtomicLock(&queue->lock);
+    if (queue->tail - queue->head >= GFC_JOBS_QUEUE_SIZE)
+    {
+        SDL_AtomicUnlock(&queue->lock);
+        return 0;
+    }
+    queue->jobs[queue->tail & (GFC_JOBS_QUEUE_SIZE - 1)] = *job;
+    queue->tail++;
+    SDL_AtomicUnlock(&queue->lock);
+    return 1;
+}
+
+static Uint8 gfc_jobs_queue_pop(GFC_JobQueue *queue,GFC_Job *job,Uint8 newest,Uint8 block)
+{
+    if (block)SDL_AtomicLock(&queue->lock);
+    else if (!SDL_AtomicTryLock(&queue->lock))return 0;
+    if (queue->tail == queue->head)
+    {
+        SDL_AtomicUnlock(&queue->lock);
+        return 0;
+    }
+    if (newest)*job = queue->jobs[--queue->tail & (GFC_JOBS_QUEUE_SIZE - 1)];
+    else *job = queue->jobs[queue->head++ & (GFC_JOBS_QUEUE_SIZE - 1)];
+    SDL_AtomicUnlock(&queue->lock);
+    return 1;
+}
+
+/**
+ * @brief take a job: the newest from our own queue, else the oldest from another
+ * @param block if 0 queues another thread has locked are skipped
+ */
+static Uint8 gfc_jobs_find(GFC_Job *job,Uint8 block)
+{
+    Uint32 i,n,start,self = gfc_jobs_queue;
+    if ((self)&&(gfc_jobs_queue_pop(&gfc_jobs.queues[self],job,1,1)))return 1;
+    //start somewhere random so thieves spread out instead of all hitting the first queue
+    start = gfc_rng_int(gfc_rng_thread(),gfc_jobs.queueCount);
+    for (i = 0; i < gfc_jobs.queueCount; i++)
+    {
+        n = (start + i) % gfc_jobs.queueCount;
+        if ((self)&&(n == self))continue;
+        if (gfc_jobs_queue_pop(&gfc_jobs.queues[n],job,0,block))return 1;
+    }
+    return 0;
+}
+
+static void gfc_jobs_execute(GFC_Job *job)
+{
+    job->fn(job->data,job->context);
+    if (job->counter)gfc_job_counter_done(job->counter);
+}
+
+static void gfc_jobs_post(GFC_Job *job)
+{
+    if ((!gfc_jobs.running)||(!gfc_jobs_queue_push(&gfc_jobs.queues[gfc_jobs_queue],job)))
+    {
+        gfc_jobs_execute(job);
+        return;
+    }
+    if (SDL_AtomicGet(&gfc_jobs.sleeping) > 0)SDL_SemPost(gfc_jobs.wake);
+}
+
+static int gfc_jobs_worker(void *data)
+{
+    GFC_Job job;
+    gfc_jobs_queue = (Uint32)(size_t)data;
+    for (;;)
+    {
+        if (gfc_jobs_find(&job,0))
+        {
+            gfc_jobs_execute(&job);
+            continue;
+        }
+        //say we are going to sleep before the last look, so a job posted after it will post wake
+        SDL_AtomicIncRef(&gfc_jobs.sleeping);
+        if (gfc_jobs_find(&job,1))
+        {
+            SDL_AtomicAdd(&gfc_jobs.sleeping,-1);
+            gfc_jobs_execute(&job);
+            continue;
+        }
+        if (SDL_AtomicGet(&gfc_jobs.quit))
+        {
+            SDL_AtomicAdd(&gfc_jobs.sleeping,-1);
+            break;
+        }
+        SDL_SemWait(gfc_jobs.wake);
+        SDL_AtomicAdd(&gfc_jobs.sleeping,-1);
+    }
+    return 0;
+}
+
+void gfc_jobs_init(Uint32 threads)
+{
+    Uint32 i;
+    if (gfc_jobs.running)return;//already running
+    if (!threads)
+    {
+        threads = SDL_GetCPUCount() - 1;
+        if (threads < 1)threads = 1;
+    }
+    gfc_jobs.queueCount = threads + 2;
+    gfc_jobs.queues = gfc_allocate_array(sizeof(GFC_JobQueue),gfc_jobs.queueCount);
+    gfc_jobs.threads = gfc_allocate_array(sizeof(SDL_Thread *),threads);
+    gfc_jobs.wake = SDL_CreateSemaphore(0);
+    if ((!gfc_jobs.queues)||(!gfc_jobs.threads)||(!gfc_jobs.wake))
+    {
+        slog("failed to allocate the job system");
+        if (gfc_jobs.queues)free(gfc_jobs.queues);
+        if (gfc_jobs.threads)free(gfc_jobs.threads);
+        if (gfc_jobs.wake)SDL_DestroySemaphore(gfc_jobs.wake);
+        memset(&gfc_jobs,0,sizeof(GFC_JobManager));
+        return;
+    }
+    SDL_AtomicSet(&gfc_jobs.quit,0);
+    SDL_AtomicSet(&gfc_jobs.sleeping,0);
+    gfc_jobs.workerCount = threads;
+    gfc_jobs.running = 1;
+    gfc_jobs_queue = 1;
+    for (i = 0; i < threads; i++)
+    {
+        gfc_jobs.threads[i] = SDL_CreateThread(gfc_jobs_worker,"gfc_job_worker",(void *)(size_t)(i + 2));
+        if (!gfc_jobs.threads[i])slog("failed to create job worker thread: %s",SDL_GetError());
+    }
+    atexit(gfc_jobs_close);
+}
+
+static void gfc_jobs_close()
+{
+    GFC_Job job;
+    Uint32 i;
+    if (!gfc_jobs.running)return;
+    SDL_AtomicSet(&gfc_jobs.quit,1);
+    for (i = 0; i < gfc_jobs.workerCount; i++)
+    {
+        SDL_SemPost(gfc_jobs.wake);
+    }
+    for (i = 0; i < gfc_jobs.workerCount; i++)
+    {
+        if (gfc_jobs.threads[i])SDL_WaitThread(gfc_jobs.threads[i],NULL);
+    }
+    //the workers drain the queues before they quit, this catches anything posted while they were stopping
+    gfc_jobs_queue = 0;
+    while (gfc_jobs_find(&job,1))gfc_jobs_execute(&job);
+    gfc_jobs.running = 0;
+    free(gfc_jobs.queues);
+    free(gfc_jobs.threads);
+    SDL_DestroySemaphore(gfc_jobs.wake);
+    memset(&gfc_jobs,0,sizeof(GFC_JobManager));
+}
+
+Uint32 gfc_jobs_get_thread_count()
+{
+    if (!gfc_jobs.running)return 0;
+    return gfc_jobs.workerCount + 1;
+}
+
+void gfc_job_counter_add(gfcJobCounter *counter,Uint32 count)
+{
+    if (!counter)return;
+    SDL_AtomicAdd(&counter->pending,(int)count);
+}
+
+void gfc_job_counter_done(gfcJobCounter *counter)
+{
+    GFC_JobWait *wait,*next;
+    if (!counter)return;
+    //the count only drops under the lock, so once a waiter has seen zero and taken the lock we are done with the counter
+    SDL_AtomicLock(&counter->lock);
+    if (SDL_AtomicAdd(&counter->pending,-1) != 1)
+    {
+        SDL_AtomicUnlock(&counter->lock);
+        return;
+    }
+    wait = counter->waiting;
+    counter->waiting = NULL;
+    SDL_AtomicUnlock(&counter->lock);
+    for (;wait;wait = next)
+    {
+        next = wait->next;
+        gfc_jobs_post(&wait->job);
+        free(wait);
+    }
+}
+
+/**
+ * @brief wait for the thread that took the counter to zero to let go of it, so the caller can free or reuse it
+ */
+static void gfc_job_counter_settle(gfcJobCounter *counter)
+{
+    SDL_AtomicLock(&counter->lock);
+    SDL_AtomicUnlock(&counter->lock);
+}
+
+Uint8 gfc_job_counter_is_done(gfcJobCounter *counter)
+{
+    if (!counter)return 1;
+    if (SDL_AtomicGet(&counter->pending) > 0)return 0;
+    gfc_job_counter_settle(counter);
+    return 1;
+}
+
+void gfc_jobs_run_after(gfcJobCounter *after,gfc_work_func_context *fn,void *data,void *context,gfcJobCounter *counter)
+{
+    GFC_Job job;
+    GFC_JobWait *wait;
+    if (!fn)
+    {
+        slog("no job function provided");
+        return;
+    }
+    job.fn = fn;
+    job.data = data;
+    job.context = context;
+    job.counter = counter;
+    if (counter)SDL_AtomicIncRef(&counter->pending);
+    if (!after)
+    {
+        gfc_jobs_post(&job);
+        return;
+    }
+    //checked under the lock so it can not reach zero between the check and the job being added to the wait list
+    SDL_AtomicLock(&after->lock);
+    if (SDL_AtomicGet(&after->pending) <= 0)
+    {
+        SDL_AtomicUnlock(&after->lock);
+        gfc_jobs_post(&job);
+        return;
+    }
+    wait = gfc_allocate_array(sizeof(GFC_JobWait),1);
+    if (!wait)
+    {
+        SDL_AtomicUnlock(&after->lock);
+        slog("failed to hold a job back, running it now");
+        gfc_jobs_post(&job);
+        return;
+    }
+    wait->job = job;
+    wait->next = after->waiting;
+    after->waiting = wait;
+    SDL_AtomicUnlock(&after->lock);
+}
+
+void gfc_jobs_run(gfc_work_func_context *fn,void *data,void *context,gfcJobCounter *counter)
+{
+    gfc_jobs_run_after(NULL,fn,data,context,counter);
+}
+
+void gfc_jobs_wait(gfcJobCounter *counter)
+{
+    GFC_Job job;
+    if (!counter)return;
+    while (SDL_AtomicGet(&counter->pending) > 0)
+    {
+        if ((gfc_jobs.running)&&(gfc_jobs_find(&job,0)))
+        {
+            gfc_jobs_execute(&job);
+            continue;
+        }
+        SDL_Delay(0);
+    }
+    gfc_job_counter_settle(counter);
+}
+
+static void gfc_jobs_call(void *data,void *context)
+{
+    GFC_JobCall *call = data;
+    call->fn(call->data);
+}
+
+static int gfc_jobs_call_thread(void *data)
+{
+    GFC_JobCall *call = data;
+    call->fn(call->data);
+    return 0;
+}
+
+void gfc_jobs_run_parallel(gfc_work_func *fn,void *data,Uint32 threads)
+{
+    GFC_JobCall call;
+    gfcJobCounter counter = {0};
+    SDL_Thread **workers = NULL;
+    Uint32 i;
+    if (!fn)return;
+    call.fn = fn;
+    call.data = data;
+    if (gfc_jobs.running)
+    {
+        if ((!threads)||(threads > gfc_jobs.workerCount + 1))threads = gfc_jobs.workerCount + 1;
+        for (i = 1; i < threads; i++)
+        {
+            gfc_jobs_run(gfc_jobs_call,&call,NULL,&counter);
+        }
+        fn(data);
+        gfc_jobs_wait(&counter);
+        return;
+    }
+    if (!threads)
+    {
+        threads = SDL_GetCPUCount();
+        if (threads < 1)threads = 1;
+    }
+    if (threads > 1)
+    {
+        workers = gfc_allocate_array(sizeof(SDL_Thread *),threads);
+        if (!workers)threads = 1;
+    }
+    for (i = 1; i < threads; i++)
+    {
+        workers[i] = SDL_CreateThread(gfc_jobs_call_thread,"gfc_jobs_thread",&call);
+        if (!workers[i])slog("failed to create thread: %s",SDL_GetError());
+    }
+    fn(data);
+    for (i = 1; i < threads; i++)
+    {
+        if (workers[i])SDL_WaitThread(workers[i],NULL);
+    }
+    if (workers)free(workers);
+}
+
+static void gfc_jobs_for_worker(void *data)
+{
+    GFC_JobFor *f = data;
+    gfcJobRange range;
+    Uint32 n;
+    while ((n = (Uint32)SDL_AtomicAdd(&f->next,1)) < f->chunks)
+    {
+        range.begin = f->begin + n * f->grain;
+        range.end = MIN(range.begin + f->grain,f->end);
+        f->fn(&range,f->context);
+    }
+}
+
+void gfc_parallel_for(Uint32 begin,Uint32 end,Uint32 grain,gfc_work_func_context *fn,void *context)
+{
+    GFC_JobFor f;
+    gfcJobRange range;
+    Uint32 threads;
+    if ((!fn)||(end <= begin))return;
+    if (!gfc_jobs.running)
+    {
+        range.begin = begin;
+        range.end = end;
+        fn(&range,context);
+        return;
+    }
+    threads = gfc_jobs.workerCount + 1;
+    if (!grain)grain = (end - begin) / (threads * GFC_JOBS_CHUNKS_PER_THREAD);
+    if (!grain)grain = 1;
+    f.fn = fn;
+    f.context = context;
+    f.begin = begin;
+    f.end = end;
+    f.grain = grain;
+    f.chunks = (end - begin + grain - 1) / grain;
+    SDL_AtomicSet(&f.next,0);
+    gfc_jobs_run_parallel(gfc_jobs_for_worker,&f,MIN(f.chunks,threads));
+}
+
+static void gfc_jobs_foreach_range(void *data,void *context)
+{
+    gfcJobRange *range = data;
+    GFC_JobForeach *f = context;
+    Uint32 i;
+    for (i = range->begin; i < range->end; i++)
+    {
+        f->function(f->list->elements[i].data,f->context);
+    }
+}
+
+void gfc_parallel_foreach_context(gfcList *list,void (*function)(void *data,void *context),void *contextData)
+{
+    GFC_JobForeach f;
+    if (!list)
+    {
+        slog("no list provided");
+        return;
+    }
+    if (!function)
+    {
+        slog("no function provided");
+        return;
+    }
+    f.list = list;
+    f.function = function;
+    f.context = contextData;
+    gfc_parallel_for(0,list->count,0,gfc_jobs_foreach_range,&f);
+}
+
+/*eol@eof*/
@@ -8,9 +8,9 @@ void gfc_list_delete(gfcList *list)
     if (!list)return;
     if (list->elements)
     {
-        free(list->elements);
+        gfc_allocator_free(list->allocator,list->elements);
     }
-    free(list);
+    gfc_allocator_free(list->allocator,list);
 }
 
 gfcList *gfc_list_new()
@@ -23,7 +23,7 @@ gfcList *gfc_list_copy(gfcList *old)
     gfcList *new;
     if (!old)return 0;
     if (old->size <= 0)return NULL;
-    new = gfc_list_new_size(old->size);
+    new = gfc_list_new_size_allocator(old->size,old->allocator);
     if (!new)return NULL;
     if (old->count <= 0)return new;
     memcpy(new->elements,old->elements,sizeof(ListElementData)*old->count);
@@ -32,6 +32,11 @@ gfcList *gfc_list_copy(gfcList *old)
 }
 
 gfcList *gfc_list_new_size(Uint32 count)
+{
+    return gfc_list_new_size_allocator(count,NULL);
+}
+
+gfcList *gfc_list_new_size_allocator(Uint32 count,gfcAllocator *allocator)
 {
     gfcList *l;
     if (!count)
@@ -39,19 +44,19 @@ gfcList *gfc_list_new_size(Uint32 count)
         slog("cannot make a list of size zero");
         return NULL;
     }
-    l = (gfcList *)malloc(sizeof(gfcList));
+    l = (gfcList *)gfc_allocator_alloc(allocator,sizeof(gfcList),1);
     if (!l)
     {
         slog("failed to allocate space for the list");
         return NULL;
     }
-    memset(l,0,sizeof(gfcList));
     l->size = count;
-    l->elements = gfc_allocate_array(sizeof(ListElementData),count);
+    l->allocator = allocator;
+    l->elements = gfc_allocator_alloc(allocator,sizeof(ListElementData),count);
     if (!l->elements)
     {
         slog("failed to allocate space for list elements");
-        free(l);
+        gfc_allocator_free(allocator,l);
         return NULL;
     }
     return l;
@@ -86,28 +91,36 @@ void *gfc_list_get_nth(gfcList *list,Uint32 n)
     return list->elements[n].data;
 }
 
-gfcList *gfc_list_expand(gfcList *list)
+int gfc_list_reserve(gfcList *list,Uint32 count)
 {
-    gfcList *l;
+    ListElementData *elements;
     if (!list)
     {
         slog("no list provided");
-        return NULL;
+        return -1;
     }
-    if (!list->size)list->size = 8;
-    l = gfc_list_new_size(list->size * 2);
-    if (!l)
+    if (count <= list->size)return 0;
+    //grow in place when the allocator can
+    elements = gfc_allocator_realloc(list->allocator,list->elements,sizeof(ListElementData)*list->size,sizeof(ListElementData)*count);
+    if (!elements)
     {
-        return list;
+        slog("failed to allocate space for list elements");
+        return -1;
     }
-    if (list->count > 0)
+    memset(&elements[list->size],0,sizeof(ListElementData)*(count - list->size));
+    list->elements = elements;
+    list->size = count;
+    return 0;
+}
+
+gfcList *gfc_list_expand(gfcList *list)
+{
+    if (!list)
     {
-        memcpy(l->elements,list->elements,sizeof(ListElementData)*list->count);
+        slog("no list provided");
+        return NULL;
     }
-    list->size = l->size;// update the new size
-    free(list->elements);//free the old data
-    list->elements = l->elements;//point to new memory address
-    free(l);//free the temp list
+    gfc_list_reserve(list,list->size?list->size * 2:8);
     return list;//for backward compatibility
 }
 
@@ -119,8 +132,7 @@ gfcList *gfc_list_append(gfcList *list,void *data)
     }
     if (list->count >= list->size)
     {
-        list = gfc_list_expand(list);
-        if (!list)
+        if (gfc_list_reserve(list,list->size?list->size * 2:8) != 0)
         {
             slog("append failed due to lack of memory");
             return NULL;
@@ -170,15 +182,14 @@ gfcList *gfc_list_insert(gfcList *list,void *data,Uint32 n)
         slog("no list provided");
         return NULL;
     }
-    if (n > list->size + 1)
+    if (n > list->count)
     {
         slog("attempting to insert element beyond length of list");
         return list;
     }
     if (list->count >= list->size)
     {
-        list = gfc_list_expand(list);
-        if (!list)return NULL;
+        if (gfc_list_reserve(list,list->size?list->size * 2:8) != 0)return NULL;
     }
     memmove(&list->elements[n+1],&list->elements[n],sizeof(ListElementData)*(list->count - n));//copy all elements after n
     list->elements[n].data = data;
@@ -247,7 +258,7 @@ int gfc_list_delete_data(gfcList *list,void *data)
 void gfc_list_clear(gfcList *list)
 {
     if (!list)return;
-    memset(list->elements,0,list->size);//zero out all the data;
+    memset(list->elements,0,sizeof(ListElementData)*list->size);//zero out all the data;
     list->count = 0;
 }
 
@@ -269,11 +280,49 @@ int gfc_list_delete_nth(gfcList *list,Uint32 n)
         list->elements[n].data = NULL;
         return 0;
     }
-    memmove(&list->elements[n],&list->elements[n+1],sizeof(ListElementData)*(list->count - n));//copy all elements after n
+    memmove(&list->elements[n],&list->elements[n+1],sizeof(ListElementData)*(list->count - n - 1));//copy all elements after n
+    list->count--;
+    list->elements[list->count].data = NULL;
+    return 0;
+}
+
+int gfc_list_swap_remove_nth(gfcList *list,Uint32 n)
+{
+    if (!list)
+    {
+        slog("no list provided");
+        return -1;
+    }
+    if (n >= list->count)
+    {
+        slog("attempting to delete beyond the length of the list");
+        return -1;
+    }
     list->count--;
+    list->elements[n].data = list->elements[list->count].data;//the last element fills the hole
+    list->elements[list->count].data = NULL;
     return 0;
 }
 
+int gfc_list_swap_remove_data(gfcList *list,void *data)
+{
+    int i;
+    if (!list)
+    {
+        slog("no list provided");
+        return -1;
+    }
+    if (!data)return -1;
+    for (i = 0; i < list->count;i++)
+    {
+        if (list->elements[i].data == data)
+        {
+            return gfc_list_swap_remove_nth(list,i);
+        }
+    }
+    return -1;
+}
+
 Uint32 gfc_list_get_count(gfcList *list)
 {
     if (!list)return 0;
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <float.h>
 
 #include "gfc_matrix.h"
 #include "simple_logger.h"
@@ -53,21 +54,162 @@ Vector3D gfc_unproject(Vector3D in, Matrix4 view, Matrix4 proj, Vector2D viewpor
     gfc_matrix_M_multiply_v(&wor, InvView, eye);
     Vector3D dir = vector3d(wor.x, -wor.y, wor.z); //z is verticle axis in game
     vector3d_normalize(&dir);
+    return dir;
+}
 
-    //printf("Game ray normalized: (%f,%f,%f)\n", dir.x, dir.y, dir.z);
-
-
-    //Test to see if invert and multiply result in identity matrix
-    Matrix4 test = { 0 };
-    //printf("testing matrix functions\n");
-    gfc_matrix_multiply(test, proj, InvProj);
-    //gfc_matrix4_slog(test);
-
+Uint8 gfc_unprojector_set(gfcUnprojector *u,Matrix4 view,Matrix4 proj,Vector2D viewport)
+{
+    Matrix4 invProj,invView,viewProj;
+    float a[3],b[3],c[3],k0,k1,sx,sy;
+    int i;
+    if (!u)return 0;
+    memset(u,0,sizeof(gfcUnprojector));
+    if ((!viewport.x) || (!viewport.y))
+    {
+        slog("cannot unproject into a view of zero width or height");
+        return 0;
+    }
+    gfc_matrix_multiply(viewProj,view,proj);
+    if ((!gfc_matrix4_invert(invProj,proj))||(!gfc_matrix4_invert(invView,view))||(!gfc_matrix4_invert(u->invViewProj,viewProj)))
+    {
+        slog("cannot unproject with a view or projection matrix that has no inverse");
+        return 0;
+    }
+    //gfc_unproject is affine in the screen position, so its two matrix multiplies fold down to dx, dy and origin
+    k0 = invProj[0][3] - invProj[0][2];
+    k1 = invProj[1][3] - invProj[1][2];
+    for (i = 0; i < 3; i++)
+    {
+        a[i] = invView[i][0] * invProj[0][0] + invView[i][1] * invProj[1][0];
+        b[i] = invView[i][0] * invProj[0][1] + invView[i][1] * invProj[1][1];
+        c[i] = invView[i][0] * k0 + invView[i][1] * k1 - invView[i][2] + invView[i][3];
+    }
+    sx = 2.0f / viewport.x;
+    sy = 2.0f / viewport.y;
+    //ndc x = sx * x - 1 and ndc y = 1 - sy * y, then y is flipped for the game's axes
+    u->dx = vector3d(a[0] * sx,-a[1] * sx,a[2] * sx);
+    u->dy = vector3d(-b[0] * sy,b[1] * sy,-b[2] * sy);
+    u->origin = vector3d(c[0] - a[0] + b[0],-(c[1] - a[1] + b[1]),c[2] - a[2] + b[2]);
+    u->viewport = viewport;
+    u->valid = 1;
+    return 1;
+}
 
+Vector3D gfc_unprojector_direction(gfcUnprojector *u,Vector3D in)
+{
+    Vector3D dir = {0};
+    if ((!u)||(!u->valid))return dir;
+    dir.x = u->dx.x * in.x + u->dy.x * in.y + u->origin.x;
+    dir.y = u->dx.y * in.x + u->dy.y * in.y + u->origin.y;
+    dir.z = u->dx.z * in.x + u->dy.z * in.y + u->origin.z;
+    vector3d_normalize(&dir);
+    return dir;
+}
 
+Vector3D gfc_unprojector_point(gfcUnprojector *u,Vector3D in)
+{
+    Vector3D out = {0};
+    Vector4D world;
+    if ((!u)||(!u->valid))return out;
+    gfc_matrix_v_multiply_M(
+        &world,
+        u->invViewProj,
+        vector4d((2.0f * in.x) / u->viewport.x - 1,1 - (2.0f * in.y) / u->viewport.y,2.0f * in.z - 1,1));
+    if (world.w == 0)return out;
+    return vector3d(world.x / world.w,world.y / world.w,world.z / world.w);
+}
 
+void gfc_unproject_batch(gfcUnprojector *u,Vector3D *in,Vector3D *out,Uint32 n)
+{
+    Uint32 i = 0;
+#ifdef GFC_SIMD
+    Uint32 k;
+    gfc_f4 dxx,dxy,dxz,dyx,dyy,dyz,ox,oy,oz,tiny;
+    gfc_f4 x,y,wx,wy,wz,len;
+    float tx[4],ty[4],tz[4];
+#endif
+    if ((!u)||(!u->valid)||(!in)||(!out))return;
+#ifdef GFC_SIMD
+    dxx = gfc_f4_set1(u->dx.x);
+    dxy = gfc_f4_set1(u->dx.y);
+    dxz = gfc_f4_set1(u->dx.z);
+    dyx = gfc_f4_set1(u->dy.x);
+    dyy = gfc_f4_set1(u->dy.y);
+    dyz = gfc_f4_set1(u->dy.z);
+    ox = gfc_f4_set1(u->origin.x);
+    oy = gfc_f4_set1(u->origin.y);
+    oz = gfc_f4_set1(u->origin.z);
+    //a zero direction divided by the root of this stays zero, as vector3d_normalize leaves it
+    tiny = gfc_f4_set1(FLT_MIN);
+    for (; i + 4 <= n; i += 4)
+    {
+        x = gfc_f4_set(in[i].x,in[i + 1].x,in[i + 2].x,in[i + 3].x);
+        y = gfc_f4_set(in[i].y,in[i + 1].y,in[i + 2].y,in[i + 3].y);
+        wx = gfc_f4_add(gfc_f4_add(gfc_f4_mul(dxx,x),gfc_f4_mul(dyx,y)),ox);
+        wy = gfc_f4_add(gfc_f4_add(gfc_f4_mul(dxy,x),gfc_f4_mul(dyy,y)),oy);
+        wz = gfc_f4_add(gfc_f4_add(gfc_f4_mul(dxz,x),gfc_f4_mul(dyz,y)),oz);
+        len = gfc_f4_add(gfc_f4_add(gfc_f4_mul(wx,wx),gfc_f4_mul(wy,wy)),gfc_f4_mul(wz,wz));
+        len = gfc_f4_sqrt(gfc_f4_max(len,tiny));
+        gfc_f4_store(tx,gfc_f4_div(wx,len));
+        gfc_f4_store(ty,gfc_f4_div(wy,len));
+        gfc_f4_store(tz,gfc_f4_div(wz,len));
+        for (k = 0; k < 4; k++)
+        {
+            out[i + k].x = tx[k];
+            out[i + k].y = ty[k];
+            out[i + k].z = tz[k];
+        }
+    }
+#endif
+    for (; i < n; i++)
+    {
+        out[i] = gfc_unprojector_direction(u,in[i]);
+    }
+}
 
-    return dir;
+void gfc_unproject_points_batch(gfcUnprojector *u,Vector3D *in,Vector3D *out,Uint32 n)
+{
+    Uint32 i;
+    float sx,sy;
+#ifdef GFC_SIMD
+    gfc_f4 r0,r1,r2,r3,o;
+    float temp[4];
+#else
+    Vector4D world;
+#endif
+    if ((!u)||(!u->valid)||(!in)||(!out))return;
+    sx = 2.0f / u->viewport.x;
+    sy = 2.0f / u->viewport.y;
+#ifdef GFC_SIMD
+    r0 = gfc_f4_load(u->invViewProj[0]);
+    r1 = gfc_f4_load(u->invViewProj[1]);
+    r2 = gfc_f4_load(u->invViewProj[2]);
+    r3 = gfc_f4_load(u->invViewProj[3]);
+    for (i = 0; i < n; i++)
+    {
+        o = gfc_f4_add(
+            gfc_f4_add(gfc_f4_mul(gfc_f4_set1(in[i].x * sx - 1),r0),gfc_f4_mul(gfc_f4_set1(1 - in[i].y * sy),r1)),
+            gfc_f4_add(gfc_f4_mul(gfc_f4_set1(2.0f * in[i].z - 1),r2),r3));
+        gfc_f4_store(temp,o);
+        if (temp[3] == 0)
+        {
+            out[i] = vector3d(0,0,0);
+            continue;
+        }
+        out[i] = vector3d(temp[0] / temp[3],temp[1] / temp[3],temp[2] / temp[3]);
+    }
+#else
+    for (i = 0; i < n; i++)
+    {
+        gfc_matrix_v_multiply_M(&world,u->invViewProj,vector4d(in[i].x * sx - 1,1 - in[i].y * sy,2.0f * in[i].z - 1,1));
+        if (world.w == 0)
+        {
+            out[i] = vector3d(0,0,0);
+            continue;
+        }
+        out[i] = vector3d(world.x / world.w,world.y / world.w,world.z / world.w);
+    }
+#endif
 }
 
 void gfc_matrix4_slog(Matrix4 mat)
@@ -219,8 +361,77 @@ Uint8 gfc_matrix16_invert(float m[16], float invOut[16])
 }
 
 
+#ifdef GFC_SIMD_SSE
+/*
+ * blockwise inverse: the matrix is split into 2x2 sub matrices A B / C D, each held row major in one register
+ * see "Fast 4x4 Matrix Inverse with SSE SIMD, Explained" by Eric Zhang
+ */
+#define gfc_sse_mask(x,y,z,w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define gfc_sse_swizzle(v,x,y,z,w) _mm_shuffle_ps(v,v,gfc_sse_mask(x,y,z,w))
+#define gfc_sse_shuffle(a,b,x,y,z,w) _mm_shuffle_ps(a,b,gfc_sse_mask(x,y,z,w))
+
+/*2x2 A * B*/
+static inline __m128 gfc_sse_mat2_mul(__m128 a,__m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a,gfc_sse_swizzle(b,0,3,0,3)),_mm_mul_ps(gfc_sse_swizzle(a,1,0,3,2),gfc_sse_swizzle(b,2,1,2,1)));
+}
+
+/*2x2 adjugate(A) * B*/
+static inline __m128 gfc_sse_mat2_adj_mul(__m128 a,__m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(gfc_sse_swizzle(a,3,3,0,0),b),_mm_mul_ps(gfc_sse_swizzle(a,1,1,2,2),gfc_sse_swizzle(b,2,3,0,1)));
+}
+
+/*2x2 A * adjugate(B)*/
+static inline __m128 gfc_sse_mat2_mul_adj(__m128 a,__m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a,gfc_sse_swizzle(b,3,0,3,0)),_mm_mul_ps(gfc_sse_swizzle(a,1,0,3,2),gfc_sse_swizzle(b,2,1,2,1)));
+}
+#endif
+
 Uint8 gfc_matrix4_invert(Matrix4 mOut, Matrix4 mIn)
 {
+#ifdef GFC_SIMD_SSE
+    __m128 r0,r1,r2,r3,a,b,c,d,detSub,detA,detB,detC,detD,detM,dc,ab,x,y,z,w,tr;
+    r0 = _mm_loadu_ps(mIn[0]);
+    r1 = _mm_loadu_ps(mIn[1]);
+    r2 = _mm_loadu_ps(mIn[2]);
+    r3 = _mm_loadu_ps(mIn[3]);
+    a = _mm_movelh_ps(r0,r1);
+    b = _mm_movehl_ps(r1,r0);
+    c = _mm_movelh_ps(r2,r3);
+    d = _mm_movehl_ps(r3,r2);
+    //determinants of the sub matrices as (|A| |B| |C| |D|)
+    detSub = _mm_sub_ps(
+        _mm_mul_ps(gfc_sse_shuffle(r0,r2,0,2,0,2),gfc_sse_shuffle(r1,r3,1,3,1,3)),
+        _mm_mul_ps(gfc_sse_shuffle(r0,r2,1,3,1,3),gfc_sse_shuffle(r1,r3,0,2,0,2)));
+    detA = gfc_sse_swizzle(detSub,0,0,0,0);
+    detB = gfc_sse_swizzle(detSub,1,1,1,1);
+    detC = gfc_sse_swizzle(detSub,2,2,2,2);
+    detD = gfc_sse_swizzle(detSub,3,3,3,3);
+    dc = gfc_sse_mat2_adj_mul(d,c);
+    ab = gfc_sse_mat2_adj_mul(a,b);
+    x = _mm_sub_ps(_mm_mul_ps(detD,a),gfc_sse_mat2_mul(b,dc));
+    w = _mm_sub_ps(_mm_mul_ps(detA,d),gfc_sse_mat2_mul(c,ab));
+    y = _mm_sub_ps(_mm_mul_ps(detB,c),gfc_sse_mat2_mul_adj(d,ab));
+    z = _mm_sub_ps(_mm_mul_ps(detC,b),gfc_sse_mat2_mul_adj(a,dc));
+    //|M| = |A||D| + |B||C| - tr(A#B D#C)
+    tr = _mm_mul_ps(ab,gfc_sse_swizzle(dc,0,2,1,3));
+    tr = _mm_add_ps(tr,gfc_sse_swizzle(tr,1,0,3,2));
+    tr = _mm_add_ps(tr,gfc_sse_swizzle(tr,2,3,0,1));
+    detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA,detD),_mm_mul_ps(detB,detC)),tr);
+    if (_mm_cvtss_f32(detM) == 0)return 0;
+    detM = _mm_div_ps(_mm_setr_ps(1.f,-1.f,-1.f,1.f),detM);
+    x = _mm_mul_ps(x,detM);
+    y = _mm_mul_ps(y,detM);
+    z = _mm_mul_ps(z,detM);
+    w = _mm_mul_ps(w,detM);
+    _mm_storeu_ps(mOut[0],gfc_sse_shuffle(x,y,3,1,3,1));
+    _mm_storeu_ps(mOut[1],gfc_sse_shuffle(x,y,2,0,2,0));
+    _mm_storeu_ps(mOut[2],gfc_sse_shuffle(z,w,3,1,3,1));
+    _mm_storeu_ps(mOut[3],gfc_sse_shuffle(z,w,2,0,2,0));
+    return 1;
+#else
     float m[16];
     gfc_matrix4_to_matrix16(m,mIn);
     
@@ -230,6 +441,7 @@ Uint8 gfc_matrix4_invert(Matrix4 mOut, Matrix4 mIn)
     //gfc_matrix4_transpose(mOut);
 
     return 1;
+#endif
 }
 
 
@@ -246,6 +458,11 @@ void gfc_matrix_copy(
 
 void gfc_matrix_multiply_scalar(Matrix4 out,Matrix4 m1,float s)
 {
+#ifdef GFC_SIMD
+  gfc_f4 scale = gfc_f4_set1(s);
+  int i;
+  for (i = 0; i < 4; i++)gfc_f4_store(out[i],gfc_f4_mul(gfc_f4_load(m1[i]),scale));
+#else
     Matrix4 temp;
   temp[0][0] = s*m1[0][0];
   temp[0][1] = s*m1[0][1];
@@ -267,6 +484,7 @@ void gfc_matrix_multiply_scalar(Matrix4 out,Matrix4 m1,float s)
   temp[3][2] = s*m1[3][2];
   temp[3][3] = s*m1[3][3];
   gfc_matrix_copy(out,temp);
+#endif
 }
 
 
@@ -276,6 +494,22 @@ void gfc_matrix_multiply(
     Matrix4 m1
   )
 {
+#ifdef GFC_SIMD
+  gfc_f4 r0,r1,r2,r3,o[4];
+  int i;
+  r0 = gfc_f4_load(m1[0]);
+  r1 = gfc_f4_load(m1[1]);
+  r2 = gfc_f4_load(m1[2]);
+  r3 = gfc_f4_load(m1[3]);
+  //each row of the result is a blend of the rows of m1
+  for (i = 0; i < 4; i++)
+  {
+    o[i] = gfc_f4_add(
+      gfc_f4_add(gfc_f4_mul(gfc_f4_set1(m2[i][0]),r0),gfc_f4_mul(gfc_f4_set1(m2[i][1]),r1)),
+      gfc_f4_add(gfc_f4_mul(gfc_f4_set1(m2[i][2]),r2),gfc_f4_mul(gfc_f4_set1(m2[i][3]),r3)));
+  }
+  for (i = 0; i < 4; i++)gfc_f4_store(out[i],o[i]);
+#else
   Matrix4 out1;
   out1[0][0] = m2[0][0]*m1[0][0] + m2[0][1]*m1[1][0] + m2[0][2]*m1[2][0] + m2[0][3]*m1[3][0];
   out1[0][1] = m2[0][0]*m1[0][1] + m2[0][1]*m1[1][1] + m2[0][2]*m1[2][1] + m2[0][3]*m1[3][1];
@@ -297,6 +531,7 @@ void gfc_matrix_multiply(
   out1[3][2] = m2[3][0]*m1[0][2] + m2[3][1]*m1[1][2] + m2[3][2]*m1[2][2] + m2[3][3]*m1[3][2];
   out1[3][3] = m2[3][0]*m1[0][3] + m2[3][1]*m1[1][3] + m2[3][2]*m1[2][3] + m2[3][3]*m1[3][3];
   gfc_matrix_copy(out,out1);
+#endif
 }
 
 void gfc_matrix_v_multiply_M(
@@ -305,6 +540,14 @@ void gfc_matrix_v_multiply_M(
   Vector4D   vec
 )
 {
+#ifdef GFC_SIMD
+  gfc_f4 o;
+  if (!out)return;
+  o = gfc_f4_add(
+    gfc_f4_add(gfc_f4_mul(gfc_f4_set1(vec.x),gfc_f4_load(mat[0])),gfc_f4_mul(gfc_f4_set1(vec.y),gfc_f4_load(mat[1]))),
+    gfc_f4_add(gfc_f4_mul(gfc_f4_set1(vec.z),gfc_f4_load(mat[2])),gfc_f4_mul(gfc_f4_set1(vec.w),gfc_f4_load(mat[3]))));
+  gfc_f4_store(&out->x,o);
+#else
   float x,y,z,w;
   float ox,oy,oz,ow;
   if (!out)return;
@@ -320,6 +563,7 @@ void gfc_matrix_v_multiply_M(
   out->y = oy;
   out->z = oz;
   out->w = ow;
+#endif
 }
 
 
@@ -329,6 +573,17 @@ void gfc_matrix_M_multiply_v(
   Vector4D   vec
 )
 {
+#ifdef GFC_SIMD
+  gfc_f4 v;
+  if (!out)return;
+  v = gfc_f4_load(&vec.x);
+  //each component is the dot product of a row with the vector
+  gfc_f4_store(&out->x,gfc_f4_hsum4(
+    gfc_f4_mul(gfc_f4_load(mat[0]),v),
+    gfc_f4_mul(gfc_f4_load(mat[1]),v),
+    gfc_f4_mul(gfc_f4_load(mat[2]),v),
+    gfc_f4_mul(gfc_f4_load(mat[3]),v)));
+#else
   float x,y,z,w;
   float ox,oy,oz,ow;
   if (!out)return;
@@ -344,6 +599,51 @@ void gfc_matrix_M_multiply_v(
   out->y = oy;
   out->z = oz;
   out->w = ow;
+#endif
+}
+
+void gfc_matrix_transform_points(
+    Matrix4 mat,
+    Vector3D *in,
+    Vector3D *out,
+    Uint32 n
+)
+{
+  Uint32 i;
+#ifdef GFC_SIMD
+  gfc_f4 r0,r1,r2,r3,o;
+  float temp[4];
+#else
+  float x,y,z;
+#endif
+  if ((!in)||(!out))return;
+#ifdef GFC_SIMD
+  r0 = gfc_f4_load(mat[0]);
+  r1 = gfc_f4_load(mat[1]);
+  r2 = gfc_f4_load(mat[2]);
+  r3 = gfc_f4_load(mat[3]);
+  for (i = 0; i < n; i++)
+  {
+    o = gfc_f4_add(
+      gfc_f4_add(gfc_f4_mul(gfc_f4_set1(in[i].x),r0),gfc_f4_mul(gfc_f4_set1(in[i].y),r1)),
+      gfc_f4_add(gfc_f4_mul(gfc_f4_set1(in[i].z),r2),r3));
+    //Vector3D is 12 bytes, a 16 byte store would run past the last point
+    gfc_f4_store(temp,o);
+    out[i].x = temp[0];
+    out[i].y = temp[1];
+    out[i].z = temp[2];
+  }
+#else
+  for (i = 0; i < n; i++)
+  {
+    x = in[i].x;
+    y = in[i].y;
+    z = in[i].z;
+    out[i].x = x*mat[0][0] + y*mat[1][0] + z*mat[2][0] + mat[3][0];
+    out[i].y = x*mat[0][1] + y*mat[1][1] + z*mat[2][1] + mat[3][1];
+    out[i].z = x*mat[0][2] + y*mat[1][2] + z*mat[2][2] + mat[3][2];
+  }
+#endif
 }
 
 
@@ -1,3 +1,11 @@
+#include <math.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_simd.h"
+#include "gfc_random.h"
+#include "gfc_jobs.h"
 #include "gfc_noise.h"
 
 float interpolate(float a0, float a1, float w)
@@ -66,3 +74,555 @@ float gfc_perlin(Vector2D in)
     value = interpolate(ix0, ix1, sy);
     return value; // Will return in range -1 to 1. To make it in range 0 to 1, multiply by 0.5 and add 0.5
 }
+
+#define GFC_NOISE_SQRT2 1.41421356f     /**<2D gradient noise only reaches 1/sqrt(2) with unit gradients*/
+#define GFC_NOISE_ROWS_PER_TASK 8
+
+//unit vectors every 22.5 degrees
+static const float gfc_noise_grad2[16][2] =
+{
+    { 1.0f, 0.0f},{ 0.92387953f, 0.38268343f},{ 0.70710678f, 0.70710678f},{ 0.38268343f, 0.92387953f},
+    { 0.0f, 1.0f},{-0.38268343f, 0.92387953f},{-0.70710678f, 0.70710678f},{-0.92387953f, 0.38268343f},
+    {-1.0f, 0.0f},{-0.92387953f,-0.38268343f},{-0.70710678f,-0.70710678f},{-0.38268343f,-0.92387953f},
+    { 0.0f,-1.0f},{ 0.38268343f,-0.92387953f},{ 0.70710678f,-0.70710678f},{ 0.92387953f,-0.38268343f}
+};
+
+//the twelve cube edge directions, with four repeated to make sixteen, as improved perlin noise does
+static const float gfc_noise_grad3[16][3] =
+{
+    { 1, 1, 0},{-1, 1, 0},{ 1,-1, 0},{-1,-1, 0},
+    { 1, 0, 1},{-1, 0, 1},{ 1, 0,-1},{-1, 0,-1},
+    { 0, 1, 1},{ 0,-1, 1},{ 0, 1,-1},{ 0,-1,-1},
+    { 1, 1, 0},{ 0,-1, 1},{-1, 1, 0},{ 0,-1,-1}
+};
+
+typedef struct
+{
+    Uint32 seed;
+    Uint32 periodX,periodY,periodZ;
+    float frequency;
+    float amplitude;
+}GFC_NoiseOctave;
+
+/**
+ * @brief the gradients of two neighboring lattice rows, for the lattice columns a row of samples crosses
+ */
+typedef struct
+{
+    float  *rows[2];    /**<gradients of lattice rows row and row + 1, two floats per column*/
+    Uint32  capacity;   /**<lattice columns there is room for*/
+    Sint32  start;      /**<first lattice column*/
+    Sint32  row;
+    Uint8   valid;
+}GFC_NoiseRowCache;
+
+typedef struct
+{
+    float *out;
+    Uint32 w,h,d;
+    float ox,oy,oz;
+    float scale;
+    Uint8 legacy;       /**<gfc_perlin's gradients and linear weights*/
+    Uint8 ridged;
+    Uint32 octaveCount;
+    GFC_NoiseOctave octaves[GFC_NOISE_MAX_OCTAVES];
+    float norm;         /**<one over the total amplitude*/
+    SDL_atomic_t nextRow;
+}GFC_NoiseFill;
+
+static inline Sint32 gfc_noise_wrap(Sint32 i,Uint32 period)
+{
+    if (!period)return i;
+    i %= (Sint32)period;
+    if (i < 0)i += period;
+    return i;
+}
+
+/**
+ * @brief floor to an int without a libm call, the same as (int)floor(x) for anything an int can hold
+ */
+static inline Sint32 gfc_noise_floor(float x)
+{
+    Sint32 i = (Sint32)x;
+    return i - (x < (float)i);
+}
+
+static inline float gfc_noise_fade(float t)
+{
+    return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+static inline const float *gfc_noise_gradient2(const GFC_NoiseOctave *o,Sint32 ix,Sint32 iy)
+{
+    return gfc_noise_grad2[gfc_random_hash3(gfc_noise_wrap(ix,o->periodX),gfc_noise_wrap(iy,o->periodY),0,o->seed) & 15];
+}
+
+static Uint32 gfc_noise_setup_octaves(const gfcNoiseParams *params,GFC_NoiseOctave *octaves,float *norm)
+{
+    Uint32 i,count;
+    float frequency = 1,amplitude = 1,total = 0;
+    count = params->octaves;
+    if (!count)count = 1;
+    if (count > GFC_NOISE_MAX_OCTAVES)count = GFC_NOISE_MAX_OCTAVES;
+    for (i = 0; i < count; i++)
+    {
+        octaves[i].seed = params->seed + i * 0x9e3779b9u;
+        octaves[i].periodX = (Uint32)(params->periodX * frequency + 0.5f);
+        octaves[i].periodY = (Uint32)(params->periodY * frequency + 0.5f);
+        octaves[i].periodZ = (Uint32)(params->periodZ * frequency + 0.5f);
+        octaves[i].frequency = frequency;
+        octaves[i].amplitude = amplitude;
+        total += amplitude;
+        frequency *= params->lacunarity;
+        amplitude *= params->gain;
+    }
+    *norm = total > 0 ? 1 / total : 1;
+    return count;
+}
+
+static float gfc_noise_octave2(const GFC_NoiseOctave *o,float x,float y)
+{
+    Sint32 ix = gfc_noise_floor(x),iy = gfc_noise_floor(y);
+    float dx0 = x - (float)ix,dx1 = x - (float)(ix + 1);
+    float dy0 = y - (float)iy,dy1 = y - (float)(iy + 1);
+    float u = gfc_noise_fade(dx0),v = gfc_noise_fade(dy0);
+    const float *g00,*g10,*g01,*g11;
+    float n00,n10,n01,n11,a,b;
+    g00 = gfc_noise_gradient2(o,ix,iy);
+    g10 = gfc_noise_gradient2(o,ix + 1,iy);
+    g01 = gfc_noise_gradient2(o,ix,iy + 1);
+    g11 = gfc_noise_gradient2(o,ix + 1,iy + 1);
+    n00 = g00[0] * dx0 + g00[1] * dy0;
+    n10 = g10[0] * dx1 + g10[1] * dy0;
+    n01 = g01[0] * dx0 + g01[1] * dy1;
+    n11 = g11[0] * dx1 + g11[1] * dy1;
+    a = (n10 - n00) * u + n00;
+    b = (n11 - n01) * u + n01;
+    return ((b - a) * v + a) * GFC_NOISE_SQRT2;
+}
+
+static float gfc_noise_octave3(const GFC_NoiseOctave *o,float x,float y,float z)
+{
+    Sint32 ix = gfc_noise_floor(x),iy = gfc_noise_floor(y),iz = gfc_noise_floor(z);
+    Sint32 cx,cy,cz;
+    float d[2][3];
+    float corner[8];
+    float u,v,w,a,b,c,e;
+    const float *g;
+    int i;
+    d[0][0] = x - (float)ix;
+    d[0][1] = y - (float)iy;
+    d[0][2] = z - (float)iz;
+    d[1][0] = d[0][0] - 1;
+    d[1][1] = d[0][1] - 1;
+    d[1][2] = d[0][2] - 1;
+    for (i = 0; i < 8; i++)
+    {
+        cx = i & 1;
+        cy = (i >> 1) & 1;
+        cz = i >> 2;
+        g = gfc_noise_grad3[gfc_random_hash3(
+            gfc_noise_wrap(ix + cx,o->periodX),
+            gfc_noise_wrap(iy + cy,o->periodY),
+            gfc_noise_wrap(iz + cz,o->periodZ),o->seed) & 15];
+        corner[i] = g[0] * d[cx][0] + g[1] * d[cy][1] + g[2] * d[cz][2];
+    }
+    u = gfc_noise_fade(d[0][0]);
+    v = gfc_noise_fade(d[0][1]);
+    w = gfc_noise_fade(d[0][2]);
+    a = (corner[1] - corner[0]) * u + corner[0];
+    b = (corner[3] - corner[2]) * u + corner[2];
+    c = (corner[5] - corner[4]) * u + corner[4];
+    e = (corner[7] - corner[6]) * u + corner[6];
+    a = (b - a) * v + a;
+    c = (e - c) * v + c;
+    return (c - a) * w + a;
+}
+
+static inline float gfc_noise_shape(float n,Uint8 ridged)
+{
+    if (!ridged)return n;
+    n = 1 - fabsf(n);
+    return n * n;
+}
+
+gfcNoiseParams gfc_noise_params(Uint32 seed,Uint32 octaves)
+{
+    gfcNoiseParams params = {0};
+    params.seed = seed;
+    params.octaves = octaves;
+    params.lacunarity = 2;
+    params.gain = 0.5;
+    params.fractal = GFC_NF_FBM;
+    return params;
+}
+
+float gfc_noise2(Uint32 seed,Vector2D in)
+{
+    GFC_NoiseOctave o = {0};
+    o.seed = seed;
+    return gfc_noise_octave2(&o,in.x,in.y);
+}
+
+float gfc_noise3(Uint32 seed,Vector3D in)
+{
+    GFC_NoiseOctave o = {0};
+    o.seed = seed;
+    return gfc_noise_octave3(&o,in.x,in.y,in.z);
+}
+
+float gfc_noise_fractal2(const gfcNoiseParams *params,Vector2D in)
+{
+    GFC_NoiseOctave octaves[GFC_NOISE_MAX_OCTAVES];
+    Uint32 i,count;
+    float norm,value = 0;
+    Uint8 ridged;
+    if (!params)return 0;
+    count = gfc_noise_setup_octaves(params,octaves,&norm);
+    ridged = params->fractal == GFC_NF_RIDGED;
+    for (i = 0; i < count; i++)
+    {
+        value += gfc_noise_shape(gfc_noise_octave2(&octaves[i],in.x * octaves[i].frequency,in.y * octaves[i].frequency),ridged) * octaves[i].amplitude;
+    }
+    return value * norm;
+}
+
+float gfc_noise_fractal3(const gfcNoiseParams *params,Vector3D in)
+{
+    GFC_NoiseOctave octaves[GFC_NOISE_MAX_OCTAVES];
+    Uint32 i,count;
+    float norm,value = 0,f;
+    Uint8 ridged;
+    if (!params)return 0;
+    count = gfc_noise_setup_octaves(params,octaves,&norm);
+    ridged = params->fractal == GFC_NF_RIDGED;
+    for (i = 0; i < count; i++)
+    {
+        f = octaves[i].frequency;
+        value += gfc_noise_shape(gfc_noise_octave3(&octaves[i],in.x * f,in.y * f,in.z * f),ridged) * octaves[i].amplitude;
+    }
+    return value * norm;
+}
+
+//grid fill section
+
+static void gfc_noise_lattice_row(GFC_NoiseFill *fill,const GFC_NoiseOctave *o,float *out,Sint32 start,Uint32 count,Sint32 iy)
+{
+    Uint32 i;
+    Vector2D g;
+    const float *t;
+    for (i = 0; i < count; i++)
+    {
+        if (fill->legacy)
+        {
+            g = randomGradient(start + i,iy);
+            out[i * 2] = g.x;
+            out[i * 2 + 1] = g.y;
+            continue;
+        }
+        t = gfc_noise_gradient2(o,start + i,iy);
+        out[i * 2] = t[0];
+        out[i * 2 + 1] = t[1];
+    }
+}
+
+/**
+ * @brief get the four corner gradients for a sample, from the row cache if it covers them
+ */
+static inline void gfc_noise_corners(GFC_NoiseFill *fill,const GFC_NoiseOctave *o,GFC_NoiseRowCache *cache,Sint32 ix,Sint32 iy,float g[8])
+{
+    const float *c;
+    Vector2D v;
+    int i;
+    if (cache->valid)
+    {
+        c = cache->rows[0] + (ix - cache->start) * 2;
+        g[0] = c[0];
+        g[1] = c[1];
+        g[2] = c[2];
+        g[3] = c[3];
+        c = cache->rows[1] + (ix - cache->start) * 2;
+        g[4] = c[0];
+        g[5] = c[1];
+        g[6] = c[2];
+        g[7] = c[3];
+        return;
+    }
+    for (i = 0; i < 4; i++)
+    {
+        if (fill->legacy)
+        {
+            v = randomGradient(ix + (i & 1),iy + (i >> 1));
+            g[i * 2] = v.x;
+            g[i * 2 + 1] = v.y;
+            continue;
+        }
+        c = gfc_noise_gradient2(o,ix + (i & 1),iy + (i >> 1));
+        g[i * 2] = c[0];
+        g[i * 2 + 1] = c[1];
+    }
+}
+
+/**
+ * @brief make one row of one octave of noise
+ */
+static void gfc_noise_row2(GFC_NoiseFill *fill,const GFC_NoiseOctave *o,GFC_NoiseRowCache *cache,float *out,float ox,float scale,float y)
+{
+    Uint32 i = 0,w = fill->w;
+    Sint32 iy,lo,hi;
+    float first,last,dy0,dy1,v;
+    float x,g[8];
+    float *swap;
+#ifdef GFC_SIMD
+    Uint32 k;
+    GFC_ALIGN16_PRE float xs[4],x0[4],x1[4],gx[4][4],gy[4][4] GFC_ALIGN16_POST;
+    gfc_f4 vx,dx0,dx1,vdy0,vdy1,vv,u,n00,n10,n01,n11,a,b,six,fifteen,ten,sqrt2;
+#endif
+    Sint32 ix;
+    float dx,du,n[4],a1,b1;
+
+    iy = gfc_noise_floor(y);
+    dy0 = y - (float)iy;
+    dy1 = y - (float)(iy + 1);
+    v = fill->legacy ? dy0 : gfc_noise_fade(dy0);
+    //the lattice columns this row crosses, only worth caching if samples share them
+    first = ox;
+    last = ox + (float)(w - 1) * scale;
+    lo = gfc_noise_floor(MIN(first,last));
+    hi = gfc_noise_floor(MAX(first,last)) + 1;
+    if ((cache->capacity)&&((Uint32)(hi - lo + 1) <= cache->capacity))
+    {
+        if ((!cache->valid)||(cache->start != lo)||((iy != cache->row)&&(iy != cache->row + 1)))
+        {
+            gfc_noise_lattice_row(fill,o,cache->rows[0],lo,hi - lo + 1,iy);
+            gfc_noise_lattice_row(fill,o,cache->rows[1],lo,hi - lo + 1,iy + 1);
+        }
+        else if (iy == cache->row + 1)
+        {
+            //moved down one lattice row, the old bottom row is the new top
+            swap = cache->rows[0];
+            cache->rows[0] = cache->rows[1];
+            cache->rows[1] = swap;
+            gfc_noise_lattice_row(fill,o,cache->rows[1],lo,hi - lo + 1,iy + 1);
+        }
+        cache->start = lo;
+        cache->row = iy;
+        cache->valid = 1;
+    }
+    else cache->valid = 0;
+#ifdef GFC_SIMD
+    vdy0 = gfc_f4_set1(dy0);
+    vdy1 = gfc_f4_set1(dy1);
+    vv = gfc_f4_set1(v);
+    six = gfc_f4_set1(6);
+    fifteen = gfc_f4_set1(15);
+    ten = gfc_f4_set1(10);
+    sqrt2 = gfc_f4_set1(GFC_NOISE_SQRT2);
+    for (; i + 4 <= w; i += 4)
+    {
+        for (k = 0; k < 4; k++)
+        {
+            xs[k] = ox + (float)(i + k) * scale;
+            ix = gfc_noise_floor(xs[k]);
+            x0[k] = (float)ix;
+            x1[k] = (float)(ix + 1);
+            gfc_noise_corners(fill,o,cache,ix,iy,g);
+            gx[0][k] = g[0];
+            gy[0][k] = g[1];
+            gx[1][k] = g[2];
+            gy[1][k] = g[3];
+            gx[2][k] = g[4];
+            gy[2][k] = g[5];
+            gx[3][k] = g[6];
+            gy[3][k] = g[7];
+        }
+        vx = gfc_f4_load(xs);
+        dx0 = gfc_f4_sub(vx,gfc_f4_load(x0));
+        dx1 = gfc_f4_sub(vx,gfc_f4_load(x1));
+        n00 = gfc_f4_add(gfc_f4_mul(gfc_f4_load(gx[0]),dx0),gfc_f4_mul(gfc_f4_load(gy[0]),vdy0));
+        n10 = gfc_f4_add(gfc_f4_mul(gfc_f4_load(gx[1]),dx1),gfc_f4_mul(gfc_f4_load(gy[1]),vdy0));
+        n01 = gfc_f4_add(gfc_f4_mul(gfc_f4_load(gx[2]),dx0),gfc_f4_mul(gfc_f4_load(gy[2]),vdy1));
+        n11 = gfc_f4_add(gfc_f4_mul(gfc_f4_load(gx[3]),dx1),gfc_f4_mul(gfc_f4_load(gy[3]),vdy1));
+        if (fill->legacy)u = dx0;
+        else u = gfc_f4_mul(gfc_f4_mul(gfc_f4_mul(dx0,dx0),dx0),
+            gfc_f4_add(gfc_f4_mul(dx0,gfc_f4_sub(gfc_f4_mul(dx0,six),fifteen)),ten));
+        a = gfc_f4_add(gfc_f4_mul(gfc_f4_sub(n10,n00),u),n00);
+        b = gfc_f4_add(gfc_f4_mul(gfc_f4_sub(n11,n01),u),n01);
+        a = gfc_f4_add(gfc_f4_mul(gfc_f4_sub(b,a),vv),a);
+        if (!fill->legacy)a = gfc_f4_mul(a,sqrt2);
+        gfc_f4_store(out + i,a);
+    }
+#endif
+    for (; i < w; i++)
+    {
+        x = ox + (float)i * scale;
+        ix = gfc_noise_floor(x);
+        dx = x - (float)ix;
+        gfc_noise_corners(fill,o,cache,ix,iy,g);
+        n[0] = g[0] * dx + g[1] * dy0;
+        n[1] = g[2] * (x - (float)(ix + 1)) + g[3] * dy0;
+        n[2] = g[4] * dx + g[5] * dy1;
+        n[3] = g[6] * (x - (float)(ix + 1)) + g[7] * dy1;
+        du = fill->legacy ? dx : gfc_noise_fade(dx);
+        a1 = (n[1] - n[0]) * du + n[0];
+        b1 = (n[3] - n[2]) * du + n[2];
+        a1 = (b1 - a1) * v + a1;
+        out[i] = fill->legacy ? a1 : a1 * GFC_NOISE_SQRT2;
+    }
+}
+
+static void gfc_noise_fill_worker(void *data)
+{
+    GFC_NoiseFill *fill = data;
+    GFC_NoiseRowCache caches[GFC_NOISE_MAX_OCTAVES];
+    GFC_NoiseOctave *o;
+    float *block,*row,*out;
+    float y,f;
+    Uint32 first,r,end,i,n,columns;
+    columns = fill->w + 2;
+    //a scratch row, then two lattice rows of gradients per octave
+    block = gfc_allocate_array(sizeof(float),fill->w + fill->octaveCount * columns * 4);
+    if (!block)return;
+    row = block;
+    for (n = 0; n < fill->octaveCount; n++)
+    {
+        caches[n].rows[0] = block + fill->w + n * columns * 4;
+        caches[n].rows[1] = caches[n].rows[0] + columns * 2;
+        caches[n].capacity = columns;
+        caches[n].valid = 0;
+    }
+    while ((first = (Uint32)SDL_AtomicAdd(&fill->nextRow,GFC_NOISE_ROWS_PER_TASK)) < fill->h)
+    {
+        end = MIN(first + GFC_NOISE_ROWS_PER_TASK,fill->h);
+        for (r = first; r < end; r++)
+        {
+            y = fill->oy + (float)r * fill->scale;
+            out = fill->out + (size_t)r * fill->w;
+            if ((fill->octaveCount == 1)&&(!fill->ridged))
+            {
+                gfc_noise_row2(fill,&fill->octaves[0],&caches[0],out,fill->ox,fill->scale,y);
+                continue;
+            }
+            for (n = 0; n < fill->octaveCount; n++)
+            {
+                o = &fill->octaves[n];
+                f = o->frequency;
+                gfc_noise_row2(fill,o,&caches[n],row,fill->ox * f,fill->scale * f,y * f);
+                if (!n)
+                {
+                    for (i = 0; i < fill->w; i++)out[i] = gfc_noise_shape(row[i],fill->ridged) * o->amplitude;
+                    continue;
+                }
+                for (i = 0; i < fill->w; i++)out[i] += gfc_noise_shape(row[i],fill->ridged) * o->amplitude;
+            }
+            for (i = 0; i < fill->w; i++)out[i] *= fill->norm;
+        }
+    }
+    free(block);
+}
+
+static void gfc_noise_fill3_worker(void *data)
+{
+    GFC_NoiseFill *fill = data;
+    GFC_NoiseOctave *o;
+    float *out;
+    float x,y,z,f,value;
+    Uint32 first,r,end,i,n,rows;
+    rows = fill->h * fill->d;
+    while ((first = (Uint32)SDL_AtomicAdd(&fill->nextRow,GFC_NOISE_ROWS_PER_TASK)) < rows)
+    {
+        end = MIN(first + GFC_NOISE_ROWS_PER_TASK,rows);
+        for (r = first; r < end; r++)
+        {
+            y = fill->oy + (float)(r % fill->h) * fill->scale;
+            z = fill->oz + (float)(r / fill->h) * fill->scale;
+            out = fill->out + (size_t)r * fill->w;
+            for (i = 0; i < fill->w; i++)
+            {
+                x = fill->ox + (float)i * fill->scale;
+                value = 0;
+                for (n = 0; n < fill->octaveCount; n++)
+                {
+                    o = &fill->octaves[n];
+                    f = o->frequency;
+                    value += gfc_noise_shape(gfc_noise_octave3(o,x * f,y * f,z * f),fill->ridged) * o->amplitude;
+                }
+                out[i] = value * fill->norm;
+            }
+        }
+    }
+}
+
+/**
+ * @brief run a fill worker on this thread and as many more as asked for, each taking a few rows at a time
+ */
+static void gfc_noise_fill_run(GFC_NoiseFill *fill,Uint32 rows,Uint32 threads,gfc_work_func *worker)
+{
+    Uint32 tasks;
+    if (!threads)
+    {
+        threads = gfc_jobs_get_thread_count();
+        if (!threads)threads = SDL_GetCPUCount();
+        if (threads < 1)threads = 1;
+    }
+    tasks = (rows + GFC_NOISE_ROWS_PER_TASK - 1) / GFC_NOISE_ROWS_PER_TASK;
+    if (threads > tasks)threads = tasks;
+    SDL_AtomicSet(&fill->nextRow,0);
+    gfc_jobs_run_parallel(worker,fill,threads);
+    if ((Uint32)SDL_AtomicGet(&fill->nextRow) < rows)
+    {
+        slog("failed to allocate noise fill buffers, the fill is incomplete");
+    }
+}
+
+void gfc_perlin_fill(float *out,Uint32 w,Uint32 h,Vector2D origin,float scale)
+{
+    GFC_NoiseFill fill = {0};
+    if ((!out)||(!w)||(!h))return;
+    fill.out = out;
+    fill.w = w;
+    fill.h = h;
+    fill.ox = origin.x;
+    fill.oy = origin.y;
+    fill.scale = scale;
+    fill.legacy = 1;
+    fill.octaveCount = 1;
+    fill.octaves[0].frequency = 1;
+    fill.octaves[0].amplitude = 1;
+    fill.norm = 1;
+    gfc_noise_fill_run(&fill,h,1,gfc_noise_fill_worker);
+}
+
+void gfc_noise_fill(float *out,Uint32 w,Uint32 h,Vector2D origin,float scale,const gfcNoiseParams *params)
+{
+    GFC_NoiseFill fill = {0};
+    if ((!out)||(!w)||(!h)||(!params))return;
+    fill.out = out;
+    fill.w = w;
+    fill.h = h;
+    fill.ox = origin.x;
+    fill.oy = origin.y;
+    fill.scale = scale;
+    fill.ridged = params->fractal == GFC_NF_RIDGED;
+    fill.octaveCount = gfc_noise_setup_octaves(params,fill.octaves,&fill.norm);
+    gfc_noise_fill_run(&fill,h,params->threads,gfc_noise_fill_worker);
+}
+
+void gfc_noise_fill3(float *out,Uint32 w,Uint32 h,Uint32 d,Vector3D origin,float scale,const gfcNoiseParams *params)
+{
+    GFC_NoiseFill fill = {0};
+    if ((!out)||(!w)||(!h)||(!d)||(!params))return;
+    fill.out = out;
+    fill.w = w;
+    fill.h = h;
+    fill.d = d;
+    fill.ox = origin.x;
+    fill.oy = origin.y;
+    fill.oz = origin.z;
+    fill.scale = scale;
+    fill.ridged = params->fractal == GFC_NF_RIDGED;
+    fill.octaveCount = gfc_noise_setup_octaves(params,fill.octaves,&fill.norm);
+    gfc_noise_fill_run(&fill,h * d,params->threads,gfc_noise_fill3_worker);
+}
+
+/*eol@eof*/
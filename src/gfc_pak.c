@@ -1,29 +1,284 @@
+#include <ctype.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include "miniz.h"
 #include "simple_logger.h"
 #include "simple_json_parse.h"
 #include "gfc_text.h"
 #include "gfc_list.h"
+#include "gfc_deque.h"
+#include "gfc_hashmap.h"
+#include "gfc_callbacks.h"
+#include "gfc_profile.h"
 #include "gfc_pak.h"
 
+#define GFC_ZIP_LOCAL_HEADER_SIZE 30
+#define GFC_ZIP_LOCAL_HEADER_SIG 0x04034b50
+
+typedef enum
+{
+    GFC_PVT_Heap,       /**<extracted into a heap buffer*/
+    GFC_PVT_File,       /**<a loose file mapped on its own*/
+    GFC_PVT_Pak,        /**<a stored entry inside of a mapped pak*/
+    GFC_PVT_Cache       /**<a reference to an entry in the extraction cache*/
+}GFC_PakViewType;
+
+typedef struct
+{
+    const void *data;       /**<what was handed out*/
+    void *base;             /**<what must be released*/
+    size_t length;          /**<length of the mapping*/
+    GFC_PakViewType type;
+}GFC_PakView;
+
 typedef struct
 {
     TextLine filename;
     mz_zip_archive zipFile;
+    FILE *file;             /**<what zipFile reads from, kept open until the pak is retired*/
+    Uint8 *map;             /**<the whole pak mapped read only from the same descriptor, NULL if mapping is not supported*/
+    size_t mapSize;
+    Sint64 modified;        /**<when the pak last changed on disk, when it was opened*/
+    Sint64 diskSize;
 }GFC_PakFile;
 
+typedef struct
+{
+    GFC_PakFile *pakFile;
+    mz_uint index;          /**<file index within the archive*/
+}GFC_PakEntry;
+
+typedef struct GFC_PakCacheEntry_S
+{
+    TextLine key;                       /**<archive index key of the file*/
+    void *data;
+    size_t size;
+    Uint32 refCount;                    /**<views handed out, referenced entries are never evicted*/
+    Uint8 retired;                      /**<dropped from the cache while referenced, freed when released*/
+    struct GFC_PakCacheEntry_S *prev;   /**<least recently used list of unreferenced entries*/
+    struct GFC_PakCacheEntry_S *next;
+}GFC_PakCacheEntry;
+
+typedef struct
+{
+    HashMap *entries;           /**<archive index key to GFC_PakCacheEntry*/
+    GFC_PakCacheEntry *newest;  /**<most recently released unreferenced entry*/
+    GFC_PakCacheEntry *oldest;  /**<next to be evicted*/
+    size_t budget;              /**<0 means the cache is disabled*/
+    GFC_PakCacheStats stats;
+}GFC_PakCache;
+
+typedef struct
+{
+    GFC_PakFile *pakFile;   /**<the pak this reader has open*/
+    mz_zip_archive zipFile; /**<a reader private to one worker thread*/
+}GFC_PakReader;
+
+typedef struct
+{
+    SDL_Thread *thread;
+    gfcList *readers;       /**<GFC_PakReader *, opened as needed, miniz readers cannot be shared between threads*/
+}GFC_PakWorker;
+
+typedef struct
+{
+    Uint32 id;
+    GFC_PakLoadPriority priority;
+    Uint8 cancelled;
+    Uint8 loose;            /**<load from disk first*/
+    GFC_PakFile *pakFile;   /**<archive to fall back on, if any*/
+    mz_uint index;
+    GFC_PakLoadResult result;
+    void (*process)(GFC_PakLoadResult *result);    /**<run on the worker once the file is loaded, if set*/
+    Callback callback;
+}GFC_PakRequest;
+
+typedef struct
+{
+    SDL_mutex *lock;
+    SDL_cond *wake;
+    Uint8 quit;
+    Uint32 nextId;
+    Uint32 workerCount;
+    GFC_PakWorker *workers;
+    gfcDeque *pending[PLP_MAX]; /**<GFC_PakRequest * waiting for a worker, one first in first out queue per priority*/
+    gfcList *completed;         /**<GFC_PakRequest * waiting to be delivered on the main thread*/
+    gfcList *delivering;        /**<swapped with completed while delivering, so workers never wait on callbacks*/
+    gfcList *requests;          /**<every request not yet delivered, for cancelling*/
+    Uint8 polling;              /**<callbacks are being delivered*/
+}GFC_PakAsync;
+
+typedef struct
+{
+    Uint8 loose;            /**<a file on disk overrides the archives*/
+    GFC_PakEntry *entry;    /**<the archive entry, if any*/
+}GFC_PakLookup;
+
 typedef struct
 {
     gfcList *pak_files;
+    gfcList *retired;       /**<GFC_PakFile * replaced by gfc_pak_manager_refresh(), mappings into them may still be in use*/
+    gfcList *views;         /**<GFC_PakView * for everything handed out by gfc_pak_file_map*/
+    HashMap *archive_index; /**<lower case path to GFC_PakEntry, the first pak added that has the file wins*/
+    HashMap *lookups;       /**<exact path as requested to GFC_PakLookup, includes misses*/
 }GFC_PakManager;
 
 static GFC_PakManager pak_manager = {0};
+static GFC_PakAsync pak_async = {0};
+static GFC_PakCache pak_cache = {0};
 
 void gfc_pak_file_free(GFC_PakFile *pakFile);
 GFC_PakFile *gfc_pak_file_new();
+void *gfc_pak_load_file_from_disk(const char *filename,size_t *fileSize);
+
 
+static void gfc_pak_manager_clear_lookups()
+{
+    if (!pak_manager.lookups)return;
+    gfc_hashmap_foreach(pak_manager.lookups,free);
+    gfc_hashmap_free(pak_manager.lookups);
+    pak_manager.lookups = NULL;
+}
+
+static void gfc_pak_manager_clear_index()
+{
+    gfc_pak_manager_clear_lookups();
+    if (!pak_manager.archive_index)return;
+    gfc_hashmap_foreach(pak_manager.archive_index,free);
+    gfc_hashmap_free(pak_manager.archive_index);
+    pak_manager.archive_index = NULL;
+}
+
+/**
+ * @brief archive paths are matched case insensitively, same as mz_zip_reader_locate_file
+ */
+static void gfc_pak_index_key(TextLine key,const char *filename)
+{
+    int i;
+    for (i = 0;(filename[i] != 0)&&(i < GFCLINELEN - 1);i++)
+    {
+        key[i] = tolower((unsigned char)filename[i]);
+    }
+    key[i] = 0;
+}
+
+/**
+ * @brief add all of the files in a pak to the archive index.  Files already indexed from an earlier pak are kept.
+ */
+static void gfc_pak_manager_index_pak(GFC_PakFile *pakFile)
+{
+    mz_uint i,c;
+    TextLine name,key;
+    GFC_PakEntry *entry;
+    if (!pakFile)return;
+    if (!pak_manager.archive_index)
+    {
+        pak_manager.archive_index = gfc_hashmap_new_size(mz_zip_reader_get_num_files(&pakFile->zipFile));
+        if (!pak_manager.archive_index)return;
+    }
+    c = mz_zip_reader_get_num_files(&pakFile->zipFile);
+    for (i = 0; i < c; i++)
+    {
+        if (mz_zip_reader_is_file_a_directory(&pakFile->zipFile,i))continue;
+        if (!mz_zip_reader_get_filename(&pakFile->zipFile,i,name,GFCLINELEN))continue;
+        gfc_pak_index_key(key,name);
+        if (gfc_hashmap_get(pak_manager.archive_index,key))continue;//overridden by an earlier pak
+        entry = gfc_allocate_array(sizeof(GFC_PakEntry),1);
+        if (!entry)return;
+        entry->pakFile = pakFile;
+        entry->index = i;
+        gfc_hashmap_insert(pak_manager.archive_index,key,entry);
+    }
+    //anything we cached a miss for may be in here now
+    gfc_pak_manager_clear_lookups();
+}
+
+void gfc_pak_manager_invalidate()
+{
+    int i,c;
+    gfc_pak_manager_clear_index();
+    c = gfc_list_get_count(pak_manager.pak_files);
+    for (i = 0; i < c; i++)
+    {
+        gfc_pak_manager_index_pak(gfc_list_get_nth(pak_manager.pak_files,i));
+    }
+}
+
+/**
+ * @brief get when a file on disk last changed
+ * @return 0 if it is not a regular file, 1 otherwise
+ */
+static Uint8 gfc_pak_stat_stamp(const struct stat *st,Sint64 *modified,Sint64 *size)
+{
+    if ((st->st_mode & S_IFMT) != S_IFREG)return 0;
+    if (modified)
+    {
+#ifdef __linux__
+        *modified = (Sint64)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+#else
+        *modified = (Sint64)st->st_mtime * 1000000000;
+#endif
+    }
+    if (size)*size = st->st_size;
+    return 1;
+}
+
+static Uint8 gfc_pak_disk_stamp(const char *filename,Sint64 *modified,Sint64 *size)
+{
+    struct stat st;
+    if (stat(filename,&st) != 0)return 0;
+    return gfc_pak_stat_stamp(&st,modified,size);
+}
+
+static void *gfc_pak_map_descriptor(int fd,size_t *length);
+
+static Uint8 gfc_pak_loose_file_exists(const char *filename)
+{
+    Sint64 size;
+    if (!gfc_pak_disk_stamp(filename,NULL,&size))return 0;
+    if (size <= 0)return 0;//empty overrides are ignored, same as loading them
+    return 1;
+}
+
+/**
+ * @brief find where a file should come from.  The answer is cached, including misses, until the next invalidate
+ * @return NULL if out of memory, the resolved lookup otherwise
+ */
+static GFC_PakLookup *gfc_pak_manager_resolve(const char *filename)
+{
+    TextLine key;
+    GFC_PakLookup *lookup;
+    if (!pak_manager.lookups)
+    {
+        pak_manager.lookups = gfc_hashmap_new_size(256);
+        if (!pak_manager.lookups)return NULL;
+    }
+    lookup = gfc_hashmap_get(pak_manager.lookups,filename);
+    if (lookup)return lookup;
+    lookup = gfc_allocate_array(sizeof(GFC_PakLookup),1);
+    if (!lookup)return NULL;
+    //loose files on disk take precedence over every pak, then paks in the order they were added
+    lookup->loose = gfc_pak_loose_file_exists(filename);
+    if (pak_manager.archive_index)
+    {
+        gfc_pak_index_key(key,filename);
+        lookup->entry = gfc_hashmap_get(pak_manager.archive_index,key);
+    }
+    gfc_hashmap_insert(pak_manager.lookups,filename,lookup);
+    return lookup;
+}
+
+static void gfc_pak_async_close();
+static void gfc_pak_cache_close();
 
 void gfc_pak_manager_close()
 {
+    gfc_pak_async_close();//workers read from the pak files, stop them first
+    gfc_pak_manager_clear_index();
     //clear out all loaded pak files
     if (pak_manager.pak_files)
     {
@@ -31,6 +286,20 @@ void gfc_pak_manager_close()
         gfc_list_delete(pak_manager.pak_files);
     }
     pak_manager.pak_files = NULL;
+    gfc_list_foreach(pak_manager.retired,(gfc_work_func*)gfc_pak_file_free);
+    gfc_list_delete(pak_manager.retired);
+    pak_manager.retired = NULL;
+    if (pak_manager.views)
+    {
+        if (gfc_list_get_count(pak_manager.views))
+        {
+            slog("pak manager closing with %i files still mapped",gfc_list_get_count(pak_manager.views));
+        }
+        gfc_list_foreach(pak_manager.views,free);
+        gfc_list_delete(pak_manager.views);
+    }
+    pak_manager.views = NULL;
+    gfc_pak_cache_close();
 }
 
 void gfc_pak_manager_init()
@@ -54,6 +323,37 @@ GFC_PakFile *gfc_pak_manager_get_by_filename(const char *filename)
     return NULL;
 }
 
+static GFC_PakFile *gfc_pak_file_open(const char *filename)
+{
+    GFC_PakFile *pakFile;
+    struct stat st;
+    pakFile = gfc_pak_file_new();
+    if (!pakFile)
+    {
+        slog("failed to allocate data for pak file");
+        return NULL;
+    }
+    //everything is read through this one descriptor, so the index, the map and the stamp are all of the same file
+    //even if another is renamed over it while it is open
+    pakFile->file = fopen(filename,"rb");
+    if (!pakFile->file)
+    {
+        slog("failed to open archive file %s",filename);
+        gfc_pak_file_free(pakFile);
+        return NULL;
+    }
+    if (fstat(fileno(pakFile->file),&st) == 0)gfc_pak_stat_stamp(&st,&pakFile->modified,&pakFile->diskSize);
+    if (!mz_zip_reader_init_cfile(&pakFile->zipFile, pakFile->file, 0, 0))
+    {
+        slog("loading of archive file %s failed.",filename);
+        gfc_pak_file_free(pakFile);
+        return NULL;
+    }
+    pakFile->map = gfc_pak_map_descriptor(fileno(pakFile->file),&pakFile->mapSize);
+    gfc_line_cpy(pakFile->filename,filename);
+    return pakFile;
+}
+
 void gfc_pak_manager_add(const char *filename)
 {
     GFC_PakFile *pakFile = NULL;
@@ -65,25 +365,119 @@ void gfc_pak_manager_add(const char *filename)
     }
     pakFile = gfc_pak_manager_get_by_filename(filename);
     if (pakFile)return;// already loaded
-    pakFile = gfc_pak_file_new();
-    if (!pakFile)
+    pakFile = gfc_pak_file_open(filename);
+    if (!pakFile)return;
+    gfc_list_append(pak_manager.pak_files,pakFile);
+    gfc_pak_manager_index_pak(pakFile);
+}
+
+static void gfc_pak_cache_retire_all();
+static Uint8 gfc_pak_async_busy();
+
+/**
+ * @brief stop reading from a pak that has been reopened
+ * @note its mapping is kept until close, views and streams handed out may still point into it.  Worker readers
+ * of it are left open for the same reason, and since the pointer is never reused they never serve the new pak
+ */
+static void gfc_pak_file_retire(GFC_PakFile *pakFile)
+{
+    mz_zip_reader_end(&pakFile->zipFile);
+    if (pakFile->file)fclose(pakFile->file);
+    pakFile->file = NULL;
+    pak_manager.retired = gfc_list_append(pak_manager.retired,pakFile);
+}
+
+int gfc_pak_manager_refresh()
+{
+    GFC_PakFile *pakFile,*fresh;
+    Sint64 modified,size;
+    int i,c,reopened = 0;
+    c = gfc_list_get_count(pak_manager.pak_files);
+    for (i = 0; i < c; i++)
     {
-        slog("failed to allocate data for pak file");
-        return;
+        pakFile = gfc_list_get_nth(pak_manager.pak_files,i);
+        if (!pakFile)continue;
+        //a pak being replaced can be missing for a moment, keep the old one until the new one is there
+        if (!gfc_pak_disk_stamp(pakFile->filename,&modified,&size))continue;
+        if ((modified == pakFile->modified)&&(size == pakFile->diskSize))continue;
+        //queued loads hold entry indices into the old directory
+        if (gfc_pak_async_busy())break;
+        fresh = gfc_pak_file_open(pakFile->filename);
+        if (!fresh)
+        {
+            //most likely still being written, try again when it changes again
+            pakFile->modified = modified;
+            pakFile->diskSize = size;
+            continue;
+        }
+        gfc_list_set_nth(pak_manager.pak_files,i,fresh);
+        gfc_pak_file_retire(pakFile);
+        reopened++;
+    }
+    if (!reopened)return 0;
+    //cached entries are keyed by name, they could have come from a pak that changed
+    gfc_pak_cache_retire_all();
+    gfc_pak_manager_invalidate();
+    return reopened;
+}
+
+int gfc_pak_file_get_stamp(const char *filename,GFC_PakFileStamp *stamp)
+{
+    GFC_PakLookup *lookup;
+    mz_zip_archive_file_stat pStat = {0};
+    Sint64 modified = 0,size = 0;
+    if ((!filename)||(!stamp))return -1;
+    memset(stamp,0,sizeof(GFC_PakFileStamp));
+    lookup = gfc_pak_manager_resolve(filename);
+    if (!lookup)return -1;
+    //lookups are cached, keep this one up to date with the disk
+    lookup->loose = (gfc_pak_disk_stamp(filename,&modified,&size))&&(size > 0);
+    if (lookup->loose)
+    {
+        stamp->found = 1;
+        stamp->loose = 1;
+        stamp->modified = modified;
+        stamp->size = size;
+        return 0;
     }
-    if (!mz_zip_reader_init_file(&pakFile->zipFile, filename, 0))
+    if (!lookup->entry)return 0;
+    if (!mz_zip_reader_file_stat(&lookup->entry->pakFile->zipFile, lookup->entry->index, &pStat))return -1;
+    stamp->found = 1;
+    stamp->modified = lookup->entry->pakFile->modified;
+    stamp->size = pStat.m_uncomp_size;
+    stamp->crc = pStat.m_crc32;
+    return 0;
+}
+
+int gfc_pak_file_get_crc(const char *filename,Uint32 *crc)
+{
+    GFC_PakFileStamp stamp;
+    void *data;
+    size_t size = 0;
+    if (!crc)return -1;
+    *crc = 0;
+    if (gfc_pak_file_get_stamp(filename,&stamp) != 0)return -1;
+    if (!stamp.found)return -1;
+    if (!stamp.loose)
     {
-        slog("loading of archive file %s failed.",filename);
-        gfc_pak_file_free(pakFile);
-        return;
+        *crc = stamp.crc;
+        return 0;
     }
-    gfc_list_append(pak_manager.pak_files,pakFile);
+    data = gfc_pak_load_file_from_disk(filename,&size);
+    if (!data)return -1;
+    *crc = (Uint32)mz_crc32(MZ_CRC32_INIT,data,size);
+    free(data);
+    return 0;
 }
 
 void gfc_pak_file_free(GFC_PakFile *pakFile)
 {
     if (!pakFile)return;
+#ifndef _WIN32
+    if (pakFile->map)munmap(pakFile->map,pakFile->mapSize);
+#endif
     mz_zip_reader_end(&pakFile->zipFile);
+    if (pakFile->file)fclose(pakFile->file);
     free(pakFile);
 }
 
@@ -114,6 +508,7 @@ void *gfc_pak_load_file_from_disk(const char *filename,size_t *fileSize)
         return NULL;
     }
     fread(data, size, 1, file);
+    fclose(file);
     if (fileSize)
     {
         *fileSize = size;
@@ -123,55 +518,1114 @@ void *gfc_pak_load_file_from_disk(const char *filename,size_t *fileSize)
 
 SJson *gfc_pak_load_json(const char *filename)
 {
-    void *data;
+    const void *data;
     SJson *json;
     size_t fileSize;
-    data = gfc_pak_file_extract(filename,&fileSize);
+    data = gfc_pak_file_map(filename,&fileSize);
     if (!data)return NULL;
-    json = sj_parse_buffer(data,fileSize);
-    free(data);
+    json = sj_parse_buffer((char *)data,fileSize);
+    gfc_pak_file_unmap(data);
     return json;
 }
 
-void *gfc_pak_file_extract(const char *filename,size_t *fileSize)
+//extraction cache section
+
+static void gfc_pak_cache_unlink(GFC_PakCacheEntry *entry)
+{
+    if (entry->prev)entry->prev->next = entry->next;
+    else if (pak_cache.newest == entry)pak_cache.newest = entry->next;
+    if (entry->next)entry->next->prev = entry->prev;
+    else if (pak_cache.oldest == entry)pak_cache.oldest = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+static void gfc_pak_cache_entry_free(GFC_PakCacheEntry *entry)
+{
+    if (!entry)return;
+    free(entry->data);
+    free(entry);
+}
+
+static void gfc_pak_cache_remove(GFC_PakCacheEntry *entry)
+{
+    gfc_pak_cache_unlink(entry);
+    gfc_hashmap_delete_by_key(pak_cache.entries,entry->key);
+    pak_cache.stats.bytesResident -= entry->size;
+    pak_cache.stats.entries--;
+    gfc_pak_cache_entry_free(entry);
+}
+
+/**
+ * @brief evict unreferenced entries, oldest first, until the resident size is within limit
+ */
+static void gfc_pak_cache_trim(size_t limit)
+{
+    while ((pak_cache.stats.bytesResident > limit)&&(pak_cache.oldest))
+    {
+        gfc_pak_cache_remove(pak_cache.oldest);
+        pak_cache.stats.evictions++;
+    }
+}
+
+static void gfc_pak_cache_close()
+{
+    if (pak_cache.entries)
+    {
+        //outstanding views are leaked references at this point, free them anyway
+        gfc_hashmap_foreach(pak_cache.entries,(gfc_work_func*)gfc_pak_cache_entry_free);
+        gfc_hashmap_free(pak_cache.entries);
+    }
+    memset(&pak_cache,0,sizeof(GFC_PakCache));
+}
+
+/**
+ * @brief get a reference to a cached file
+ * @return NULL if not cached
+ */
+static GFC_PakCacheEntry *gfc_pak_cache_acquire(const char *key)
+{
+    GFC_PakCacheEntry *entry;
+    entry = gfc_hashmap_get(pak_cache.entries,key);
+    if (!entry)
+    {
+        pak_cache.stats.misses++;
+        return NULL;
+    }
+    pak_cache.stats.hits++;
+    if (!entry->refCount++)gfc_pak_cache_unlink(entry);//in use, no longer a candidate for eviction
+    return entry;
+}
+
+static void gfc_pak_cache_release(GFC_PakCacheEntry *entry)
+{
+    if ((!entry)||(!entry->refCount))return;
+    if (--entry->refCount)return;
+    if (entry->retired)
+    {
+        pak_cache.stats.bytesResident -= entry->size;
+        pak_cache.stats.entries--;
+        gfc_pak_cache_entry_free(entry);
+        return;
+    }
+    entry->next = pak_cache.newest;
+    if (pak_cache.newest)pak_cache.newest->prev = entry;
+    pak_cache.newest = entry;
+    if (!pak_cache.oldest)pak_cache.oldest = entry;
+    gfc_pak_cache_trim(pak_cache.budget);
+}
+
+/**
+ * @brief add freshly extracted data to the cache, taking ownership of it
+ * @return NULL if it would not fit, caller keeps ownership of data in that case.  A referenced entry otherwise
+ */
+static GFC_PakCacheEntry *gfc_pak_cache_insert(const char *key,void *data,size_t size)
+{
+    GFC_PakCacheEntry *entry;
+    if (size > pak_cache.budget)return NULL;
+    if (!pak_cache.entries)
+    {
+        pak_cache.entries = gfc_hashmap_new_size(64);
+        if (!pak_cache.entries)return NULL;
+    }
+    entry = gfc_allocate_array(sizeof(GFC_PakCacheEntry),1);
+    if (!entry)return NULL;
+    //make room before it lands so the budget is a real ceiling on unreferenced data
+    gfc_pak_cache_trim(pak_cache.budget - size);
+    gfc_line_cpy(entry->key,key);
+    entry->data = data;
+    entry->size = size;
+    entry->refCount = 1;
+    gfc_hashmap_insert(pak_cache.entries,entry->key,entry);
+    pak_cache.stats.bytesResident += size;
+    pak_cache.stats.entries++;
+    return entry;
+}
+
+void gfc_pak_cache_set_budget(size_t bytes)
+{
+    pak_cache.budget = bytes;
+    gfc_pak_cache_trim(bytes);
+}
+
+void gfc_pak_cache_flush()
+{
+    gfc_pak_cache_trim(0);
+}
+
+/**
+ * @brief drop everything from the cache, entries still in use are freed when they are released
+ */
+static void gfc_pak_cache_retire_all()
+{
+    gfcList *entries;
+    GFC_PakCacheEntry *entry;
+    int i,c;
+    entries = gfc_hashmap_get_all_values(pak_cache.entries);
+    c = gfc_list_get_count(entries);
+    for (i = 0; i < c; i++)
+    {
+        entry = gfc_list_get_nth(entries,i);
+        if (!entry)continue;
+        if (!entry->refCount)
+        {
+            gfc_pak_cache_remove(entry);
+            continue;
+        }
+        gfc_hashmap_delete_by_key(pak_cache.entries,entry->key);
+        entry->retired = 1;
+    }
+    gfc_list_delete(entries);
+}
+
+void gfc_pak_cache_get_stats(GFC_PakCacheStats *stats)
+{
+    if (!stats)return;
+    memcpy(stats,&pak_cache.stats,sizeof(GFC_PakCacheStats));
+}
+
+void gfc_pak_cache_reset_stats()
+{
+    pak_cache.stats.hits = 0;
+    pak_cache.stats.misses = 0;
+    pak_cache.stats.evictions = 0;
+    pak_cache.stats.bytesInflated = 0;
+}
+
+static void *gfc_pak_zip_extract(mz_zip_archive *zip,mz_uint index,const char *filename,size_t *fileSize)
 {
-    GFC_PakFile *pakFile = NULL;
     mz_zip_archive_file_stat pStat = {0};
     void *fileData;
-    int index;
-    int i,c;
+    if (!mz_zip_reader_file_stat(zip, index, &pStat))
+    {
+        slog("failed to read archive for file %s",filename);
+        return NULL;
+    }
+    fileData = gfc_allocate_array(pStat.m_uncomp_size,1);
+    if (!fileData)
+    {
+        slog("failed to allocate data to extract file %s",filename);
+        return NULL;
+    }
+    if (!mz_zip_reader_extract_to_mem(zip, index, fileData, pStat.m_uncomp_size, 0))
+    {
+        slog("failed to extract file %s",filename);
+        free(fileData);
+        return NULL;
+    }
+    if (pStat.m_method)GFC_PROFILE_COUNT(GFC_PC_BYTES_INFLATED,pStat.m_uncomp_size);
+    if (fileSize)*fileSize = pStat.m_uncomp_size;
+    return fileData;
+}
+
+static void *gfc_pak_entry_extract(GFC_PakEntry *entry,const char *filename,size_t *fileSize)
+{
+    void *data;
+    size_t size = 0;
+    data = gfc_pak_zip_extract(&entry->pakFile->zipFile,entry->index,filename,&size);
+    if (!data)return NULL;
+    pak_cache.stats.bytesInflated += size;
+    if (fileSize)*fileSize = size;
+    return data;
+}
+
+/**
+ * @brief extract an archive entry through the cache
+ * @return NULL if the cache is disabled, the file does not fit or extraction failed.  A referenced cache entry otherwise
+ */
+static GFC_PakCacheEntry *gfc_pak_entry_extract_cached(GFC_PakEntry *entry,const char *filename)
+{
+    TextLine key;
+    GFC_PakCacheEntry *cached;
+    void *data;
+    size_t size = 0;
+    if (!pak_cache.budget)return NULL;
+    gfc_pak_index_key(key,filename);
+    cached = gfc_pak_cache_acquire(key);
+    if (cached)return cached;
+    data = gfc_pak_entry_extract(entry,filename,&size);
+    if (!data)return NULL;
+    cached = gfc_pak_cache_insert(key,data,size);
+    if (!cached)free(data);
+    return cached;
+}
+
+void *gfc_pak_file_extract(const char *filename,size_t *fileSize)
+{
+    GFC_PakLookup *lookup;
+    GFC_PakCacheEntry *cached;
+    void *fileData;
+    GFC_PROFILE_ZONE("gfc_pak_file_extract");
     if (!filename)return NULL;
+    lookup = gfc_pak_manager_resolve(filename);
+    if (!lookup)return NULL;
     //first we see if there is a local override to a pak file
-    fileData = gfc_pak_load_file_from_disk(filename,fileSize);
-    if (fileData)return fileData;
-    c = gfc_list_get_count(pak_manager.pak_files);
-    for (i = 0; i< c; i++)
+    if (lookup->loose)
     {
-        pakFile = gfc_list_get_nth(pak_manager.pak_files,i);
-        if (!pakFile)continue;
-        index = mz_zip_reader_locate_file(&pakFile->zipFile, filename, NULL, 0);
-        if (index == -1)continue;// not in this file
-        if (!mz_zip_reader_file_stat(&pakFile->zipFile, index, &pStat))
+        fileData = gfc_pak_load_file_from_disk(filename,fileSize);
+        if (fileData)return fileData;
+    }
+    if (!lookup->entry)return NULL;//nope, couldn't find it
+    cached = gfc_pak_entry_extract_cached(lookup->entry,filename);
+    if (cached)
+    {
+        //the caller owns what we return, so hand out a copy
+        fileData = gfc_allocate_array(cached->size,1);
+        if (fileData)
         {
-            slog("failed to read archive for file %f",filename);
-            return NULL;
+            memcpy(fileData,cached->data,cached->size);
+            if (fileSize)*fileSize = cached->size;
         }
-        fileData = gfc_allocate_array(pStat.m_uncomp_size,1);
-        if (!fileData)
+        gfc_pak_cache_release(cached);
+        return fileData;
+    }
+    return gfc_pak_entry_extract(lookup->entry,filename,fileSize);
+}
+
+/**
+ * @brief map the whole of an open file read only
+ * @return NULL if the file is empty or mapping is not supported
+ */
+static void *gfc_pak_map_descriptor(int fd,size_t *length)
+{
+#ifndef _WIN32
+    struct stat st;
+    void *map;
+    if ((fstat(fd,&st) != 0)||(st.st_size <= 0))return NULL;
+    map = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    if (map == MAP_FAILED)return NULL;
+    *length = st.st_size;
+    return map;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * @brief map a whole file read only
+ * @return NULL if the file could not be opened, is empty, or mapping is not supported
+ */
+static void *gfc_pak_map_from_disk(const char *filename,size_t *length)
+{
+#ifndef _WIN32
+    int fd;
+    void *map;
+    fd = open(filename,O_RDONLY);
+    if (fd < 0)return NULL;
+    map = gfc_pak_map_descriptor(fd,length);
+    close(fd);//the mapping holds its own reference to the file
+    return map;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * @brief get a pointer to the start of an entry's data, as it is stored, in the mapped pak
+ * @return NULL if the pak can not be mapped or the entry is encrypted or out of bounds
+ */
+static const void *gfc_pak_file_find_data(GFC_PakFile *pakFile,mz_zip_archive_file_stat *pStat)
+{
+    const Uint8 *header;
+    size_t offset;
+    if (pStat->m_is_encrypted)return NULL;
+    if (!pakFile->map)return NULL;
+    offset = pStat->m_local_header_ofs;
+    if (offset + GFC_ZIP_LOCAL_HEADER_SIZE > pakFile->mapSize)return NULL;
+    header = pakFile->map + offset;
+    if ((header[0] | (header[1] << 8) | (header[2] << 16) | ((Uint32)header[3] << 24)) != GFC_ZIP_LOCAL_HEADER_SIG)
+    {
+        slog("pak file %s has a bad local header",pakFile->filename);
+        return NULL;
+    }
+    //the local header has its own copies of the name and extra field lengths
+    offset += GFC_ZIP_LOCAL_HEADER_SIZE + (header[26] | (header[27] << 8)) + (header[28] | (header[29] << 8));
+    if (offset + pStat->m_comp_size > pakFile->mapSize)return NULL;
+    return pakFile->map + offset;
+}
+
+/**
+ * @brief get a pointer to the start of a stored (uncompressed) entry in the mapped pak
+ */
+static const void *gfc_pak_file_find_stored(GFC_PakFile *pakFile,mz_zip_archive_file_stat *pStat)
+{
+    if (pStat->m_method != 0)return NULL;//has to be inflated
+    if (pStat->m_comp_size != pStat->m_uncomp_size)return NULL;
+    return gfc_pak_file_find_data(pakFile,pStat);
+}
+
+static const void *gfc_pak_file_view_add(const void *data,void *base,size_t length,GFC_PakViewType type)
+{
+    GFC_PakView *view;
+    gfcList *views;
+    view = gfc_allocate_array(sizeof(GFC_PakView),1);
+    if (!view)return NULL;
+    view->data = data;
+    view->base = base;
+    view->length = length;
+    view->type = type;
+    views = gfc_list_append(pak_manager.views,view);
+    if (!views)
+    {
+        free(view);
+        return NULL;
+    }
+    pak_manager.views = views;
+    return data;
+}
+
+const void *gfc_pak_file_map(const char *filename,size_t *fileSize)
+{
+    GFC_PakLookup *lookup;
+    GFC_PakCacheEntry *cached;
+    mz_zip_archive_file_stat pStat = {0};
+    const void *data;
+    void *base;
+    size_t size = 0;
+    if (!filename)return NULL;
+    lookup = gfc_pak_manager_resolve(filename);
+    if (!lookup)return NULL;
+    //local overrides win, same as extraction
+    if (lookup->loose)
+    {
+        base = gfc_pak_map_from_disk(filename,&size);
+        if (base)
         {
-            slog("failed to allocate data to extract file %f",filename);
-            return NULL;
+            data = gfc_pak_file_view_add(base,base,size,GFC_PVT_File);
+            if (!data)
+            {
+#ifndef _WIN32
+                munmap(base,size);
+#endif
+                return NULL;
+            }
+            if (fileSize)*fileSize = size;
+            return data;
+        }
+    }
+    if (!lookup->entry)return NULL;
+    if (mz_zip_reader_file_stat(&lookup->entry->pakFile->zipFile, lookup->entry->index, &pStat))
+    {
+        data = gfc_pak_file_find_stored(lookup->entry->pakFile,&pStat);
+        if (data)
+        {
+            if (fileSize)*fileSize = pStat.m_uncomp_size;
+            return gfc_pak_file_view_add(data,NULL,pStat.m_uncomp_size,GFC_PVT_Pak);
         }
-        if (!mz_zip_reader_extract_to_mem(&pakFile->zipFile, index, fileData, pStat.m_uncomp_size, 0))
+    }
+    //compressed, let extraction handle it
+    cached = gfc_pak_entry_extract_cached(lookup->entry,filename);
+    if (cached)
+    {
+        if (fileSize)*fileSize = cached->size;
+        data = gfc_pak_file_view_add(cached->data,cached,cached->size,GFC_PVT_Cache);
+        if (!data)gfc_pak_cache_release(cached);
+        return data;
+    }
+    base = gfc_pak_entry_extract(lookup->entry,filename,&size);
+    if (!base)return NULL;
+    if (fileSize)*fileSize = size;
+    data = gfc_pak_file_view_add(base,base,size,GFC_PVT_Heap);
+    if (!data)free(base);
+    return data;
+}
+
+void gfc_pak_file_unmap(const void *data)
+{
+    GFC_PakView *view;
+    int i,c;
+    if (!data)return;
+    c = gfc_list_get_count(pak_manager.views);
+    for (i = 0; i < c; i++)
+    {
+        view = gfc_list_get_nth(pak_manager.views,i);
+        if ((!view)||(view->data != data))continue;
+        switch (view->type)
         {
-            slog("failed to extract file %f",filename);
-            free(fileData);
+            case GFC_PVT_Heap:
+                free(view->base);
+                break;
+            case GFC_PVT_File:
+#ifndef _WIN32
+                munmap(view->base,view->length);
+#endif
+                break;
+            case GFC_PVT_Pak:
+                break;//the pak mapping lives as long as the pak file
+            case GFC_PVT_Cache:
+                gfc_pak_cache_release(view->base);
+                break;
+        }
+        gfc_list_delete_nth(pak_manager.views,i);
+        free(view);
+        return;
+    }
+    slog("gfc_pak_file_unmap: pointer was not mapped by gfc_pak_file_map");
+}
+
+//streaming section
+
+#define GFC_PAK_STREAM_WINDOW 65536   /**<how much recently inflated data a stream keeps, a power of two*/
+
+typedef struct
+{
+    const Uint8 *src;       /**<the entry data as stored, in the pak mapping or owned*/
+    size_t srcSize;
+    void *owned;            /**<freed on close, if set*/
+    Sint64 size;            /**<uncompressed size*/
+    Sint64 position;        /**<where the next read starts*/
+    Uint8 inflating;        /**<src is raw deflate, otherwise it is the file itself*/
+    mz_stream zs;
+    Uint8 *window;          /**<ring of the last GFC_PAK_STREAM_WINDOW bytes inflated*/
+    Sint64 inflated;        /**<how far into the file the inflater has gotten*/
+}GFC_PakStream;
+
+static void gfc_pak_stream_restart(GFC_PakStream *stream)
+{
+    mz_inflateReset(&stream->zs);
+    stream->zs.next_in = stream->src;
+    stream->zs.avail_in = (unsigned int)stream->srcSize;
+    stream->inflated = 0;
+}
+
+/**
+ * @brief inflate the next piece of the file into the window
+ * @return how many bytes were inflated, 0 at the end of the data or on error
+ */
+static size_t gfc_pak_stream_inflate(GFC_PakStream *stream)
+{
+    size_t offset,space;
+    int status;
+    offset = (size_t)(stream->inflated & (GFC_PAK_STREAM_WINDOW - 1));
+    space = GFC_PAK_STREAM_WINDOW - offset;
+    stream->zs.next_out = stream->window + offset;
+    stream->zs.avail_out = (unsigned int)space;
+    status = mz_inflate(&stream->zs,MZ_SYNC_FLUSH);
+    if ((status != MZ_OK)&&(status != MZ_STREAM_END)&&(status != MZ_BUF_ERROR))
+    {
+        slog("failed to inflate pak stream: %s",mz_error(status));
+    }
+    space -= stream->zs.avail_out;
+    stream->inflated += space;
+    GFC_PROFILE_COUNT(GFC_PC_BYTES_INFLATED,space);
+    return space;
+}
+
+static size_t gfc_pak_stream_read_bytes(GFC_PakStream *stream,Uint8 *out,size_t count)
+{
+    size_t done = 0,offset,length;
+    Sint64 available;
+    if (stream->position >= stream->size)return 0;
+    if (count > stream->size - stream->position)count = (size_t)(stream->size - stream->position);
+    if (!stream->inflating)
+    {
+        memcpy(out,stream->src + stream->position,count);
+        stream->position += count;
+        return count;
+    }
+    //seeking back past the window means inflating from the start again
+    if (stream->position < stream->inflated - MIN(stream->inflated,GFC_PAK_STREAM_WINDOW))
+    {
+        gfc_pak_stream_restart(stream);
+    }
+    while (done < count)
+    {
+        if (stream->position >= stream->inflated)
+        {
+            if (!gfc_pak_stream_inflate(stream))break;
+            continue;//skipping forward inflates and drops what is passed over
+        }
+        available = stream->inflated - stream->position;
+        offset = (size_t)(stream->position & (GFC_PAK_STREAM_WINDOW - 1));
+        length = MIN(count - done,(size_t)available);
+        length = MIN(length,GFC_PAK_STREAM_WINDOW - offset);
+        memcpy(out + done,stream->window + offset,length);
+        done += length;
+        stream->position += length;
+    }
+    return done;
+}
+
+static Sint64 SDLCALL gfc_pak_stream_size(SDL_RWops *rw)
+{
+    return ((GFC_PakStream *)rw->hidden.unknown.data1)->size;
+}
+
+static Sint64 SDLCALL gfc_pak_stream_seek(SDL_RWops *rw,Sint64 offset,int whence)
+{
+    GFC_PakStream *stream = rw->hidden.unknown.data1;
+    switch (whence)
+    {
+        case RW_SEEK_SET:
+            break;
+        case RW_SEEK_CUR:
+            offset += stream->position;
+            break;
+        case RW_SEEK_END:
+            offset += stream->size;
+            break;
+        default:
+            return SDL_SetError("gfc_pak_stream_seek: unknown value for 'whence'");
+    }
+    if (offset < 0)return SDL_SetError("gfc_pak_stream_seek: seek before the start of the file");
+    //the work is put off until something is read, decoders often seek more than they read
+    stream->position = MIN(offset,stream->size);
+    return stream->position;
+}
+
+static size_t SDLCALL gfc_pak_stream_read(SDL_RWops *rw,void *ptr,size_t size,size_t maxnum)
+{
+    GFC_PakStream *stream = rw->hidden.unknown.data1;
+    if ((!size)||(!maxnum))return 0;
+    return gfc_pak_stream_read_bytes(stream,ptr,size * maxnum) / size;
+}
+
+static size_t SDLCALL gfc_pak_stream_write(SDL_RWops *rw,const void *ptr,size_t size,size_t num)
+{
+    SDL_SetError("gfc_pak_stream_write: pak streams are read only");
+    return 0;
+}
+
+static void gfc_pak_stream_free(GFC_PakStream *stream)
+{
+    if (!stream)return;
+    if (stream->inflating)mz_inflateEnd(&stream->zs);
+    if (stream->window)free(stream->window);
+    if (stream->owned)free(stream->owned);
+    free(stream);
+}
+
+static int SDLCALL gfc_pak_stream_close(SDL_RWops *rw)
+{
+    if (!rw)return 0;
+    gfc_pak_stream_free(rw->hidden.unknown.data1);
+    SDL_FreeRW(rw);
+    return 0;
+}
+
+static SDL_RWops *gfc_pak_stream_new(const void *src,size_t srcSize,size_t size,void *owned,Uint8 inflating)
+{
+    GFC_PakStream *stream;
+    SDL_RWops *rw;
+    stream = gfc_allocate_array(sizeof(GFC_PakStream),1);
+    if (!stream)
+    {
+        if (owned)free(owned);
+        return NULL;
+    }
+    stream->src = src;
+    stream->srcSize = srcSize;
+    stream->owned = owned;
+    stream->size = size;
+    if (inflating)
+    {
+        stream->window = gfc_allocate_array(GFC_PAK_STREAM_WINDOW,1);
+        //raw deflate, zip entries have no zlib header
+        if ((!stream->window)||(mz_inflateInit2(&stream->zs,-MZ_DEFAULT_WINDOW_BITS) != MZ_OK))
+        {
+            gfc_pak_stream_free(stream);
             return NULL;
         }
-        if (fileSize)*fileSize = pStat.m_uncomp_size;
-        return fileData;
+        stream->inflating = 1;
+        gfc_pak_stream_restart(stream);
+    }
+    rw = SDL_AllocRW();
+    if (!rw)
+    {
+        gfc_pak_stream_free(stream);
+        return NULL;
+    }
+    rw->size = gfc_pak_stream_size;
+    rw->seek = gfc_pak_stream_seek;
+    rw->read = gfc_pak_stream_read;
+    rw->write = gfc_pak_stream_write;
+    rw->close = gfc_pak_stream_close;
+    rw->type = SDL_RWOPS_UNKNOWN;
+    rw->hidden.unknown.data1 = stream;
+    return rw;
+}
+
+SDL_RWops *gfc_pak_file_open_rw(const char *filename)
+{
+    GFC_PakLookup *lookup;
+    mz_zip_archive_file_stat pStat = {0};
+    const void *data;
+    void *base;
+    size_t size = 0;
+    SDL_RWops *rw;
+    if (!filename)return NULL;
+    lookup = gfc_pak_manager_resolve(filename);
+    if (!lookup)return NULL;
+    if (lookup->loose)
+    {
+        rw = SDL_RWFromFile(filename,"rb");
+        if (rw)return rw;
+    }
+    if (!lookup->entry)return NULL;
+    if (mz_zip_reader_file_stat(&lookup->entry->pakFile->zipFile, lookup->entry->index, &pStat))
+    {
+        data = gfc_pak_file_find_stored(lookup->entry->pakFile,&pStat);
+        if (data)
+        {
+            //the pak mapping lives as long as the pak file, so it can be read straight from there
+            return SDL_RWFromConstMem(data,(int)pStat.m_uncomp_size);
+        }
+        if (pStat.m_method == MZ_DEFLATED)
+        {
+            data = gfc_pak_file_find_data(lookup->entry->pakFile,&pStat);
+            if (data)
+            {
+                return gfc_pak_stream_new(data,pStat.m_comp_size,pStat.m_uncomp_size,NULL,1);
+            }
+        }
+    }
+    //the pak could not be mapped, read the whole thing instead
+    base = gfc_pak_entry_extract(lookup->entry,filename,&size);
+    if (!base)return NULL;
+    return gfc_pak_stream_new(base,size,size,base,0);
+}
+
+//async loading section
+
+/**
+ * @brief remove a request from a list if it is in it
+ * @return 1 if it was removed, 0 if it was not there
+ */
+static Uint8 gfc_pak_request_remove(gfcList *list,GFC_PakRequest *request)
+{
+    int index;
+    if (!list)return 0;
+    index = gfc_list_get_item_index(list,request);
+    if (index < 0)return 0;
+    gfc_list_delete_nth(list,index);
+    return 1;
+}
+
+static void gfc_pak_request_free(GFC_PakRequest *request)
+{
+    if (!request)return;
+    if (request->result.data)free(request->result.data);
+    free(request);
+}
+
+static mz_zip_archive *gfc_pak_worker_get_reader(GFC_PakWorker *worker,GFC_PakFile *pakFile)
+{
+    int i,c;
+    gfcList *readers;
+    GFC_PakReader *reader;
+    c = gfc_list_get_count(worker->readers);
+    for (i = 0; i < c; i++)
+    {
+        reader = gfc_list_get_nth(worker->readers,i);
+        if ((reader)&&(reader->pakFile == pakFile))return &reader->zipFile;
+    }
+    //reading the map rather than the path, what is at the path now may not be the pak that was indexed
+    if (!pakFile->map)return NULL;
+    reader = gfc_allocate_array(sizeof(GFC_PakReader),1);
+    if (!reader)return NULL;
+    if (!mz_zip_reader_init_mem(&reader->zipFile, pakFile->map, pakFile->mapSize, 0))
+    {
+        slog("worker failed to read archive file %s",pakFile->filename);
+        free(reader);
+        return NULL;
+    }
+    readers = gfc_list_append(worker->readers,reader);
+    if (!readers)
+    {
+        mz_zip_reader_end(&reader->zipFile);
+        free(reader);
+        return NULL;
+    }
+    reader->pakFile = pakFile;
+    worker->readers = readers;
+    return &reader->zipFile;
+}
+
+static void gfc_pak_worker_load(GFC_PakWorker *worker,GFC_PakRequest *request)
+{
+    mz_zip_archive *zip;
+    if (request->loose)
+    {
+        request->result.data = gfc_pak_load_file_from_disk(request->result.filename,&request->result.size);
+        if (request->result.data)return;
+    }
+    if (!request->pakFile)return;
+    zip = gfc_pak_worker_get_reader(worker,request->pakFile);
+    if (!zip)return;
+    request->result.data = gfc_pak_zip_extract(zip,request->index,request->result.filename,&request->result.size);
+}
+
+/**
+ * @brief take the oldest request from the most urgent queue that has one
+ * @note must be called with the lock held
+ */
+static GFC_PakRequest *gfc_pak_async_next()
+{
+    int i;
+    GFC_PakRequest *request;
+    for (i = 0; i < PLP_MAX; i++)
+    {
+        request = gfc_deque_pop_front(pak_async.pending[i]);
+        if (request)return request;
     }
-    //nope, couldn't find it
     return NULL;
 }
+
+/**
+ * @brief hand a finished request to the main thread
+ * @note must be called with the lock held.  This never allocates, room was made when the request was queued
+ */
+static void gfc_pak_async_complete(GFC_PakRequest *request)
+{
+    gfc_list_append(pak_async.completed,request);
+}
+
+static int gfc_pak_worker_run(void *data)
+{
+    GFC_PakWorker *worker = data;
+    GFC_PakRequest *request;
+    SDL_LockMutex(pak_async.lock);
+    while (!pak_async.quit)
+    {
+        request = gfc_pak_async_next();
+        if (!request)
+        {
+            SDL_CondWait(pak_async.wake,pak_async.lock);
+            continue;
+        }
+        SDL_UnlockMutex(pak_async.lock);
+        gfc_pak_worker_load(worker,request);
+        if ((request->process)&&(request->result.data))request->process(&request->result);
+        SDL_LockMutex(pak_async.lock);
+        gfc_pak_async_complete(request);
+    }
+    SDL_UnlockMutex(pak_async.lock);
+    return 0;
+}
+
+/**
+ * @brief load a request on the calling thread, for when there are no workers
+ */
+static void gfc_pak_request_load_now(GFC_PakRequest *request)
+{
+    if (request->loose)
+    {
+        request->result.data = gfc_pak_load_file_from_disk(request->result.filename,&request->result.size);
+    }
+    if ((!request->result.data)&&(request->pakFile))
+    {
+        request->result.data = gfc_pak_zip_extract(&request->pakFile->zipFile,request->index,request->result.filename,&request->result.size);
+    }
+    if ((request->process)&&(request->result.data))request->process(&request->result);
+}
+
+/**
+ * @brief make sure one more request can be tracked and completed without allocating
+ * every completed request is still in requests, so completed and delivering never need more room than it has
+ * @note must be called with the lock held
+ * @return -1 if there is not enough memory, 0 otherwise
+ */
+static int gfc_pak_async_make_room()
+{
+    Uint32 count;
+    if (!pak_async.requests)pak_async.requests = gfc_list_new();
+    if (!pak_async.completed)pak_async.completed = gfc_list_new();
+    if (!pak_async.delivering)pak_async.delivering = gfc_list_new();
+    if ((!pak_async.requests)||(!pak_async.completed)||(!pak_async.delivering))return -1;
+    count = gfc_list_get_count(pak_async.requests) + 1;
+    if (gfc_list_reserve(pak_async.requests,count) != 0)return -1;
+    if (gfc_list_reserve(pak_async.completed,count) != 0)return -1;
+    if (gfc_list_reserve(pak_async.delivering,count) != 0)return -1;
+    return 0;
+}
+
+void gfc_pak_async_init(Uint32 workerCount)
+{
+    Uint32 i,started = 0;
+    if (pak_async.workers)return;//already running
+    if (!workerCount)
+    {
+        //leave a core for the main thread, inflate is cpu bound but the disk is the real limit
+        workerCount = SDL_GetCPUCount() - 1;
+        if (workerCount < 1)workerCount = 1;
+        if (workerCount > 4)workerCount = 4;
+    }
+    //a pool that failed to start keeps its locks, loads are then done on the calling thread
+    if (!pak_async.lock)pak_async.lock = SDL_CreateMutex();
+    if (!pak_async.wake)pak_async.wake = SDL_CreateCond();
+    if ((!pak_async.lock)||(!pak_async.wake))
+    {
+        slog("failed to create pak async locks");
+        gfc_pak_async_close();
+        return;
+    }
+    pak_async.workers = gfc_allocate_array(sizeof(GFC_PakWorker),workerCount);
+    if (!pak_async.workers)
+    {
+        gfc_pak_async_close();
+        return;
+    }
+    pak_async.workerCount = workerCount;
+    for (i = 0; i < workerCount; i++)
+    {
+        pak_async.workers[i].thread = SDL_CreateThread(gfc_pak_worker_run,"gfc_pak_worker",&pak_async.workers[i]);
+        if (!pak_async.workers[i].thread)
+        {
+            slog("failed to create pak worker thread: %s",SDL_GetError());
+            continue;
+        }
+        started++;
+    }
+    if (!started)
+    {
+        slog("no pak worker threads started, asynchronous loads will be done as they are requested");
+        free(pak_async.workers);
+        pak_async.workers = NULL;
+        pak_async.workerCount = 0;
+    }
+}
+
+/**
+ * @brief check if any asynchronous loads are waiting or undelivered
+ */
+static Uint8 gfc_pak_async_busy()
+{
+    Uint8 busy;
+    if (!pak_async.lock)return 0;
+    SDL_LockMutex(pak_async.lock);
+    busy = gfc_list_get_count(pak_async.requests)?1:0;
+    SDL_UnlockMutex(pak_async.lock);
+    return busy;
+}
+
+static void gfc_pak_async_close()
+{
+    Uint32 i;
+    int j,c;
+    GFC_PakReader *reader;
+    if (pak_async.lock)
+    {
+        SDL_LockMutex(pak_async.lock);
+        pak_async.quit = 1;
+        SDL_CondBroadcast(pak_async.wake);
+        SDL_UnlockMutex(pak_async.lock);
+    }
+    for (i = 0; i < pak_async.workerCount; i++)
+    {
+        if (pak_async.workers[i].thread)SDL_WaitThread(pak_async.workers[i].thread,NULL);
+        c = gfc_list_get_count(pak_async.workers[i].readers);
+        for (j = 0; j < c; j++)
+        {
+            reader = gfc_list_get_nth(pak_async.workers[i].readers,j);
+            if (!reader)continue;
+            mz_zip_reader_end(&reader->zipFile);
+            free(reader);
+        }
+        gfc_list_delete(pak_async.workers[i].readers);
+    }
+    if (pak_async.workers)free(pak_async.workers);
+    //anything still queued or undelivered is dropped
+    gfc_list_foreach(pak_async.requests,(gfc_work_func*)gfc_pak_request_free);
+    gfc_list_delete(pak_async.requests);
+    for (i = 0; i < PLP_MAX; i++)
+    {
+        gfc_deque_delete(pak_async.pending[i]);
+    }
+    gfc_list_delete(pak_async.completed);
+    gfc_list_delete(pak_async.delivering);
+    if (pak_async.wake)SDL_DestroyCond(pak_async.wake);
+    if (pak_async.lock)SDL_DestroyMutex(pak_async.lock);
+    memset(&pak_async,0,sizeof(GFC_PakAsync));
+}
+
+Uint32 gfc_pak_load_async_process(
+    const char *filename,
+    void (*process)(GFC_PakLoadResult *result),
+    void (*callback)(void *result),
+    void *context,
+    GFC_PakLoadPriority priority)
+{
+    GFC_PakLookup *lookup;
+    GFC_PakRequest *request;
+    Uint8 loaded = 0;
+    if (!filename)return 0;
+    if ((priority < 0)||(priority >= PLP_MAX))priority = PLP_Normal;
+    if (!pak_async.lock)
+    {
+        gfc_pak_async_init(0);
+        if (!pak_async.lock)return 0;
+    }
+    request = gfc_allocate_array(sizeof(GFC_PakRequest),1);
+    if (!request)return 0;
+    //resolve here so the workers never touch the shared lookup tables
+    lookup = gfc_pak_manager_resolve(filename);
+    if (lookup)
+    {
+        request->loose = lookup->loose;
+        if (lookup->entry)
+        {
+            request->pakFile = lookup->entry->pakFile;
+            request->index = lookup->entry->index;
+        }
+    }
+    gfc_line_cpy(request->result.filename,filename);
+    request->result.context = context;
+    request->priority = priority;
+    request->process = process;
+    request->callback.callback = callback;
+    request->callback.data = &request->result;
+    //with no workers to hand it to, or a pak the workers can not read because it is not mapped,
+    //load it now and deliver it on the next poll like any other
+    if (((!pak_async.workers)&&((request->loose)||(request->pakFile)))||
+        ((request->pakFile)&&(!request->pakFile->map)))
+    {
+        gfc_pak_request_load_now(request);
+        loaded = 1;
+    }
+    SDL_LockMutex(pak_async.lock);
+    if (gfc_pak_async_make_room() != 0)
+    {
+        SDL_UnlockMutex(pak_async.lock);
+        slog("failed to queue asynchronous load of %s",filename);
+        gfc_pak_request_free(request);
+        return 0;
+    }
+    if ((!request->loose)&&(!request->pakFile))
+    {
+        //known miss, skip the workers and report it on the next poll
+        gfc_pak_async_complete(request);
+    }
+    else if ((!pak_async.workers)||(loaded))
+    {
+        gfc_pak_async_complete(request);
+    }
+    else
+    {
+        if (!pak_async.pending[priority])pak_async.pending[priority] = gfc_deque_new();
+        if (gfc_deque_push_back(pak_async.pending[priority],request) != 0)
+        {
+            SDL_UnlockMutex(pak_async.lock);
+            slog("failed to queue asynchronous load of %s",filename);
+            gfc_pak_request_free(request);
+            return 0;
+        }
+        SDL_CondSignal(pak_async.wake);
+    }
+    if (!++pak_async.nextId)pak_async.nextId = 1;//zero means no request
+    request->id = request->result.id = pak_async.nextId;
+    gfc_list_append(pak_async.requests,request);//room was made above
+    SDL_UnlockMutex(pak_async.lock);
+    return request->id;
+}
+
+Uint32 gfc_pak_load_async_priority(
+    const char *filename,
+    void (*callback)(void *result),
+    void *context,
+    GFC_PakLoadPriority priority)
+{
+    return gfc_pak_load_async_process(filename,NULL,callback,context,priority);
+}
+
+Uint32 gfc_pak_load_async(const char *filename,void (*callback)(void *result),void *context)
+{
+    return gfc_pak_load_async_priority(filename,callback,context,PLP_Normal);
+}
+
+Uint8 gfc_pak_load_cancel(Uint32 requestId)
+{
+    int i,c;
+    GFC_PakRequest *request;
+    if ((!requestId)||(!pak_async.lock))return 0;
+    SDL_LockMutex(pak_async.lock);
+    c = gfc_list_get_count(pak_async.requests);
+    for (i = 0; i < c; i++)
+    {
+        request = gfc_list_get_nth(pak_async.requests,i);
+        if ((!request)||(request->id != requestId))continue;
+        if (gfc_deque_delete_data(pak_async.pending[request->priority],request) == 0)
+        {
+            //never started, no one else has a reference to it
+            gfc_list_delete_nth(pak_async.requests,i);
+            SDL_UnlockMutex(pak_async.lock);
+            gfc_pak_request_free(request);
+            return 1;
+        }
+        //a worker has it or it is done, drop it when it is polled
+        request->cancelled = 1;
+        SDL_UnlockMutex(pak_async.lock);
+        return 1;
+    }
+    SDL_UnlockMutex(pak_async.lock);
+    return 0;
+}
+
+int gfc_pak_poll_request(Uint32 requestId)
+{
+    int i,c;
+    GFC_PakRequest *request = NULL;
+    if ((!requestId)||(!pak_async.lock))return -1;
+    SDL_LockMutex(pak_async.lock);
+    c = gfc_list_get_count(pak_async.requests);
+    for (i = 0; i < c; i++)
+    {
+        request = gfc_list_get_nth(pak_async.requests,i);
+        if ((request)&&(request->id == requestId))break;
+        request = NULL;
+    }
+    if (!request)
+    {
+        SDL_UnlockMutex(pak_async.lock);
+        return -1;
+    }
+    if (!gfc_pak_request_remove(pak_async.completed,request))
+    {
+        SDL_UnlockMutex(pak_async.lock);
+        return 0;//still waiting for or on a worker
+    }
+    gfc_list_delete_nth(pak_async.requests,i);
+    SDL_UnlockMutex(pak_async.lock);
+    if (request->cancelled)
+    {
+        gfc_pak_request_free(request);
+        return -1;
+    }
+    gfc_callback_call(&request->callback);
+    gfc_pak_request_free(request);
+    return 1;
+}
+
+int gfc_pak_poll_completions()
+{
+    int i,c,delivered = 0;
+    gfcList *completed;
+    GFC_PakRequest *request;
+    if ((!pak_async.lock)||(pak_async.polling))return 0;
+    SDL_LockMutex(pak_async.lock);
+    //the empty delivering list has as much room as completed did, so workers can keep completing
+    completed = pak_async.completed;
+    pak_async.completed = pak_async.delivering;
+    pak_async.delivering = completed;
+    c = gfc_list_get_count(completed);
+    for (i = 0; i < c; i++)
+    {
+        gfc_pak_request_remove(pak_async.requests,gfc_list_get_nth(completed,i));
+    }
+    SDL_UnlockMutex(pak_async.lock);
+    pak_async.polling = 1;
+    for (i = 0; i < c; i++)
+    {
+        request = gfc_list_get_nth(completed,i);
+        if (!request)continue;
+        if (!request->cancelled)
+        {
+            gfc_callback_call(&request->callback);
+            delivered++;
+        }
+        gfc_pak_request_free(request);
+    }
+    gfc_list_clear(completed);
+    pak_async.polling = 0;
+    return delivered;
+}
+
 /*eol@eof*/
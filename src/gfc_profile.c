@@ -0,0 +1,314 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_profile.h"
+
+typedef struct
+{
+    const char *name;
+    Uint64      start;
+    Uint64      end;
+}GFC_ProfileEvent;
+
+typedef struct
+{
+    SDL_threadID        id;
+    Uint32              index;                              /**<order the thread first recorded in, for naming it*/
+    GFC_ProfileEvent    events[GFC_PROFILE_RING_SIZE];
+    Uint64              written;                            /**<every event ever written, the ring keeps the newest*/
+    const char         *stackName[GFC_PROFILE_MAX_DEPTH];
+    Uint64              stackStart[GFC_PROFILE_MAX_DEPTH];
+    Uint8               stackRecord[GFC_PROFILE_MAX_DEPTH]; /**<if the zone started while recording was on*/
+    Uint32              depth;
+    Uint64              counters[GFC_PC_MAX];
+    Uint8               retired;                            /**<its thread has exited, the next new thread takes it over*/
+}GFC_ProfileThread;
+
+typedef struct
+{
+    SDL_SpinLock        lock;
+    GFC_ProfileThread  *threads[GFC_PROFILE_MAX_THREADS];
+    Uint32              threadCount;
+    Uint64              base;       /**<performance counter when the first thread started recording*/
+    Uint8               full;       /**<set once a thread could not get a buffer, so it is only reported once*/
+    SDL_TLSID           exitKey;    /**<its destructor retires a thread's buffer when an SDL thread exits*/
+}GFC_ProfileManager;
+
+static GFC_ProfileManager gfc_profile = {0};
+static SDL_atomic_t gfc_profile_disabled = {0};
+static GFC_THREAD_LOCAL GFC_ProfileThread *gfc_profile_thread_data = NULL;
+static GFC_THREAD_LOCAL Uint8 gfc_profile_thread_failed = 0;
+
+static const char *gfc_profile_counter_names[GFC_PC_MAX] =
+{
+    "allocations",
+    "allocated bytes",
+    "bytes inflated",
+    "hashmap probes"
+};
+
+/**
+ * @brief called as an SDL thread exits, hands its buffer on to the next thread that starts recording
+ * @note buffers are never freed, any thread may still be recording into its own until the process exits
+ */
+static void gfc_profile_thread_exit(void *data)
+{
+    GFC_ProfileThread *thread = data;
+    if (!thread)return;
+    //anything counted by later exit handlers on this thread is dropped rather than written into a buffer in use again
+    gfc_profile_thread_data = NULL;
+    gfc_profile_thread_failed = 1;
+    SDL_AtomicLock(&gfc_profile.lock);
+    thread->retired = 1;
+    SDL_AtomicUnlock(&gfc_profile.lock);
+}
+
+/**
+ * @brief take over the buffer of a thread that has exited, so short lived threads do not use up every slot
+ * @note must be called with the lock held.  Its events and counters are kept, the trace shows them under the new thread
+ */
+static GFC_ProfileThread *gfc_profile_reuse_thread()
+{
+    GFC_ProfileThread *thread;
+    Uint32 i;
+    for (i = 0; i < gfc_profile.threadCount; i++)
+    {
+        thread = gfc_profile.threads[i];
+        if (!thread->retired)continue;
+        thread->retired = 0;
+        thread->depth = 0;
+        thread->id = SDL_ThreadID();
+        return thread;
+    }
+    return NULL;
+}
+
+/**
+ * @brief give a new buffer a slot
+ * @return -1 if every slot is taken by a running thread, 0 otherwise
+ */
+static int gfc_profile_add_thread(GFC_ProfileThread *thread)
+{
+    SDL_AtomicLock(&gfc_profile.lock);
+    if (gfc_profile.threadCount >= GFC_PROFILE_MAX_THREADS)
+    {
+        if (!gfc_profile.full)slog("gfc_profile: more than %i threads recording at once, not recording the rest",GFC_PROFILE_MAX_THREADS);
+        gfc_profile.full = 1;
+        SDL_AtomicUnlock(&gfc_profile.lock);
+        return -1;
+    }
+    if (!gfc_profile.base)gfc_profile.base = SDL_GetPerformanceCounter();
+    thread->index = gfc_profile.threadCount;
+    gfc_profile.threads[gfc_profile.threadCount++] = thread;
+    SDL_AtomicUnlock(&gfc_profile.lock);
+    return 0;
+}
+
+static GFC_ProfileThread *gfc_profile_get_thread()
+{
+    GFC_ProfileThread *thread;
+    if (gfc_profile_thread_data)return gfc_profile_thread_data;
+    if (gfc_profile_thread_failed)return NULL;
+    SDL_AtomicLock(&gfc_profile.lock);
+    if (!gfc_profile.exitKey)gfc_profile.exitKey = SDL_TLSCreate();
+    thread = gfc_profile_reuse_thread();
+    SDL_AtomicUnlock(&gfc_profile.lock);
+    if (!thread)
+    {
+        //not gfc_allocate_array, that counts allocations and would come back here
+        thread = calloc(1,sizeof(GFC_ProfileThread));
+        if (!thread)
+        {
+            gfc_profile_thread_failed = 1;
+            return NULL;
+        }
+        thread->id = SDL_ThreadID();
+        if (gfc_profile_add_thread(thread) != 0)
+        {
+            free(thread);
+            gfc_profile_thread_failed = 1;
+            return NULL;
+        }
+    }
+    if (gfc_profile.exitKey)SDL_TLSSet(gfc_profile.exitKey,thread,gfc_profile_thread_exit);
+    gfc_profile_thread_data = thread;
+    return thread;
+}
+
+void gfc_profile_begin(const char *name)
+{
+    GFC_ProfileThread *thread;
+    //pushed even while recording is off so that every gfc_profile_end() has a zone to pop
+    thread = gfc_profile_get_thread();
+    if (!thread)return;
+    if (thread->depth < GFC_PROFILE_MAX_DEPTH)
+    {
+        thread->stackName[thread->depth] = name;
+        thread->stackRecord[thread->depth] = SDL_AtomicGet(&gfc_profile_disabled)?0:1;
+        thread->stackStart[thread->depth] = SDL_GetPerformanceCounter();
+    }
+    thread->depth++;
+}
+
+void gfc_profile_end()
+{
+    GFC_ProfileThread *thread;
+    GFC_ProfileEvent *event;
+    Uint64 end;
+    thread = gfc_profile_thread_data;
+    if (!thread)return;
+    if (!thread->depth)return;
+    end = SDL_GetPerformanceCounter();
+    thread->depth--;
+    if (thread->depth >= GFC_PROFILE_MAX_DEPTH)return;
+    if (!thread->stackRecord[thread->depth])return;
+    thread->stackRecord[thread->depth] = 0;
+    if (SDL_AtomicGet(&gfc_profile_disabled))return;
+    event = &thread->events[thread->written & (GFC_PROFILE_RING_SIZE - 1)];
+    event->name = thread->stackName[thread->depth];
+    event->start = thread->stackStart[thread->depth];
+    event->end = end;
+    thread->written++;
+}
+
+Uint8 gfc_profile_zone_begin(const char *name)
+{
+    gfc_profile_begin(name);
+    return 1;
+}
+
+void gfc_profile_zone_end(Uint8 *zone)
+{
+    gfc_profile_end();
+}
+
+void gfc_profile_count(gfcProfileCounter counter,Uint64 amount)
+{
+    GFC_ProfileThread *thread;
+    if ((Uint32)counter >= GFC_PC_MAX)return;
+    if (SDL_AtomicGet(&gfc_profile_disabled))return;
+    thread = gfc_profile_get_thread();
+    if (!thread)return;
+    thread->counters[counter] += amount;
+}
+
+Uint64 gfc_profile_get_counter(gfcProfileCounter counter)
+{
+    Uint64 total = 0;
+    Uint32 i;
+    if ((Uint32)counter >= GFC_PC_MAX)return 0;
+    SDL_AtomicLock(&gfc_profile.lock);
+    for (i = 0; i < gfc_profile.threadCount; i++)
+    {
+        total += gfc_profile.threads[i]->counters[counter];
+    }
+    SDL_AtomicUnlock(&gfc_profile.lock);
+    return total;
+}
+
+const char *gfc_profile_get_counter_name(gfcProfileCounter counter)
+{
+    if ((Uint32)counter >= GFC_PC_MAX)return "unknown";
+    return gfc_profile_counter_names[counter];
+}
+
+void gfc_profile_set_enabled(Uint8 enabled)
+{
+    SDL_AtomicSet(&gfc_profile_disabled,enabled?0:1);
+}
+
+void gfc_profile_reset()
+{
+    Uint32 i;
+    SDL_AtomicLock(&gfc_profile.lock);
+    for (i = 0; i < gfc_profile.threadCount; i++)
+    {
+        gfc_profile.threads[i]->written = 0;
+        memset(gfc_profile.threads[i]->counters,0,sizeof(gfc_profile.threads[i]->counters));
+    }
+    gfc_profile.base = SDL_GetPerformanceCounter();
+    SDL_AtomicUnlock(&gfc_profile.lock);
+}
+
+static void gfc_profile_write_name(FILE *file,const char *name)
+{
+    const char *c;
+    fputc('"',file);
+    if (name)
+    {
+        for (c = name; *c; c++)
+        {
+            if ((*c == '"')||(*c == '\\'))fprintf(file,"\\%c",*c);
+            else if ((unsigned char)*c < 0x20)fprintf(file,"\\u%04x",(unsigned char)*c);
+            else fputc(*c,file);
+        }
+    }
+    fputc('"',file);
+}
+
+static double gfc_profile_micro(Uint64 ticks,Uint64 base,double scale)
+{
+    if (ticks < base)return 0;
+    return (double)(ticks - base) * scale;
+}
+
+int gfc_profile_write_chrome_trace(const char *filename)
+{
+    FILE *file;
+    GFC_ProfileThread *thread;
+    GFC_ProfileEvent *event;
+    Uint64 first,i;
+    Uint32 t,c;
+    double scale;
+    Uint8 comma = 0;
+    if (!filename)return -1;
+    file = fopen(filename,"w");
+    if (!file)
+    {
+        slog("gfc_profile: failed to open %s to write a trace",filename);
+        return -1;
+    }
+    scale = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    fprintf(file,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    SDL_AtomicLock(&gfc_profile.lock);
+    for (t = 0; t < gfc_profile.threadCount; t++)
+    {
+        thread = gfc_profile.threads[t];
+        fprintf(file,"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s %u\"}}",
+            comma?",\n":"",(unsigned long)thread->id,thread->index?"thread":"main",thread->index);
+        comma = 1;
+        first = 0;
+        if (thread->written > GFC_PROFILE_RING_SIZE)first = thread->written - GFC_PROFILE_RING_SIZE;
+        for (i = first; i < thread->written; i++)
+        {
+            event = &thread->events[i & (GFC_PROFILE_RING_SIZE - 1)];
+            fprintf(file,",\n{\"name\":");
+            gfc_profile_write_name(file,event->name);
+            fprintf(file,",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+                (unsigned long)thread->id,
+                gfc_profile_micro(event->start,gfc_profile.base,scale),
+                gfc_profile_micro(event->end,event->start,scale));
+        }
+    }
+    SDL_AtomicUnlock(&gfc_profile.lock);
+    fprintf(file,"%s{\"name\":\"gfc counters\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"args\":{",
+        comma?",\n":"",gfc_profile_micro(SDL_GetPerformanceCounter(),gfc_profile.base,scale));
+    for (c = 0; c < GFC_PC_MAX; c++)
+    {
+        fprintf(file,"%s\"%s\":%llu",c?",":"",gfc_profile_counter_names[c],
+            (unsigned long long)gfc_profile_get_counter((gfcProfileCounter)c));
+    }
+    fprintf(file,"}}\n]}\n");
+    if (fclose(file) != 0)
+    {
+        slog("gfc_profile: failed to finish writing %s",filename);
+        return -1;
+    }
+    return 0;
+}
+
+/*eol@eof*/
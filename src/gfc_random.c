@@ -0,0 +1,177 @@
+#define GFC_RANDOM_IMPLEMENTATION
+#include <math.h>
+
+#include "simple_logger.h"
+
+#include "gfc_random.h"
+
+typedef struct
+{
+    gfcRng  rng;
+    Uint8   seeded;
+}GFC_ThreadRng;
+
+static GFC_THREAD_LOCAL GFC_ThreadRng gfc_thread_rng = {{{0}},0};
+
+static Uint64 gfc_rng_splitmix(Uint64 *x)
+{
+    Uint64 z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+void gfc_rng_seed(gfcRng *rng,Uint64 seed)
+{
+    Uint64 a,b;
+    if (!rng)return;
+    //splitmix spreads the seed over the whole state, so small and similar seeds still give unrelated streams
+    a = gfc_rng_splitmix(&seed);
+    b = gfc_rng_splitmix(&seed);
+    rng->s[0] = (Uint32)a;
+    rng->s[1] = (Uint32)(a >> 32);
+    rng->s[2] = (Uint32)b;
+    rng->s[3] = (Uint32)(b >> 32);
+    if (!(rng->s[0] | rng->s[1] | rng->s[2] | rng->s[3]))rng->s[0] = 1;
+}
+
+gfcRng gfc_rng(Uint64 seed)
+{
+    gfcRng rng;
+    gfc_rng_seed(&rng,seed);
+    return rng;
+}
+
+gfcRng *gfc_rng_thread()
+{
+    if (!gfc_thread_rng.seeded)
+    {
+        gfc_rng_seed(&gfc_thread_rng.rng,SDL_GetPerformanceCounter() ^ ((Uint64)SDL_ThreadID() << 32));
+        gfc_thread_rng.seeded = 1;
+    }
+    return &gfc_thread_rng.rng;
+}
+
+void gfc_rng_thread_seed(Uint64 seed)
+{
+    gfc_rng_seed(&gfc_thread_rng.rng,seed);
+    gfc_thread_rng.seeded = 1;
+}
+
+void gfc_rng_jump(gfcRng *rng)
+{
+    static const Uint32 jump[4] = {0x8764000b,0xf542d2d3,0x6fa035c3,0x77f2db5b};
+    Uint32 s[4] = {0};
+    int i,b;
+    if (!rng)return;
+    for (i = 0; i < 4; i++)
+    {
+        for (b = 0; b < 32; b++)
+        {
+            if (jump[i] & (1u << b))
+            {
+                s[0] ^= rng->s[0];
+                s[1] ^= rng->s[1];
+                s[2] ^= rng->s[2];
+                s[3] ^= rng->s[3];
+            }
+            gfc_rng_next(rng);
+        }
+    }
+    rng->s[0] = s[0];
+    rng->s[1] = s[1];
+    rng->s[2] = s[2];
+    rng->s[3] = s[3];
+}
+
+float gfc_rng_cfloat(gfcRng *rng)
+{
+    return ((Sint32)gfc_rng_next(rng) >> 7) * (1.0f / 16777216.0f);
+}
+
+Uint32 gfc_rng_int(gfcRng *rng,Uint32 n)
+{
+    Uint64 m;
+    Uint32 low,threshold;
+    if (!n)return 0;
+    //Lemire's multiply and shift, rejecting the few values that would make the low results more likely
+    m = (Uint64)gfc_rng_next(rng) * n;
+    low = (Uint32)m;
+    if (low < n)
+    {
+        threshold = (0u - n) % n;
+        while (low < threshold)
+        {
+            m = (Uint64)gfc_rng_next(rng) * n;
+            low = (Uint32)m;
+        }
+    }
+    return (Uint32)(m >> 32);
+}
+
+Sint32 gfc_rng_range(gfcRng *rng,Sint32 min,Sint32 max)
+{
+    Uint32 span;
+    if (max < min)
+    {
+        span = min;
+        min = max;
+        max = span;
+    }
+    span = (Uint32)max - (Uint32)min + 1;
+    if (!span)return (Sint32)gfc_rng_next(rng);//the whole range of Sint32
+    return (Sint32)((Uint32)min + gfc_rng_int(rng,span));
+}
+
+float gfc_rng_range_float(gfcRng *rng,float min,float max)
+{
+    return min + (max - min) * gfc_rng_float(rng);
+}
+
+Vector2D gfc_rng_vector2d_unit(gfcRng *rng)
+{
+    float angle = gfc_rng_float(rng) * GFC_2PI;
+    return vector2d(cosf(angle),sinf(angle));
+}
+
+Vector3D gfc_rng_vector3d_unit(gfcRng *rng)
+{
+    float z,r,angle;
+    //an even spread of z with an even spread of angle around it is even over the sphere
+    z = gfc_rng_cfloat(rng);
+    r = sqrtf(MAX(1 - z * z,0));
+    angle = gfc_rng_float(rng) * GFC_2PI;
+    return vector3d(r * cosf(angle),r * sinf(angle),z);
+}
+
+Vector3D gfc_rng_vector3d_range(gfcRng *rng,Vector3D min,Vector3D max)
+{
+    Vector3D v;
+    v.x = gfc_rng_range_float(rng,min.x,max.x);
+    v.y = gfc_rng_range_float(rng,min.y,max.y);
+    v.z = gfc_rng_range_float(rng,min.z,max.z);
+    return v;
+}
+
+void gfc_rng_fill_floats(gfcRng *rng,float *out,Uint32 count)
+{
+    gfcRng s;
+    Uint32 i;
+    if ((!rng)||(!out))return;
+    //work on a local copy so the state stays in registers instead of being stored back each time
+    s = *rng;
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        out[i] = gfc_rng_float(&s);
+        out[i + 1] = gfc_rng_float(&s);
+        out[i + 2] = gfc_rng_float(&s);
+        out[i + 3] = gfc_rng_float(&s);
+    }
+    for (; i < count; i++)
+    {
+        out[i] = gfc_rng_float(&s);
+    }
+    *rng = s;
+}
+
+/*eol@eof*/
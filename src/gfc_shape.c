@@ -1,3 +1,4 @@
+#define GFC_SHAPE_IMPLEMENTATION
 #include <assert.h>
 
 #include "simple_logger.h"
@@ -10,11 +11,6 @@ Uint8 gfc_edge_circle_intersection_poc_old(Edge e,Circle c,Vector2D *poc,Vector2
 Uint8 gfc_edge_to_circle_intersection_poc(Edge e,Circle c,Vector2D *poc,Vector2D *normal);
 Uint8 gfc_circle_to_edge_intersection_poc(Edge e,Circle c,Vector2D *poc,Vector2D *normal);
 
-Vector2D gfc_rect_get_center_point(Rect r)
-{
-    return vector2d(r.x + r.w*0.5,r.y + r.h*0.5);
-}
-
 Vector2D gfc_edge_get_normal_for_rect(Edge e, Rect r)
 {
     Vector2D out = {0};
@@ -357,53 +353,6 @@ Vector2D gfc_shape_get_normal_for_shape(Shape s, Shape s2)
     return out;
 }
 
-Vector4D gfc_rect_to_vector4d(Rect r)
-{
-    return vector4d(r.x,r.y,r.w,r.h);
-}
-
-Rect gfc_rect(float x, float y, float w, float h)
-{
-    Rect r;
-    gfc_rect_set(r,x,y,w,h);
-    return r;
-}
-
-Circle gfc_circle(float x, float y, float r)
-{
-    Circle c;
-    gfc_circle_set(c,x,y,r);
-    return c;
-}
-
-SDL_Rect gfc_rect_to_sdl_rect(Rect r)
-{
-    SDL_Rect r2;
-    r2.x = r.x;
-    r2.y = r.y;
-    r2.w = r.w;
-    r2.h = r.h;
-    return r2;
-}
-
-Rect gfc_rect_from_sdl_rect(SDL_Rect r)
-{
-    Rect r2;
-    r2.x = r.x;
-    r2.y = r.y;
-    r2.w = r.w;
-    r2.h = r.h;
-    return r2;
-}
-
-Uint8 gfc_point_in_rect(Vector2D p,Rect r)
-{
-    if ((p.x >= r.x) && (p.x <= r.x + r.w)&&
-        (p.y >= r.y) && (p.y <= r.y + r.h))
-        return 1;
-    return 0;
-}
-
 
 Uint8 gfc_rect_overlap_poc(Rect a,Rect b,Vector2D *poc, Vector2D *normal)
 {
@@ -461,12 +410,6 @@ Uint8 gfc_point_in_shape(Vector2D p,Shape s)
     return 0;
 }
 
-Uint8 gfc_point_in_cicle(Vector2D p,Circle c)
-{
-    if (vector2d_magnitude_compare(vector2d(c.x-p.x,c.y-p.y),c.r) <= 0)return 1;
-    return 0;
-}
-
 // return number of points of intersection (0, 1, 2, or -1 if the circles are the same)
 
 int gfc_circle_intersect_circle(Circle A, Circle B, Vector2D *pocA, Vector2D *pocB)
@@ -707,28 +650,6 @@ Uint8 gfc_shape_overlap(Shape a, Shape b)
     return gfc_shape_overlap_poc(a,b,NULL,NULL);
 }
 
-Shape gfc_shape_rect(float x, float y, float w, float h)
-{
-    Shape shape;
-    shape.type = ST_RECT;
-    shape.s.r.x = x;
-    shape.s.r.y = y;
-    shape.s.r.w = w;
-    shape.s.r.h = h;
-    return shape;
-}
-
-Shape gfc_shape_from_rect(Rect r)
-{
-    Shape shape;
-    shape.type = ST_RECT;
-    shape.s.r.x = r.x;
-    shape.s.r.y = r.y;
-    shape.s.r.w = r.w;
-    shape.s.r.h = r.h;
-    return shape;
-}
-
 Shape gfc_shape_sdl_rect(SDL_Rect r)
 {
     Shape shape;
@@ -740,26 +661,6 @@ Shape gfc_shape_sdl_rect(SDL_Rect r)
     return shape;
 }
 
-Shape gfc_shape_circle(float x, float y, float r)
-{
-    Shape shape;
-    shape.type = ST_CIRCLE;
-    shape.s.c.x = x; 
-    shape.s.c.y = y;
-    shape.s.c.r = r;
-    return shape;
-}
-
-Shape gfc_shape_from_circle(Circle c)
-{
-    Shape shape;
-    shape.type = ST_CIRCLE;
-    shape.s.c.x = c.x;
-    shape.s.c.y = c.y;
-    shape.s.c.r = c.r;
-    return shape;
-}
-
 Circle gfc_shape_to_circle(Shape s)
 {
     Circle c = {0};
@@ -777,19 +678,6 @@ Circle gfc_shape_to_circle(Shape s)
     }
 }
 
-Shape gfc_shape_edge(float x1,float y1,float x2,float y2)
-{
-    return gfc_shape_from_edge(gfc_edge(x1,y1,x2,y2));
-}
-
-Shape gfc_shape_from_edge(Edge e)
-{
-    Shape shape;
-    shape.type = ST_EDGE;
-    gfc_edge_copy(shape.s.e,e);
-    return shape;
-}
-
 void gfc_shape_copy(Shape *dst,Shape src)
 {
     if (!dst)return;
@@ -854,20 +742,6 @@ Uint8 gfc_edge_intersect(Edge a,Edge b)
     return gfc_edge_intersect_poc(a,b,NULL,NULL);
 }
 
-Edge gfc_edge(float x1, float y1, float x2, float y2)
-{
-    Edge e;
-    gfc_edge_set(e,x1,y1,x2,y2);
-    return e;
-}
-
-Edge gfc_edge_from_vectors(Vector2D a,Vector2D b)
-{
-    Edge e;
-    gfc_edge_set(e,a.x,a.y,b.x,b.y);
-    return e;
-}
-
 Uint8 gfc_rect_to_intersection_poc(Edge e, Rect r,Vector2D *poc,Vector2D *normal)
 {
     Uint8 ret;
@@ -1259,14 +1133,6 @@ void gfc_shape_slog(Shape shape)
     }
 }
 
-float gfc_edge_length(Edge e)
-{
-    float a,b;
-    a = e.x1 - e.x2;
-    b = e.y1 - e.y2;
-    return vector2d_magnitude(vector2d(a,b));
-}
-
 Circle gfc_edge_get_bounding_circle(Edge e)
 {
     Circle c;
@@ -1309,16 +1175,6 @@ Rect gfc_circle_get_bounds(Circle c)
     return r;
 }
 
-Rect gfc_rect_from_vector4(Vector4D v)
-{
-    Rect r;
-    r.x = v.x;
-    r.y = v.y;
-    r.w = v.z;
-    r.h = v.w;
-    return r;
-}
-
 Rect gfc_shape_get_bounds(Shape shape)
 {
     Rect r = {0,0,0,0};
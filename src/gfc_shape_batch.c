@@ -0,0 +1,448 @@
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_simd.h"
+#include "gfc_shape_batch.h"
+
+#if defined(GFC_SIMD) && !defined(GFC_SHAPE_BATCH_SCALAR)
+#define GFC_BATCH_SIMD 1
+#endif
+
+#define GFC_BATCH_BLOCK 256     /**<shapes tested per pass when building contact lists*/
+
+/**
+ * @brief grow the streams of a batch so they hold at least count floats, padded to a multiple of 4
+ * the padding is zeroed so the SIMD kernels can always read whole groups of four
+ */
+static int gfc_shape_batch_reserve(float **streams[],Uint32 streamCount,Uint32 *size,Uint32 count)
+{
+    float *stream;
+    Uint32 i,newSize;
+    if (count <= *size)return 0;
+    newSize = *size?*size:8;
+    while (newSize < count)newSize *= 2;
+    newSize = (newSize + 3) & ~3u;
+    for (i = 0; i < streamCount; i++)
+    {
+        stream = realloc(*streams[i],sizeof(float) * newSize);
+        if (!stream)
+        {
+            slog("failed to grow shape batch");
+            return -1;
+        }
+        memset(&stream[*size],0,sizeof(float) * (newSize - *size));
+        *streams[i] = stream;
+    }
+    *size = newSize;
+    return 0;
+}
+
+static void gfc_shape_batch_free_streams(float **streams[],Uint32 streamCount)
+{
+    Uint32 i;
+    for (i = 0; i < streamCount; i++)
+    {
+        if (*streams[i])free(*streams[i]);
+    }
+}
+
+/*circles*/
+
+gfcCircleBatch *gfc_circle_batch_new(Uint32 count)
+{
+    gfcCircleBatch *batch;
+    batch = gfc_allocate_array(sizeof(gfcCircleBatch),1);
+    if (!batch)return NULL;
+    {
+        float **streams[] = {&batch->x,&batch->y,&batch->r};
+        if (gfc_shape_batch_reserve(streams,3,&batch->size,count?count:8) != 0)
+        {
+            gfc_circle_batch_free(batch);
+            return NULL;
+        }
+    }
+    return batch;
+}
+
+void gfc_circle_batch_free(gfcCircleBatch *batch)
+{
+    if (!batch)return;
+    {
+        float **streams[] = {&batch->x,&batch->y,&batch->r};
+        gfc_shape_batch_free_streams(streams,3);
+    }
+    free(batch);
+}
+
+int gfc_circle_batch_append(gfcCircleBatch *batch,Circle c)
+{
+    if (!batch)return -1;
+    {
+        float **streams[] = {&batch->x,&batch->y,&batch->r};
+        if (gfc_shape_batch_reserve(streams,3,&batch->size,batch->count + 1) != 0)return -1;
+    }
+    gfc_circle_batch_set(batch,batch->count++,c);
+    return batch->count - 1;
+}
+
+void gfc_circle_batch_set(gfcCircleBatch *batch,Uint32 n,Circle c)
+{
+    if ((!batch)||(n >= batch->count))return;
+    batch->x[n] = c.x;
+    batch->y[n] = c.y;
+    batch->r[n] = c.r;
+}
+
+Circle gfc_circle_batch_get(gfcCircleBatch *batch,Uint32 n)
+{
+    Circle c = {0};
+    if ((!batch)||(n >= batch->count))return c;
+    return gfc_circle(batch->x[n],batch->y[n],batch->r[n]);
+}
+
+/*rects*/
+
+gfcRectBatch *gfc_rect_batch_new(Uint32 count)
+{
+    gfcRectBatch *batch;
+    batch = gfc_allocate_array(sizeof(gfcRectBatch),1);
+    if (!batch)return NULL;
+    {
+        float **streams[] = {&batch->x,&batch->y,&batch->w,&batch->h};
+        if (gfc_shape_batch_reserve(streams,4,&batch->size,count?count:8) != 0)
+        {
+            gfc_rect_batch_free(batch);
+            return NULL;
+        }
+    }
+    return batch;
+}
+
+void gfc_rect_batch_free(gfcRectBatch *batch)
+{
+    if (!batch)return;
+    {
+        float **streams[] = {&batch->x,&batch->y,&batch->w,&batch->h};
+        gfc_shape_batch_free_streams(streams,4);
+    }
+    free(batch);
+}
+
+int gfc_rect_batch_append(gfcRectBatch *batch,Rect r)
+{
+    if (!batch)return -1;
+    {
+        float **streams[] = {&batch->x,&batch->y,&batch->w,&batch->h};
+        if (gfc_shape_batch_reserve(streams,4,&batch->size,batch->count + 1) != 0)return -1;
+    }
+    gfc_rect_batch_set(batch,batch->count++,r);
+    return batch->count - 1;
+}
+
+void gfc_rect_batch_set(gfcRectBatch *batch,Uint32 n,Rect r)
+{
+    if ((!batch)||(n >= batch->count))return;
+    batch->x[n] = r.x;
+    batch->y[n] = r.y;
+    batch->w[n] = r.w;
+    batch->h[n] = r.h;
+}
+
+Rect gfc_rect_batch_get(gfcRectBatch *batch,Uint32 n)
+{
+    Rect r = {0};
+    if ((!batch)||(n >= batch->count))return r;
+    return gfc_rect(batch->x[n],batch->y[n],batch->w[n],batch->h[n]);
+}
+
+/*edges*/
+
+gfcEdgeBatch *gfc_edge_batch_new(Uint32 count)
+{
+    gfcEdgeBatch *batch;
+    batch = gfc_allocate_array(sizeof(gfcEdgeBatch),1);
+    if (!batch)return NULL;
+    {
+        float **streams[] = {&batch->x1,&batch->y1,&batch->x2,&batch->y2};
+        if (gfc_shape_batch_reserve(streams,4,&batch->size,count?count:8) != 0)
+        {
+            gfc_edge_batch_free(batch);
+            return NULL;
+        }
+    }
+    return batch;
+}
+
+void gfc_edge_batch_free(gfcEdgeBatch *batch)
+{
+    if (!batch)return;
+    {
+        float **streams[] = {&batch->x1,&batch->y1,&batch->x2,&batch->y2};
+        gfc_shape_batch_free_streams(streams,4);
+    }
+    free(batch);
+}
+
+int gfc_edge_batch_append(gfcEdgeBatch *batch,Edge e)
+{
+    if (!batch)return -1;
+    {
+        float **streams[] = {&batch->x1,&batch->y1,&batch->x2,&batch->y2};
+        if (gfc_shape_batch_reserve(streams,4,&batch->size,batch->count + 1) != 0)return -1;
+    }
+    gfc_edge_batch_set(batch,batch->count++,e);
+    return batch->count - 1;
+}
+
+void gfc_edge_batch_set(gfcEdgeBatch *batch,Uint32 n,Edge e)
+{
+    if ((!batch)||(n >= batch->count))return;
+    batch->x1[n] = e.x1;
+    batch->y1[n] = e.y1;
+    batch->x2[n] = e.x2;
+    batch->y2[n] = e.y2;
+}
+
+Edge gfc_edge_batch_get(gfcEdgeBatch *batch,Uint32 n)
+{
+    Edge e = {0};
+    if ((!batch)||(n >= batch->count))return e;
+    return gfc_edge(batch->x1[n],batch->y1[n],batch->x2[n],batch->y2[n]);
+}
+
+/*kernels
+ * each tests shapes [start,end) and ORs hit bits into hits, bit 0 of hits[0] is shape start
+ * start must be a multiple of 32
+ */
+
+#ifdef GFC_BATCH_SIMD
+static const Uint8 gfc_batch_lane_count[16] = {0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4};
+
+static Uint32 gfc_shape_batch_lanes(Uint32 i,Uint32 end)
+{
+    if (end - i >= 4)return 0xF;
+    return (1u << (end - i)) - 1;
+}
+#endif
+
+static Uint32 gfc_circle_overlap_range(Circle a,gfcCircleBatch *batch,Uint32 start,Uint32 end,Uint32 *hits)
+{
+    Uint32 i,bits,found = 0;
+#ifdef GFC_BATCH_SIMD
+    gfc_f4 ax = gfc_f4_set1(a.x),ay = gfc_f4_set1(a.y),ar = gfc_f4_set1(a.r);
+    gfc_f4 dx,dy,rr;
+    for (i = start; i < end; i += 4)
+    {
+        dx = gfc_f4_sub(ax,gfc_f4_load(&batch->x[i]));
+        dy = gfc_f4_sub(ay,gfc_f4_load(&batch->y[i]));
+        rr = gfc_f4_add(ar,gfc_f4_load(&batch->r[i]));
+        bits = gfc_m4_bits(gfc_f4_le(
+            gfc_f4_add(gfc_f4_mul(dx,dx),gfc_f4_mul(dy,dy)),
+            gfc_f4_mul(rr,rr))) & gfc_shape_batch_lanes(i,end);
+        if (!bits)continue;
+        found += gfc_batch_lane_count[bits];
+        hits[(i - start) >> 5] |= bits << ((i - start) & 31);
+    }
+#else
+    for (i = start; i < end; i++)
+    {
+        if (!gfc_circle_overlap(a,gfc_circle(batch->x[i],batch->y[i],batch->r[i])))continue;
+        found++;
+        hits[(i - start) >> 5] |= 1u << ((i - start) & 31);
+    }
+    (void)bits;
+#endif
+    return found;
+}
+
+static Uint32 gfc_rect_overlap_range(Rect a,gfcRectBatch *batch,Uint32 start,Uint32 end,Uint32 *hits)
+{
+    Uint32 i,bits,found = 0;
+#ifdef GFC_BATCH_SIMD
+    gfc_f4 ax = gfc_f4_set1(a.x),ay = gfc_f4_set1(a.y);
+    gfc_f4 ax2 = gfc_f4_set1(a.x + a.w),ay2 = gfc_f4_set1(a.y + a.h);
+    gfc_f4 bx,by;
+    gfc_m4 miss;
+    for (i = start; i < end; i += 4)
+    {
+        bx = gfc_f4_load(&batch->x[i]);
+        by = gfc_f4_load(&batch->y[i]);
+        miss = gfc_m4_or(
+            gfc_m4_or(gfc_f4_gt(ax,gfc_f4_add(bx,gfc_f4_load(&batch->w[i]))),gfc_f4_gt(bx,ax2)),
+            gfc_m4_or(gfc_f4_gt(ay,gfc_f4_add(by,gfc_f4_load(&batch->h[i]))),gfc_f4_gt(by,ay2)));
+        bits = ~gfc_m4_bits(miss) & gfc_shape_batch_lanes(i,end);
+        if (!bits)continue;
+        found += gfc_batch_lane_count[bits];
+        hits[(i - start) >> 5] |= bits << ((i - start) & 31);
+    }
+#else
+    for (i = start; i < end; i++)
+    {
+        if (!gfc_rect_overlap(a,gfc_rect(batch->x[i],batch->y[i],batch->w[i],batch->h[i])))continue;
+        found++;
+        hits[(i - start) >> 5] |= 1u << ((i - start) & 31);
+    }
+    (void)bits;
+#endif
+    return found;
+}
+
+static Uint32 gfc_edge_intersect_range(Edge a,gfcEdgeBatch *batch,Uint32 start,Uint32 end,Uint32 *hits)
+{
+    Uint32 i,bits,found = 0;
+#ifdef GFC_BATCH_SIMD
+    gfc_f4 ax1 = gfc_f4_set1(a.x1),ay1 = gfc_f4_set1(a.y1);
+    gfc_f4 adx = gfc_f4_set1(a.x2 - a.x1),ady = gfc_f4_set1(a.y2 - a.y1);
+    gfc_f4 zero = gfc_f4_set1(0),one = gfc_f4_set1(1);
+    gfc_f4 bx1,by1,bdx,bdy,ox,oy,den,ua,ub;
+    gfc_m4 hit;
+    for (i = start; i < end; i += 4)
+    {
+        bx1 = gfc_f4_load(&batch->x1[i]);
+        by1 = gfc_f4_load(&batch->y1[i]);
+        bdx = gfc_f4_sub(gfc_f4_load(&batch->x2[i]),bx1);
+        bdy = gfc_f4_sub(gfc_f4_load(&batch->y2[i]),by1);
+        ox = gfc_f4_sub(ax1,bx1);
+        oy = gfc_f4_sub(ay1,by1);
+        den = gfc_f4_sub(gfc_f4_mul(bdy,adx),gfc_f4_mul(bdx,ady));
+        ua = gfc_f4_div(gfc_f4_sub(gfc_f4_mul(bdx,oy),gfc_f4_mul(bdy,ox)),den);
+        ub = gfc_f4_div(gfc_f4_sub(gfc_f4_mul(adx,oy),gfc_f4_mul(ady,ox)),den);
+        hit = gfc_m4_and(
+            gfc_m4_and(gfc_f4_ne(den,zero),gfc_m4_and(gfc_f4_le(zero,ua),gfc_f4_le(ua,one))),
+            gfc_m4_and(gfc_f4_le(zero,ub),gfc_f4_le(ub,one)));
+        bits = gfc_m4_bits(hit) & gfc_shape_batch_lanes(i,end);
+        if (!bits)continue;
+        found += gfc_batch_lane_count[bits];
+        hits[(i - start) >> 5] |= bits << ((i - start) & 31);
+    }
+#else
+    for (i = start; i < end; i++)
+    {
+        if (!gfc_edge_intersect(a,gfc_edge(batch->x1[i],batch->y1[i],batch->x2[i],batch->y2[i])))continue;
+        found++;
+        hits[(i - start) >> 5] |= 1u << ((i - start) & 31);
+    }
+    (void)bits;
+#endif
+    return found;
+}
+
+Uint32 gfc_circle_overlap_batch(Circle a,gfcCircleBatch *batch,Uint32 *hits)
+{
+    Uint32 block[GFC_BATCH_BLOCK / 32];
+    Uint32 start,found = 0;
+    if ((!batch)||(!batch->count))return 0;
+    if (hits)
+    {
+        memset(hits,0,sizeof(Uint32) * gfc_shape_batch_mask_words(batch->count));
+        return gfc_circle_overlap_range(a,batch,0,batch->count,hits);
+    }
+    for (start = 0; start < batch->count; start += GFC_BATCH_BLOCK)
+    {
+        memset(block,0,sizeof(block));
+        found += gfc_circle_overlap_range(a,batch,start,MIN(start + GFC_BATCH_BLOCK,batch->count),block);
+    }
+    return found;
+}
+
+Uint32 gfc_rect_overlap_batch(Rect a,gfcRectBatch *batch,Uint32 *hits)
+{
+    Uint32 block[GFC_BATCH_BLOCK / 32];
+    Uint32 start,found = 0;
+    if ((!batch)||(!batch->count))return 0;
+    if (hits)
+    {
+        memset(hits,0,sizeof(Uint32) * gfc_shape_batch_mask_words(batch->count));
+        return gfc_rect_overlap_range(a,batch,0,batch->count,hits);
+    }
+    for (start = 0; start < batch->count; start += GFC_BATCH_BLOCK)
+    {
+        memset(block,0,sizeof(block));
+        found += gfc_rect_overlap_range(a,batch,start,MIN(start + GFC_BATCH_BLOCK,batch->count),block);
+    }
+    return found;
+}
+
+Uint32 gfc_edge_intersect_batch(Edge a,gfcEdgeBatch *batch,Uint32 *hits)
+{
+    Uint32 block[GFC_BATCH_BLOCK / 32];
+    Uint32 start,found = 0;
+    if ((!batch)||(!batch->count))return 0;
+    if (hits)
+    {
+        memset(hits,0,sizeof(Uint32) * gfc_shape_batch_mask_words(batch->count));
+        return gfc_edge_intersect_range(a,batch,0,batch->count,hits);
+    }
+    for (start = 0; start < batch->count; start += GFC_BATCH_BLOCK)
+    {
+        memset(block,0,sizeof(block));
+        found += gfc_edge_intersect_range(a,batch,start,MIN(start + GFC_BATCH_BLOCK,batch->count),block);
+    }
+    return found;
+}
+
+/*contacts: the kernels find the candidates, the poc functions confirm them and fill in the contact*/
+
+Uint32 gfc_circle_overlap_batch_contacts(Circle a,gfcCircleBatch *batch,gfcBatchContact *contacts,Uint32 maxContacts)
+{
+    Uint32 block[GFC_BATCH_BLOCK / 32];
+    Uint32 start,end,i,count = 0;
+    if ((!batch)||(!contacts))return 0;
+    for (start = 0; (start < batch->count)&&(count < maxContacts); start += GFC_BATCH_BLOCK)
+    {
+        end = MIN(start + GFC_BATCH_BLOCK,batch->count);
+        memset(block,0,sizeof(block));
+        if (!gfc_circle_overlap_range(a,batch,start,end,block))continue;
+        for (i = start; (i < end)&&(count < maxContacts); i++)
+        {
+            if (!gfc_shape_batch_hit(block,i - start))continue;
+            if (!gfc_circle_overlap_poc(a,gfc_circle_batch_get(batch,i),&contacts[count].poc,&contacts[count].normal))continue;
+            contacts[count++].index = i;
+        }
+    }
+    return count;
+}
+
+Uint32 gfc_rect_overlap_batch_contacts(Rect a,gfcRectBatch *batch,gfcBatchContact *contacts,Uint32 maxContacts)
+{
+    Uint32 block[GFC_BATCH_BLOCK / 32];
+    Uint32 start,end,i,count = 0;
+    if ((!batch)||(!contacts))return 0;
+    for (start = 0; (start < batch->count)&&(count < maxContacts); start += GFC_BATCH_BLOCK)
+    {
+        end = MIN(start + GFC_BATCH_BLOCK,batch->count);
+        memset(block,0,sizeof(block));
+        if (!gfc_rect_overlap_range(a,batch,start,end,block))continue;
+        for (i = start; (i < end)&&(count < maxContacts); i++)
+        {
+            if (!gfc_shape_batch_hit(block,i - start))continue;
+            if (!gfc_rect_overlap_poc(a,gfc_rect_batch_get(batch,i),&contacts[count].poc,&contacts[count].normal))continue;
+            contacts[count++].index = i;
+        }
+    }
+    return count;
+}
+
+Uint32 gfc_edge_intersect_batch_contacts(Edge a,gfcEdgeBatch *batch,gfcBatchContact *contacts,Uint32 maxContacts)
+{
+    Uint32 block[GFC_BATCH_BLOCK / 32];
+    Uint32 start,end,i,count = 0;
+    if ((!batch)||(!contacts))return 0;
+    for (start = 0; (start < batch->count)&&(count < maxContacts); start += GFC_BATCH_BLOCK)
+    {
+        end = MIN(start + GFC_BATCH_BLOCK,batch->count);
+        memset(block,0,sizeof(block));
+        if (!gfc_edge_intersect_range(a,batch,start,end,block))continue;
+        for (i = start; (i < end)&&(count < maxContacts); i++)
+        {
+            if (!gfc_shape_batch_hit(block,i - start))continue;
+            if (!gfc_edge_intersect_poc(a,gfc_edge_batch_get(batch,i),&contacts[count].poc,&contacts[count].normal))continue;
+            contacts[count++].index = i;
+        }
+    }
+    return count;
+}
+
+/*eol@eof*/
@@ -0,0 +1,649 @@
+#include <math.h>
+#include <float.h>
+
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_spatial.h"
+
+#define GFC_SPATIAL_MAX_PROXY_CELLS 64      /**<shapes covering more cells than this are kept off the grid*/
+#define GFC_SPATIAL_MIN_CELLS 64
+#define GFC_SPATIAL_COORD_LIMIT 1000000000.0
+
+typedef struct
+{
+    Sint32  x,y;
+    Uint32 *proxies;    /**<handles of the shapes touching this cell*/
+    Uint32  count;
+    Uint32  size;
+    Uint8   used;       /**<this slot of the cell table has been claimed*/
+}GFC_SpatialCell;
+
+typedef struct
+{
+    Shape   shape;
+    Rect    bounds;
+    void   *data;
+    Sint32  range[4];   /**<the cells covered: min x, min y, max x, max y*/
+    Uint32  stamp;      /**<the last query that visited this shape*/
+    Uint32  nextFree;
+    Uint8   inUse;
+    Uint8   oversized;  /**<too big for the grid, lives in the oversized list*/
+}GFC_SpatialProxy;
+
+struct gfcSpatialIndex_S
+{
+    float               cellSize;
+    double              invCellSize;
+    GFC_SpatialCell    *cells;          /**<open addressing table of cells, size is a power of two*/
+    Uint32              cellTableSize;
+    Uint32              cellsUsed;
+    GFC_SpatialCell     oversized;      /**<shapes that are tested by every query*/
+    GFC_SpatialProxy   *proxies;
+    Uint32              proxySize;
+    Uint32              proxyHighWater; /**<proxies past this have never been used*/
+    Uint32              freeHead;       /**<1 based index of the first free proxy, 0 if none*/
+    Uint32              count;
+    Uint32              stamp;
+};
+
+static Uint32 gfc_spatial_cell_hash(Sint32 x,Sint32 y)
+{
+    Uint32 h;
+    h = ((Uint32)x * 73856093u) ^ ((Uint32)y * 19349663u);
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    return h;
+}
+
+gfcSpatialIndex *gfc_spatial_index_new(float cellSize)
+{
+    gfcSpatialIndex *index;
+    if (cellSize <= 0)
+    {
+        slog("spatial index cell size must be positive");
+        return NULL;
+    }
+    index = gfc_allocate_array(sizeof(gfcSpatialIndex),1);
+    if (!index)return NULL;
+    index->cellSize = cellSize;
+    index->invCellSize = 1.0 / cellSize;
+    index->cellTableSize = GFC_SPATIAL_MIN_CELLS;
+    index->cells = gfc_allocate_array(sizeof(GFC_SpatialCell),index->cellTableSize);
+    if (!index->cells)
+    {
+        free(index);
+        return NULL;
+    }
+    index->stamp = 1;
+    return index;
+}
+
+void gfc_spatial_index_free(gfcSpatialIndex *index)
+{
+    Uint32 i;
+    if (!index)return;
+    for (i = 0; i < index->cellTableSize; i++)
+    {
+        if (index->cells[i].proxies)free(index->cells[i].proxies);
+    }
+    free(index->cells);
+    if (index->oversized.proxies)free(index->oversized.proxies);
+    if (index->proxies)free(index->proxies);
+    free(index);
+}
+
+static GFC_SpatialCell *gfc_spatial_cell_slot(GFC_SpatialCell *cells,Uint32 tableSize,Sint32 x,Sint32 y)
+{
+    Uint32 i;
+    i = gfc_spatial_cell_hash(x,y) & (tableSize - 1);
+    while ((cells[i].used)&&((cells[i].x != x)||(cells[i].y != y)))
+    {
+        i = (i + 1) & (tableSize - 1);
+    }
+    return &cells[i];
+}
+
+static int gfc_spatial_cells_resize(gfcSpatialIndex *index,Uint32 size)
+{
+    GFC_SpatialCell *cells,*slot;
+    Uint32 i;
+    cells = gfc_allocate_array(sizeof(GFC_SpatialCell),size);
+    if (!cells)return -1;
+    for (i = 0; i < index->cellTableSize; i++)
+    {
+        if (!index->cells[i].used)continue;
+        slot = gfc_spatial_cell_slot(cells,size,index->cells[i].x,index->cells[i].y);
+        memcpy(slot,&index->cells[i],sizeof(GFC_SpatialCell));
+    }
+    free(index->cells);
+    index->cells = cells;
+    index->cellTableSize = size;
+    return 0;
+}
+
+/**
+ * @brief give back a cell that no longer holds any shapes
+ * @note uses backward shift deletion so the probe chains stay intact without tombstones
+ */
+static void gfc_spatial_cell_release(gfcSpatialIndex *index,GFC_SpatialCell *cell)
+{
+    Uint32 i,j,home,mask;
+    mask = index->cellTableSize - 1;
+    if (cell->proxies)free(cell->proxies);
+    i = cell - index->cells;
+    for (j = (i + 1) & mask; index->cells[j].used; j = (j + 1) & mask)
+    {
+        home = gfc_spatial_cell_hash(index->cells[j].x,index->cells[j].y) & mask;
+        //leave it if its home slot lies cyclically between the hole and where it sits
+        if (((j - home) & mask) < ((j - i) & mask))continue;
+        memcpy(&index->cells[i],&index->cells[j],sizeof(GFC_SpatialCell));
+        i = j;
+    }
+    memset(&index->cells[i],0,sizeof(GFC_SpatialCell));
+    index->cellsUsed--;
+    if ((index->cellTableSize > GFC_SPATIAL_MIN_CELLS)&&(index->cellsUsed * 8 < index->cellTableSize))
+    {
+        gfc_spatial_cells_resize(index,index->cellTableSize / 2);
+    }
+}
+
+void gfc_spatial_index_clear(gfcSpatialIndex *index)
+{
+    GFC_SpatialCell *cells;
+    Uint32 i;
+    if (!index)return;
+    for (i = 0; i < index->cellTableSize; i++)
+    {
+        if (index->cells[i].proxies)free(index->cells[i].proxies);
+    }
+    memset(index->cells,0,sizeof(GFC_SpatialCell) * index->cellTableSize);
+    index->cellsUsed = 0;
+    if (index->cellTableSize > GFC_SPATIAL_MIN_CELLS)
+    {
+        cells = gfc_allocate_array(sizeof(GFC_SpatialCell),GFC_SPATIAL_MIN_CELLS);
+        if (cells)
+        {
+            free(index->cells);
+            index->cells = cells;
+            index->cellTableSize = GFC_SPATIAL_MIN_CELLS;
+        }
+    }
+    index->oversized.count = 0;
+    index->proxyHighWater = 0;
+    index->freeHead = 0;
+    index->count = 0;
+}
+
+/**
+ * @brief find a cell, optionally claiming it
+ * @return NULL if the cell was not found (or could not be made), the cell otherwise
+ */
+static GFC_SpatialCell *gfc_spatial_cell_get(gfcSpatialIndex *index,Sint32 x,Sint32 y,Uint8 create)
+{
+    GFC_SpatialCell *cell;
+    cell = gfc_spatial_cell_slot(index->cells,index->cellTableSize,x,y);
+    if (cell->used)return cell;
+    if (!create)return NULL;
+    if ((index->cellsUsed + 1) * 4 > index->cellTableSize * 3)
+    {
+        if (gfc_spatial_cells_resize(index,index->cellTableSize * 2) != 0)return NULL;
+        cell = gfc_spatial_cell_slot(index->cells,index->cellTableSize,x,y);
+    }
+    cell->used = 1;
+    cell->x = x;
+    cell->y = y;
+    index->cellsUsed++;
+    return cell;
+}
+
+static int gfc_spatial_cell_add(GFC_SpatialCell *cell,Uint32 proxy)
+{
+    Uint32 *proxies;
+    if (cell->count >= cell->size)
+    {
+        proxies = realloc(cell->proxies,sizeof(Uint32) * (cell->size?cell->size * 2:4));
+        if (!proxies)
+        {
+            slog("failed to grow spatial index cell");
+            return -1;
+        }
+        cell->proxies = proxies;
+        cell->size = cell->size?cell->size * 2:4;
+    }
+    cell->proxies[cell->count++] = proxy;
+    return 0;
+}
+
+static void gfc_spatial_cell_remove(GFC_SpatialCell *cell,Uint32 proxy)
+{
+    Uint32 i;
+    for (i = 0; i < cell->count; i++)
+    {
+        if (cell->proxies[i] != proxy)continue;
+        cell->proxies[i] = cell->proxies[--cell->count];
+        return;
+    }
+}
+
+static Sint32 gfc_spatial_coord(gfcSpatialIndex *index,double v)
+{
+    v = floor(v * index->invCellSize);
+    if (v < -GFC_SPATIAL_COORD_LIMIT)return (Sint32)-GFC_SPATIAL_COORD_LIMIT;
+    if (v > GFC_SPATIAL_COORD_LIMIT)return (Sint32)GFC_SPATIAL_COORD_LIMIT;
+    return (Sint32)v;
+}
+
+static void gfc_spatial_range(gfcSpatialIndex *index,Rect r,Sint32 range[4])
+{
+    range[0] = gfc_spatial_coord(index,r.x);
+    range[1] = gfc_spatial_coord(index,r.y);
+    range[2] = gfc_spatial_coord(index,r.x + r.w);
+    range[3] = gfc_spatial_coord(index,r.y + r.h);
+}
+
+static Uint64 gfc_spatial_range_cells(Sint32 range[4])
+{
+    return (Uint64)(range[2] - range[0] + 1) * (Uint64)(range[3] - range[1] + 1);
+}
+
+static GFC_SpatialProxy *gfc_spatial_proxy_get(gfcSpatialIndex *index,Uint32 proxy)
+{
+    if ((!index)||(!proxy)||(proxy > index->proxyHighWater))return NULL;
+    if (!index->proxies[proxy - 1].inUse)return NULL;
+    return &index->proxies[proxy - 1];
+}
+
+static void gfc_spatial_proxy_link(gfcSpatialIndex *index,Uint32 id,GFC_SpatialProxy *proxy)
+{
+    GFC_SpatialCell *cell;
+    Sint32 x,y;
+    gfc_spatial_range(index,proxy->bounds,proxy->range);
+    proxy->oversized = (gfc_spatial_range_cells(proxy->range) > GFC_SPATIAL_MAX_PROXY_CELLS);
+    if (proxy->oversized)
+    {
+        gfc_spatial_cell_add(&index->oversized,id);
+        return;
+    }
+    for (y = proxy->range[1]; y <= proxy->range[3]; y++)
+    {
+        for (x = proxy->range[0]; x <= proxy->range[2]; x++)
+        {
+            cell = gfc_spatial_cell_get(index,x,y,1);
+            if (!cell)continue;
+            gfc_spatial_cell_add(cell,id);
+        }
+    }
+}
+
+static void gfc_spatial_proxy_unlink(gfcSpatialIndex *index,Uint32 id,GFC_SpatialProxy *proxy)
+{
+    GFC_SpatialCell *cell;
+    Sint32 x,y;
+    if (proxy->oversized)
+    {
+        gfc_spatial_cell_remove(&index->oversized,id);
+        return;
+    }
+    for (y = proxy->range[1]; y <= proxy->range[3]; y++)
+    {
+        for (x = proxy->range[0]; x <= proxy->range[2]; x++)
+        {
+            cell = gfc_spatial_cell_get(index,x,y,0);
+            if (!cell)continue;
+            gfc_spatial_cell_remove(cell,id);
+            if (!cell->count)gfc_spatial_cell_release(index,cell);
+        }
+    }
+}
+
+Uint32 gfc_spatial_index_insert(gfcSpatialIndex *index,Shape shape,void *data)
+{
+    GFC_SpatialProxy *proxies,*proxy;
+    Uint32 id;
+    if (!index)return 0;
+    if (index->freeHead)
+    {
+        id = index->freeHead;
+        index->freeHead = index->proxies[id - 1].nextFree;
+    }
+    else
+    {
+        if (index->proxyHighWater >= index->proxySize)
+        {
+            proxies = realloc(index->proxies,sizeof(GFC_SpatialProxy) * (index->proxySize?index->proxySize * 2:64));
+            if (!proxies)
+            {
+                slog("failed to grow spatial index");
+                return 0;
+            }
+            index->proxies = proxies;
+            index->proxySize = index->proxySize?index->proxySize * 2:64;
+        }
+        id = ++index->proxyHighWater;
+    }
+    proxy = &index->proxies[id - 1];
+    memset(proxy,0,sizeof(GFC_SpatialProxy));
+    proxy->inUse = 1;
+    proxy->shape = shape;
+    proxy->bounds = gfc_shape_get_bounds(shape);
+    proxy->data = data;
+    gfc_spatial_proxy_link(index,id,proxy);
+    index->count++;
+    return id;
+}
+
+void gfc_spatial_index_move(gfcSpatialIndex *index,Uint32 id,Shape shape)
+{
+    GFC_SpatialProxy *proxy;
+    Sint32 range[4];
+    proxy = gfc_spatial_proxy_get(index,id);
+    if (!proxy)return;
+    proxy->shape = shape;
+    proxy->bounds = gfc_shape_get_bounds(shape);
+    gfc_spatial_range(index,proxy->bounds,range);
+    if (memcmp(range,proxy->range,sizeof(range)) == 0)return;//same cells, nothing to relink
+    gfc_spatial_proxy_unlink(index,id,proxy);
+    gfc_spatial_proxy_link(index,id,proxy);
+}
+
+void gfc_spatial_index_remove(gfcSpatialIndex *index,Uint32 id)
+{
+    GFC_SpatialProxy *proxy;
+    proxy = gfc_spatial_proxy_get(index,id);
+    if (!proxy)return;
+    gfc_spatial_proxy_unlink(index,id,proxy);
+    proxy->inUse = 0;
+    proxy->data = NULL;
+    proxy->nextFree = index->freeHead;
+    index->freeHead = id;
+    index->count--;
+}
+
+void *gfc_spatial_index_get_data(gfcSpatialIndex *index,Uint32 id)
+{
+    GFC_SpatialProxy *proxy;
+    proxy = gfc_spatial_proxy_get(index,id);
+    if (!proxy)return NULL;
+    return proxy->data;
+}
+
+const Shape *gfc_spatial_index_get_shape(gfcSpatialIndex *index,Uint32 id)
+{
+    GFC_SpatialProxy *proxy;
+    proxy = gfc_spatial_proxy_get(index,id);
+    if (!proxy)return NULL;
+    return &proxy->shape;
+}
+
+Uint32 gfc_spatial_index_get_count(gfcSpatialIndex *index)
+{
+    if (!index)return 0;
+    return index->count;
+}
+
+static void gfc_spatial_next_stamp(gfcSpatialIndex *index)
+{
+    Uint32 i;
+    index->stamp++;
+    if (index->stamp)return;
+    //wrapped around, forget every old stamp
+    for (i = 0; i < index->proxyHighWater; i++)index->proxies[i].stamp = 0;
+    index->stamp = 1;
+}
+
+typedef struct
+{
+    Rect                region;
+    Shape              *shape;      /**<if set, the exact test to pass*/
+    gfcSpatialQueryFunc func;
+    void               *context;
+    Uint32              found;
+    Uint8               done;
+}GFC_SpatialQuery;
+
+static void gfc_spatial_query_proxy(gfcSpatialIndex *index,Uint32 id,GFC_SpatialQuery *query)
+{
+    GFC_SpatialProxy *proxy = &index->proxies[id - 1];
+    if (proxy->stamp == index->stamp)return;
+    proxy->stamp = index->stamp;
+    if (!gfc_rect_overlap(proxy->bounds,query->region))return;
+    if ((query->shape)&&(!gfc_shape_overlap(proxy->shape,*query->shape)))return;
+    query->found++;
+    if ((query->func)&&(!query->func(id,proxy->data,query->context)))query->done = 1;
+}
+
+static void gfc_spatial_query_cell(gfcSpatialIndex *index,GFC_SpatialCell *cell,GFC_SpatialQuery *query)
+{
+    Uint32 i;
+    for (i = 0; (i < cell->count)&&(!query->done); i++)
+    {
+        gfc_spatial_query_proxy(index,cell->proxies[i],query);
+    }
+}
+
+static Uint32 gfc_spatial_query(gfcSpatialIndex *index,GFC_SpatialQuery *query)
+{
+    GFC_SpatialCell *cell;
+    Sint32 range[4],x,y;
+    Uint32 i;
+    if (!index)return 0;
+    gfc_spatial_next_stamp(index);
+    gfc_spatial_query_cell(index,&index->oversized,query);
+    gfc_spatial_range(index,query->region,range);
+    if (gfc_spatial_range_cells(range) > index->cellTableSize)
+    {
+        //the region covers more cells than exist, just check every shape
+        for (i = 0; (i < index->proxyHighWater)&&(!query->done); i++)
+        {
+            if (!index->proxies[i].inUse)continue;
+            gfc_spatial_query_proxy(index,i + 1,query);
+        }
+        return query->found;
+    }
+    for (y = range[1]; (y <= range[3])&&(!query->done); y++)
+    {
+        for (x = range[0]; (x <= range[2])&&(!query->done); x++)
+        {
+            cell = gfc_spatial_cell_get(index,x,y,0);
+            if (!cell)continue;
+            gfc_spatial_query_cell(index,cell,query);
+        }
+    }
+    return query->found;
+}
+
+Uint32 gfc_spatial_index_query_rect(gfcSpatialIndex *index,Rect region,gfcSpatialQueryFunc func,void *context)
+{
+    GFC_SpatialQuery query = {0};
+    query.region = region;
+    query.func = func;
+    query.context = context;
+    return gfc_spatial_query(index,&query);
+}
+
+Uint32 gfc_spatial_index_query_shape(gfcSpatialIndex *index,Shape shape,gfcSpatialQueryFunc func,void *context)
+{
+    GFC_SpatialQuery query = {0};
+    query.region = gfc_shape_get_bounds(shape);
+    query.shape = &shape;
+    query.func = func;
+    query.context = context;
+    return gfc_spatial_query(index,&query);
+}
+
+typedef struct
+{
+    Edge                edge;
+    Shape               edgeShape;
+    Rect                edgeBounds;
+    gfcSpatialQueryFunc func;
+    void               *context;
+    Uint32              found;
+    Uint8               done;
+    Uint8               first;      /**<only looking for the nearest hit*/
+    double              bestT;      /**<how far along the edge the nearest hit is, 0 - 1*/
+    Uint32              best;
+    Vector2D            bestPoc,bestNormal;
+}GFC_SpatialCast;
+
+static void gfc_spatial_cast_proxy(gfcSpatialIndex *index,Uint32 id,GFC_SpatialCast *cast)
+{
+    GFC_SpatialProxy *proxy = &index->proxies[id - 1];
+    Vector2D poc = {0},normal = {0};
+    double dx,dy,len2,t;
+    if (proxy->stamp == index->stamp)return;
+    proxy->stamp = index->stamp;
+    if (!gfc_rect_overlap(proxy->bounds,cast->edgeBounds))return;
+    if (!cast->first)
+    {
+        if (!gfc_shape_overlap(cast->edgeShape,proxy->shape))return;
+        cast->found++;
+        if ((cast->func)&&(!cast->func(id,proxy->data,cast->context)))cast->done = 1;
+        return;
+    }
+    if (!gfc_shape_overlap_poc(cast->edgeShape,proxy->shape,&poc,&normal))return;
+    cast->found++;
+    dx = cast->edge.x2 - cast->edge.x1;
+    dy = cast->edge.y2 - cast->edge.y1;
+    len2 = dx * dx + dy * dy;
+    t = len2 > 0?((poc.x - cast->edge.x1) * dx + (poc.y - cast->edge.y1) * dy) / len2:0;
+    if ((cast->best)&&(t >= cast->bestT))return;
+    cast->best = id;
+    cast->bestT = t;
+    cast->bestPoc = poc;
+    cast->bestNormal = normal;
+}
+
+static void gfc_spatial_cast(gfcSpatialIndex *index,GFC_SpatialCast *cast)
+{
+    GFC_SpatialCell *cell;
+    Sint32 x,y,endX,endY,stepX,stepY;
+    double dx,dy,tMaxX,tMaxY,tDeltaX,tDeltaY,tNext;
+    Uint64 steps;
+    Uint32 i;
+    gfc_spatial_next_stamp(index);
+    cast->edgeShape = gfc_shape_from_edge(cast->edge);
+    cast->edgeBounds = gfc_shape_get_bounds(cast->edgeShape);
+    for (i = 0; (i < index->oversized.count)&&(!cast->done); i++)
+    {
+        gfc_spatial_cast_proxy(index,index->oversized.proxies[i],cast);
+    }
+    x = gfc_spatial_coord(index,cast->edge.x1);
+    y = gfc_spatial_coord(index,cast->edge.y1);
+    endX = gfc_spatial_coord(index,cast->edge.x2);
+    endY = gfc_spatial_coord(index,cast->edge.y2);
+    dx = cast->edge.x2 - cast->edge.x1;
+    dy = cast->edge.y2 - cast->edge.y1;
+    stepX = dx > 0 ? 1 : -1;
+    stepY = dy > 0 ? 1 : -1;
+    tDeltaX = dx != 0 ? index->cellSize / fabs(dx) : DBL_MAX;
+    tDeltaY = dy != 0 ? index->cellSize / fabs(dy) : DBL_MAX;
+    tMaxX = dx != 0 ? (((double)x + (stepX > 0)) * index->cellSize - cast->edge.x1) / dx : DBL_MAX;
+    tMaxY = dy != 0 ? (((double)y + (stepY > 0)) * index->cellSize - cast->edge.y1) / dy : DBL_MAX;
+    //walk the cells under the edge from start to end
+    steps = (Uint64)abs(endX - x) + (Uint64)abs(endY - y) + 1;
+    for (;steps > 0;steps--)
+    {
+        cell = gfc_spatial_cell_get(index,x,y,0);
+        if (cell)
+        {
+            for (i = 0; (i < cell->count)&&(!cast->done); i++)
+            {
+                gfc_spatial_cast_proxy(index,cell->proxies[i],cast);
+            }
+        }
+        if (cast->done)return;
+        if ((x == endX)&&(y == endY))return;
+        tNext = MIN(tMaxX,tMaxY);
+        //any hit beyond here would be further along than the one we have
+        if ((cast->first)&&(cast->best)&&(tNext > cast->bestT))return;
+        if (tMaxX < tMaxY)
+        {
+            x += stepX;
+            tMaxX += tDeltaX;
+        }
+        else
+        {
+            y += stepY;
+            tMaxY += tDeltaY;
+        }
+    }
+}
+
+Uint32 gfc_spatial_index_edge_cast(gfcSpatialIndex *index,Edge edge,gfcSpatialQueryFunc func,void *context)
+{
+    GFC_SpatialCast cast = {0};
+    if (!index)return 0;
+    cast.edge = edge;
+    cast.func = func;
+    cast.context = context;
+    gfc_spatial_cast(index,&cast);
+    return cast.found;
+}
+
+Uint32 gfc_spatial_index_edge_cast_first(gfcSpatialIndex *index,Edge edge,Vector2D *poc,Vector2D *normal)
+{
+    GFC_SpatialCast cast = {0};
+    if (!index)return 0;
+    cast.edge = edge;
+    cast.first = 1;
+    gfc_spatial_cast(index,&cast);
+    if (!cast.best)return 0;
+    if (poc)*poc = cast.bestPoc;
+    if (normal)*normal = cast.bestNormal;
+    return cast.best;
+}
+
+static Uint8 gfc_spatial_pair_test(gfcSpatialIndex *index,Uint32 a,Uint32 b,gfcSpatialPairFunc func,void *context)
+{
+    GFC_SpatialProxy *pa = &index->proxies[a - 1];
+    GFC_SpatialProxy *pb = &index->proxies[b - 1];
+    if (!gfc_rect_overlap(pa->bounds,pb->bounds))return 0;
+    if (!gfc_shape_overlap(pa->shape,pb->shape))return 0;
+    if (func)func(a,b,context);
+    return 1;
+}
+
+Uint32 gfc_spatial_index_overlap_pairs(gfcSpatialIndex *index,gfcSpatialPairFunc func,void *context)
+{
+    GFC_SpatialCell *cell;
+    GFC_SpatialProxy *pa,*pb;
+    Uint32 c,i,j,a,b,found = 0;
+    if (!index)return 0;
+    for (c = 0; c < index->cellTableSize; c++)
+    {
+        cell = &index->cells[c];
+        if ((!cell->used)||(cell->count < 2))continue;
+        for (i = 0; i < cell->count; i++)
+        {
+            a = cell->proxies[i];
+            pa = &index->proxies[a - 1];
+            for (j = i + 1; j < cell->count; j++)
+            {
+                b = cell->proxies[j];
+                pb = &index->proxies[b - 1];
+                //a pair can share many cells, only report it from the cell holding the corner of their overlap
+                if (gfc_spatial_coord(index,MAX(pa->bounds.x,pb->bounds.x)) != cell->x)continue;
+                if (gfc_spatial_coord(index,MAX(pa->bounds.y,pb->bounds.y)) != cell->y)continue;
+                found += gfc_spatial_pair_test(index,a,b,func,context);
+            }
+        }
+    }
+    //oversized shapes are not in any cell, test them against everything
+    for (i = 0; i < index->oversized.count; i++)
+    {
+        a = index->oversized.proxies[i];
+        for (b = 1; b <= index->proxyHighWater; b++)
+        {
+            pb = &index->proxies[b - 1];
+            if ((!pb->inUse)||(b == a))continue;
+            if ((pb->oversized)&&(b < a))continue;//already reported from the other side
+            found += gfc_spatial_pair_test(index,a,b,func,context);
+        }
+    }
+    return found;
+}
+
+/*eol@eof*/
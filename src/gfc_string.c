@@ -0,0 +1,165 @@
+#define GFC_STRING_IMPLEMENTATION
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_string.h"
+
+static Uint32 gfc_string_hash_finish(Uint32 h)
+{
+    //finalize so the low bits used for hashmap slots are well mixed
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    if (!h)h = 1;//zero is reserved for empty slots and strings
+    return h;
+}
+
+Uint32 gfc_string_hash_seeded(const char *text,size_t length,Uint32 seed)
+{
+    Uint32 h = seed;
+    size_t i;
+    if (!text)return 0;
+    for (i = 0; i < length; i++)
+    {
+        h = h * 33 + text[i];
+    }
+    return gfc_string_hash_finish(h);
+}
+
+Uint32 gfc_string_hash_cstr(const char *text,Uint32 seed,size_t *length)
+{
+    Uint32 h = seed;
+    const char *p;
+    if (!text)
+    {
+        if (length)*length = 0;
+        return 0;
+    }
+    for (p = text; *p; p++)
+    {
+        h = h * 33 + *p;
+    }
+    if (length)*length = (size_t)(p - text);
+    return gfc_string_hash_finish(h);
+}
+
+Uint8 gfc_string_equal_cstr(const gfcString *a,const char *text)
+{
+    size_t length;
+    if ((!a)||(!text))return 0;
+    length = strlen(text);
+    return gfc_string_equal_n(a,text,length);
+}
+
+int gfc_string_cmp(const gfcString *a,const gfcString *b)
+{
+    Uint32 length;
+    int result;
+    if (a == b)return 0;
+    if (!a)return -1;
+    if (!b)return 1;
+    length = MIN(a->length,b->length);
+    result = memcmp(gfc_string_cstr(a),gfc_string_cstr(b),length);
+    if (result)return result;
+    if (a->length < b->length)return -1;
+    if (a->length > b->length)return 1;
+    return 0;
+}
+
+void gfc_string_clear_allocator(gfcString *str,gfcAllocator *allocator)
+{
+    if (!str)return;
+    if (str->length >= GFC_STRING_LOCAL_SIZE)gfc_allocator_free(allocator,str->text.heap);
+    memset(str,0,sizeof(gfcString));
+}
+
+void gfc_string_clear(gfcString *str)
+{
+    gfc_string_clear_allocator(str,NULL);
+}
+
+int gfc_string_set_allocator(gfcString *str,const char *text,size_t length,gfcAllocator *allocator)
+{
+    char *heap = NULL;
+    if (!str)return -1;
+    if ((!text)||(!length))
+    {
+        gfc_string_clear_allocator(str,allocator);
+        return 0;
+    }
+    if (length > 0xFFFFFFFE)
+    {
+        slog("string of %lu bytes is too long",(unsigned long)length);
+        gfc_string_clear_allocator(str,allocator);
+        return -1;
+    }
+    if (length >= GFC_STRING_LOCAL_SIZE)
+    {
+        //allocated before the old text is freed, text may be the old text
+        heap = gfc_allocator_alloc(allocator,length + 1,1);
+        if (!heap)
+        {
+            slog("failed to allocate a string of %lu bytes",(unsigned long)length);
+            gfc_string_clear_allocator(str,allocator);
+            return -1;
+        }
+        memcpy(heap,text,length);
+        heap[length] = 0;
+        gfc_string_clear_allocator(str,allocator);
+        str->text.heap = heap;
+    }
+    else
+    {
+        if (str->length >= GFC_STRING_LOCAL_SIZE)
+        {
+            heap = str->text.heap;//text may point into it, so free it after the copy
+            str->text.heap = NULL;
+        }
+        memmove(str->text.local,text,length);
+        memset(&str->text.local[length],0,GFC_STRING_LOCAL_SIZE - length);
+        gfc_allocator_free(allocator,heap);
+    }
+    str->length = (Uint32)length;
+    str->hash = gfc_string_hash_seeded(gfc_string_cstr(str),length,GFC_STRING_HASH_SEED);
+    return 0;
+}
+
+int gfc_string_set_n(gfcString *str,const char *text,size_t length)
+{
+    return gfc_string_set_allocator(str,text,length,NULL);
+}
+
+int gfc_string_set(gfcString *str,const char *text)
+{
+    if (!text)return gfc_string_set_allocator(str,NULL,0,NULL);
+    return gfc_string_set_allocator(str,text,strlen(text),NULL);
+}
+
+int gfc_string_copy(gfcString *dst,const gfcString *src)
+{
+    char *heap;
+    if ((!dst)||(!src))return -1;
+    if (dst == src)return 0;
+    if (src->length < GFC_STRING_LOCAL_SIZE)
+    {
+        gfc_string_clear(dst);
+        memcpy(dst,src,sizeof(gfcString));
+        return 0;
+    }
+    heap = gfc_allocator_alloc(NULL,src->length + 1,1);
+    if (!heap)
+    {
+        slog("failed to allocate a string of %u bytes",src->length);
+        return -1;
+    }
+    memcpy(heap,src->text.heap,src->length + 1);
+    gfc_string_clear(dst);
+    dst->text.heap = heap;
+    dst->length = src->length;
+    dst->hash = src->hash;
+    return 0;
+}
+
+/*eol@eof*/
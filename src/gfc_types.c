@@ -5,6 +5,9 @@
 
 #include "simple_logger.h"
 
+#include "gfc_random.h"
+#include "gfc_profile.h"
+
 long get_file_Size(FILE *file)
 {
   long size;
@@ -25,8 +28,7 @@ long get_file_Size(FILE *file)
 
 float gfc_random_seeded(Uint32 seed)
 {
-    srand(seed);
-    return gfc_random();
+    return gfc_random_hash_float((Sint32)seed,0,0);
 }
 
 SDL_Rect gfc_sdl_rect(Sint32 x,Sint32 y,Uint32 w, Uint32 h)
@@ -59,6 +61,8 @@ void *gfc_allocate_array(size_t typeSize,size_t count)
         return NULL;
     }
     memset(array,0,typeSize*count);
+    GFC_PROFILE_COUNT(GFC_PC_ALLOCATIONS,1);
+    GFC_PROFILE_COUNT(GFC_PC_ALLOCATED_BYTES,typeSize * count);
     return array;
 }
 
@@ -1,92 +1,10 @@
+#define GFC_VECTOR_IMPLEMENTATION
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include "gfc_simd.h"
 #include "gfc_vector.h"
 
-Vector2D vector2d(float x, float y)
-{
-  Vector2D vec;
-  vector2d_set(vec,x, y);
-  return vec;
-}
-
-Vector3D vector3d(float x, float y, float z)
-{
-  Vector3D vec;
-  vector3d_set(vec,x, y, z);
-  return vec;
-}
-
-Vector4D vector4d(float x, float y, float z, float w)
-{
-  Vector4D vec;
-  vector4d_set(vec,x, y, z, w);
-  return vec;
-}
-
-Vector2D vector2d_multiply(Vector2D a, Vector2D b)
-{
-    return vector2d(a.x * b.x, a.y * b.y);
-}
-
-Vector3D vector3d_multiply(Vector3D a, Vector3D b)
-{
-    return vector3d(a.x * b.x, a.y * b.y, a.z * b.z);
-}
-
-Vector4D vector4d_multiply(Vector4D a, Vector4D b)
-{
-    return vector4d(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
-}
-
-Bool vector2d_distance_between_less_than(Vector2D p1,Vector2D p2,float size)
-{
-    if (vector2d_magnitude_between(p1,p2) < size)return 1;
-    return 0;
-}
-
-Bool vector3d_distance_between_less_than(Vector3D p1,Vector3D p2,float size)
-{
-    if (vector3d_magnitude_between(p1,p2) < size)return 1;
-    return 0;
-}
-
-Bool vector4d_distance_between_less_than(Vector4D p1,Vector4D p2,float size)
-{
-    if (vector4d_magnitude_between(p1,p2) < size)return 1;
-    return 0;
-}
-
-float vector2d_magnitude (Vector2D V)
-{
-  return sqrt (V.x * V.x + V.y * V.y);
-}
-
-float vector3d_magnitude (Vector3D V)
-{
-  return sqrt (V.x * V.x + V.y * V.y + V.z * V.z);
-}
-
-float vector4d_magnitude (Vector4D V)
-{
-  return sqrt (V.x * V.x + V.y * V.y + V.z * V.z + V.w * V.w);
-}
-
-float vector2d_magnitude_squared(Vector2D V)
-{
-  return (V.x * V.x + V.y * V.y);
-}
-
-float vector3d_magnitude_squared(Vector3D V)
-{
-  return (V.x * V.x + V.y * V.y + V.z * V.z);
-}
-
-float vector4d_magnitude_squared(Vector4D V)
-{
-  return (V.x * V.x + V.y * V.y + V.z * V.z + V.w * V.w);
-}
-
 void vector2d_set_magnitude(Vector2D * V,float magnitude)
 {
   if (!V)return;
@@ -114,55 +32,6 @@ void vector4d_set_magnitude(Vector4D * V,float magnitude)
   V->w *= magnitude;
 }
 
-float vector2d_magnitude_between(Vector2D a,Vector2D b)
-{
-    Vector2D c;
-    vector2d_sub(c,a,b);
-    return vector2d_magnitude(c);
-}
-
-float vector3d_magnitude_between(Vector3D a,Vector3D b)
-{
-    Vector3D c;
-    vector3d_sub(c,a,b);
-    return vector3d_magnitude(c);
-}
-
-float vector4d_magnitude_between(Vector4D a,Vector4D b)
-{
-    Vector4D c;
-    vector4d_sub(c,a,b);
-    return vector4d_magnitude(c);
-}
-
-int vector2d_magnitude_compare(Vector2D V,float size)
-{
-    float ms = vector2d_magnitude_squared(V);
-    float ss = size * size;
-    if (ms < ss)return -1;
-    if (ms == ss)return 0;
-    return 1;
-}
-
-int vector3d_magnitude_compare(Vector3D V,float size)
-{
-    float ms = vector3d_magnitude_squared(V);
-    float ss = size * size;
-    if (ms < ss)return -1;
-    if (ms == ss)return 0;
-    return 1;
-}
-
-int vector4d_magnitude_compare(Vector4D V,float size)
-{
-    float ms = vector4d_magnitude_squared(V);
-    float ss = size * size;
-    if (ms < ss)return -1;
-    if (ms == ss)return 0;
-    return 1;
-}
-
-
 void vector3d_set_angle_by_radians(Vector3D *out,float radians)
 {
   if(!out)return;
@@ -222,6 +91,42 @@ void vector4d_normalize (Vector4D *V)
   V->w *= M;
 }
 
+void vector2d_normalize_fast (Vector2D *V)
+{
+  float M;
+  if (!V)return;
+  M = vector2d_magnitude_squared(*V);
+  if (M == 0.0f)return;
+  M = gfc_rsqrt(M);
+  V->x *= M;
+  V->y *= M;
+}
+
+void vector3d_normalize_fast (Vector3D *V)
+{
+  float M;
+  if (!V)return;
+  M = vector3d_magnitude_squared(*V);
+  if (M == 0.0f)return;
+  M = gfc_rsqrt(M);
+  V->x *= M;
+  V->y *= M;
+  V->z *= M;
+}
+
+void vector4d_normalize_fast (Vector4D *V)
+{
+  float M;
+  if (!V)return;
+  M = vector4d_magnitude_squared(*V);
+  if (M == 0.0f)return;
+  M = gfc_rsqrt(M);
+  V->x *= M;
+  V->y *= M;
+  V->z *= M;
+  V->w *= M;
+}
+
 Vector2D *vector2d_dup(Vector2D old)
 {
   Vector2D *duped = NULL;
@@ -0,0 +1,278 @@
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_list.h"
+#include "gfc_string.h"
+#include "gfc_hashmap.h"
+#include "gfc_pak.h"
+#include "gfc_profile.h"
+#include "gfc_watch.h"
+
+#define GFC_WATCH_DEFAULT_INTERVAL 250
+
+typedef struct
+{
+    gfcString filename;
+    GFC_PakFileStamp stamp;     /**<as of the last check, a different stamp is what makes it worth hashing*/
+    Uint32 crc;                 /**<crc of the contents as of the last change, 0 if not found*/
+    gfcList *subscribers;       /**<GFC_WatchSubscriber **/
+    Uint8 dirty;                /**<a subscriber was removed while callbacks were running*/
+}GFC_WatchFile;
+
+typedef struct
+{
+    Uint32 id;
+    Callback callback;          /**<callback.callback is NULL once removed*/
+}GFC_WatchSubscriber;
+
+typedef struct
+{
+    HashMap *files;             /**<filename to GFC_WatchFile*/
+    gfcList *fileList;          /**<GFC_WatchFile *, in the order they were first watched*/
+    Uint32 nextId;
+    Uint32 interval;
+    Uint32 lastCheck;           /**<SDL_GetTicks() of the last check*/
+    Uint8 firing;               /**<callbacks are running, removals wait until they are done*/
+    Uint8 initialized;
+    gfcCallbackQueue *callback_queue;
+}GFC_WatchManager;
+
+static GFC_WatchManager watch_manager = {0};
+
+static void gfc_watch_file_free(GFC_WatchFile *file)
+{
+    if (!file)return;
+    gfc_list_foreach(file->subscribers,free);
+    gfc_list_delete(file->subscribers);
+    gfc_string_clear(&file->filename);
+    free(file);
+}
+
+static void gfc_watch_close()
+{
+    gfc_list_foreach(watch_manager.fileList,(gfc_work_func*)gfc_watch_file_free);
+    gfc_list_delete(watch_manager.fileList);
+    gfc_hashmap_free(watch_manager.files);
+    memset(&watch_manager,0,sizeof(GFC_WatchManager));
+}
+
+static int gfc_watch_init()
+{
+    if (watch_manager.files)return 0;
+    watch_manager.files = gfc_hashmap_new();
+    if (!watch_manager.files)
+    {
+        slog("gfc_watch: failed to allocate the watch list");
+        return -1;
+    }
+    if (!watch_manager.initialized)
+    {
+        watch_manager.interval = GFC_WATCH_DEFAULT_INTERVAL;
+        watch_manager.initialized = 1;
+        atexit(gfc_watch_close);
+    }
+    return 0;
+}
+
+static Uint8 gfc_watch_stamp_equal(const GFC_PakFileStamp *a,const GFC_PakFileStamp *b)
+{
+    return (a->found == b->found)&&(a->loose == b->loose)&&(a->modified == b->modified)&&
+        (a->size == b->size)&&(a->crc == b->crc);
+}
+
+/**
+ * @brief get the crc of a file as it is now, 0 if it can not be found
+ */
+static Uint32 gfc_watch_file_crc(GFC_WatchFile *file)
+{
+    Uint32 crc = 0;
+    if (!file->stamp.found)return 0;
+    if (gfc_pak_file_get_crc(gfc_string_cstr(&file->filename),&crc) != 0)return 0;
+    return crc;
+}
+
+static GFC_WatchFile *gfc_watch_file_get(const char *filename)
+{
+    GFC_WatchFile *file;
+    file = gfc_hashmap_get(watch_manager.files,filename);
+    if (file)return file;
+    file = gfc_allocate_array(sizeof(GFC_WatchFile),1);
+    if (!file)return NULL;
+    if (gfc_string_set(&file->filename,filename) != 0)
+    {
+        free(file);
+        return NULL;
+    }
+    //the file as it is now is the baseline, only changes from here on are reported
+    gfc_pak_file_get_stamp(filename,&file->stamp);
+    file->crc = gfc_watch_file_crc(file);
+    gfc_hashmap_insert_string(watch_manager.files,&file->filename,file);
+    watch_manager.fileList = gfc_list_append(watch_manager.fileList,file);
+    return file;
+}
+
+Uint32 gfc_watch_add(const char *filename,void (*onChange)(void *data),void *data)
+{
+    GFC_WatchFile *file;
+    GFC_WatchSubscriber *subscriber;
+    if ((!filename)||(!onChange))return 0;
+    if (gfc_watch_init() != 0)return 0;
+    file = gfc_watch_file_get(filename);
+    if (!file)return 0;
+    subscriber = gfc_allocate_array(sizeof(GFC_WatchSubscriber),1);
+    if (!subscriber)return 0;
+    if (!++watch_manager.nextId)watch_manager.nextId = 1;//zero means no watch
+    subscriber->id = watch_manager.nextId;
+    subscriber->callback.callback = onChange;
+    subscriber->callback.data = data;
+    file->subscribers = gfc_list_append(file->subscribers,subscriber);
+    return subscriber->id;
+}
+
+/**
+ * @brief delete removed subscribers, and files no one watches any more
+ */
+static void gfc_watch_file_purge(GFC_WatchFile *file)
+{
+    GFC_WatchSubscriber *subscriber;
+    int i;
+    for (i = gfc_list_get_count(file->subscribers) - 1; i >= 0; i--)
+    {
+        subscriber = gfc_list_get_nth(file->subscribers,i);
+        if ((subscriber)&&(subscriber->callback.callback))continue;
+        gfc_list_delete_nth(file->subscribers,i);
+        free(subscriber);
+    }
+    file->dirty = 0;
+    if (gfc_list_get_count(file->subscribers))return;
+    gfc_hashmap_delete_by_string(watch_manager.files,&file->filename);
+    gfc_list_delete_data(watch_manager.fileList,file);
+    gfc_watch_file_free(file);
+}
+
+/**
+ * @brief find a watch by its id
+ * @param fileOut [optional output] the file it watches
+ * @return NULL if there is no such watch, it may still be there with no callback if it was removed while firing
+ */
+static GFC_WatchSubscriber *gfc_watch_find(Uint32 watchId,GFC_WatchFile **fileOut)
+{
+    GFC_WatchFile *file;
+    GFC_WatchSubscriber *subscriber;
+    int i,j,c,s;
+    if (!watchId)return NULL;
+    c = gfc_list_get_count(watch_manager.fileList);
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(watch_manager.fileList,i);
+        if (!file)continue;
+        s = gfc_list_get_count(file->subscribers);
+        for (j = 0; j < s; j++)
+        {
+            subscriber = gfc_list_get_nth(file->subscribers,j);
+            if ((!subscriber)||(subscriber->id != watchId))continue;
+            if (fileOut)*fileOut = file;
+            return subscriber;
+        }
+    }
+    return NULL;
+}
+
+void gfc_watch_remove(Uint32 watchId)
+{
+    GFC_WatchFile *file = NULL;
+    GFC_WatchSubscriber *subscriber;
+    subscriber = gfc_watch_find(watchId,&file);
+    if (!subscriber)return;
+    subscriber->callback.callback = NULL;
+    if (watch_manager.firing)file->dirty = 1;
+    else gfc_watch_file_purge(file);
+}
+
+/**
+ * @brief call a watch's callback from the callback queue, if it has not been removed since it was posted
+ * @param data the watch id.  Its callback data may have been freed along with the watch, so only the id is queued
+ */
+static void gfc_watch_deliver(void *data)
+{
+    GFC_WatchSubscriber *subscriber;
+    Callback callback;
+    subscriber = gfc_watch_find((Uint32)(size_t)data,NULL);
+    if ((!subscriber)||(!subscriber->callback.callback))return;
+    callback = subscriber->callback;//the callback may remove its own watch
+    gfc_callback_call(&callback);
+}
+
+static void gfc_watch_file_notify(GFC_WatchFile *file)
+{
+    GFC_WatchSubscriber *subscriber;
+    Uint32 i;
+    //callbacks added during this run are not told about a change from before they were added
+    Uint32 c = gfc_list_get_count(file->subscribers);
+    for (i = 0; i < c; i++)
+    {
+        subscriber = gfc_list_get_nth(file->subscribers,i);
+        if ((!subscriber)||(!subscriber->callback.callback))continue;
+        if ((watch_manager.callback_queue)&&
+            (gfc_callback_queue_post(watch_manager.callback_queue,gfc_watch_deliver,(void *)(size_t)subscriber->id) == 0))continue;
+        gfc_callback_call(&subscriber->callback);
+    }
+}
+
+Uint32 gfc_watch_check()
+{
+    GFC_WatchFile *file;
+    GFC_PakFileStamp stamp;
+    gfcList *files;
+    Uint32 crc,changed = 0;
+    int i,c;
+    GFC_PROFILE_ZONE("gfc_watch_check");
+    watch_manager.lastCheck = SDL_GetTicks();
+    if (!gfc_list_get_count(watch_manager.fileList))return 0;
+    gfc_pak_manager_refresh();
+    //a snapshot, callbacks may watch more files
+    files = gfc_list_copy(watch_manager.fileList);
+    c = gfc_list_get_count(files);
+    watch_manager.firing = 1;
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(files,i);
+        if (!file)continue;
+        if (gfc_pak_file_get_stamp(gfc_string_cstr(&file->filename),&stamp) != 0)continue;
+        if (gfc_watch_stamp_equal(&stamp,&file->stamp))continue;
+        file->stamp = stamp;
+        crc = gfc_watch_file_crc(file);
+        if (crc == file->crc)continue;//touched, or the pak it is in changed, but it is the same
+        file->crc = crc;
+        changed++;
+        gfc_watch_file_notify(file);
+    }
+    watch_manager.firing = 0;
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(files,i);
+        if ((file)&&(file->dirty))gfc_watch_file_purge(file);
+    }
+    gfc_list_delete(files);
+    return changed;
+}
+
+Uint32 gfc_watch_update()
+{
+    if (!watch_manager.files)return 0;
+    if ((watch_manager.interval)&&(SDL_GetTicks() - watch_manager.lastCheck < watch_manager.interval))return 0;
+    return gfc_watch_check();
+}
+
+void gfc_watch_set_interval(Uint32 milliseconds)
+{
+    if (gfc_watch_init() != 0)return;
+    watch_manager.interval = milliseconds;
+}
+
+void gfc_watch_set_callback_queue(gfcCallbackQueue *queue)
+{
+    watch_manager.callback_queue = queue;
+}
+
+/*eol@eof*/
@@ -0,0 +1,655 @@
+/**
+ * gfc_bench
+ * times the hot paths of gfc so changes to them can be compared before and after
+ * usage: gfc_bench [-t milliseconds] [-f filter] [-json]
+ *
+ * Each benchmark runs its operation enough times to fill the target time (100ms by default) and reports
+ * the time and heap allocations per operation.  Allocations are counted by wrapping malloc, calloc and realloc
+ * at link time (see the bench target in src/Makefile), so only allocations made by gfc and this tool are seen.
+ * Output is one tab separated line per benchmark with a header line starting with #, or a json array with -json.
+ * -f only runs benchmarks whose name contains the filter.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include "miniz.h"
+#include "gfc_types.h"
+#include "gfc_list.h"
+#include "gfc_array.h"
+#include "gfc_hashmap.h"
+#include "gfc_shape.h"
+#include "gfc_matrix.h"
+#include "gfc_noise.h"
+#include "gfc_pak.h"
+
+#define BENCH_PAK "gfc_bench.pak"
+
+typedef struct
+{
+    Uint64 n;               /**<how many operations to run*/
+    Uint32 size;            /**<the size parameter of the benchmark, 0 if it has none*/
+    Uint64 start;
+    Uint64 ticks;           /**<time spent timing*/
+    Uint64 allocStart;
+    Uint64 allocs;          /**<allocations made while timing*/
+    Uint8 running;
+    const char *skipped;    /**<why the benchmark could not run, it is left out of the results*/
+}Bench;
+
+typedef struct
+{
+    const char *name;
+    void (*run)(Bench *b);
+    Uint32 size;
+}BenchCase;
+
+static Uint64 bench_allocations = 0;
+static volatile float bench_sink = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count,size_t size);
+void *__real_realloc(void *ptr,size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    bench_allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count,size_t size)
+{
+    bench_allocations++;
+    return __real_calloc(count,size);
+}
+
+void *__wrap_realloc(void *ptr,size_t size)
+{
+    bench_allocations++;
+    return __real_realloc(ptr,size);
+}
+
+/**
+ * @brief start timing, call after any setup the benchmark needs.  May be called again after bench_stop()
+ */
+static void bench_start(Bench *b)
+{
+    if (b->running)return;
+    b->allocStart = bench_allocations;
+    b->start = SDL_GetPerformanceCounter();
+    b->running = 1;
+}
+
+/**
+ * @brief stop timing, call before cleanup that should not be counted
+ */
+static void bench_stop(Bench *b)
+{
+    if (!b->running)return;
+    b->ticks += SDL_GetPerformanceCounter() - b->start;
+    b->allocs += bench_allocations - b->allocStart;
+    b->running = 0;
+}
+
+/**
+ * @brief give up on a benchmark that can not run, it is reported as skipped instead of timed
+ */
+static void bench_skip(Bench *b,const char *reason)
+{
+    bench_stop(b);
+    b->skipped = reason;
+}
+
+/*hashmap*/
+
+static char (*bench_make_keys(Uint32 count,const char *prefix))[32]
+{
+    char (*keys)[32];
+    Uint32 i;
+    keys = malloc(sizeof(*keys) * count);
+    if (!keys)return NULL;
+    for (i = 0; i < count; i++)
+    {
+        snprintf(keys[i],32,"%s%u",prefix,i * 2654435761u);
+    }
+    return keys;
+}
+
+static void bench_hashmap_insert(Bench *b)
+{
+    char (*keys)[32];
+    HashMap *map;
+    Uint64 i;
+    Uint32 k = 0;
+    keys = bench_make_keys(b->size,"key");
+    if (!keys)
+    {
+        bench_skip(b,"out of memory");
+        return;
+    }
+    map = gfc_hashmap_new();
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        if (k == b->size)
+        {
+            //start over so the map keeps growing through the same sizes
+            gfc_hashmap_free(map);
+            map = gfc_hashmap_new();
+            k = 0;
+        }
+        gfc_hashmap_insert(map,keys[k],keys[k]);
+        k++;
+    }
+    bench_stop(b);
+    gfc_hashmap_free(map);
+    free(keys);
+}
+
+static HashMap *bench_hashmap_fill(char (*keys)[32],Uint32 count)
+{
+    HashMap *map;
+    Uint32 i;
+    map = gfc_hashmap_new();
+    for (i = 0; i < count; i++)
+    {
+        gfc_hashmap_insert(map,keys[i],keys[i]);
+    }
+    return map;
+}
+
+static void bench_hashmap_get(Bench *b)
+{
+    char (*keys)[32];
+    HashMap *map;
+    Uint64 i;
+    keys = bench_make_keys(b->size,"key");
+    if (!keys)
+    {
+        bench_skip(b,"out of memory");
+        return;
+    }
+    map = bench_hashmap_fill(keys,b->size);
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        if (!gfc_hashmap_get(map,keys[i % b->size]))bench_sink += 1;
+    }
+    bench_stop(b);
+    gfc_hashmap_free(map);
+    free(keys);
+}
+
+static void bench_hashmap_get_miss(Bench *b)
+{
+    char (*keys)[32],(*missing)[32];
+    HashMap *map;
+    Uint64 i;
+    keys = bench_make_keys(b->size,"key");
+    missing = bench_make_keys(b->size,"nokey");
+    if ((!keys)||(!missing))
+    {
+        free(keys);
+        free(missing);
+        bench_skip(b,"out of memory");
+        return;
+    }
+    map = bench_hashmap_fill(keys,b->size);
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        if (gfc_hashmap_get(map,missing[i % b->size]))bench_sink += 1;
+    }
+    bench_stop(b);
+    gfc_hashmap_free(map);
+    free(keys);
+    free(missing);
+}
+
+/*list*/
+
+static gfcList *bench_list_fill(Uint32 count)
+{
+    gfcList *list;
+    Uint32 i;
+    list = gfc_list_new();
+    for (i = 0; i < count; i++)
+    {
+        list = gfc_list_append(list,(void*)(size_t)(i + 1));
+    }
+    return list;
+}
+
+static void bench_list_append(Bench *b)
+{
+    gfcList *list;
+    Uint64 i;
+    list = gfc_list_new();
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        if (gfc_list_get_count(list) == b->size)gfc_list_clear(list);
+        list = gfc_list_append(list,(void*)(size_t)(i + 1));
+    }
+    bench_stop(b);
+    gfc_list_delete(list);
+}
+
+static void bench_list_insert(Bench *b)
+{
+    gfcList *list;
+    Uint64 i;
+    list = bench_list_fill(b->size);
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        //insert into the middle and take it back out so the list stays the same size
+        list = gfc_list_insert(list,(void*)(size_t)(i + 1),b->size / 2);
+        gfc_list_delete_nth(list,b->size / 2);
+    }
+    bench_stop(b);
+    gfc_list_delete(list);
+}
+
+static void bench_list_delete(Bench *b)
+{
+    gfcList *list;
+    void *data;
+    Uint64 i;
+    list = bench_list_fill(b->size);
+    data = (void*)(size_t)(b->size / 2 + 1);
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        //find and delete from the middle, then put it back on the end
+        gfc_list_delete_data(list,data);
+        list = gfc_list_append(list,data);
+    }
+    bench_stop(b);
+    gfc_list_delete(list);
+}
+
+/*array*/
+
+static void bench_array_append(Bench *b)
+{
+    gfcArray *array;
+    Uint64 i;
+    array = gfc_array_new_type(Vector2D);
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        if (array->count == b->size)array->count = 0;
+        if (i & 1)gfc_array_append_value(array,Vector2D,vector2d(i,b->size));
+        else gfc_array_append_value(array,Vector2D,{i,b->size});
+    }
+    bench_stop(b);
+    gfc_array_delete(array);
+}
+
+static void bench_array_foreach(Bench *b)
+{
+    gfcArray *array;
+    float sum = 0;
+    Uint64 i;
+    array = gfc_array_new_size(sizeof(Vector2D),b->size);
+    for (i = 0; i < b->size; i++)
+    {
+        gfc_array_append_value(array,Vector2D,vector2d(i,1));
+    }
+    bench_start(b);
+    for (i = 0; i < b->n; i += b->size)
+    {
+        gfc_array_foreach_type(array,Vector2D,it)
+        {
+            sum += it->x + it->y;
+        }
+    }
+    bench_stop(b);
+    gfc_array_delete(array);
+    bench_sink += sum;
+}
+
+/*shape*/
+
+static void bench_shape_overlap(Bench *b,Shape *shapes,Uint32 count)
+{
+    Vector2D poc,normal;
+    Uint64 i;
+    Uint32 s;
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        s = (i % count) * 2;
+        if (gfc_shape_overlap_poc(shapes[s],shapes[s + 1],&poc,&normal))bench_sink += poc.x;
+    }
+    bench_stop(b);
+}
+
+static void bench_shape_rect_rect(Bench *b)
+{
+    Shape shapes[4];
+    shapes[0] = gfc_shape_rect(0,0,10,10);
+    shapes[1] = gfc_shape_rect(5,5,10,10);
+    shapes[2] = gfc_shape_rect(0,0,10,10);
+    shapes[3] = gfc_shape_rect(20,20,10,10);
+    bench_shape_overlap(b,shapes,2);
+}
+
+static void bench_shape_circle_circle(Bench *b)
+{
+    Shape shapes[4];
+    shapes[0] = gfc_shape_circle(0,0,10);
+    shapes[1] = gfc_shape_circle(12,3,5);
+    shapes[2] = gfc_shape_circle(0,0,10);
+    shapes[3] = gfc_shape_circle(30,30,5);
+    bench_shape_overlap(b,shapes,2);
+}
+
+static void bench_shape_rect_circle(Bench *b)
+{
+    Shape shapes[4];
+    shapes[0] = gfc_shape_rect(0,0,10,10);
+    shapes[1] = gfc_shape_circle(12,5,4);
+    shapes[2] = gfc_shape_rect(0,0,10,10);
+    shapes[3] = gfc_shape_circle(30,30,4);
+    bench_shape_overlap(b,shapes,2);
+}
+
+static void bench_shape_edge_rect(Bench *b)
+{
+    Shape shapes[4];
+    shapes[0] = gfc_shape_edge(-5,5,15,6);
+    shapes[1] = gfc_shape_rect(0,0,10,10);
+    shapes[2] = gfc_shape_edge(-5,20,15,21);
+    shapes[3] = gfc_shape_rect(0,0,10,10);
+    bench_shape_overlap(b,shapes,2);
+}
+
+static void bench_shape_edge_circle(Bench *b)
+{
+    Shape shapes[4];
+    shapes[0] = gfc_shape_edge(-15,2,15,3);
+    shapes[1] = gfc_shape_circle(0,0,10);
+    shapes[2] = gfc_shape_edge(-15,20,15,21);
+    shapes[3] = gfc_shape_circle(0,0,10);
+    bench_shape_overlap(b,shapes,2);
+}
+
+static void bench_shape_edge_edge(Bench *b)
+{
+    Shape shapes[4];
+    shapes[0] = gfc_shape_edge(0,0,10,10);
+    shapes[1] = gfc_shape_edge(0,10,10,0);
+    shapes[2] = gfc_shape_edge(0,0,10,0);
+    shapes[3] = gfc_shape_edge(0,5,10,5);
+    bench_shape_overlap(b,shapes,2);
+}
+
+/*matrix*/
+
+static void bench_matrix_setup(Matrix4 a,Matrix4 b)
+{
+    int i,j;
+    for (i = 0; i < 4; i++)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            a[i][j] = (i == j) ? 2.0f : 0.25f * (i + 1) - 0.1f * j;
+            b[i][j] = (i == j) ? 1.5f : 0.1f * j - 0.05f * i;
+        }
+    }
+}
+
+static void bench_matrix_multiply(Bench *b)
+{
+    Matrix4 m1,m2,out;
+    Uint64 i;
+    bench_matrix_setup(m1,m2);
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        gfc_matrix_multiply(out,m1,m2);
+        m1[3][0] = out[0][3];//keep the inputs changing so the work is not hoisted out of the loop
+    }
+    bench_stop(b);
+    bench_sink += out[0][0];
+}
+
+static void bench_matrix_invert(Bench *b)
+{
+    Matrix4 m1,m2,out;
+    Uint64 i;
+    bench_matrix_setup(m1,m2);
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        if (!gfc_matrix4_invert(out,m1))bench_sink += 1;
+        m1[3][0] = 0.25f + out[0][3] * 0.001f;
+    }
+    bench_stop(b);
+    bench_sink += out[0][0];
+}
+
+/*noise*/
+
+static void bench_perlin(Bench *b)
+{
+    Uint64 i;
+    float sum = 0;
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        sum += gfc_perlin(vector2d((i & 1023) * 0.37f,((i >> 10) & 1023) * 0.11f));
+    }
+    bench_stop(b);
+    bench_sink += sum;
+}
+
+/*pak*/
+
+static Uint8 bench_pak_ready = 0;
+static Uint8 bench_pak_failed = 0;  /**<so a pak that could not be built is not tried again every round*/
+
+static int bench_pak_build()
+{
+    mz_zip_archive zip;
+    Uint8 *text,*noise;
+    Uint32 i,seed = 1;
+    int ok;
+    text = malloc(65536);
+    noise = malloc(65536);
+    if ((!text)||(!noise))
+    {
+        free(text);
+        free(noise);
+        return -1;
+    }
+    //text deflates well, noise does not and is stored the way gfc_pak_build would store it
+    for (i = 0; i < 65536; i++)
+    {
+        text[i] = "{\"name\":\"gfc_bench\",\"value\":12345},\n"[i % 36];
+        seed = seed * 1664525u + 1013904223u;
+        noise[i] = (Uint8)(seed >> 24);
+    }
+    memset(&zip,0,sizeof(mz_zip_archive));
+    ok = mz_zip_writer_init_file(&zip,BENCH_PAK,0);
+    if (ok)ok = mz_zip_writer_add_mem(&zip,"gfc_bench/deflate_small.json",text,4096,MZ_DEFAULT_LEVEL);
+    if (ok)ok = mz_zip_writer_add_mem(&zip,"gfc_bench/deflate_large.json",text,65536,MZ_DEFAULT_LEVEL);
+    if (ok)ok = mz_zip_writer_add_mem(&zip,"gfc_bench/stored.bin",noise,65536,MZ_NO_COMPRESSION);
+    if (ok)ok = mz_zip_writer_finalize_archive(&zip);
+    mz_zip_writer_end(&zip);
+    free(text);
+    free(noise);
+    if (!ok)
+    {
+        fprintf(stderr,"failed to write %s\n",BENCH_PAK);
+        return -1;
+    }
+    gfc_pak_manager_init();
+    gfc_pak_manager_add(BENCH_PAK);
+    bench_pak_ready = 1;
+    return 0;
+}
+
+static void bench_pak_extract(Bench *b,const char *filename,size_t budget)
+{
+    void *data;
+    size_t size;
+    Uint64 i;
+    if ((!bench_pak_ready)&&((bench_pak_failed)||(bench_pak_build() != 0)))
+    {
+        bench_pak_failed = 1;
+        bench_skip(b,"the benchmark pak could not be built");
+        return;
+    }
+    gfc_pak_cache_set_budget(budget);
+    bench_start(b);
+    for (i = 0; i < b->n; i++)
+    {
+        data = gfc_pak_file_extract(filename,&size);
+        free(data);
+    }
+    bench_stop(b);
+    gfc_pak_cache_set_budget(0);
+}
+
+static void bench_pak_extract_deflate_small(Bench *b)
+{
+    bench_pak_extract(b,"gfc_bench/deflate_small.json",0);
+}
+
+static void bench_pak_extract_deflate_large(Bench *b)
+{
+    bench_pak_extract(b,"gfc_bench/deflate_large.json",0);
+}
+
+static void bench_pak_extract_stored(Bench *b)
+{
+    bench_pak_extract(b,"gfc_bench/stored.bin",0);
+}
+
+static void bench_pak_extract_cached(Bench *b)
+{
+    bench_pak_extract(b,"gfc_bench/deflate_large.json",1 << 20);
+}
+
+static BenchCase bench_cases[] =
+{
+    {"hashmap_insert",bench_hashmap_insert,16},
+    {"hashmap_insert",bench_hashmap_insert,1024},
+    {"hashmap_insert",bench_hashmap_insert,65536},
+    {"hashmap_get",bench_hashmap_get,16},
+    {"hashmap_get",bench_hashmap_get,1024},
+    {"hashmap_get",bench_hashmap_get,65536},
+    {"hashmap_get_miss",bench_hashmap_get_miss,16},
+    {"hashmap_get_miss",bench_hashmap_get_miss,1024},
+    {"hashmap_get_miss",bench_hashmap_get_miss,65536},
+    {"list_append",bench_list_append,16},
+    {"list_append",bench_list_append,1024},
+    {"list_append",bench_list_append,65536},
+    {"list_insert",bench_list_insert,16},
+    {"list_insert",bench_list_insert,1024},
+    {"list_insert",bench_list_insert,65536},
+    {"list_delete",bench_list_delete,16},
+    {"list_delete",bench_list_delete,1024},
+    {"list_delete",bench_list_delete,65536},
+    {"array_append",bench_array_append,1024},
+    {"array_foreach",bench_array_foreach,1024},
+    {"array_foreach",bench_array_foreach,65536},
+    {"shape_overlap_poc_rect_rect",bench_shape_rect_rect,0},
+    {"shape_overlap_poc_circle_circle",bench_shape_circle_circle,0},
+    {"shape_overlap_poc_rect_circle",bench_shape_rect_circle,0},
+    {"shape_overlap_poc_edge_rect",bench_shape_edge_rect,0},
+    {"shape_overlap_poc_edge_circle",bench_shape_edge_circle,0},
+    {"shape_overlap_poc_edge_edge",bench_shape_edge_edge,0},
+    {"matrix_multiply",bench_matrix_multiply,0},
+    {"matrix4_invert",bench_matrix_invert,0},
+    {"perlin",bench_perlin,0},
+    {"pak_extract_deflate",bench_pak_extract_deflate_small,4096},
+    {"pak_extract_deflate",bench_pak_extract_deflate_large,65536},
+    {"pak_extract_stored",bench_pak_extract_stored,65536},
+    {"pak_extract_cached",bench_pak_extract_cached,65536},
+    {NULL,NULL,0}
+};
+
+/**
+ * @brief run a benchmark with more and more operations until it fills the target time
+ */
+static void bench_run(BenchCase *c,Uint64 target,Bench *result)
+{
+    Bench b;
+    Uint64 n = 1,next;
+    for (;;)
+    {
+        memset(&b,0,sizeof(Bench));
+        b.n = n;
+        b.size = c->size;
+        c->run(&b);
+        bench_stop(&b);
+        if ((b.skipped)||(b.ticks >= target)||(n >= 1000000000))break;
+        //aim a little past the target from the rate so far, but do not grow too fast on a noisy first run
+        if (b.ticks)next = (Uint64)((double)n * target / b.ticks * 1.2);
+        else next = n * 100;
+        if (next > n * 100)next = n * 100;
+        if (next <= n)next = n + 1;
+        n = next;
+    }
+    *result = b;
+}
+
+static void bench_usage()
+{
+    printf("usage: gfc_bench [-t milliseconds] [-f filter] [-json]\n");
+}
+
+int main(int argc,char *argv[])
+{
+    BenchCase *c;
+    Bench b;
+    const char *filter = NULL;
+    double ms = 100,ns,allocs,frequency;
+    Uint8 json = 0,first = 1;
+    int i;
+    for (i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i],"-t") == 0)&&(i + 1 < argc))ms = atof(argv[++i]);
+        else if ((strcmp(argv[i],"-f") == 0)&&(i + 1 < argc))filter = argv[++i];
+        else if (strcmp(argv[i],"-json") == 0)json = 1;
+        else
+        {
+            bench_usage();
+            return 1;
+        }
+    }
+    if (ms <= 0)ms = 100;
+    frequency = (double)SDL_GetPerformanceFrequency();
+    if (json)printf("[\n");
+    else printf("# benchmark\tsize\titerations\tns/op\tallocs/op\n");
+    for (c = bench_cases; c->name; c++)
+    {
+        if ((filter)&&(!strstr(c->name,filter)))continue;
+        bench_run(c,(Uint64)(ms * frequency / 1000.0),&b);
+        if (b.skipped)
+        {
+            fprintf(stderr,"%s skipped: %s\n",c->name,b.skipped);
+            continue;
+        }
+        ns = (double)b.ticks * 1000000000.0 / frequency / (double)b.n;
+        allocs = (double)b.allocs / (double)b.n;
+        if (json)
+        {
+            printf("%s  {\"name\":\"%s\",\"size\":%u,\"iterations\":%llu,\"ns_per_op\":%.3f,\"allocs_per_op\":%.4f}",
+                first?"":",\n",c->name,c->size,(unsigned long long)b.n,ns,allocs);
+        }
+        else
+        {
+            printf("%s\t%u\t%llu\t%.3f\t%.4f\n",c->name,c->size,(unsigned long long)b.n,ns,allocs);
+        }
+        fflush(stdout);
+        first = 0;
+    }
+    if (json)printf("\n]\n");
+    if (bench_pak_ready)remove(BENCH_PAK);
+    return 0;
+}
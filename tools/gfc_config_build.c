@@ -0,0 +1,57 @@
+/**
+ * gfc_config_build
+ * compiles config def json files into blobs that gfc_config_def_load() can use without parsing them
+ * usage: gfc_config_build [-o output.gcd] <defs.json> [<defs.json>...]
+ *
+ * Each file is written next to itself under the name gfc_config_def_load() looks for, unless -o is given for a single file.
+ * Files are found through the pak manager just as the game would, so loose files take priority over paks in the working directory.
+ * A blob records the crc of the json it came from, gfc_config_def_load() ignores it once the json changes.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "gfc_text.h"
+#include "gfc_pak.h"
+#include "gfc_config_blob.h"
+
+static void config_build_usage()
+{
+    fprintf(stderr,"usage: gfc_config_build [-o output.gcd] <defs.json> [<defs.json>...]\n");
+}
+
+int main(int argc,char *argv[])
+{
+    TextLine compiled;
+    const char *output = NULL;
+    int first = 1;
+    int failed = 0;
+    int i;
+    if ((argc > 2)&&(strcmp(argv[1],"-o") == 0))
+    {
+        output = argv[2];
+        first = 3;
+    }
+    if ((first >= argc)||((output)&&(argc - first != 1)))
+    {
+        config_build_usage();
+        return 1;
+    }
+    gfc_pak_manager_init();
+    for (i = first; i < argc; i++)
+    {
+        if (output)gfc_line_cpy(compiled,output);
+        else if (gfc_config_blob_get_name(argv[i],compiled) != 0)
+        {
+            fprintf(stderr,"%s: name too long\n",argv[i]);
+            failed++;
+            continue;
+        }
+        if (gfc_config_blob_compile(argv[i],compiled) != 0)
+        {
+            fprintf(stderr,"%s: failed to compile\n",argv[i]);
+            failed++;
+            continue;
+        }
+        printf("%s -> %s\n",argv[i],compiled);
+    }
+    return failed?1:0;
+}
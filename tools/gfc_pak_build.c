@@ -0,0 +1,354 @@
+/**
+ * gfc_pak_build
+ * packs a directory tree into a pak file that gfc_pak_manager_add() can mount
+ * usage: gfc_pak_build [-j threads] [-l level] [-r ratio] [-v] <directory> <output.pak>
+ *
+ * Files are compressed in parallel and written in sorted path order so builds are repeatable.
+ * Each file is stored uncompressed or deflated, whichever suits it:
+ *  - files that are already compressed (images, audio, archives) are stored so they can be memory mapped by gfc_pak_file_map()
+ *  - files that do not shrink below ratio of their original size when deflated are stored
+ * The zip central directory at the end of the pak is the index.  gfc_pak_manager_add() hashes it on mount for O(1) lookups.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <SDL.h>
+#include "miniz.h"
+#include "gfc_text.h"
+
+typedef struct
+{
+    TextLine name;          /**<path within the pak*/
+    char *path;             /**<path on disk*/
+    void *packed;           /**<deflated data, NULL if stored*/
+    size_t packedSize;
+    void *data;             /**<the original file*/
+    size_t size;
+    mz_uint32 crc;
+    Uint8 done;             /**<ready to be written*/
+    Uint8 failed;
+}PakBuildFile;
+
+typedef struct
+{
+    PakBuildFile *files;
+    Uint32 count;
+    Uint32 size;
+    Uint32 next;            /**<next file for a worker to take*/
+    Uint32 written;         /**<files before this have been written and released*/
+    Uint32 window;          /**<how far ahead of the writer the workers may get*/
+    int level;
+    float ratio;
+    Uint8 verbose;
+    SDL_mutex *lock;
+    SDL_cond *progress;
+}PakBuild;
+
+static PakBuild pak_build = {0};
+
+static const char *pak_build_stored_extensions[] =
+{
+    ".png",".jpg",".jpeg",".ogg",".mp3",".flac",".opus",".zip",".pak",".gz",".webp",NULL
+};
+
+static Uint8 pak_build_is_precompressed(const char *name)
+{
+    const char *ext;
+    int i;
+    ext = strrchr(name,'.');
+    if (!ext)return 0;
+    for (i = 0; pak_build_stored_extensions[i] != NULL; i++)
+    {
+        if (strcasecmp(ext,pak_build_stored_extensions[i]) == 0)return 1;
+    }
+    return 0;
+}
+
+static int pak_build_add_file(const char *path,const char *name)
+{
+    PakBuildFile *files;
+    if (strlen(name) >= GFCLINELEN)
+    {
+        fprintf(stderr,"path too long for a pak entry: %s\n",name);
+        return -1;
+    }
+    if (pak_build.count >= pak_build.size)
+    {
+        files = realloc(pak_build.files,sizeof(PakBuildFile) * (pak_build.size?pak_build.size * 2:256));
+        if (!files)return -1;
+        pak_build.files = files;
+        pak_build.size = pak_build.size?pak_build.size * 2:256;
+    }
+    memset(&pak_build.files[pak_build.count],0,sizeof(PakBuildFile));
+    gfc_line_cpy(pak_build.files[pak_build.count].name,name);
+    pak_build.files[pak_build.count].path = strdup(path);
+    if (!pak_build.files[pak_build.count].path)return -1;
+    pak_build.count++;
+    return 0;
+}
+
+/**
+ * @brief gather every regular file under dir, prefix is the path within the pak so far
+ */
+static int pak_build_scan(const char *dir,const char *prefix)
+{
+    DIR *d;
+    struct dirent *ent;
+    struct stat st;
+    char path[1024];
+    char name[1024];
+    int rc = 0;
+    d = opendir(dir);
+    if (!d)
+    {
+        fprintf(stderr,"failed to open directory %s\n",dir);
+        return -1;
+    }
+    while ((ent = readdir(d)) != NULL)
+    {
+        if (ent->d_name[0] == '.')continue;//hidden files, . and ..
+        snprintf(path,sizeof(path),"%s/%s",dir,ent->d_name);
+        if (prefix[0])snprintf(name,sizeof(name),"%s/%s",prefix,ent->d_name);
+        else snprintf(name,sizeof(name),"%s",ent->d_name);
+        if (stat(path,&st) != 0)continue;
+        if ((st.st_mode & S_IFMT) == S_IFDIR)rc |= pak_build_scan(path,name);
+        else if ((st.st_mode & S_IFMT) == S_IFREG)rc |= pak_build_add_file(path,name);
+    }
+    closedir(d);
+    return rc;
+}
+
+static int pak_build_compare(const void *a,const void *b)
+{
+    return strcmp(((const PakBuildFile *)a)->name,((const PakBuildFile *)b)->name);
+}
+
+static void *pak_build_load(const char *path,size_t *size)
+{
+    FILE *file;
+    long length;
+    void *data;
+    file = fopen(path,"rb");
+    if (!file)return NULL;
+    fseek(file,0,SEEK_END);
+    length = ftell(file);
+    fseek(file,0,SEEK_SET);
+    if (length < 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+    data = malloc(length?length:1);
+    if ((data)&&(length)&&(fread(data,length,1,file) != 1))
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *size = length;
+    return data;
+}
+
+static void pak_build_pack(PakBuildFile *file)
+{
+    file->data = pak_build_load(file->path,&file->size);
+    if (!file->data)
+    {
+        fprintf(stderr,"failed to read %s\n",file->path);
+        file->failed = 1;
+        return;
+    }
+    file->crc = mz_crc32(MZ_CRC32_INIT,file->data,file->size);
+    if ((!pak_build.level)||(!file->size)||(pak_build_is_precompressed(file->name)))return;
+    //raw deflate, the zip headers are written by the writer
+    file->packed = tdefl_compress_mem_to_heap(
+        file->data,
+        file->size,
+        &file->packedSize,
+        tdefl_create_comp_flags_from_zip_params(pak_build.level,-MZ_DEFAULT_WINDOW_BITS,MZ_DEFAULT_STRATEGY));
+    if ((file->packed)&&(file->packedSize >= file->size * pak_build.ratio))
+    {
+        //not worth inflating at load time, store it so it can be mapped
+        free(file->packed);
+        file->packed = NULL;
+    }
+}
+
+static int pak_build_worker(void *data)
+{
+    PakBuild *build = data;
+    Uint32 index;
+    SDL_LockMutex(build->lock);
+    for (;;)
+    {
+        if (build->next >= build->count)break;
+        if (build->next >= build->written + build->window)
+        {
+            //the writer is behind, don't hold any more files in memory
+            SDL_CondWait(build->progress,build->lock);
+            continue;
+        }
+        index = build->next++;
+        SDL_UnlockMutex(build->lock);
+        pak_build_pack(&build->files[index]);
+        SDL_LockMutex(build->lock);
+        build->files[index].done = 1;
+        SDL_CondBroadcast(build->progress);
+    }
+    SDL_UnlockMutex(build->lock);
+    return 0;
+}
+
+static int pak_build_write(mz_zip_archive *zip,PakBuildFile *file)
+{
+    mz_bool ok;
+    if (file->failed)return -1;
+    if (file->packed)
+    {
+        ok = mz_zip_writer_add_mem_ex(zip,file->name,file->packed,file->packedSize,NULL,0,
+            pak_build.level | MZ_ZIP_FLAG_COMPRESSED_DATA,file->size,file->crc);
+    }
+    else
+    {
+        ok = mz_zip_writer_add_mem_ex(zip,file->name,file->data,file->size,NULL,0,MZ_NO_COMPRESSION,0,0);
+    }
+    if (!ok)
+    {
+        fprintf(stderr,"failed to add %s to the pak: %s\n",file->name,mz_zip_get_error_string(mz_zip_get_last_error(zip)));
+        return -1;
+    }
+    if (pak_build.verbose)
+    {
+        printf("%s %s %lu -> %lu\n",
+            file->packed?"deflate":"stored ",
+            file->name,
+            (unsigned long)file->size,
+            (unsigned long)(file->packed?file->packedSize:file->size));
+    }
+    return 0;
+}
+
+static void pak_build_usage()
+{
+    printf("usage: gfc_pak_build [-j threads] [-l level] [-r ratio] [-v] <directory> <output.pak>\n");
+    printf("  -j threads  compression threads, default is one per core\n");
+    printf("  -l level    deflate level 0-10, 0 stores everything, default %i\n",MZ_DEFAULT_LEVEL);
+    printf("  -r ratio    store files that do not deflate below this fraction of their size, default 0.9\n");
+    printf("  -v          list every file as it is written\n");
+}
+
+int main(int argc,char *argv[])
+{
+    mz_zip_archive zip;
+    SDL_Thread **threads;
+    PakBuildFile *file;
+    const char *dir = NULL,*output = NULL;
+    int threadCount = 0;
+    int i,rc = 0;
+    Uint32 f;
+    pak_build.level = MZ_DEFAULT_LEVEL;
+    pak_build.ratio = 0.9;
+    for (i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i],"-j") == 0)&&(i + 1 < argc))threadCount = atoi(argv[++i]);
+        else if ((strcmp(argv[i],"-l") == 0)&&(i + 1 < argc))pak_build.level = atoi(argv[++i]);
+        else if ((strcmp(argv[i],"-r") == 0)&&(i + 1 < argc))pak_build.ratio = atof(argv[++i]);
+        else if (strcmp(argv[i],"-v") == 0)pak_build.verbose = 1;
+        else if (!dir)dir = argv[i];
+        else if (!output)output = argv[i];
+        else
+        {
+            pak_build_usage();
+            return 1;
+        }
+    }
+    if ((!dir)||(!output))
+    {
+        pak_build_usage();
+        return 1;
+    }
+    if (pak_build.level < 0)pak_build.level = 0;
+    if (pak_build.level > MZ_UBER_COMPRESSION)pak_build.level = MZ_UBER_COMPRESSION;
+    if (threadCount <= 0)threadCount = SDL_GetCPUCount();
+    if (threadCount <= 0)threadCount = 1;
+    if (pak_build_scan(dir,"") != 0)return 1;
+    if (!pak_build.count)
+    {
+        fprintf(stderr,"no files found in %s\n",dir);
+        return 1;
+    }
+    qsort(pak_build.files,pak_build.count,sizeof(PakBuildFile),pak_build_compare);
+
+    memset(&zip,0,sizeof(mz_zip_archive));
+    if (!mz_zip_writer_init_file(&zip,output,0))
+    {
+        fprintf(stderr,"failed to create %s\n",output);
+        return 1;
+    }
+    pak_build.window = threadCount * 4;
+    pak_build.lock = SDL_CreateMutex();
+    pak_build.progress = SDL_CreateCond();
+    threads = calloc(threadCount,sizeof(SDL_Thread *));
+    if ((!pak_build.lock)||(!pak_build.progress)||(!threads))
+    {
+        fprintf(stderr,"failed to start worker threads\n");
+        return 1;
+    }
+    for (i = 0,f = 0; i < threadCount; i++)
+    {
+        threads[i] = SDL_CreateThread(pak_build_worker,"gfc_pak_build",&pak_build);
+        if (threads[i])f++;
+    }
+    if (!f)
+    {
+        //no threads, pack everything up front on this one
+        pak_build.window = pak_build.count;
+        pak_build_worker(&pak_build);
+    }
+    //the writer is not thread safe, write in order on this thread as files finish
+    for (f = 0; f < pak_build.count; f++)
+    {
+        file = &pak_build.files[f];
+        SDL_LockMutex(pak_build.lock);
+        while (!file->done)SDL_CondWait(pak_build.progress,pak_build.lock);
+        SDL_UnlockMutex(pak_build.lock);
+        if (pak_build_write(&zip,file) != 0)rc = 1;
+        free(file->data);
+        free(file->packed);
+        free(file->path);
+        file->data = file->packed = NULL;
+        SDL_LockMutex(pak_build.lock);
+        pak_build.written = f + 1;
+        SDL_CondBroadcast(pak_build.progress);
+        SDL_UnlockMutex(pak_build.lock);
+    }
+    for (i = 0; i < threadCount; i++)
+    {
+        if (threads[i])SDL_WaitThread(threads[i],NULL);
+    }
+    if (rc != 0)
+    {
+        //a pak missing some of its files is worse than no pak, don't leave one behind
+        mz_zip_writer_end(&zip);
+        remove(output);
+        fprintf(stderr,"some files could not be packed, %s was not written\n",output);
+    }
+    else if ((!mz_zip_writer_finalize_archive(&zip))||(!mz_zip_writer_end(&zip)))
+    {
+        fprintf(stderr,"failed to finish %s\n",output);
+        mz_zip_writer_end(&zip);
+        remove(output);
+        rc = 1;
+    }
+    else printf("packed %u files into %s\n",pak_build.count,output);
+    free(threads);
+    free(pak_build.files);
+    SDL_DestroyCond(pak_build.progress);
+    SDL_DestroyMutex(pak_build.lock);
+    return rc;
+}
+
+/*eol@eof*/